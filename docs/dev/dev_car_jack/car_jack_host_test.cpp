@@ -0,0 +1,268 @@
+// host test of the CarJack state machine, input traces (switches and handle sensor) are replayed against it
+// with a virtual time and a simple model of the stepper and the jack, the limit switch follows the model.
+// the loop only calls update() when an input changed or the next timer of the state machine expired, like
+// main.cpp after an input interrupt or the timeout of the thread flag, so the number of updates is the
+// number of times the thread wakes up
+//
+// compile and run from the repository root:
+//   g++ -std=c++17 -O2 -Ilib/Hsm -Isrc docs/dev/dev_car_jack/car_jack_host_test.cpp src/CarJack.cpp -o car_jack_host_test
+//   ./car_jack_host_test
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CarJack.h"
+
+static const float VELOCITY_MAX = 12.0f; // rps, like Stepper
+static const float ACCELERATION = 12.0f; // rps/s, 1 s to full speed
+static const float SOFTWARE_STOP_POS = 10.0f;
+static const float TOP_POS = 600.0f;
+
+// the actions of the state machine are logged with their time
+typedef struct action_s {
+    uint32_t time_ms;
+    std::string name;
+} action_t;
+
+// model of the stepper (velocity or position command with the ramp of the engine) and of the jack
+class CarJackModel : public CarJackIO
+{
+public:
+    float position = 5.0f; // rotations above the limit switch
+    float velocity = 0.0f;
+    float offset = 0.0f;   // position of the rotation 0
+    bool is_enabled = false;
+    bool is_solenoid = false;
+    bool is_initialized = false;
+    bool is_velocity_command = true;
+    float setpoint = 0.0f;
+    uint32_t time_ms = 0;
+    std::vector<action_t> actions;
+
+    void enableStepper(bool enable) override { is_enabled = enable; log(enable ? "enable" : "disable"); }
+    void setSolenoid(bool pullBack) override
+    {
+        if (pullBack != is_solenoid)
+            log(pullBack ? "solenoid on" : "solenoid off");
+        is_solenoid = pullBack;
+    }
+    void stop() override { setVelocity(0.0f); }
+    bool rampUp() override { setVelocity(VELOCITY_MAX); return velocity >= VELOCITY_MAX; }
+    bool rampDown() override { setVelocity(-VELOCITY_MAX); return velocity <= -VELOCITY_MAX; }
+    bool up() override { setRotation(TOP_POS); return getRotation() >= TOP_POS - 1.0e-3f; }
+    bool down() override
+    {
+        if (is_initialized) {
+            setRotation(SOFTWARE_STOP_POS);
+            return getRotation() <= SOFTWARE_STOP_POS + 1.0e-3f;
+        }
+        setVelocity(-VELOCITY_MAX);
+        return false;
+    }
+    void setInitialized(bool isInitialized) override
+    {
+        if (isInitialized) {
+            offset = position;
+            log("initialized");
+        }
+        is_initialized = isInitialized;
+    }
+    void play(Sound sound) override
+    {
+        static const char* names[] = {"play notInitialized", "play inUpperPos", "play inLowerPos", "play manualMode", "play automaticMode"};
+        log(names[sound]);
+    }
+    void toggleVoiceMode() override { log("toggle voice mode"); }
+
+    float getRotation() const { return position - offset; }
+    bool isLimitSwitch() const { return position <= 0.0f; }
+
+    // advances the model by 1 ms
+    void step()
+    {
+        const float dt = 1.0e-3f;
+        time_ms++;
+        if (!is_enabled)
+            return;
+        float velocity_desired = setpoint;
+        if (!is_velocity_command) {
+            // decelerates in time to stop at the target
+            const float distance = setpoint - getRotation();
+            velocity_desired = copysignf(fminf(VELOCITY_MAX, sqrtf(2.0f * ACCELERATION * fabsf(distance))), distance);
+            if (fabsf(distance) < VELOCITY_MAX * dt && fabsf(velocity) <= ACCELERATION * dt * 2.0f) {
+                position = setpoint + offset;
+                velocity = 0.0f;
+                return;
+            }
+        }
+        const float dv = ACCELERATION * dt;
+        velocity += fmaxf(-dv, fminf(dv, velocity_desired - velocity));
+        position += velocity * dt;
+    }
+
+    uint32_t firstTime(const std::string& name, uint32_t after_ms = 0) const
+    {
+        for (const action_t& action : actions)
+            if (action.name == name && action.time_ms >= after_ms)
+                return action.time_ms;
+        return UINT32_MAX;
+    }
+
+    int count(const std::string& name) const
+    {
+        int n = 0;
+        for (const action_t& action : actions)
+            n += (action.name == name) ? 1 : 0;
+        return n;
+    }
+
+private:
+    void setVelocity(float v) { is_velocity_command = true; setpoint = v; }
+    void setRotation(float r) { is_velocity_command = false; setpoint = r; }
+    void log(const std::string& name) { actions.push_back({time_ms, name}); }
+};
+
+// input levels set by the user (switches and handle sensor) from time_ms on
+typedef struct trace_s {
+    uint32_t time_ms;
+    uint8_t inputs;
+} trace_t;
+
+typedef struct result_s {
+    int num_of_updates;
+    uint32_t time_end_ms;
+} result_t;
+
+static result_t run(CarJack& car_jack, CarJackModel& model, const std::vector<trace_t>& trace, uint32_t duration_ms)
+{
+    result_t result{0, 0};
+    size_t ind = 0;
+    uint8_t user_inputs = 0;
+    auto inputs = [&]() { return static_cast<uint8_t>(user_inputs | (model.isLimitSwitch() ? CarJack::INPUT_LIMIT_SWITCH : 0)); };
+
+    while (ind < trace.size() && trace[ind].time_ms == 0)
+        user_inputs = trace[ind++].inputs;
+    car_jack.begin(inputs(), model.time_ms);
+    uint8_t inputs_last = inputs();
+    uint32_t time_wake_ms = (car_jack.getTimeToNextTimerMs() < 0) ? UINT32_MAX : model.time_ms + car_jack.getTimeToNextTimerMs();
+
+    while (model.time_ms < duration_ms) {
+        model.step();
+        while (ind < trace.size() && trace[ind].time_ms <= model.time_ms)
+            user_inputs = trace[ind++].inputs;
+
+        // the thread wakes up on an input edge or when the timer expired
+        if (inputs() == inputs_last && model.time_ms < time_wake_ms)
+            continue;
+        inputs_last = inputs();
+        car_jack.update(inputs_last, model.time_ms);
+        result.num_of_updates++;
+        time_wake_ms = (car_jack.getTimeToNextTimerMs() < 0) ? UINT32_MAX : model.time_ms + car_jack.getTimeToNextTimerMs();
+    }
+    result.time_end_ms = model.time_ms;
+    return result;
+}
+
+static int num_of_errors = 0;
+
+static void check(const char* name, bool ok)
+{
+    printf("%-70s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok)
+        num_of_errors++;
+}
+
+static void print(const CarJack& car_jack, const CarJackModel& model, const result_t& result)
+{
+    printf("    %d updates in %.1f s, state %s, rotation %.2f\n", result.num_of_updates, result.time_end_ms * 1.0e-3,
+           car_jack.getStateName(), model.getRotation());
+    for (const action_t& action : model.actions)
+        printf("    %6u ms  %s\n", action.time_ms, action.name.c_str());
+}
+
+int main()
+{
+    const uint8_t UP = CarJack::INPUT_UP_SWITCH;
+    const uint8_t DOWN = CarJack::INPUT_DOWN_SWITCH;
+    const uint8_t HANDLE = CarJack::INPUT_HANDLE_SENSOR;
+
+    {
+        // up without the lowest position only plays the message, the thread sleeps without input changes
+        CarJackModel model;
+        CarJack car_jack(model);
+        const result_t result = run(car_jack, model, {{1000, UP}, {2000, 0}, {3000, UP}, {4000, 0}}, 60000);
+        print(car_jack, model, result);
+        check("not initialized, up does not move", model.position == 5.0f);
+        check("not initialized, the message is played once", model.count("play notInitialized") == 1);
+        check("idle, the thread only wakes up for the input changes", result.num_of_updates == 4);
+    }
+
+    {
+        // down homes at the limit switch and stops at the lowest position, the solenoid is released 3 s after down
+        CarJackModel model;
+        CarJack car_jack(model);
+        const result_t result = run(car_jack, model, {{1000, DOWN}, {6000, 0}}, 12000);
+        print(car_jack, model, result);
+        const uint32_t time_limit_ms = model.firstTime("initialized");
+        check("down, the solenoid is pulled back at once", model.firstTime("solenoid on") == 1000);
+        check("down, the limit switch initializes after 60 ms", time_limit_ms != UINT32_MAX);
+        check("down, stops at the lowest position", fabsf(model.getRotation() - SOFTWARE_STOP_POS) < 0.01f && model.velocity == 0.0f);
+        check("down, the lowest position message is played", model.firstTime("play inLowerPos") < 6000);
+        check("down, the solenoid is released 3 s after the down switch", model.firstTime("solenoid off") == 9000);
+        check("down, state idle", std::string(car_jack.getStateName()) == "idle");
+    }
+
+    {
+        // up after homing, the solenoid is released at full speed and the jack stops at the top
+        CarJackModel model;
+        CarJack car_jack(model);
+        const result_t result = run(car_jack, model, {{1000, DOWN}, {6000, 0}, {6500, UP}}, 70000);
+        print(car_jack, model, result);
+        const uint32_t time_solenoid_off_ms = model.firstTime("solenoid off", 6500);
+        check("up, the solenoid stays pulled back until full speed", time_solenoid_off_ms >= 7500 && time_solenoid_off_ms < 7600);
+        check("up, stops at the top position", fabsf(model.getRotation() - TOP_POS) < 0.01f && model.velocity == 0.0f);
+        check("up, the top position message is played once", model.count("play inUpperPos") == 1);
+        // polls every 20 ms while driving, then sleeps
+        const uint32_t time_top_ms = model.firstTime("play inUpperPos");
+        check("up, the thread stops waking up at the top", result.num_of_updates < static_cast<int>(time_top_ms - 6500) / 20 + 100);
+    }
+
+    {
+        // releasing down during the 400 ms of the solenoid does not move the jack, pressing it again waits again
+        CarJackModel model;
+        CarJack car_jack(model);
+        const result_t result = run(car_jack, model, {{1000, DOWN}, {1200, 0}, {1300, DOWN}, {1650, 0}}, 2000);
+        print(car_jack, model, result);
+        check("short down, no movement before the solenoid is pulled back", model.position == 5.0f);
+        check("short down, the solenoid stays pulled back", model.count("solenoid on") == 1 && model.is_solenoid);
+    }
+
+    {
+        // both switches for 3 s toggle the voice mode once, 2.9 s do nothing, also in manual mode
+        CarJackModel model;
+        CarJack car_jack(model);
+        const result_t result = run(car_jack, model, {{1000, UP | DOWN}, {3900, 0}, {5000, UP}, {5010, UP | DOWN}, {9000, 0},
+                                                      {10000, HANDLE}, {11000, HANDLE | UP | DOWN}, {14500, HANDLE}}, 16000);
+        print(car_jack, model, result);
+        check("both switches, toggles after 3 s", model.firstTime("toggle voice mode") == 8010);
+        check("both switches, toggles once per press", model.count("toggle voice mode") == 2);
+        check("both switches, does not move", fabsf(model.position - 5.0f) < 1.0e-6f);
+    }
+
+    {
+        // the handle sensor switches to manual and back, manual forgets the lowest position
+        CarJackModel model;
+        CarJack car_jack(model);
+        const result_t result = run(car_jack, model, {{1000, DOWN}, {2500, HANDLE | DOWN}, {3000, DOWN}}, 8000);
+        print(car_jack, model, result);
+        check("manual, disables the stepper and releases the solenoid", model.firstTime("disable") == 2500 && model.firstTime("solenoid off") == 2500);
+        check("manual, forgets the lowest position", model.firstTime("initialized", 3000) != UINT32_MAX);
+        check("automatic again, continues with the switch still pressed", std::string(car_jack.getStateName()) == "lowering");
+    }
+
+    printf("%d errors\n", num_of_errors);
+    return num_of_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+// host check of ControlSchedule, the schedule of the ControlScheduler, against a virtual clock. every task
+// advances the clock by its execution time, the ticks start every period like the thread flags of the
+// RealTimeThread, so the order, the phasing of the divisors and the diagnostics can be checked exactly
+//
+// compile and run from the repository root:
+//   g++ -std=c++17 -O2 -Ilib/ControlScheduler docs/dev/dev_control_scheduler/control_schedule_host_check.cpp lib/ControlScheduler/ControlSchedule.cpp -o control_schedule_host_check
+//   ./control_schedule_host_check
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "ControlSchedule.h"
+
+static const uint32_t PERIOD_US = 500;
+
+// execution time of every task id in us
+typedef std::vector<int64_t> exec_times_t;
+
+// runs one tick starting at time_us, returns the ids in the order they were executed
+static std::vector<int> tick(ControlSchedule& schedule, int64_t time_us, const exec_times_t& exec_times_us)
+{
+    std::vector<int> ids;
+    schedule.beginTick(time_us);
+    for (int id = schedule.nextTask(); id >= 0; id = schedule.nextTask()) {
+        ids.push_back(id);
+        time_us += exec_times_us[id];
+        schedule.endTask(id, time_us);
+    }
+    schedule.endTick(time_us);
+    return ids;
+}
+
+// runs num_of_ticks ticks, returns how often every task id was executed
+static std::vector<int> run(ControlSchedule& schedule, int num_of_ticks, const exec_times_t& exec_times_us)
+{
+    std::vector<int> counts(CONTROL_SCHEDULER_NUM_OF_TASKS_MAX, 0);
+    for (int k = 0; k < num_of_ticks; k++)
+        for (int id : tick(schedule, static_cast<int64_t>(k) * PERIOD_US, exec_times_us))
+            counts[id]++;
+    return counts;
+}
+
+static int num_of_errors = 0;
+
+static void check(const char* name, bool ok)
+{
+    printf("%-70s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok)
+        num_of_errors++;
+}
+
+int main()
+{
+    {
+        // rate-monotonic order, the shortest period first, equal periods in the order of the ids
+        ControlSchedule schedule(PERIOD_US);
+        const int id_div4 = schedule.addTask(4);
+        const int id_div1_a = schedule.addTask(1);
+        const int id_div2 = schedule.addTask(2);
+        const int id_div1_b = schedule.addTask(1);
+        const exec_times_t exec_times_us(CONTROL_SCHEDULER_NUM_OF_TASKS_MAX, 10);
+        std::vector<std::vector<int>> ticks;
+        for (int k = 0; k < 5; k++)
+            ticks.push_back(tick(schedule, k * PERIOD_US, exec_times_us));
+        check("order, all tasks in the first tick", ticks[0] == std::vector<int>({id_div1_a, id_div1_b, id_div2, id_div4}));
+        check("order, divisor 1 only", ticks[1] == std::vector<int>({id_div1_a, id_div1_b}));
+        check("order, divisor 1 and 2", ticks[2] == std::vector<int>({id_div1_a, id_div1_b, id_div2}));
+        check("order, divisor 1 again", ticks[3] == std::vector<int>({id_div1_a, id_div1_b}));
+        check("order, all tasks after 4 ticks", ticks[4] == ticks[0]);
+    }
+
+    {
+        // a task is due in the tick after it was added and then every divisor-th tick
+        ControlSchedule schedule(PERIOD_US);
+        const int id_div1 = schedule.addTask(1);
+        const exec_times_t exec_times_us(CONTROL_SCHEDULER_NUM_OF_TASKS_MAX, 10);
+        std::vector<int> ticks_div3;
+        int id_div3 = -1;
+        for (int k = 0; k < 14; k++) {
+            if (k == 5)
+                id_div3 = schedule.addTask(3);
+            for (int id : tick(schedule, k * PERIOD_US, exec_times_us))
+                if (id == id_div3)
+                    ticks_div3.push_back(k);
+        }
+        check("phasing, added task runs in the next tick and every 3rd tick", ticks_div3 == std::vector<int>({5, 8, 11}));
+        check("phasing, the divisor is kept", schedule.getDivisor(id_div3) == 3 && schedule.getDivisor(id_div1) == 1);
+
+        // a removed task is not executed anymore and its slot is reused
+        schedule.removeTask(id_div1);
+        const std::vector<int> counts = run(schedule, 6, exec_times_us);
+        check("remove, the task is not executed anymore", counts[id_div1] == 0 && counts[id_div3] == 2);
+        check("remove, the slot is reused", schedule.addTask(2) == id_div1 && schedule.getNumOfTasks() == 2);
+    }
+
+    {
+        // periods have to be multiples of the base period
+        ControlSchedule schedule(PERIOD_US);
+        check("period, 750 us is rejected", schedule.addTaskWithPeriod(750) == -1);
+        check("period, 250 us is rejected", schedule.addTaskWithPeriod(250) == -1);
+        check("period, divisor 0 is rejected", schedule.addTask(0) == -1);
+        const int id = schedule.addTaskWithPeriod(2000);
+        check("period, 2000 us is divisor 4", id >= 0 && schedule.getDivisor(id) == 4);
+        for (int i = 1; i < CONTROL_SCHEDULER_NUM_OF_TASKS_MAX; i++)
+            schedule.addTask(1);
+        check("period, no slot left", schedule.addTask(1) == -1 && schedule.getNumOfTasks() == CONTROL_SCHEDULER_NUM_OF_TASKS_MAX);
+    }
+
+    {
+        // a slow task with a long period overruns the tick but meets its own deadline
+        ControlSchedule schedule(PERIOD_US);
+        const int id_fast = schedule.addTask(1);
+        const int id_slow = schedule.addTask(4);
+        exec_times_t exec_times_us(CONTROL_SCHEDULER_NUM_OF_TASKS_MAX, 0);
+        exec_times_us[id_fast] = 100;
+        exec_times_us[id_slow] = 600;
+        run(schedule, 10, exec_times_us);
+        schedule.printDiagnostics();
+        check("overrun, counted in the ticks of the slow task", schedule.getTickOverrunCount() == 3);
+        check("overrun, max. tick time", schedule.getTickExecTimeMax_us() == 700);
+        check("overrun, no deadline misses", schedule.getDeadlineMissCount(id_fast) == 0 && schedule.getDeadlineMissCount(id_slow) == 0);
+        check("overrun, max. execution times", schedule.getExecTimeMax_us(id_fast) == 100 && schedule.getExecTimeMax_us(id_slow) == 600);
+    }
+
+    {
+        // the second task of a full tick ends after its period, every tick is a deadline miss and an overrun
+        ControlSchedule schedule(PERIOD_US);
+        const int id_first = schedule.addTask(1);
+        const int id_second = schedule.addTask(1);
+        const int id_slow = schedule.addTask(2);
+        exec_times_t exec_times_us(CONTROL_SCHEDULER_NUM_OF_TASKS_MAX, 0);
+        exec_times_us[id_first] = 300;
+        exec_times_us[id_second] = 300;
+        exec_times_us[id_slow] = 500; // ends at 1100 us, after its period of 1000 us
+        run(schedule, 10, exec_times_us);
+        schedule.printDiagnostics();
+        check("deadline, the first task meets its deadline", schedule.getDeadlineMissCount(id_first) == 0);
+        check("deadline, the second task misses every tick", schedule.getDeadlineMissCount(id_second) == 10);
+        check("deadline, the slow task misses every time it runs", schedule.getDeadlineMissCount(id_slow) == 5);
+        check("deadline, every tick is an overrun", schedule.getTickOverrunCount() == 10);
+
+        schedule.resetDiagnostics();
+        check("deadline, reset clears the counters", schedule.getDeadlineMissCount(id_second) == 0 && schedule.getTickOverrunCount() == 0 &&
+                                                    schedule.getExecTimeMax_us(id_first) == 0 && schedule.getTickExecTimeMax_us() == 0);
+    }
+
+    printf("%d errors\n", num_of_errors);
+    return num_of_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,139 @@
+// host micro benchmark and consistency check for BiquadBank and ControllerBank, compares them against
+// the same number of IIRFilter and PIDCntrl objects that are updated one after the other like in the drivers
+//
+// compile and run from the repository root:
+//   g++ -std=c++17 -O2 -Ilib/IIRFilter -Ilib/PIDCntrl -Ilib/BiquadBank -Ilib/ControllerBank docs/dev/dev_controller_bank/controller_bank_benchmark.cpp lib/IIRFilter/IIRFilter.cpp lib/PIDCntrl/PIDCntrl.cpp -o controller_bank_benchmark
+//   ./controller_bank_benchmark
+//
+// on the target the same comparison can be done with the DWT cycle counter instead of std::chrono
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "BiquadBank.h"
+#include "ControllerBank.h"
+#include "IIRFilter.h"
+#include "PIDCntrl.h"
+
+static const size_t NUM_OF_CHANNELS = 8; // robots run 6 - 10 filters per period
+static const int NUM_OF_UPDATES = 20000000 / NUM_OF_CHANNELS;
+static const float TS = 500.0e-6f;
+
+// test signal, a sine plus a step that drives the controllers into saturation
+static float input(size_t ch, int k)
+{
+    const float t = static_cast<float>(k) * TS;
+    return sinf(2.0f * 3.14159265f * (1.0f + static_cast<float>(ch)) * t) + ((k % 4000) < 2000 ? 2.0f : -2.0f);
+}
+
+// keeps the optimiser from removing the loops
+static volatile float sink;
+
+template <typename F>
+static double nsPerUpdate(F update)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    for (int k = 0; k < NUM_OF_UPDATES; k++)
+        update(k);
+    const double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return dt / (static_cast<double>(NUM_OF_UPDATES) * NUM_OF_CHANNELS) * 1.0e9;
+}
+
+int main()
+{
+    // filters like the ones used in the drivers
+    IIRFilter filters[NUM_OF_CHANNELS];
+    for (size_t i = 0; i < NUM_OF_CHANNELS; i++) {
+        switch (i % 4) {
+            case 0: filters[i].lowPass2Init(15.0f, 1.0f, TS); break;
+            case 1: filters[i].notchInit(120.0f, 0.5f, TS); break;
+            case 2: filters[i].lowPass1Init(30.0f, TS); break;
+            default: filters[i].leadLag1Init(5.0f, 50.0f, TS); break;
+        }
+    }
+    BiquadBank<NUM_OF_CHANNELS> biquad_bank;
+    for (size_t i = 0; i < NUM_OF_CHANNELS; i++)
+        biquad_bank.setFilter(i, filters[i]);
+
+    // velocity controllers like in DCMotor, every second channel without D part and roll-off
+    PIDCntrl cntrls[NUM_OF_CHANNELS];
+    ControllerBank<NUM_OF_CHANNELS> cntrl_bank;
+    const float tau_f = 1.0f / (2.0f * 3.14159265f * 30.0f);
+    const float tau_ro = 1.0f / (2.0f * 3.14159265f * 0.5f / (2.0f * TS));
+    for (size_t i = 0; i < NUM_OF_CHANNELS; i++) {
+        const float kd = (i % 2) ? 0.0f : 0.0192f;
+        const float ki = (i % 3) ? 140.0f : 0.0f;
+        const float tau = (i % 2) ? 0.0f : tau_ro;
+        cntrls[i].setup(4.2f, ki, kd, tau_f, tau, TS, -12.0f, 12.0f);
+        cntrls[i].setIntegratorLimits(-3.6f, 3.6f);
+        cntrls[i].setParamF(0.5f);
+        cntrl_bank.setup(i, 4.2f, ki, kd, tau_f, tau, TS, -12.0f, 12.0f);
+        cntrl_bank.setIntegratorLimits(i, -3.6f, 3.6f);
+        cntrl_bank.setParamF(i, 0.5f);
+    }
+    // the same controllers for update(e), which has no feedforward
+    PIDCntrl cntrls_e[NUM_OF_CHANNELS];
+    for (size_t i = 0; i < NUM_OF_CHANNELS; i++)
+        cntrls_e[i] = cntrls[i];
+    ControllerBank<NUM_OF_CHANNELS> cntrl_bank_e = cntrl_bank;
+
+    // consistency, the same inputs have to give the same outputs
+    float error_filter_max = 0.0f;
+    float error_cntrl_max = 0.0f;
+    float error_cntrl_e_max = 0.0f;
+    for (int k = 0; k < 100000; k++) {
+        float x[NUM_OF_CHANNELS], y_bank[NUM_OF_CHANNELS], w[NUM_OF_CHANNELS], u_bank[NUM_OF_CHANNELS];
+        float e[NUM_OF_CHANNELS], u_bank_e[NUM_OF_CHANNELS];
+        for (size_t i = 0; i < NUM_OF_CHANNELS; i++) {
+            x[i] = input(i, k);
+            w[i] = (k % 3000 < 1500) ? 3.0f : -3.0f;
+        }
+        biquad_bank.apply(x, y_bank);
+        cntrl_bank.update(w, y_bank, y_bank, y_bank, u_bank);
+        for (size_t i = 0; i < NUM_OF_CHANNELS; i++)
+            e[i] = w[i] - y_bank[i];
+        cntrl_bank_e.update(e, u_bank_e);
+        for (size_t i = 0; i < NUM_OF_CHANNELS; i++) {
+            const float y = filters[i].apply(x[i]);
+            const float u = cntrls[i].update(w[i], y_bank[i], y_bank[i], y_bank[i]);
+            const float u_e = cntrls_e[i].update(e[i]);
+            error_filter_max = fmaxf(error_filter_max, fabsf(y - y_bank[i]));
+            error_cntrl_max = fmaxf(error_cntrl_max, fabsf(u - u_bank[i]));
+            error_cntrl_e_max = fmaxf(error_cntrl_e_max, fabsf(u_e - u_bank_e[i]));
+        }
+    }
+
+    float x[NUM_OF_CHANNELS], y[NUM_OF_CHANNELS], u[NUM_OF_CHANNELS];
+    const double ns_filters = nsPerUpdate([&](int k) {
+        for (size_t i = 0; i < NUM_OF_CHANNELS; i++)
+            y[i] = filters[i].apply(static_cast<float>(k & 0xFF) + static_cast<float>(i));
+        sink = y[k % NUM_OF_CHANNELS];
+    });
+    const double ns_biquad_bank = nsPerUpdate([&](int k) {
+        for (size_t i = 0; i < NUM_OF_CHANNELS; i++)
+            x[i] = static_cast<float>(k & 0xFF) + static_cast<float>(i);
+        biquad_bank.apply(x, y);
+        sink = y[k % NUM_OF_CHANNELS];
+    });
+    const double ns_cntrls = nsPerUpdate([&](int k) {
+        for (size_t i = 0; i < NUM_OF_CHANNELS; i++)
+            u[i] = cntrls[i].update(static_cast<float>(k & 0x3) + static_cast<float>(i), y[i], y[i], y[i]);
+        sink = u[k % NUM_OF_CHANNELS];
+    });
+    const double ns_cntrl_bank = nsPerUpdate([&](int k) {
+        for (size_t i = 0; i < NUM_OF_CHANNELS; i++)
+            x[i] = static_cast<float>(k & 0x3) + static_cast<float>(i);
+        cntrl_bank.update(x, y, y, y, u);
+        sink = u[k % NUM_OF_CHANNELS];
+    });
+
+    printf("%d channels, ns per channel update, max. abs. difference to the scalar classes\n", (int)NUM_OF_CHANNELS);
+    printf("IIRFilter::apply()          %6.2f\n", ns_filters);
+    printf("BiquadBank::apply()         %6.2f   %.3e\n", ns_biquad_bank, error_filter_max);
+    printf("PIDCntrl::update()          %6.2f\n", ns_cntrls);
+    printf("ControllerBank::update()    %6.2f   %.3e\n", ns_cntrl_bank, error_cntrl_max);
+    printf("ControllerBank::update(e)            %.3e\n", error_cntrl_e_max);
+
+    return (error_filter_max < 1.0e-4f && error_cntrl_max < 1.0e-4f && error_cntrl_e_max < 1.0e-4f) ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+// host check of the fixed-point filters and controllers against the float versions, prints the
+// quantisation of the coefficients, the max. error in parts of full scale and a checksum of all
+// fixed-point outputs, the integer arithmetic is bit-exact so the same checksum is expected on the target
+//
+// the input signal is a recorded SDLogger file (raw floats, first column is used) if one is given,
+// otherwise a synthetic encoder velocity (quantised steps, chirp and noise) like in DCMotor
+//
+// compile and run from the repository root:
+//   g++ -std=c++17 -O2 -Ilib/FixedPoint -Ilib/IIRFilter -Ilib/PIDCntrl -Ilib/IIRFilterQ31 -Ilib/PIDCntrlQ31 -Ilib/AvgFilterQ15 docs/dev/dev_fixed_point/fixed_point_host_check.cpp lib/IIRFilter/IIRFilter.cpp lib/PIDCntrl/PIDCntrl.cpp lib/IIRFilterQ31/IIRFilterQ31.cpp lib/PIDCntrlQ31/PIDCntrlQ31.cpp lib/AvgFilterQ15/AvgFilterQ15.cpp -o fixed_point_host_check
+//   ./fixed_point_host_check [file.bin]
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "AvgFilterQ15.h"
+#include "FixedPoint.h"
+#include "IIRFilter.h"
+#include "IIRFilterQ31.h"
+#include "PIDCntrl.h"
+#include "PIDCntrlQ31.h"
+
+static const float TS = 500.0e-6f;
+static const float VELOCITY_SCALE = 100.0f; // rps
+static const float VOLTAGE_SCALE = 64.0f;   // V, headroom for the unfiltered controller output
+static const int NUM_OF_SAMPLES = 40000;
+
+static uint32_t checksum = 2166136261u; // fnv-1a over all fixed-point outputs
+static void hash(int32_t val)
+{
+    for (int i = 0; i < 4; i++) {
+        checksum ^= static_cast<uint8_t>(val >> (8 * i));
+        checksum *= 16777619u;
+    }
+}
+
+static std::vector<float> readSignal(const char* file_name)
+{
+    std::vector<float> signal;
+    FILE* file = fopen(file_name, "rb");
+    if (!file) {
+        printf("could not open %s\n", file_name);
+        return signal;
+    }
+    const int num_of_floats = fgetc(file);
+    if (num_of_floats <= 0 || (num_of_floats & 0x80)) {
+        printf("%s is empty or encoded, only raw SDLogger files are supported\n", file_name);
+        fclose(file);
+        return signal;
+    }
+    std::vector<float> record(num_of_floats);
+    while (fread(record.data(), sizeof(float), num_of_floats, file) == (size_t)num_of_floats)
+        signal.push_back(record[0]);
+    fclose(file);
+
+    // normalise to half full scale
+    float abs_max = 0.0f;
+    for (float val : signal)
+        abs_max = fmaxf(abs_max, fabsf(val));
+    for (float& val : signal)
+        val = (abs_max > 0.0f) ? 0.5f * VELOCITY_SCALE * val / abs_max : 0.0f;
+    return signal;
+}
+
+static std::vector<float> syntheticSignal()
+{
+    // encoder velocity, steps between +-40 rps, a chirp and the quantisation of a 1/3200 rotation encoder
+    std::vector<float> signal(NUM_OF_SAMPLES);
+    uint32_t seed = 1;
+    for (int k = 0; k < NUM_OF_SAMPLES; k++) {
+        const float t = static_cast<float>(k) * TS;
+        const float step = ((k / 4000) % 2) ? 40.0f : -40.0f;
+        const float chirp = 10.0f * sinf(2.0f * 3.14159265f * (1.0f + 20.0f * t) * t);
+        seed = seed * 1664525u + 1013904223u;
+        const float noise = 0.5f * (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f);
+        const float velocity = step + chirp + noise;
+        signal[k] = roundf(velocity * TS * 3200.0f) / (TS * 3200.0f);
+    }
+    return signal;
+}
+
+int main(int argc, char* argv[])
+{
+    const std::vector<float> signal = (argc > 1) ? readSignal(argv[1]) : syntheticSignal();
+    if (signal.empty())
+        return 1;
+    bool ok = true;
+
+    // biquads, error in parts of full scale
+    printf("IIRFilterQ31 (%d samples), coefficient error and max. error in parts of full scale\n", (int)signal.size());
+    for (int type = 0; type < 4; type++) {
+        IIRFilter filter;
+        const char* name;
+        float gain = 1.0f; // input gain so that the output stays below full scale
+        switch (type) {
+            case 0: filter.lowPass2Init(15.0f, 1.0f, TS); name = "lowPass2 15 Hz"; break;
+            case 1: filter.notchInit(120.0f, 0.5f, TS); name = "notch 120 Hz  "; break;
+            case 2: filter.lowPass1Init(30.0f, TS); name = "lowPass1 30 Hz"; break;
+            default: filter.leadLag1Init(5.0f, 50.0f, TS); name = "leadLag1      "; gain = 0.1f; break;
+        }
+        IIRFilterQ31 filter_q31;
+        filter_q31.setFilter(filter);
+
+        float B[3], A[2], w[2], B_q[3], A_q[2];
+        filter.getBiquad(B, A, w);
+        filter_q31.getCoefficients(B_q, A_q);
+        float coefficient_error_max = 0.0f;
+        for (int i = 0; i < 3; i++)
+            coefficient_error_max = fmaxf(coefficient_error_max, fabsf(B[i] - B_q[i]));
+        for (int i = 0; i < 2; i++)
+            coefficient_error_max = fmaxf(coefficient_error_max, fabsf(A[i] - A_q[i]));
+
+        float error_max = 0.0f;
+        for (float x : signal) {
+            const float y = filter.apply(gain * x / VELOCITY_SCALE);
+            const q31_t y_q31 = filter_q31.apply(fixedFloatToQ31(gain * x / VELOCITY_SCALE));
+            hash(y_q31);
+            error_max = fmaxf(error_max, fabsf(y - fixedQ31ToFloat(y_q31)));
+        }
+        printf("  %s shift %d   %.2e   %.2e\n", name, filter_q31.getShift(), coefficient_error_max, error_max);
+        ok &= (error_max < 1.0e-5f);
+    }
+
+    // velocity controller like in DCMotor, closed loop with a first order plant so the signals are realistic
+    {
+        const float tau_f = 1.0f / (2.0f * 3.14159265f * 30.0f);
+        const float tau_ro = 1.0f / (2.0f * 3.14159265f * 0.5f / (2.0f * TS));
+        PIDCntrl cntrl;
+        PIDCntrlQ31 cntrl_q31;
+        cntrl.setup(4.2f, 140.0f, 0.0192f, tau_f, tau_ro, TS, -11.76f, 11.76f);
+        cntrl.setIntegratorLimits(-3.5f, 3.5f);
+        cntrl.setParamF(0.5f);
+        cntrl_q31.setup(4.2f, 140.0f, 0.0192f, tau_f, tau_ro, TS, -11.76f, 11.76f, VELOCITY_SCALE, VOLTAGE_SCALE);
+        cntrl_q31.setIntegratorLimits(-3.5f, 3.5f);
+        cntrl_q31.setParamF(0.5f);
+
+        // the setpoint is smoothed like by the motion planner, plant: first order, 6 rps per V, 50 ms, both
+        // controllers see the same measurement
+        IIRFilter setpoint_filter;
+        setpoint_filter.lowPass1Init(5.0f, TS);
+        float velocity = 0.0f;
+        float error_max = 0.0f;
+        int num_of_saturated = 0;
+        for (size_t k = 0; k < signal.size(); k++) {
+            const float w = setpoint_filter.apply(signal[k]);
+            const float u = cntrl.update(w, velocity, velocity, velocity);
+            const q31_t w_q31 = fixedFloatToQ31(w / VELOCITY_SCALE);
+            const q31_t y_q31 = fixedFloatToQ31(velocity / VELOCITY_SCALE);
+            const q31_t u_q31 = cntrl_q31.update(w_q31, y_q31, y_q31, y_q31);
+            hash(u_q31);
+            error_max = fmaxf(error_max, fabsf(u / VOLTAGE_SCALE - fixedQ31ToFloat(u_q31)));
+            num_of_saturated += (fabsf(u) >= 11.76f);
+            velocity += TS / 0.05f * (6.0f * u - velocity);
+        }
+        printf("PIDCntrlQ31 shift %d, max. error %.2e of full scale, %d of %d samples saturated\n",
+               cntrl_q31.getShift(), error_max, num_of_saturated, (int)signal.size());
+        ok &= (error_max < 1.0e-4f);
+    }
+
+    // moving average against the exact average of the quantised samples
+    {
+        const uint8_t N = 10;
+        AvgFilterQ15 avg_q15(N);
+        std::vector<q15_t> samples(N, 0);
+        int error_max = 0;
+        for (size_t k = 0; k < signal.size(); k++) {
+            const q15_t x = fixedFloatToQ15(signal[k] / VELOCITY_SCALE);
+            samples[k % N] = x;
+            double sum = 0.0;
+            for (q15_t s : samples)
+                sum += s;
+            const q15_t y = avg_q15.apply(x);
+            hash(y);
+            error_max = std::max(error_max, static_cast<int>(fabs(sum / N - y) + 0.5));
+        }
+        printf("AvgFilterQ15 N = %d, max. error %d LSB\n", N, error_max);
+        ok &= (error_max <= 1);
+    }
+
+    // saturation semantics
+    ok &= (fixedFloatToQ31(1.0f) == FIXED_POINT_Q31_MAX) && (fixedFloatToQ31(-2.0f) == FIXED_POINT_Q31_MIN);
+    ok &= (fixedFloatToQ31(NAN) == 0) && (fixedFloatToQ15(0.5f) == 16384);
+    ok &= (fixedShiftRound(-3, 1) == -1) && (fixedShiftRound(3, 1) == 2);
+
+    printf("checksum 0x%08x\n%s\n", checksum, ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
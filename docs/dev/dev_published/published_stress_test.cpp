@@ -0,0 +1,149 @@
+// host stress test for Published<T>, one writer thread publishes as fast as it can while several reader
+// threads check that every snapshot they get belongs to one single publish() and that the snapshots
+// never go back in time, the same is done with an unprotected copy to show that the test detects torn reads
+//
+// compile and run from the repository root:
+//   g++ -std=c++17 -O2 -pthread -Ilib/Published docs/dev/dev_published/published_stress_test.cpp -o published_stress_test
+//   ./published_stress_test
+//
+// the test returns 1 if Published<T> delivered a torn or an old snapshot
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "Published.h"
+
+static const int NUM_OF_READERS = 3;
+static const int NUM_OF_WORDS = 16; // 64 bytes, a bit larger than ImuData
+static const auto DURATION = std::chrono::seconds(2);
+
+// every word is derived from the same counter, a snapshot is consistent if all of them match
+struct Data {
+    uint32_t words[NUM_OF_WORDS];
+};
+
+static void fill(Data& data, uint32_t counter)
+{
+    for (int i = 0; i < NUM_OF_WORDS; i++)
+        data.words[i] = counter * (2u * i + 1u);
+}
+
+static bool isConsistent(const Data& data)
+{
+    const uint32_t counter = data.words[0];
+    for (int i = 1; i < NUM_OF_WORDS; i++) {
+        if (data.words[i] != counter * (2u * i + 1u))
+            return false;
+    }
+    return true;
+}
+
+// unprotected copy for comparison, every word is written and read on its own like a plain struct copy
+// (relaxed atomics so that the comparison itself is not undefined behaviour)
+struct NaiveData {
+    std::atomic<uint32_t> words[NUM_OF_WORDS];
+
+    void write(const Data& data)
+    {
+        for (int i = 0; i < NUM_OF_WORDS; i++)
+            words[i].store(data.words[i], std::memory_order_relaxed);
+    }
+
+    Data read() const
+    {
+        Data data;
+        for (int i = 0; i < NUM_OF_WORDS; i++)
+            data.words[i] = words[i].load(std::memory_order_relaxed);
+        return data;
+    }
+};
+
+struct Result {
+    uint64_t num_of_reads{0};
+    uint64_t num_of_torn{0};
+    uint64_t num_of_old{0};
+};
+
+int main()
+{
+    Data initial;
+    fill(initial, 0);
+    Published<Data> published(initial);
+    NaiveData naive;
+    naive.write(initial);
+
+    std::atomic<bool> is_running{true};
+    uint32_t num_of_publish = 0;
+
+    std::thread writer([&]() {
+        Data data;
+        uint32_t counter = 0;
+        while (is_running.load(std::memory_order_relaxed)) {
+            fill(data, ++counter);
+            published.publish(data);
+            naive.write(data);
+        }
+        num_of_publish = counter;
+    });
+
+    std::vector<Result> results(2 * NUM_OF_READERS);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < NUM_OF_READERS; r++) {
+        // readers of the Published<Data>
+        readers.emplace_back([&, r]() {
+            Result& result = results[r];
+            uint32_t counter_last = 0;
+            while (is_running.load(std::memory_order_relaxed)) {
+                const Data data = published.read();
+                result.num_of_reads++;
+                if (!isConsistent(data))
+                    result.num_of_torn++;
+                else if (data.words[0] < counter_last)
+                    result.num_of_old++;
+                else
+                    counter_last = data.words[0];
+            }
+        });
+        // readers of the unprotected copy
+        readers.emplace_back([&, r]() {
+            Result& result = results[NUM_OF_READERS + r];
+            while (is_running.load(std::memory_order_relaxed)) {
+                const Data data = naive.read();
+                result.num_of_reads++;
+                if (!isConsistent(data))
+                    result.num_of_torn++;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(DURATION);
+    is_running = false;
+    writer.join();
+    for (auto& reader : readers)
+        reader.join();
+
+    Result sum_published, sum_naive;
+    for (int r = 0; r < NUM_OF_READERS; r++) {
+        sum_published.num_of_reads += results[r].num_of_reads;
+        sum_published.num_of_torn += results[r].num_of_torn;
+        sum_published.num_of_old += results[r].num_of_old;
+        sum_naive.num_of_reads += results[NUM_OF_READERS + r].num_of_reads;
+        sum_naive.num_of_torn += results[NUM_OF_READERS + r].num_of_torn;
+    }
+
+    printf("publish calls:   %u\n", num_of_publish);
+    printf("Published<Data>: %llu reads, %llu torn, %llu old\n",
+           static_cast<unsigned long long>(sum_published.num_of_reads),
+           static_cast<unsigned long long>(sum_published.num_of_torn),
+           static_cast<unsigned long long>(sum_published.num_of_old));
+    printf("unprotected:     %llu reads, %llu torn\n",
+           static_cast<unsigned long long>(sum_naive.num_of_reads),
+           static_cast<unsigned long long>(sum_naive.num_of_torn));
+
+    const bool is_passed = (sum_published.num_of_torn == 0) && (sum_published.num_of_old == 0);
+    printf("%s\n", is_passed ? "passed" : "FAILED");
+    return is_passed ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+// host check of SCurve, the profiles are sampled with the period of the motion planner and checked for the
+// exact stop at the target, the velocity, acceleration and jerk limits, the synchronisation of two axes with
+// setMinimumDuration() and the continuity of the acceleration if the target changes while accelerating
+//
+// compile and run from the repository root:
+//   g++ -std=c++17 -O2 -Ilib/SCurve docs/dev/dev_scurve/scurve_host_check.cpp lib/SCurve/SCurve.cpp -o scurve_host_check
+//   ./scurve_host_check
+
+#include <cmath>
+#include <cstdio>
+
+#include "SCurve.h"
+
+static const float TS = 0.001f;           // period of the DCMotor thread
+static const float VELOCITY_MAX = 1.0f;
+static const float ACCELERATION_MAX = 2.0f;
+static const float DECELERATION_MAX = 1.5f;
+static const float JERK_MAX = 20.0f;
+static const float TOLERANCE = 1.0e-3f;   // relative, for the float rounding of the sampled profile
+
+typedef struct result_s {
+    int num_of_ticks;       // until the target is reached, -1 if it is not reached
+    float velocity_max;     // absolute values
+    float acceleration_max; // while speeding up
+    float deceleration_max; // while slowing down
+    float jerk_max;         // from the change of the acceleration within one period
+} result_t;
+
+static void setLimits(SCurve& s_curve)
+{
+    s_curve.setLimits(VELOCITY_MAX, ACCELERATION_MAX, DECELERATION_MAX, JERK_MAX);
+}
+
+// one period of a profile, updates the maxima of the result
+static void sample(SCurve& s_curve, result_t& result, float acceleration_previous)
+{
+    const float velocity = s_curve.getVelocity();
+    const float acceleration = s_curve.getAcceleration();
+    result.velocity_max = fmaxf(result.velocity_max, fabsf(velocity));
+    if (velocity * acceleration > 0.0f)
+        result.acceleration_max = fmaxf(result.acceleration_max, fabsf(acceleration));
+    else
+        result.deceleration_max = fmaxf(result.deceleration_max, fabsf(acceleration));
+    result.jerk_max = fmaxf(result.jerk_max, fabsf(acceleration - acceleration_previous) / TS);
+}
+
+// runs incrementToPosition() until the target is reached or time_max [s] has passed
+static result_t runToPosition(SCurve& s_curve, double target, float time_max)
+{
+    result_t result{-1, 0.0f, 0.0f, 0.0f, 0.0f};
+    const int num_of_ticks_max = static_cast<int>(time_max / TS);
+    for (int i = 1; i <= num_of_ticks_max; i++) {
+        const float acceleration_previous = s_curve.getAcceleration();
+        s_curve.incrementToPosition(target, TS);
+        sample(s_curve, result, acceleration_previous);
+        if (s_curve.getPosition() == static_cast<double>(static_cast<float>(target)) && s_curve.getVelocity() == 0.0f) {
+            result.num_of_ticks = i;
+            break;
+        }
+    }
+    return result;
+}
+
+static bool isWithinLimits(const result_t& result)
+{
+    return result.velocity_max <= VELOCITY_MAX * (1.0f + TOLERANCE) &&
+           result.acceleration_max <= ACCELERATION_MAX * (1.0f + TOLERANCE) &&
+           result.deceleration_max <= DECELERATION_MAX * (1.0f + TOLERANCE) &&
+           result.jerk_max <= JERK_MAX * (1.0f + TOLERANCE);
+}
+
+static void print(const char* name, const result_t& result)
+{
+    printf("%s: %d ticks, v max %.4f, a max %.4f, d max %.4f, j max %.3f\n", name, result.num_of_ticks, result.velocity_max,
+                                                                         result.acceleration_max, result.deceleration_max, result.jerk_max);
+}
+
+static int num_of_errors = 0;
+
+static void check(const char* name, bool ok)
+{
+    printf("%-70s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok)
+        num_of_errors++;
+}
+
+int main()
+{
+    {
+        // short moves that do not reach the acceleration limit, moves without cruising and long moves
+        const float targets[] = {0.01f, -0.01f, 0.3f, -0.3f, 1.0f, -1.0f, 5.0f, -5.0f};
+        bool is_exact = true;
+        bool is_in_time = true;
+        bool is_limited = true;
+        for (float target : targets) {
+            SCurve s_curve;
+            setLimits(s_curve);
+            const float duration = s_curve.getTimeToPosition(target);
+            const result_t result = runToPosition(s_curve, target, duration + 1.0f);
+            print("position", result);
+            is_exact = is_exact && result.num_of_ticks > 0;
+            // the time of the profile is summed up in float, after a few seconds it lags by up to one period
+            is_in_time = is_in_time && result.num_of_ticks * TS >= duration - TS && result.num_of_ticks * TS <= duration + 2.0f * TS;
+            is_limited = is_limited && isWithinLimits(result);
+        }
+        check("position moves stop exactly at the target", is_exact);
+        check("position moves take getTimeToPosition()", is_in_time);
+        check("position moves stay within the velocity, acceleration and jerk limits", is_limited);
+    }
+
+    {
+        // velocity changes from rest, to a lower velocity and through zero
+        SCurve s_curve;
+        setLimits(s_curve);
+        const float targets[] = {0.8f, 0.2f, -0.5f};
+        bool is_reached = true;
+        result_t result{-1, 0.0f, 0.0f, 0.0f, 0.0f};
+        for (float target : targets) {
+            for (int i = 0; i < static_cast<int>(2.0f / TS); i++) {
+                const float acceleration_previous = s_curve.getAcceleration();
+                s_curve.incrementToVelocity(target, TS);
+                sample(s_curve, result, acceleration_previous);
+            }
+            is_reached = is_reached && s_curve.getVelocity() == target && s_curve.getAcceleration() == 0.0f;
+        }
+        print("velocity", result);
+        check("velocity changes reach the target velocity", is_reached);
+        check("velocity changes stay within the acceleration and jerk limits", isWithinLimits(result));
+    }
+
+    {
+        // two axes with different distances arrive at the same time
+        SCurve axis_x;
+        SCurve axis_y;
+        setLimits(axis_x);
+        setLimits(axis_y);
+        const double x = 2.0;
+        const double y = -0.4;
+        const float duration_y = axis_y.getTimeToPosition(y);
+        const float duration = fmaxf(axis_x.getTimeToPosition(x), duration_y);
+        axis_x.setMinimumDuration(duration);
+        axis_y.setMinimumDuration(duration);
+        check("synchronised axis takes the minimum duration", fabsf(axis_y.getTimeToPosition(y) - duration) <= TS);
+
+        int num_of_ticks_x = -1;
+        int num_of_ticks_y = -1;
+        result_t result_y{-1, 0.0f, 0.0f, 0.0f, 0.0f};
+        for (int i = 1; i <= static_cast<int>((duration + 1.0f) / TS); i++) {
+            const float acceleration_previous = axis_y.getAcceleration();
+            axis_x.incrementToPosition(x, TS);
+            axis_y.incrementToPosition(y, TS);
+            sample(axis_y, result_y, acceleration_previous);
+            if (num_of_ticks_x < 0 && axis_x.getPosition() == x && axis_x.getVelocity() == 0.0f)
+                num_of_ticks_x = i;
+            if (num_of_ticks_y < 0 && axis_y.getPosition() == static_cast<double>(static_cast<float>(y)) && axis_y.getVelocity() == 0.0f)
+                num_of_ticks_y = i;
+        }
+        result_y.num_of_ticks = num_of_ticks_y;
+        print("synchronised", result_y);
+        printf("duration %.4f s, x arrives after %d ticks, y after %d ticks, y alone takes %.4f s\n", duration, num_of_ticks_x,
+                                                                                                     num_of_ticks_y, duration_y);
+        check("synchronised axes stop exactly at their targets", num_of_ticks_x > 0 && num_of_ticks_y > 0);
+        check("synchronised axes arrive within one period", abs(num_of_ticks_x - num_of_ticks_y) <= 1 &&
+                                                            fabsf(num_of_ticks_y * TS - duration) <= TS);
+        check("synchronised axis stays within the limits", isWithinLimits(result_y));
+    }
+
+    {
+        // the target changes to the other side while the acceleration ramps up
+        SCurve s_curve;
+        setLimits(s_curve);
+        result_t result = runToPosition(s_curve, 5.0, 0.05f);
+        const float acceleration_retarget = s_curve.getAcceleration();
+        const result_t result_retarget = runToPosition(s_curve, -1.0, 10.0f);
+        print("retarget", result_retarget);
+        result.num_of_ticks = result_retarget.num_of_ticks;
+        result.velocity_max = fmaxf(result.velocity_max, result_retarget.velocity_max);
+        result.acceleration_max = fmaxf(result.acceleration_max, result_retarget.acceleration_max);
+        result.deceleration_max = fmaxf(result.deceleration_max, result_retarget.deceleration_max);
+        result.jerk_max = fmaxf(result.jerk_max, result_retarget.jerk_max);
+        check("retarget happens with a non-zero acceleration", acceleration_retarget > 0.5f);
+        check("retarget stops exactly at the new target", result.num_of_ticks > 0);
+        check("retarget keeps the acceleration continuous and within the limits", isWithinLimits(result));
+    }
+
+    {
+        // a profile that starts from the state of another profile continues its acceleration
+        SCurve s_curve;
+        setLimits(s_curve);
+        s_curve.set(0.0, 0.5f, 1.0f);
+        const float acceleration_start = s_curve.getAcceleration();
+        const result_t result = runToPosition(s_curve, 2.0, 10.0f);
+        print("set with acceleration", result);
+        s_curve.set(0.0, 0.5f, 1.0f);
+        s_curve.incrementToPosition(2.0, TS);
+        check("set() with acceleration starts the profile with it", acceleration_start == 1.0f &&
+                                                                    fabsf(s_curve.getAcceleration() - 1.0f) <= JERK_MAX * TS * (1.0f + TOLERANCE));
+        check("set() with acceleration stops exactly at the target", result.num_of_ticks > 0);
+        check("set() with acceleration stays within the limits", isWithinLimits(result));
+    }
+
+    printf("%d errors\n", num_of_errors);
+    return num_of_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+// host check of StepPulseEngine against a virtual timer, the timer interrupt is replaced by a loop that
+// advances the time by the returned delay, commands are sent at given times like from the main thread
+//
+// compile and run from the repository root:
+//   g++ -std=c++17 -O2 -Ilib/SPSCRingBuffer -Ilib/StepPulseEngine docs/dev/dev_step_pulse_engine/step_pulse_engine_host_check.cpp lib/StepPulseEngine/StepPulseEngine.cpp -o step_pulse_engine_host_check
+//   ./step_pulse_engine_host_check
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "StepPulseEngine.h"
+
+static const float STEPS_PER_REV = 400.0f;
+static const float VELOCITY_MAX = 12.0f; // rps
+static const float ACCELERATION = 12.0f; // rps/s, like the car jack, 1 s to full speed
+
+typedef struct command_s {
+    int64_t time_mus;
+    std::function<StepPulseEngine::command_result_t(StepPulseEngine&)> send;
+} command_t;
+
+typedef struct result_s {
+    int32_t steps;
+    int num_of_steps;
+    int num_of_events;
+    float velocity_max;     // rps, from the time between two steps
+    float acceleration_max; // rps/s, from the mean velocity over windows of 10 ms, the step times are quantised to 1 us
+    int64_t time_end_mus;
+} result_t;
+
+// runs the engine until it stopped and no command is left, the timer is started like Stepper does it
+static result_t run(StepPulseEngine& engine, std::vector<command_t> commands)
+{
+    result_t result{0, 0, 0, 0.0f, 0.0f, 0};
+    int64_t time_mus = 0;
+    int64_t time_event_mus = -1; // -1: timer not running
+    int64_t time_step_last_mus = -1;
+    bool direction_last = true;
+    size_t ind = 0;
+
+    // mean velocity over windows of at least 10 ms, a window ends at a change of direction. the mean velocity is
+    // the velocity at the center of the window, so the acceleration is the difference over the time between the
+    // centers of two windows (at low speed a window is a single step of more than 10 ms)
+    const int64_t window_mus = 10000;
+    int64_t time_window_mus = 0;
+    int num_of_steps_window = 0;
+    float velocity_window_last = -1.0f; // -1: no full window yet
+    float duration_window_last = 0.0f;
+
+    while (ind < commands.size() || time_event_mus >= 0) {
+        // the next command is sent before the next timer event
+        if (ind < commands.size() && (time_event_mus < 0 || commands[ind].time_mus <= time_event_mus)) {
+            time_mus = commands[ind].time_mus;
+            if (commands[ind++].send(engine) == StepPulseEngine::COMMAND_START_TIMER)
+                time_event_mus = time_mus + 1;
+            continue;
+        }
+
+        time_mus = time_event_mus;
+        uint32_t delay_mus;
+        result.num_of_events++;
+        if (engine.onTimer(delay_mus)) {
+            result.num_of_steps++;
+            if (time_step_last_mus >= 0 && engine.getDirection() == direction_last) {
+                const float velocity = 1.0e6f / static_cast<float>(time_mus - time_step_last_mus) / STEPS_PER_REV;
+                if (velocity > result.velocity_max)
+                    result.velocity_max = velocity;
+                num_of_steps_window++;
+                if (time_mus - time_window_mus >= window_mus) {
+                    const float duration_window = static_cast<float>(time_mus - time_window_mus) * 1.0e-6f;
+                    const float velocity_window = static_cast<float>(num_of_steps_window) / STEPS_PER_REV / duration_window;
+                    const float acceleration = fabsf(velocity_window - velocity_window_last) / (0.5f * (duration_window_last + duration_window));
+                    if (velocity_window_last >= 0.0f && acceleration > result.acceleration_max)
+                        result.acceleration_max = acceleration;
+                    velocity_window_last = velocity_window;
+                    duration_window_last = duration_window;
+                    time_window_mus = time_mus;
+                    num_of_steps_window = 0;
+                }
+            } else {
+                time_window_mus = time_mus;
+                num_of_steps_window = 0;
+                velocity_window_last = -1.0f;
+            }
+            time_step_last_mus = time_mus;
+            direction_last = engine.getDirection();
+        }
+        time_event_mus = (delay_mus > 0) ? time_mus + delay_mus : -1;
+    }
+    result.steps = engine.getSteps();
+    result.time_end_mus = time_mus;
+    return result;
+}
+
+static int num_of_errors = 0;
+
+static void check(const char* name, bool ok)
+{
+    printf("%-60s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok)
+        num_of_errors++;
+}
+
+static void print(const result_t& result)
+{
+    printf("    steps %d, %d steps in %d events, %.3f s, v max %.2f rps, a max %.2f rps/s\n", result.steps,
+           result.num_of_steps, result.num_of_events, result.time_end_mus * 1.0e-6, result.velocity_max,
+           result.acceleration_max);
+}
+
+int main()
+{
+    // the ramp table holds the exact step times, the tolerance covers the quantisation of the step times to 1 us
+    const float acceleration_tol = 1.05f * ACCELERATION;
+    const float velocity_tol = 1.01f * VELOCITY_MAX;
+
+    {
+        // the steps of the ramp happen at t_n = sqrt(2 * n / a) from the first step, every delay is rounded to 1 us
+        StepPulseEngine engine(STEPS_PER_REV, VELOCITY_MAX, ACCELERATION);
+        engine.setTarget(20 * 400, VELOCITY_MAX);
+        const float acceleration_steps = ACCELERATION * STEPS_PER_REV;
+        int64_t time_mus = 0;
+        float time_error_max_mus = 0.0f;
+        for (int n = 0; n < 2000; n++) {
+            uint32_t delay_mus;
+            engine.onTimer(delay_mus);
+            const float time_error_mus = fabsf(static_cast<float>(time_mus) - 1.0e6f * sqrtf(2.0f * static_cast<float>(n) / acceleration_steps));
+            if (time_error_mus > time_error_max_mus)
+                time_error_max_mus = time_error_mus;
+            time_mus += delay_mus;
+        }
+        printf("    time error of the ramp max %.1f us\n", time_error_max_mus);
+        check("ramp steps at the times of the constant acceleration", time_error_max_mus < 10.0f);
+    }
+
+    {
+        // long move, reaches the maximum velocity and stops exactly at the target
+        StepPulseEngine engine(STEPS_PER_REV, VELOCITY_MAX, ACCELERATION);
+        const result_t result = run(engine, {{0, [](StepPulseEngine& e) { return e.setTarget(20 * 400, VELOCITY_MAX); }}});
+        print(result);
+        check("long move stops at the target", result.steps == 20 * 400 && result.num_of_steps == 20 * 400);
+        check("long move reaches but does not exceed the maximum velocity", result.velocity_max > 0.95f * VELOCITY_MAX && result.velocity_max < velocity_tol);
+        check("long move acceleration is limited", result.acceleration_max < acceleration_tol);
+        check("long move needs one timer event per step", result.num_of_events <= result.num_of_steps + 1);
+        // 1 s ramp up, 1 s ramp down, 8 rotations at full speed take 0.667 s
+        check("long move takes the time of the trapezoidal profile", fabsf(result.time_end_mus * 1.0e-6f - 2.667f) < 0.05f);
+    }
+
+    {
+        // short move, the triangular profile does not reach the maximum velocity
+        StepPulseEngine engine(STEPS_PER_REV, VELOCITY_MAX, ACCELERATION);
+        const result_t result = run(engine, {{0, [](StepPulseEngine& e) { return e.setTarget(-101, VELOCITY_MAX); }}});
+        print(result);
+        check("short move stops at the target", result.steps == -101 && result.num_of_steps == 101);
+        check("short move acceleration is limited", result.acceleration_max < acceleration_tol);
+    }
+
+    {
+        // the target is moved behind the motor while it drives, it overshoots with the deceleration and comes back
+        StepPulseEngine engine(STEPS_PER_REV, VELOCITY_MAX, ACCELERATION);
+        const result_t result = run(engine, {{0, [](StepPulseEngine& e) { return e.setTarget(10000, VELOCITY_MAX); }},
+                                             {1000000, [](StepPulseEngine& e) { return e.setTarget(500, 6.0f); }}});
+        print(result);
+        check("retarget behind the motor stops at the new target", result.steps == 500);
+        check("retarget acceleration is limited", result.acceleration_max < acceleration_tol);
+    }
+
+    {
+        // velocity mode, reverse and stop with the ramp
+        StepPulseEngine engine(STEPS_PER_REV, VELOCITY_MAX, ACCELERATION);
+        const result_t result = run(engine, {{0, [](StepPulseEngine& e) { return e.setVelocity(6.0f); }},
+                                             {2000000, [](StepPulseEngine& e) { return e.setVelocity(-6.0f); }},
+                                             {4000000, [](StepPulseEngine& e) { return e.setVelocity(0.0f); }}});
+        print(result);
+        check("velocity mode does not exceed the velocity", result.velocity_max < 1.01f * 6.0f);
+        check("velocity mode acceleration is limited", result.acceleration_max < acceleration_tol);
+        check("velocity mode stops with the ramp", engine.getVelocity() == 0.0f);
+    }
+
+    {
+        // the position is redefined while moving (limit switch), the target is shifted along, so the motor still
+        // drives the whole distance
+        StepPulseEngine engine(STEPS_PER_REV, VELOCITY_MAX, ACCELERATION);
+        const result_t result = run(engine, {{0, [](StepPulseEngine& e) { return e.setTarget(4000, VELOCITY_MAX); }},
+                                             {500000, [](StepPulseEngine& e) { return e.setPosition(0); }}});
+        print(result);
+        check("position redefined while moving drives the whole distance", result.num_of_steps == 4000 && result.steps < 4000);
+        check("position redefined while moving acceleration is limited", result.acceleration_max < acceleration_tol);
+    }
+
+    {
+        // commands while standing at the target start and stop the timer without steps
+        StepPulseEngine engine(STEPS_PER_REV, VELOCITY_MAX, ACCELERATION);
+        const result_t result = run(engine, {{0, [](StepPulseEngine& e) { return e.setTarget(0, VELOCITY_MAX); }},
+                                             {20000, [](StepPulseEngine& e) { return e.setVelocity(0.0f); }}});
+        print(result);
+        check("commands at the target do not step", result.num_of_steps == 0 && result.num_of_events == 2);
+    }
+
+    {
+        // the command buffer holds 4 commands, a discarded command is reported so that it can be sent again
+        StepPulseEngine engine(STEPS_PER_REV, VELOCITY_MAX, ACCELERATION);
+        bool is_ok = engine.setTarget(100, VELOCITY_MAX) == StepPulseEngine::COMMAND_START_TIMER;
+        for (int32_t i = 1; i < STEP_PULSE_ENGINE_NUM_OF_COMMANDS; i++)
+            is_ok = is_ok && engine.setTarget(100 + i, VELOCITY_MAX) == StepPulseEngine::COMMAND_QUEUED;
+        is_ok = is_ok && engine.setTarget(200, VELOCITY_MAX) == StepPulseEngine::COMMAND_DISCARDED;
+        uint32_t delay_mus;
+        engine.onTimer(delay_mus);
+        is_ok = is_ok && engine.setTarget(200, VELOCITY_MAX) == StepPulseEngine::COMMAND_QUEUED;
+        check("full command buffer reports the discarded command", is_ok);
+    }
+
+    printf("%d errors\n", num_of_errors);
+    return num_of_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+#include "mbed.h"
+
+// pes board pin map
+#include "PESBoardPinMap.h"
+
+// drivers
+#include "DebounceIn.h"
+#include "DCMotor.h"
+
+// IMPORTANT: set DC_MOTOR_DO_USE_PLANT_SIMULATION to true in DCMotor.h, the motor is then simulated
+//            with the DCMotorPlant model and step() is executed here faster than real time
+#if !DC_MOTOR_DO_USE_PLANT_SIMULATION
+    #error "set DC_MOTOR_DO_USE_PLANT_SIMULATION to true in DCMotor.h"
+#endif
+
+bool do_execute_main_task = false; // this variable will be toggled via the user button (blue button) and
+                                   // decides whether to execute the main task or not
+bool do_reset_all_once = false;    // this variable is used to reset certain variables and objects and
+                                   // shows how you can run a code segment only once
+
+// objects for user button (blue button) handling on nucleo board
+DebounceIn user_button(BUTTON1);   // create DebounceIn to evaluate the user button
+void toggle_do_execute_main_fcn(); // custom function which is getting executed when user
+                                   // button gets pressed, definition at the end
+
+// scenarios that are simulated when the user button is pressed
+typedef struct scenario_s {
+    const char* name;
+    bool is_rotation;        // true: setRotation(), false: setVelocity()
+    float target;            // in rotations or as fraction of the max. physical velocity
+    bool use_motion_planner;
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    {"velocity step 25%",           false, 0.25f, false},
+    {"velocity step 50%",           false, 0.50f, false},
+    {"velocity step 100%",          false, 1.00f, false},
+    {"velocity ramp 50%",           false, 0.50f, true },
+    {"rotation step 1 turn",        true,  1.00f, false},
+    {"rotation step 5 turns",       true,  5.00f, false},
+    {"rotation ramp 5 turns",       true,  5.00f, true }
+};
+
+// results of one scenario
+typedef struct result_s {
+    float rise_time_ms;      // from 10% to 90% of the target, -1 if 90% was never reached
+    float overshoot_percent;
+    float error_end;         // target minus output at the end of the simulation
+    float tick_time_mean_us; // cpu time per call of step()
+    float tick_time_max_us;
+} result_t;
+
+result_t run_scenario(const scenario_t& scenario, float sim_time_s);
+
+// main runs as an own thread
+int main()
+{
+    // attach button fall function address to user button object
+    user_button.fall(&toggle_do_execute_main_fcn);
+
+    // while loop gets executed every main_task_period_ms milliseconds, this is a
+    // simple approach to repeatedly execute main
+    const int main_task_period_ms = 20; // define main task period time in ms e.g. 20 ms, therefore
+                                        // the main task will run 50 times per second
+    Timer main_task_timer;              // create Timer object which we use to run the main task
+                                        // every main_task_period_ms
+
+    // led on nucleo board
+    DigitalOut user_led(LED1);
+
+    // additional led
+    // create DigitalOut object to command extra led, you need to add an additional resistor, e.g. 220...500 Ohm
+    // a led has an anode (+) and a cathode (-), the cathode needs to be connected to ground via the resistor
+    DigitalOut led1(PB_9);
+
+    // --- adding variables and objects and applying functions starts here ---
+
+    const float sim_time_s = 2.0f; // simulated time per scenario
+    const int num_of_scenarios = sizeof(scenarios) / sizeof(scenarios[0]);
+    bool do_run_scenarios = true;
+
+    // start timer
+    main_task_timer.start();
+
+    // this loop will run forever
+    while (true) {
+        main_task_timer.reset();
+
+        // --- code that runs every cycle at the start goes here ---
+
+        if (do_execute_main_task) {
+
+        // --- code that runs when the blue button was pressed goes here ---
+
+            // visual feedback that the main task is executed, setting this once would actually be enough
+            led1 = 1;
+
+            if (do_run_scenarios) {
+                do_run_scenarios = false;
+
+                printf("scenario, rise time (ms), overshoot (%%), end error, tick mean (us), tick max (us), real-time factor\n");
+                for (int i = 0; i < num_of_scenarios; i++) {
+                    const result_t result = run_scenario(scenarios[i], sim_time_s);
+                    printf("%s, %.2f, %.2f, %.4f, %.2f, %.2f, %.1f\n", scenarios[i].name,
+                                                                         result.rise_time_ms,
+                                                                         result.overshoot_percent,
+                                                                         result.error_end,
+                                                                         result.tick_time_mean_us,
+                                                                         result.tick_time_max_us,
+                                                                         1.0e6f * DCMotor::TS / result.tick_time_mean_us);
+                }
+
+                // the simulation takes longer than main_task_period_ms, so start over
+                main_task_timer.reset();
+            }
+        } else {
+            // the following code block gets executed only once
+            if (do_reset_all_once) {
+                do_reset_all_once = false;
+
+                // --- variables and objects that should be reset go here ---
+
+                // reset variables and objects
+                led1 = 0;
+                do_run_scenarios = true;
+            }
+        }
+
+        // toggling the user led
+        user_led = !user_led;
+
+        // --- code that runs every cycle at the end goes here ---
+
+        // read timer and make the main thread sleep for the remaining time span (non blocking)
+        int main_task_elapsed_time_ms = duration_cast<milliseconds>(main_task_timer.elapsed_time()).count();
+        if (main_task_period_ms - main_task_elapsed_time_ms < 0)
+            printf("Warning: Main task took longer than main_task_period_ms\n");
+        else
+            thread_sleep_for(main_task_period_ms - main_task_elapsed_time_ms);
+    }
+}
+
+result_t run_scenario(const scenario_t& scenario, float sim_time_s)
+{
+    const float voltage_max = 12.0f;
+    const float gear_ratio = 78.125f;
+    const float kn = 180.0f / 12.0f;
+
+    // the motor is created for every scenario, so all states start at zero
+    DCMotor motor(PB_PWM_M1, PB_ENC_A_M1, PB_ENC_B_M1, gear_ratio, kn, voltage_max);
+    if (scenario.use_motion_planner)
+        motor.enableMotionPlanner();
+
+    float target = scenario.target;
+    if (scenario.is_rotation) {
+        motor.setRotation(target);
+    } else {
+        target *= motor.getMaxPhysicalVelocity();
+        motor.setVelocity(target);
+    }
+
+    result_t result = {-1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    float time_10_s = -1.0f;
+    float output_max = 0.0f;
+    float output = 0.0f;
+    int64_t tick_time_sum_us = 0;
+    int64_t tick_time_max_us = 0;
+
+    Timer tick_timer;
+    tick_timer.start();
+    const int num_of_ticks = static_cast<int>(sim_time_s / DCMotor::TS);
+    for (int i = 0; i < num_of_ticks; i++) {
+        // only the control code is measured
+        tick_timer.reset();
+        motor.step();
+        const int64_t tick_time_us = duration_cast<microseconds>(tick_timer.elapsed_time()).count();
+        tick_time_sum_us += tick_time_us;
+        if (tick_time_us > tick_time_max_us)
+            tick_time_max_us = tick_time_us;
+
+        // evaluate step response
+        const float time_s = static_cast<float>(i + 1) * DCMotor::TS;
+        output = scenario.is_rotation ? motor.getRotation() : motor.getVelocity();
+        if (output > output_max)
+            output_max = output;
+        if (time_10_s < 0.0f && output >= 0.1f * target)
+            time_10_s = time_s;
+        if (result.rise_time_ms < 0.0f && output >= 0.9f * target)
+            result.rise_time_ms = 1.0e3f * (time_s - time_10_s);
+    }
+
+    result.overshoot_percent = (output_max > target) ? 100.0f * (output_max - target) / target : 0.0f;
+    result.error_end = target - output;
+    result.tick_time_mean_us = static_cast<float>(tick_time_sum_us) / static_cast<float>(num_of_ticks);
+    result.tick_time_max_us = static_cast<float>(tick_time_max_us);
+
+    return result;
+}
+
+void toggle_do_execute_main_fcn()
+{
+    // toggle do_execute_main_task if the button was pressed
+    do_execute_main_task = !do_execute_main_task;
+    // set do_reset_all_once to true if do_execute_main_task changed from false to true
+    if (do_execute_main_task)
+        do_reset_all_once = true;
+}
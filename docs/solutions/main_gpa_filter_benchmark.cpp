@@ -0,0 +1,208 @@
+#include "mbed.h"
+
+// drivers
+#include "DebounceIn.h"
+#include "GPA.h"
+
+// compares the double precision one point DFT filters of the GPA (GPAFilterDouble, GPAPhaseDouble) with
+// the single precision version (GPAFilterFloat, GPAPhaseFloat) over the full logspace sweep, the test
+// signals are u = sin(phi) and y = 0.5 * sin(phi - pi/4), so every frequency point should result in
+// G = Y / U = 0.5 * exp(-1i * pi/4), set GPA_DO_USE_FLOAT_FILTER in GPA.h according to the results
+
+bool do_execute_main_task = false; // this variable will be toggled via the user button (blue button) and
+                                   // decides whether to execute the main task or not
+bool do_reset_all_once = false;    // this variable is used to reset certain variables and objects and
+                                   // shows how you can run a code segment only once
+
+// objects for user button (blue button) handling on nucleo board
+DebounceIn user_button(BUTTON1);   // create DebounceIn to evaluate the user button
+void toggle_do_execute_main_fcn(); // custom function which is getting executed when user
+                                   // button gets pressed, definition at the end
+
+// results of one frequency point
+typedef struct result_s {
+    float G_abs;
+    float G_ang_deg;
+    float tick_time_mean_us; // cpu time per sample for the phase and both filters
+} result_t;
+
+template <typename Filter, typename Phase, typename Real>
+result_t run_freq_point(float fexc, int Nmeas, float Ts);
+
+// main runs as an own thread
+int main()
+{
+    // attach button fall function address to user button object
+    user_button.fall(&toggle_do_execute_main_fcn);
+
+    // while loop gets executed every main_task_period_ms milliseconds, this is a
+    // simple approach to repeatedly execute main
+    const int main_task_period_ms = 20; // define main task period time in ms e.g. 20 ms, therefore
+                                        // the main task will run 50 times per second
+    Timer main_task_timer;              // create Timer object which we use to run the main task
+                                        // every main_task_period_ms
+
+    // led on nucleo board
+    DigitalOut user_led(LED1);
+
+    // additional led
+    // create DigitalOut object to command extra led, you need to add an additional resistor, e.g. 220...500 Ohm
+    // a led has an anode (+) and a cathode (-), the cathode needs to be connected to ground via the resistor
+    DigitalOut led1(PB_9);
+
+    // --- adding variables and objects and applying functions starts here ---
+
+    // same sweep as used for the dc motor, the gpa is only used to get the frequency points
+    const float Ts = 500.0e-6f;
+    const float fMin = 1.0f;
+    const float fMax = 0.99f / 2.0f / Ts;
+    const int NfexcDes = 80;
+    const int NperMin = 3;
+    const int NmeasMin = 1000;
+    GPA gpa(fMin, fMax, NfexcDes, NperMin, NmeasMin, Ts, 1.0f, 1.0f, 0, 0, false, true);
+    bool do_run_benchmark = true;
+
+    // start timer
+    main_task_timer.start();
+
+    // this loop will run forever
+    while (true) {
+        main_task_timer.reset();
+
+        // --- code that runs every cycle at the start goes here ---
+
+        if (do_execute_main_task) {
+
+        // --- code that runs when the blue button was pressed goes here ---
+
+            // visual feedback that the main task is executed, setting this once would actually be enough
+            led1 = 1;
+
+            if (do_run_benchmark) {
+                do_run_benchmark = false;
+
+                float abs_err_max = 0.0f;
+                float ang_err_max = 0.0f;
+                float tick_time_double_us = 0.0f;
+                float tick_time_float_us = 0.0f;
+
+                printf("fexc (Hz), Nmeas, abs err double, abs err float, ang err double (deg), ang err float (deg), t double (us), t float (us)\n");
+                const int num_of_freq_points = gpa.getNumOfFreqPoints();
+                for (int i = 0; i < num_of_freq_points; i++) {
+                    float fexc;
+                    int Nmeas;
+                    if (!gpa.getMeasPara(i, fexc, Nmeas))
+                        break;
+
+                    const result_t res_double = run_freq_point<GPAFilterDouble, GPAPhaseDouble, double>(fexc, Nmeas, Ts);
+                    const result_t res_float  = run_freq_point<GPAFilterFloat, GPAPhaseFloat, float>(fexc, Nmeas, Ts);
+
+                    // the float path is compared to the double path, both are compared to the exact result
+                    const float abs_err_double = res_double.G_abs - 0.5f;
+                    const float abs_err_float  = res_float.G_abs - 0.5f;
+                    const float ang_err_double = res_double.G_ang_deg + 45.0f;
+                    const float ang_err_float  = res_float.G_ang_deg + 45.0f;
+                    printf("%9.3f, %6d, %10.3e, %10.3e, %10.3e, %10.3e, %6.2f, %6.2f\n", fexc, Nmeas,
+                                                                                        abs_err_double, abs_err_float,
+                                                                                        ang_err_double, ang_err_float,
+                                                                                        res_double.tick_time_mean_us,
+                                                                                        res_float.tick_time_mean_us);
+
+                    const float abs_err = fabsf(res_float.G_abs - res_double.G_abs) / res_double.G_abs;
+                    const float ang_err = fabsf(res_float.G_ang_deg - res_double.G_ang_deg);
+                    if (abs_err > abs_err_max)
+                        abs_err_max = abs_err;
+                    if (ang_err > ang_err_max)
+                        ang_err_max = ang_err;
+                    tick_time_double_us += res_double.tick_time_mean_us / static_cast<float>(num_of_freq_points);
+                    tick_time_float_us  += res_float.tick_time_mean_us / static_cast<float>(num_of_freq_points);
+                }
+                printf("float vs. double: max. rel. abs err %.3e, max. ang err %.3e deg\n", abs_err_max, ang_err_max);
+                printf("mean time per sample: double %.2f us, float %.2f us\n", tick_time_double_us, tick_time_float_us);
+
+                // the benchmark takes longer than main_task_period_ms, so start over
+                main_task_timer.reset();
+            }
+        } else {
+            // the following code block gets executed only once
+            if (do_reset_all_once) {
+                do_reset_all_once = false;
+
+                // --- variables and objects that should be reset go here ---
+
+                // reset variables and objects
+                led1 = 0;
+                do_run_benchmark = true;
+            }
+        }
+
+        // toggling the user led
+        user_led = !user_led;
+
+        // --- code that runs every cycle at the end goes here ---
+
+        // read timer and make the main thread sleep for the remaining time span (non blocking)
+        int main_task_elapsed_time_ms = duration_cast<milliseconds>(main_task_timer.elapsed_time()).count();
+        if (main_task_period_ms - main_task_elapsed_time_ms < 0)
+            printf("Warning: Main task took longer than main_task_period_ms\n");
+        else
+            thread_sleep_for(main_task_period_ms - main_task_elapsed_time_ms);
+    }
+}
+
+template <typename Filter, typename Phase, typename Real>
+result_t run_freq_point(float fexc, int Nmeas, float Ts)
+{
+    Filter filterU, filterY;
+    Phase phase;
+    const double scale = 1.0 / sqrt(static_cast<double>(Nmeas));
+    const double w = 2.0 * M_PI * static_cast<double>(Ts) * static_cast<double>(fexc);
+    filterU.init(scale, w);
+    filterY.init(scale, w);
+    phase.reset();
+    const Real increment = static_cast<Real>(Ts) * static_cast<Real>(fexc);
+
+    // a single sample takes less than the 1 us timer resolution, so the whole loop is measured and the time
+    // needed to generate the test signals is measured separately and subtracted
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < Nmeas; i++) {
+        const float angle = phase.getAngle();
+        filterU.apply(sinf(angle));
+        filterY.apply(0.5f * sinf(angle - 0.25f * M_PIf));
+        phase.apply(increment);
+    }
+    const int64_t time_total_us = duration_cast<microseconds>(timer.elapsed_time()).count();
+
+    volatile float signal_sum = 0.0f; // volatile so that the compiler does not remove the loop
+    const float wf = static_cast<float>(w);
+    timer.reset();
+    for (int i = 0; i < Nmeas; i++) {
+        const float angle = wf * static_cast<float>(i);
+        signal_sum = signal_sum + sinf(angle) + 0.5f * sinf(angle - 0.25f * M_PIf);
+    }
+    const int64_t time_signal_us = duration_cast<microseconds>(timer.elapsed_time()).count();
+
+    float Ureal, Uimag, Yreal, Yimag;
+    filterU.getDFT(Ureal, Uimag);
+    filterY.getDFT(Yreal, Yimag);
+    const float U_abs2 = Ureal * Ureal + Uimag * Uimag;
+    const float Greal = (Yreal * Ureal + Yimag * Uimag) / U_abs2;
+    const float Gimag = (Yimag * Ureal - Yreal * Uimag) / U_abs2;
+
+    result_t result;
+    result.G_abs = sqrtf(Greal * Greal + Gimag * Gimag);
+    result.G_ang_deg = atan2f(Gimag, Greal) * 180.0f / M_PIf;
+    result.tick_time_mean_us = static_cast<float>(time_total_us - time_signal_us) / static_cast<float>(Nmeas);
+
+    return result;
+}
+
+void toggle_do_execute_main_fcn()
+{
+    // toggle do_execute_main_task if the button was pressed
+    do_execute_main_task = !do_execute_main_task;
+    // set do_reset_all_once to true if do_execute_main_task changed from false to true
+    if (do_execute_main_task)
+        do_reset_all_once = true;
+}
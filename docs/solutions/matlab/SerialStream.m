@@ -9,6 +9,7 @@ classdef SerialStream < handle
         is_waiting_for_first_measurement
         ind_end
         num_of_floats
+        scales
         is_busy
         max_trigger_attempts
         trigger_attempts
@@ -23,16 +24,16 @@ classdef SerialStream < handle
             obj.port = port;
             obj.baudrate = baudrate;
             obj.SerialPort = serialport(obj.port, obj.baudrate);
-            obj.data = zeros(1e8, 1); % preallocate big data array
             reset(obj);
         end
 
         function reset(obj)
-            obj.data = zeros(size(obj.data));
+            obj.data = zeros(0, 1, 'uint8');
             obj.timeout = 3.0;
             obj.is_waiting_for_first_measurement = true;
             obj.ind_end = 0;
             obj.num_of_floats = 0;
+            obj.scales = []; % set if the frames are encoded with lib/TelemetryCodec
             obj.is_busy = true;
             obj.max_trigger_attempts = 5;
             obj.trigger_attempts = 0;
@@ -55,54 +56,31 @@ classdef SerialStream < handle
 
                     bytes_readable = bytes_readable - 1;
 
+                    % encoded frames, the scales follow the num_of_floats byte
+                    if (bitand(obj.num_of_floats, 128))
+                        obj.num_of_floats = bitand(obj.num_of_floats, 127);
+                        obj.scales = obj.SerialPort.read(obj.num_of_floats, 'single');
+                        bytes_readable = obj.SerialPort.NumBytesAvailable();
+                        fprintf("SerialStream receiving encoded frames\n");
+                    end
+
                     fprintf("SerialStream started, logging %d signals\n", obj.num_of_floats);
                     obj.timeout = 0.3;
 
                     obj.LoggingTimer = tic;
 
-                    % TODO: After receiving num_of_floats, the serial buffer may contain
-                    % misaligned floats if the sender was running continuously.
-                    % To make the stream robust against this, you should align the stream here.
-                    %
-                    % --- FULL ALIGNMENT CODE TEMPLATE ---
-                    %
-                    % bytes_left = obj.SerialPort.NumBytesAvailable();
-                    % misalignment = mod(bytes_left, obj.num_of_floats * 4);
-                    % if misalignment > 0
-                    %     warning('SerialStream: Discarding %d bytes to align stream', misalignment);
-                    %     obj.SerialPort.read(misalignment, 'uint8');
-                    % end
-                    %
-                    % % Optionally: Read 1 full record immediately to force alignment and
-                    % % guarantee correct first time step.
-                    % if obj.SerialPort.NumBytesAvailable() >= obj.num_of_floats * 4
-                    %     data_raw = obj.SerialPort.read(obj.num_of_floats, 'single');
-                    %     ind_start = obj.ind_end + 1;
-                    %     obj.ind_end = ind_start + obj.num_of_floats - 1;
-                    %     obj.data(ind_start:obj.ind_end) = double(data_raw);
-                    %     obj.Timer = tic;
-                    % end
-                    %
-                    % --- END OF ALIGNMENT CODE TEMPLATE ---
-                    %
-                    % This prevents reshape errors and ensures that all data is read in complete records.
-                    % (See matching logic used in your SD card reader and Python SerialStream class.)
-                    %
-                    % CURRENT STATE: Alignment not implemented yet -> possible risk of corrupted data if stream is misaligned.
+                    % frames are never split or interleaved by the sender, so the stream is aligned to the frames
                 end
 
                 % Normal streaming: read data
-                if (bytes_readable >= 4)
-                    num_of_floats_readable = floor(bytes_readable / 4);
-                    if (num_of_floats_readable > 0)
-                        data_raw = obj.SerialPort.read(num_of_floats_readable, 'single');
-
-                        ind_start = obj.ind_end + 1;
-                        obj.ind_end = ind_start + num_of_floats_readable - 1;
-                        obj.data(ind_start:obj.ind_end) = double(data_raw);
-
-                        obj.Timer = tic;
+                if (bytes_readable > 0)
+                    obj.data = [obj.data; obj.SerialPort.read(bytes_readable, 'uint8').'];
+                    if (isempty(obj.scales))
+                        obj.ind_end = floor(length(obj.data) / obj.frameSize());
+                    else
+                        obj.ind_end = length(obj.data);
                     end
+                    obj.Timer = tic;
                 end
 
                 % Logging print (every 2 sec)
@@ -126,7 +104,11 @@ classdef SerialStream < handle
                         else
                             fprintf("SerialStream ended with %0.2f seconds timeout\n", obj.timeout);
                             fprintf("             logged for %0.2f seconds\n", round(logging_time));
-                            fprintf("             measured %d datapoints\n", obj.ind_end);
+                            if (isempty(obj.scales))
+                                fprintf("             measured %d frames\n", obj.ind_end);
+                            else
+                                fprintf("             measured %d bytes\n", obj.ind_end);
+                            end
                         end
                         obj.is_busy = false;
                         break;
@@ -147,13 +129,37 @@ classdef SerialStream < handle
         end
 
         function data = getData(obj)
-            % Only use complete rows:
-            valid_length = floor(obj.ind_end / obj.num_of_floats) * obj.num_of_floats;
-
-            data.values = reshape(obj.data(1:valid_length), [obj.num_of_floats, valid_length/obj.num_of_floats]).';
+            % Only use complete frames, every frame starts with the sequence number (uint16) and the number
+            % of dropped frames (uint16), see lib/SerialStream/SerialStream.cpp
+            if (isempty(obj.scales))
+                frame_size = obj.frameSize();
+                num_of_frames = floor(length(obj.data) / frame_size);
+                frames = reshape(obj.data(1:num_of_frames*frame_size), [frame_size, num_of_frames]);
+                values = double(reshape(typecast(reshape(frames(5:end,:), [], 1), 'single'), [obj.num_of_floats, num_of_frames]).');
+            else
+                % encoded frames have different lengths, frames dropped by the sender were never
+                % encoded, so the differences stay valid
+                [values, frames] = telemetry_decode(obj.data, obj.scales, 4);
+                frames = frames.';
+                num_of_frames = size(values, 1);
+            end
+            seq = double(typecast(reshape(frames(1:2,:), [], 1), 'uint16'));
+            dropped = double(typecast(reshape(frames(3:4,:), [], 1), 'uint16'));
+
+            % Place the frames according to their sequence number, dropped frames are NaN so plots show the gaps:
+            ind = [1; 1 + cumsum(mod(diff(seq), 65536))];
+            data.values = nan(ind(end), obj.num_of_floats);
+            data.values(ind,:) = values;
+            data.num_of_lost_frames = size(data.values, 1) - num_of_frames;
+            if (data.num_of_lost_frames > 0)
+                fprintf("SerialStream: %d frames missing, %d of them dropped by the sender\n", ...
+                    data.num_of_lost_frames, mod(dropped(end) - dropped(1), 65536));
+            end
 
-            % Extract time (assumes first column is delta time):
-            data.time = cumsum(data.values(:,1)) * 1e-6;
+            % Extract time (assumes first column is delta time), the median is used for missing frames:
+            dtime = data.values(:,1);
+            dtime(isnan(dtime)) = median(dtime, 'omitnan');
+            data.time = cumsum(dtime) * 1e-6;
             data.time = data.time - data.time(1);
 
             % Remove delta time column:
@@ -164,6 +170,10 @@ classdef SerialStream < handle
 %%
     methods (Access = private)
 
+        function frame_size = frameSize(obj)
+            frame_size = 4 + 4 * double(obj.num_of_floats);
+        end
+
         function sendStartByte(obj, start_byte)
             if (~exist('start_byte', 'var') || isempty(start_byte))
                 start_byte = 255;
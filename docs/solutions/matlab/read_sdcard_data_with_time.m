@@ -10,8 +10,16 @@ function data = read_sdcard_data_with_time(file_name)
     num_of_floats = fread(file_id, 1, 'uint8');
     fprintf('   Number of floats: %d\n', num_of_floats);
     
-    % extract raw data
-    data_raw = fread(file_id, 'single');
+    % extract raw data, decode it if the SDLogger used the TelemetryCodec
+    if (bitand(num_of_floats, 128))
+        num_of_floats = bitand(num_of_floats, 127);
+        fprintf('   Encoded with scales\n');
+        scales = fread(file_id, num_of_floats, 'single');
+        values = telemetry_decode(fread(file_id, inf, 'uint8=>uint8'), scales, 0);
+        data_raw = reshape(values.', [], 1);
+    else
+        data_raw = fread(file_id, 'single');
+    end
     fprintf('   Raw data length: %d\n', length(data_raw));
     
     % close the file
@@ -0,0 +1,102 @@
+function [values, frame_headers] = telemetry_decode(data, scales, frame_header_size)
+    % decodes the records of lib/TelemetryCodec, see lib/TelemetryCodec/TelemetryCodec.h
+    %
+    % data:              bytes after the header (num_of_floats byte and scales)
+    % scales:            resolution per LSB of every channel, 0 is a raw float channel
+    % frame_header_size: bytes in front of every record, 4 for the SerialStream (sequence number and
+    %                    number of dropped frames), 0 for the SDLogger
+    %
+    % values:            one row per record, records in front of the first keyframe are nan
+    % frame_headers:     the frame header bytes of every record
+
+    data = uint8(data(:));
+    scales = double(scales(:)).';
+    num_of_floats = length(scales);
+    num_of_bytes = length(data);
+
+    % preallocate for the shortest possible records (1 byte per quantised channel)
+    record_size_min = frame_header_size + 1 + sum(scales ~= 0) + 4 * sum(scales == 0);
+    num_of_records_max = floor(num_of_bytes / record_size_min);
+    values = nan(num_of_records_max, num_of_floats);
+    frame_headers = zeros(num_of_records_max, frame_header_size, 'uint8');
+
+    values_past = zeros(1, num_of_floats);
+    is_valid = false;
+    pos = 1;
+    k = 0;
+    while (pos + frame_header_size <= num_of_bytes)
+        header = data(pos:pos+frame_header_size-1).';
+        p = pos + frame_header_size;
+        record_type = data(p);
+        p = p + 1;
+        if (record_type > 1)
+            fprintf('   telemetry_decode: invalid record type %d\n', record_type);
+            break;
+        end
+
+        record = zeros(1, num_of_floats);
+        is_complete = true;
+        for i = 1:num_of_floats
+            if (scales(i) == 0)
+                % raw float
+                if (p + 3 > num_of_bytes)
+                    is_complete = false;
+                    break;
+                end
+                record(i) = double(typecast(data(p:p+3), 'single'));
+                p = p + 4;
+                continue;
+            end
+
+            % varint, 7 bits per byte, MSB set if another byte follows
+            val = 0;
+            shift = 0;
+            while true
+                if (p > num_of_bytes)
+                    is_complete = false;
+                    break;
+                end
+                byte = double(data(p));
+                p = p + 1;
+                val = val + mod(byte, 128) * 2^shift;
+                shift = shift + 7;
+                if (byte < 128)
+                    break;
+                end
+            end
+            if (~is_complete)
+                break;
+            end
+
+            % zigzag: 0, 1, 2, 3, 4, ... -> 0, -1, 1, -2, 2, ...
+            if (mod(val, 2) == 0)
+                val = val / 2;
+            else
+                val = -(val + 1) / 2;
+            end
+            if (record_type == 0)
+                val = val + values_past(i);
+            end
+            % wrap around like the int32 arithmetic of the encoder
+            val = mod(val + 2^31, 2^32) - 2^31;
+            values_past(i) = val;
+            record(i) = val * scales(i);
+        end
+        if (~is_complete)
+            break; % incomplete last record
+        end
+
+        if (record_type == 1)
+            is_valid = true;
+        end
+        k = k + 1;
+        if (is_valid)
+            values(k,:) = record;
+        end
+        frame_headers(k,:) = header;
+        pos = p;
+    end
+
+    values = values(1:k,:);
+    frame_headers = frame_headers(1:k,:);
+end
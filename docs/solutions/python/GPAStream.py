@@ -0,0 +1,116 @@
+import serial
+import struct
+import time
+import numpy as np
+
+
+# frame layout, see GPA::queueFrame() in lib/GPA/GPA.cpp:
+# sync_0, sync_1, num of outputs (uint8), ind (uint16), fexc, Ureal, Uimag, Yreal, Yimag, Rreal, Rimag, avg_time,
+# Yreal and Yimag of the additional outputs (float32), crc16 over everything after the sync bytes (uint16)
+SYNC_0 = 0xA5
+SYNC_1 = 0x5A
+HEADER_LENGTH = 5
+NUM_OF_OUTPUTS_MAX = 3
+
+
+def crc16(data):
+    # crc-16/ccitt-false, poly 0x1021, init 0xffff
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def frame_length(num_of_outputs):
+    return HEADER_LENGTH + 4 * (8 + 2 * (num_of_outputs - 1)) + 2
+
+
+class GPAStream:
+    def __init__(self, port, baudrate):
+        self.port = port
+        self.baudrate = baudrate
+        self.SerialPort = serial.Serial(self.port, self.baudrate)
+        self.reset()
+
+    def reset(self):
+        self.timeout = 30.0  # the low frequency points take several seconds
+        self.buffer = bytearray()
+        self.rows = []
+        self.ind_last = -1
+        self.num_of_crc_errors = 0
+        self.num_of_lost_frames = 0
+        self.is_busy = True
+        self.Timer = time.time()
+
+    def start(self):
+        self.SerialPort.reset_input_buffer()
+        print(f"GPAStream waiting for {self.timeout:.2f} seconds per frequency point...")
+
+        while True:
+            bytes_readable = self.SerialPort.in_waiting
+            if bytes_readable > 0:
+                self.buffer += self.SerialPort.read(bytes_readable)
+                self.decode()
+
+            # Timeout check:
+            if time.time() - self.Timer > self.timeout:
+                print(f"GPAStream ended with {self.timeout:.2f} seconds timeout")
+                print(f"          received {len(self.rows)} frequency points")
+                print(f"          {self.num_of_crc_errors} crc errors, {self.num_of_lost_frames} lost frames")
+                self.is_busy = False
+                break
+
+            # Avoid burning CPU:
+            time.sleep(0.01)
+
+    def decode(self):
+        while True:
+            # search the sync bytes, everything in front of them is discarded
+            ind_sync = self.buffer.find(bytes([SYNC_0, SYNC_1]))
+            if ind_sync < 0:
+                # keep the last byte, it could be the first sync byte
+                del self.buffer[:-1]
+                return
+            del self.buffer[:ind_sync]
+
+            if len(self.buffer) < HEADER_LENGTH:
+                return
+            num_of_outputs = self.buffer[2]
+            if num_of_outputs < 1 or num_of_outputs > NUM_OF_OUTPUTS_MAX:
+                # not a valid header, skip the sync bytes
+                del self.buffer[:2]
+                continue
+            length = frame_length(num_of_outputs)
+            if len(self.buffer) < length:
+                return
+
+            frame = bytes(self.buffer[:length])
+            (crc,) = struct.unpack_from("<H", frame, length - 2)
+            if crc != crc16(frame[2 : length - 2]):
+                self.num_of_crc_errors += 1
+                del self.buffer[:2]
+                continue
+            del self.buffer[:length]
+
+            (ind,) = struct.unpack_from("<H", frame, 3)
+            values = struct.unpack_from(f"<{(length - HEADER_LENGTH - 2) // 4}f", frame, HEADER_LENGTH)
+            if self.ind_last >= 0 and ind != self.ind_last + 1:
+                self.num_of_lost_frames += ind - self.ind_last - 1
+            self.ind_last = ind
+
+            # same columns as the printed data: fexc, U, Y, R, avg_time, ind, additional Y
+            row = list(values[:8]) + [ind] + list(values[8:])
+            self.rows.append(row)
+            print(f"          {values[0]:10.4f} Hz, point {ind}")
+            self.Timer = time.time()
+
+    def is_busy_flag(self):
+        return self.is_busy
+
+    def get_data(self):
+        if len(self.rows) == 0:
+            return np.zeros((0, 9))
+        return np.array(self.rows)
@@ -2,6 +2,13 @@ import serial
 import time
 import math
 import numpy as np
+import struct
+from TelemetryCodec import TelemetryDecoder, is_encoded, read_scales
+
+
+# every frame starts with the sequence number (uint16) and the number of dropped frames (uint16),
+# followed by num_of_floats floats, see lib/SerialStream/SerialStream.cpp
+FRAME_HEADER_SIZE = 4
 
 
 class SerialStream:
@@ -9,15 +16,15 @@ class SerialStream:
         self.port = port
         self.baudrate = baudrate
         self.SerialPort = serial.Serial(self.port, self.baudrate)
-        self.data = np.zeros(int(1e8))  # preallocate big data array
         self.reset()
 
     def reset(self):
-        self.data = np.zeros_like(self.data)
+        self.data = bytearray()
         self.timeout = 3.0
         self.is_waiting_for_first_measurement = True
         self.ind_end = 0
         self.num_of_floats = 0
+        self.scales = None  # set if the frames are encoded with lib/TelemetryCodec
         self.is_busy = True
         self.max_trigger_attempts = 5
         self.trigger_attempts = 0
@@ -39,52 +46,25 @@ class SerialStream:
 
                 bytes_readable -= 1
 
+                # encoded frames, the scales follow the num_of_floats byte
+                if is_encoded(self.num_of_floats):
+                    self.num_of_floats &= 0x7F
+                    self.scales, _ = read_scales(self.SerialPort.read(4 * self.num_of_floats), 0, self.num_of_floats)
+                    bytes_readable = self.SerialPort.in_waiting
+                    print(f"SerialStream receiving encoded frames, scales {self.scales}")
+
                 print(f"SerialStream started, logging {self.num_of_floats} signals")
                 self.timeout = 0.3
 
                 self.LoggingTimer = time.time()
 
-                # TODO: After receiving num_of_floats, the serial buffer may contain
-                # misaligned floats if the sender was running continuously.
-                # To make the stream robust against this, you should align the stream here.
-                #
-                # --- FULL ALIGNMENT CODE TEMPLATE ---
-                #
-                # bytes_left = self.SerialPort.in_waiting
-                # misalignment = bytes_left % (self.num_of_floats * 4)
-                # if misalignment > 0:
-                #     print(f"WARNING: SerialStream: Discarding {misalignment} bytes to align stream")
-                #     self.SerialPort.read(misalignment)
-                #
-                # # Optionally: Read 1 full record immediately to force alignment and
-                # # guarantee correct first time step.
-                # if self.SerialPort.in_waiting >= self.num_of_floats * 4:
-                #     data_raw = self.SerialPort.read(self.num_of_floats * 4)
-                #     data_floats = np.frombuffer(data_raw, dtype=np.float32)
-                #     ind_start = self.ind_end
-                #     self.ind_end = ind_start + self.num_of_floats
-                #     self.data[ind_start:self.ind_end] = data_floats
-                #     self.Timer = time.time()
-                #
-                # --- END OF ALIGNMENT CODE TEMPLATE ---
-                #
-                # This prevents reshape errors and ensures that all data is read in complete records.
-                # (See matching logic used in your SD card reader and Python SerialStream class.)
-                #
-                # CURRENT STATE: Alignment not implemented yet -> possible risk of corrupted data if stream is misaligned.
+                # frames are never split or interleaved by the sender, so the stream is aligned to the frames
 
             # Normal operation: read data
-            if bytes_readable >= 4:
-                num_of_floats_readable = math.floor(bytes_readable / 4)
-                if num_of_floats_readable > 0:
-                    data_raw = self.SerialPort.read(int(num_of_floats_readable * 4))
-                    data_floats = np.frombuffer(data_raw, dtype=np.float32)
-
-                    ind_start = self.ind_end + 1  # Match MATLAB 1-based indexing logic
-                    self.ind_end = ind_start + num_of_floats_readable - 1
-                    self.data[ind_start - 1 : self.ind_end] = data_floats[:num_of_floats_readable]
-
-                    self.Timer = time.time()
+            if bytes_readable > 0:
+                self.data += self.SerialPort.read(bytes_readable)
+                self.ind_end = len(self.data) // self.frame_size() if self.scales is None else len(self.data)
+                self.Timer = time.time()
 
             # Logging print (every 2 sec)
             if not self.is_waiting_for_first_measurement:
@@ -103,7 +83,7 @@ class SerialStream:
                     else:
                         print(f"SerialStream ended with {self.timeout:.2f} seconds timeout")
                         print(f"             logged for {round(logging_time):.2f} seconds")
-                        print(f"             measured {self.ind_end} datapoints")
+                        print(f"             measured {self.ind_end} {'frames' if self.scales is None else 'bytes'}")
                     self.is_busy = False
                     break
 
@@ -116,17 +96,57 @@ class SerialStream:
     def is_busy_flag(self):
         return self.is_busy
 
-    def get_data(self):
-        # Only use complete rows:
-        valid_length = (self.ind_end // self.num_of_floats) * self.num_of_floats
-        values = self.data[0:valid_length].reshape((-1, self.num_of_floats))
+    def frame_size(self):
+        return FRAME_HEADER_SIZE + 4 * self.num_of_floats
+
+    def decode_frames(self):
+        # Encoded frames have different lengths, so they are decoded one after the other
+        decoder = TelemetryDecoder(self.scales)
+        frames = []
+        pos = 0
+        while True:
+            try:
+                # frames dropped by the sender were never encoded, so the differences stay valid
+                seq, dropped = struct.unpack_from("<HH", self.data, pos)
+                values, pos = decoder.decode(self.data, pos + 4)
+            except (IndexError, struct.error):
+                break  # incomplete last frame
+            except ValueError as e:
+                print(e)
+                break
+            frames.append((seq, dropped, values if values is not None else [np.nan] * self.num_of_floats))
+        frame_dtype = np.dtype([("seq", "<u2"), ("dropped", "<u2"), ("values", "<f8", (self.num_of_floats,))])
+        return np.array(frames, dtype=frame_dtype)
 
-        # Extract time (assumes first column is delta time):
-        time_array = np.cumsum(values[:, 0]) * 1e-6
+    def get_data(self):
+        if self.scales is not None:
+            frames = self.decode_frames()
+        else:
+            # Only use complete frames:
+            frame_dtype = np.dtype([("seq", "<u2"), ("dropped", "<u2"), ("values", "<f4", (self.num_of_floats,))])
+            valid_length = (len(self.data) // self.frame_size()) * self.frame_size()
+            frames = np.frombuffer(bytes(self.data[0:valid_length]), dtype=frame_dtype)
+        if frames.shape[0] == 0:
+            return {"time": np.zeros(0), "values": np.zeros((0, max(self.num_of_floats - 1, 0))), "num_of_lost_frames": 0}
+
+        # Place the frames according to their sequence number, dropped frames are NaN so plots show the gaps:
+        seq_diff = np.diff(frames["seq"].astype(np.int64)) % 65536
+        ind = np.concatenate(([0], np.cumsum(seq_diff)))
+        values = np.full((ind[-1] + 1, self.num_of_floats), np.nan)
+        values[ind] = frames["values"]
+        num_of_lost_frames = int(values.shape[0] - frames.shape[0])
+        num_of_dropped_frames = int((frames["dropped"][-1].astype(np.int64) - frames["dropped"][0]) % 65536)
+        if num_of_lost_frames > 0:
+            print(f"SerialStream: {num_of_lost_frames} frames missing, {num_of_dropped_frames} of them dropped by the sender")
+
+        # Extract time (assumes first column is delta time), the median is used for missing frames:
+        dtime = values[:, 0].copy()
+        dtime[np.isnan(dtime)] = np.nanmedian(dtime)
+        time_array = np.cumsum(dtime) * 1e-6
         time_array = time_array - time_array[0]
 
         # Remove delta time column:
-        return {"time": time_array, "values": values[:, 1:]}
+        return {"time": time_array, "values": values[:, 1:], "num_of_lost_frames": num_of_lost_frames}
 
     def send_start_byte(self, start_byte=255):
         # Flush serial port to ensure no old data is left
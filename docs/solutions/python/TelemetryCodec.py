@@ -0,0 +1,86 @@
+import struct
+
+
+# decoder for the records of lib/TelemetryCodec, see lib/TelemetryCodec/TelemetryCodec.h:
+# header: num_of_floats (uint8) with HEADER_FLAG set, scales (float32), a scale of 0 is a raw float channel
+# record: record type (uint8, DELTA or KEYFRAME), per channel a zigzag varint or a raw float32
+HEADER_FLAG = 0x80
+DELTA = 0
+KEYFRAME = 1
+
+
+def is_encoded(first_byte):
+    return (first_byte & HEADER_FLAG) != 0
+
+
+def read_scales(data, pos, num_of_floats):
+    return list(struct.unpack_from(f"<{num_of_floats}f", data, pos)), pos + 4 * num_of_floats
+
+
+class TelemetryDecoder:
+    def __init__(self, scales):
+        self.scales = scales
+        self.reset()
+
+    def reset(self):
+        # no keyframe received yet, differences can not be decoded
+        self.values_past = [0] * len(self.scales)
+        self.is_valid = False
+
+    def decode(self, data, pos):
+        # decodes the record at pos, returns the values (None if the record can not be decoded) and the
+        # position of the next record, raises IndexError if the record is incomplete
+        record_type = data[pos]
+        pos += 1
+        if record_type not in (DELTA, KEYFRAME):
+            raise ValueError(f"TelemetryDecoder: invalid record type {record_type}")
+        is_keyframe = record_type == KEYFRAME
+
+        values = [0.0] * len(self.scales)
+        for i, scale in enumerate(self.scales):
+            if scale == 0.0:
+                (values[i],) = struct.unpack_from("<f", data, pos)
+                pos += 4
+                continue
+            val_zigzag, pos = self.read_varint(data, pos)
+            val = (val_zigzag >> 1) ^ -(val_zigzag & 1)
+            if not is_keyframe:
+                val += self.values_past[i]
+            # wrap around like the int32 arithmetic of the encoder
+            val = (val + 2**31) % 2**32 - 2**31
+            self.values_past[i] = val
+            values[i] = val * scale
+
+        if is_keyframe:
+            self.is_valid = True
+        return (values if self.is_valid else None), pos
+
+    @staticmethod
+    def read_varint(data, pos):
+        val = 0
+        shift = 0
+        while True:
+            byte = data[pos]
+            pos += 1
+            val |= (byte & 0x7F) << shift
+            shift += 7
+            if byte < 0x80:
+                return val, pos
+
+
+def decode_records(data, num_of_floats):
+    # decodes consecutive records like the SDLogger writes them, data starts with the scales, records that
+    # can not be decoded are nan, returns a list with one list of values per record
+    scales, pos = read_scales(data, 0, num_of_floats)
+    decoder = TelemetryDecoder(scales)
+    records = []
+    while pos < len(data):
+        try:
+            values, pos = decoder.decode(data, pos)
+        except (IndexError, struct.error):
+            break  # incomplete last record
+        except ValueError as e:
+            print(e)
+            break
+        records.append(values if values is not None else [float("nan")] * num_of_floats)
+    return records
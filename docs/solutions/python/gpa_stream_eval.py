@@ -0,0 +1,77 @@
+# conda create --name pes-env python=3.11.4 numpy scipy matplotlib pyserial control ipykernel
+
+import os
+import time
+import numpy as np
+import matplotlib.pyplot as plt
+from GPAStream import GPAStream
+
+
+port = "/dev/ttyUSB0"  # "COM12"
+baudrate = int(2e6)
+
+# Initialize the GPAStream object
+try:
+    gpaStream.reset()
+    print("Resetting existing gpaStream object.")
+except Exception as e:
+    gpaStream = GPAStream(port, baudrate)
+    print("Creating new gpaStream object.")
+
+# Receiving the frequency points, start the measurement on the nucleo after this
+gpaStream.start()
+while gpaStream.is_busy_flag():
+    time.sleep(0.1)
+
+# Accessing the data
+data = gpaStream.get_data()
+if data.shape[0] == 0:
+    print("No frequency points received.")
+    exit()
+
+# Save the data
+file_name = os.path.join("docs", "solutions", "python", "data_gpa_00.npz")
+np.savez(file_name, data=data)
+
+# Load the data
+data = np.load(file_name)["data"]
+
+# Evaluate the data
+
+# Defining the indices for the data columns
+f = data[:, 0]
+U = data[:, 1] + 1j * data[:, 2]
+Y = data[:, 3] + 1j * data[:, 4]
+R = data[:, 5] + 1j * data[:, 6]
+
+# frequency responses, see lib/GPA/GPA.cpp for the closed loop calculus
+frf = {}
+frf["P"] = Y / U
+frf["T"] = Y / R
+# additional outputs, e.g. the control error for DCMotor gives the sensitivity function
+for ch in range(1, (data.shape[1] - 9) // 2 + 1):
+    Y_ch = data[:, 9 + 2 * (ch - 1)] + 1j * data[:, 10 + 2 * (ch - 1)]
+    frf[f"Y{ch}/R"] = Y_ch / R
+
+plt.figure(1)
+ax1 = plt.subplot(2, 1, 1)
+for name, G in frf.items():
+    plt.semilogx(f, 20 * np.log10(np.abs(G)), label=name)
+plt.grid(True, which="both")
+plt.ylabel("Magnitude (dB)")
+plt.legend()
+plt.subplot(2, 1, 2, sharex=ax1)
+for name, G in frf.items():
+    plt.semilogx(f, np.angle(G) * 180 / np.pi, label=name)
+plt.grid(True, which="both")
+plt.xlabel("Frequency (Hz)")
+plt.ylabel("Phase (deg)")
+
+plt.figure(2)
+plt.semilogx(f, data[:, 7])
+plt.grid(True, which="both")
+plt.xlabel("Frequency (Hz)")
+plt.ylabel("T avg. (mus)")
+
+# Show all plots
+plt.show()
@@ -3,13 +3,14 @@
 import os
 import numpy as np
 import matplotlib.pyplot as plt
+from TelemetryCodec import decode_records, is_encoded
 
 
 def read_sdcard_data(file_name):
     """
     1) Reads the first byte as the number of floats per record.
     2) Reads the remaining data as float32 and truncates to a multiple
-        of num_of_floats.
+        of num_of_floats, or decodes it if the SDLogger used the TelemetryCodec.
     3) Reshapes into (num_records, num_of_floats).
     4) The first column is delta time in microseconds -> convert to
         cumulative time in seconds.
@@ -29,10 +30,17 @@ def read_sdcard_data(file_name):
         if len(num_of_floats_array) == 0:
             raise ValueError("File is empty or not in the expected format.")
         num_of_floats = int(num_of_floats_array[0])
-        print(f"   Number of floats: {num_of_floats}")
 
-        # Read the remaining data as float32
-        data_raw = np.fromfile(f, dtype=np.float32)
+        if is_encoded(num_of_floats):
+            # Decode the records, the scales follow the first byte
+            num_of_floats &= 0x7F
+            print(f"   Number of floats: {num_of_floats} (encoded)")
+            data_raw = np.array(decode_records(f.read(), num_of_floats)).reshape(-1)
+        else:
+            print(f"   Number of floats: {num_of_floats}")
+
+            # Read the remaining data as float32
+            data_raw = np.fromfile(f, dtype=np.float32)
         print(f"   Raw data length: {len(data_raw)}")
 
     # Truncate to a multiple of num_of_floats
@@ -0,0 +1,52 @@
+/*
+ * EncoderCounter.cpp
+ * Copyright (c) 2018, ZHAW
+ * All rights reserved.
+ */
+
+#include "EncoderCounter.h"
+
+/**
+ * Creates the encoder counter on the simulated encoder of channel A.
+ * @param a the input pin for the channel A.
+ * @param b the input pin for the channel B.
+ */
+EncoderCounter::EncoderCounter(PinName a, PinName b) : m_pin_a(a), m_offset(0)
+{
+}
+
+EncoderCounter::~EncoderCounter() {}
+
+/**
+ * Resets the counter value to zero.
+ */
+void EncoderCounter::reset()
+{
+    reset(0);
+}
+
+/**
+ * Resets the counter value to a given offset value.
+ * @param offset the offset value to reset the counter to.
+ */
+void EncoderCounter::reset(int16_t offset)
+{
+    m_offset = static_cast<int16_t>(offset - mbed_host::getEncoder(m_pin_a));
+}
+
+/**
+ * Reads the quadrature encoder counter value.
+ * @return the quadrature encoder counter as a signed 16-bit integer value.
+ */
+int16_t EncoderCounter::read()
+{
+    return static_cast<int16_t>(mbed_host::getEncoder(m_pin_a) + m_offset);
+}
+
+/**
+ * The empty operator is a shorthand notation of the <code>read()</code> method.
+ */
+EncoderCounter::operator int16_t()
+{
+    return read();
+}
@@ -0,0 +1,37 @@
+/*
+ * EncoderCounter.h
+ * Copyright (c) 2018, ZHAW
+ * All rights reserved.
+ */
+
+#ifndef ENCODER_COUNTER_H_
+#define ENCODER_COUNTER_H_
+
+#include <cstdlib>
+#include <stdint.h>
+#include "mbed.h"
+
+/**
+ * This class implements the encoder counter of the host build, same interface as lib/EncoderCounter.
+ * The count is the encoder of channel A in the simulation, set it with mbed_host::setEncoder(a, count)
+ * or mbed_host::setEncoderSource(a, source).
+ */
+class EncoderCounter
+{
+
+public:
+
+    explicit EncoderCounter(PinName a, PinName b);
+    virtual     ~EncoderCounter();
+    void        reset();
+    void        reset(int16_t offset);
+    int16_t     read();
+    operator int16_t();
+
+private:
+
+    PinName     m_pin_a;
+    int16_t     m_offset;
+};
+
+#endif /* ENCODER_COUNTER_H_ */
@@ -0,0 +1,85 @@
+#include "FastPWM.h"
+
+// ticks of the timer of the target at the default prescaler 1, 180 MHz
+#define FAST_PWM_TICKS_PER_US 180.0
+
+FastPWM::FastPWM(PinName pin, int prescaler) : PwmOut(pin)
+{
+    period_mus(20000);
+}
+
+FastPWM::~FastPWM()
+{
+}
+
+void FastPWM::period(double seconds)
+{
+    _period_us = 1.0e6 * seconds;
+    PwmOut::period(static_cast<float>(seconds));
+}
+
+void FastPWM::period_ms(int ms)
+{
+    period(1.0e-3 * ms);
+}
+
+void FastPWM::period_mus(int us)
+{
+    period(1.0e-6 * us);
+}
+
+void FastPWM::period_ticks(uint32_t ticks)
+{
+    period(1.0e-6 * ticks / FAST_PWM_TICKS_PER_US);
+}
+
+void FastPWM::pulsewidth(double seconds)
+{
+    write(1.0e6 * seconds / _period_us);
+}
+
+void FastPWM::pulsewidth_ms(int ms)
+{
+    write(1.0e3 * ms / _period_us);
+}
+
+void FastPWM::pulsewidth_us(int us)
+{
+    write(static_cast<double>(us) / _period_us);
+}
+
+void FastPWM::pulsewidth_us(double us)
+{
+    write(us / _period_us);
+}
+
+void FastPWM::pulsewidth_ticks(uint32_t ticks)
+{
+    write(ticks / FAST_PWM_TICKS_PER_US / _period_us);
+}
+
+void FastPWM::write(double duty)
+{
+    PwmOut::write(static_cast<float>(duty));
+}
+
+double FastPWM::read(void)
+{
+    return PwmOut::read();
+}
+
+FastPWM& FastPWM::operator=(double value)
+{
+    write(value);
+    return *this;
+}
+
+FastPWM::operator double()
+{
+    return read();
+}
+
+int FastPWM::prescaler(int value)
+{
+    return 1;
+}
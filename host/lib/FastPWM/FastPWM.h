@@ -0,0 +1,45 @@
+/**
+ * @file FastPWM.h
+ * @brief FastPWM of the host build, same interface as lib/FastPWM on the simulated PwmOut.
+ *
+ * The duty cycle is the value of the pin in the simulation, read it with mbed_host::getPwm(pin).
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#include "mbed.h"
+
+#ifndef FASTPWM_H
+#define FASTPWM_H
+
+class FastPWM : public PwmOut
+{
+public:
+    FastPWM(PinName pin, int prescaler = -1);
+    ~FastPWM();
+
+    void period(double seconds);
+    void period(float seconds) { period(static_cast<double>(seconds)); }
+    void period_ms(int ms);
+    void period_mus(int us);
+    void period_ticks(uint32_t ticks);
+
+    void pulsewidth(double seconds);
+    void pulsewidth_ms(int ms);
+    void pulsewidth_us(int us);
+    void pulsewidth_us(double us);
+    void pulsewidth_ticks(uint32_t ticks);
+
+    void write(double duty);
+    void write(float duty) { write(static_cast<double>(duty)); }
+    double read(void);
+
+    FastPWM& operator=(double value);
+    operator double();
+
+    int prescaler(int value);
+
+private:
+    double _period_us;
+};
+#endif
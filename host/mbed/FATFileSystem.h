@@ -0,0 +1,48 @@
+/**
+ * @file FATFileSystem.h
+ * @brief File system of the host build, mounted on the directory of the sd card (see mbed_host.h).
+ *
+ * On the target the file system is mounted as "/sd" and files are opened with the C library, e.g.
+ * fopen("/sd/data/000.bin", "wb"). To keep the drivers unchanged the calls that take a path are mapped
+ * to the host directory in the files that include this header.
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef MBED_HOST_FAT_FILE_SYSTEM_H_
+#define MBED_HOST_FAT_FILE_SYSTEM_H_
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mbed.h"
+#include "SDBlockDevice.h"
+
+class FATFileSystem
+{
+public:
+    explicit FATFileSystem(const char* name, BlockDevice* bd = nullptr) : m_name(name) {}
+    virtual ~FATFileSystem() = default;
+
+    // creates the directory of the sd card, returns 0 on success
+    int mount(BlockDevice* bd);
+    int unmount() { return 0; }
+
+private:
+    const char* m_name;
+};
+
+namespace mbed_host {
+FILE* sdFopen(const char* path, const char* mode);
+DIR* sdOpendir(const char* path);
+int sdMkdir(const char* path, mode_t mode);
+} // namespace mbed_host
+
+#define fopen(path, mode) mbed_host::sdFopen(path, mode)
+#define opendir(path) mbed_host::sdOpendir(path)
+#define mkdir(path, mode) mbed_host::sdMkdir(path, mode)
+
+#endif /* MBED_HOST_FAT_FILE_SYSTEM_H_ */
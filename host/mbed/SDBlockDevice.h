@@ -0,0 +1,33 @@
+/**
+ * @file SDBlockDevice.h
+ * @brief Sd card of the host build, the data is stored in a directory (see mbed_host.h).
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef MBED_HOST_SD_BLOCK_DEVICE_H_
+#define MBED_HOST_SD_BLOCK_DEVICE_H_
+
+#include "mbed.h"
+
+class BlockDevice
+{
+public:
+    virtual ~BlockDevice() = default;
+    virtual int init() = 0;
+    virtual int deinit() = 0;
+};
+
+class SDBlockDevice : public BlockDevice
+{
+public:
+    SDBlockDevice(PinName mosi, PinName miso, PinName sclk, PinName cs, uint64_t hz = 1000000, bool crc_on = false) {}
+    virtual ~SDBlockDevice() = default;
+
+    int init() override { return 0; }
+    int deinit() override { return 0; }
+    int frequency(uint64_t freq) { return 0; }
+    uint64_t size() const { return 0; }
+};
+
+#endif /* MBED_HOST_SD_BLOCK_DEVICE_H_ */
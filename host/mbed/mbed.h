@@ -0,0 +1,686 @@
+/**
+ * @file mbed.h
+ * @brief Minimal mbed OS 6 API for building the drivers of lib/ on a POSIX host.
+ *
+ * Only the part of mbed that the drivers use is provided, with the same names and signatures, so the
+ * sources in lib/ compile unchanged against it:
+ * - Thread, ThisThread, Mutex, Semaphore and EventQueue on cooperative threads (ucontext)
+ * - Ticker, Timeout, Timer and Kernel::Clock in virtual time
+ * - DigitalIn/Out, InterruptIn, AnalogIn and PwmOut on simulated pins
+ * - I2C (blocking and asynchronous) on simulated devices
+ * - SerialBase and BufferedSerial on a pseudo terminal
+ *
+ * Threads are never preempted, a thread runs until it waits (thread flags, sleep, mutex, semaphore)
+ * or wakes a thread with a higher priority. Virtual time only advances while all threads wait, then
+ * the next timed event (ticker, timeout, I2C transfer, ...) is executed in interrupt context. Code
+ * takes no virtual time, so a control loop runs as if the mcu was infinitely fast, but as fast as the
+ * host can execute it. The simulation is driven with the functions of mbed_host.h.
+ *
+ * Differences to the target that matter for drivers:
+ * - busy waiting on a flag that is set by an interrupt never terminates, use thread flags
+ * - wait_us() sleeps in virtual time in a thread and returns immediately in interrupt context
+ * - events of an EventQueue are executed in interrupt context
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef MBED_HOST_MBED_H_
+#define MBED_HOST_MBED_H_
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "PinNames.h"
+
+#define MBED_HOST 1
+
+#define MBED_MAJOR_VERSION 6
+#define MBED_MINOR_VERSION 17
+#define MBED_PATCH_VERSION 0
+
+#define DEVICE_I2C 1
+#define DEVICE_I2C_ASYNCH 1
+#define DEVICE_SERIAL 1
+#define DEVICE_ANALOGIN 1
+#define DEVICE_PWMOUT 1
+#define DEVICE_INTERRUPTIN 1
+
+#define OS_STACK_SIZE 4096
+
+#define MBED_ASSERT(expr) ((expr) ? (void)0 : mbed_host::assertFailed(#expr, __FILE__, __LINE__))
+#define MBED_STATIC_ASSERT(expr, msg) static_assert(expr, msg)
+
+namespace mbed_host {
+struct Fiber;
+[[noreturn]] void assertFailed(const char* expr, const char* file, int line);
+} // namespace mbed_host
+
+// cmsis-rtos2 types used by the drivers
+
+typedef enum {
+    osPriorityNone = 0,
+    osPriorityIdle = 1,
+    osPriorityLow = 8,
+    osPriorityLow1 = 9,
+    osPriorityLow2 = 10,
+    osPriorityBelowNormal = 16,
+    osPriorityBelowNormal1 = 17,
+    osPriorityBelowNormal2 = 18,
+    osPriorityNormal = 24,
+    osPriorityNormal1 = 25,
+    osPriorityNormal2 = 26,
+    osPriorityAboveNormal = 32,
+    osPriorityAboveNormal1 = 33,
+    osPriorityAboveNormal2 = 34,
+    osPriorityHigh = 40,
+    osPriorityHigh1 = 41,
+    osPriorityHigh2 = 42,
+    osPriorityRealtime = 48,
+    osPriorityRealtime1 = 49,
+    osPriorityISR = 56,
+    osPriorityError = -1
+} osPriority_t;
+typedef osPriority_t osPriority;
+
+typedef enum {
+    osOK = 0,
+    osError = -1,
+    osErrorTimeout = -2,
+    osErrorResource = -3,
+    osErrorParameter = -4
+} osStatus_t;
+typedef osStatus_t osStatus;
+
+typedef void* osThreadId_t;
+
+#define osFlagsWaitAny 0x00000000U
+#define osFlagsWaitAll 0x00000001U
+#define osFlagsNoClear 0x00000002U
+#define osFlagsError 0x80000000U
+#define osFlagsErrorUnknown 0xFFFFFFFFU
+#define osFlagsErrorTimeout 0xFFFFFFFEU
+#define osFlagsErrorResource 0xFFFFFFFDU
+#define osFlagsErrorParameter 0xFFFFFFFCU
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags);
+
+namespace mbed {
+
+// Callback
+
+template <typename F>
+class Callback;
+
+template <typename R, typename... ArgTs>
+class Callback<R(ArgTs...)>
+{
+public:
+    Callback() = default;
+    Callback(std::nullptr_t) {}
+    Callback(R (*func)(ArgTs...))
+    {
+        if (func)
+            m_func = func;
+    }
+    template <typename T, typename U>
+    Callback(U* obj, R (T::*method)(ArgTs...)) : m_func([obj, method](ArgTs... args) { return (obj->*method)(args...); })
+    {
+    }
+    template <typename T, typename U>
+    Callback(const U* obj, R (T::*method)(ArgTs...) const) : m_func([obj, method](ArgTs... args) { return (obj->*method)(args...); })
+    {
+    }
+    template <typename F,
+              typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Callback>::value &&
+                                                 std::is_convertible<decltype(std::declval<F&>()(std::declval<ArgTs>()...)), R>::value>::type>
+    Callback(F func) : m_func(std::move(func))
+    {
+    }
+
+    R call(ArgTs... args) const { return m_func(args...); }
+    R operator()(ArgTs... args) const { return m_func(args...); }
+    explicit operator bool() const { return static_cast<bool>(m_func); }
+
+private:
+    std::function<R(ArgTs...)> m_func;
+};
+
+template <typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(R (*func)(ArgTs...) = nullptr)
+{
+    return Callback<R(ArgTs...)>(func);
+}
+
+template <typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(const Callback<R(ArgTs...)>& func)
+{
+    return func;
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(U* obj, R (T::*method)(ArgTs...))
+{
+    return Callback<R(ArgTs...)>(obj, method);
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(const U* obj, R (T::*method)(ArgTs...) const)
+{
+    return Callback<R(ArgTs...)>(obj, method);
+}
+
+// critical sections are not needed, threads are not preempted and interrupts only run while all threads wait
+
+class CriticalSectionLock
+{
+public:
+    CriticalSectionLock() = default;
+    ~CriticalSectionLock() = default;
+    static void enable() {}
+    static void disable() {}
+};
+
+// time
+
+typedef uint64_t us_timestamp_t;
+
+class Timer
+{
+public:
+    Timer() = default;
+    void start();
+    void stop();
+    void reset();
+    std::chrono::microseconds elapsed_time() const;
+    int read_us() const { return static_cast<int>(elapsed_time().count()); }
+    int read_ms() const { return static_cast<int>(elapsed_time().count() / 1000); }
+    float read() const { return 1.0e-6f * static_cast<float>(elapsed_time().count()); }
+    us_timestamp_t read_high_resolution_us() const { return static_cast<us_timestamp_t>(elapsed_time().count()); }
+
+private:
+    bool m_running{false};
+    int64_t m_start_us{0};
+    int64_t m_elapsed_us{0};
+};
+
+typedef Timer LowPowerTimer;
+
+class Ticker
+{
+public:
+    Ticker() = default;
+    Ticker(const Ticker&) = delete;
+    Ticker& operator=(const Ticker&) = delete;
+    virtual ~Ticker() { detach(); }
+
+    void attach(Callback<void()> func, std::chrono::microseconds t);
+    void attach_us(Callback<void()> func, us_timestamp_t t) { attach(func, std::chrono::microseconds{t}); }
+    void detach();
+
+private:
+    void onEvent();
+
+    Callback<void()> m_func;
+    int64_t m_period_us{0};
+    int64_t m_next_us{0};
+    uint64_t m_event{0};
+};
+
+typedef Ticker LowPowerTicker;
+
+class Timeout
+{
+public:
+    Timeout() = default;
+    Timeout(const Timeout&) = delete;
+    Timeout& operator=(const Timeout&) = delete;
+    virtual ~Timeout() { detach(); }
+
+    void attach(Callback<void()> func, std::chrono::microseconds t);
+    void attach_us(Callback<void()> func, us_timestamp_t t) { attach(func, std::chrono::microseconds{t}); }
+    void detach();
+
+private:
+    void onEvent();
+
+    Callback<void()> m_func;
+    uint64_t m_event{0};
+};
+
+typedef Timeout LowPowerTimeout;
+
+// pins
+
+class DigitalOut
+{
+public:
+    explicit DigitalOut(PinName pin, int value = 0);
+    void write(int value);
+    int read();
+    int is_connected() { return m_pin != NC; }
+    DigitalOut& operator=(int value)
+    {
+        write(value);
+        return *this;
+    }
+    DigitalOut& operator=(DigitalOut& rhs)
+    {
+        write(rhs.read());
+        return *this;
+    }
+    operator int() { return read(); }
+
+private:
+    PinName m_pin;
+};
+
+class DigitalIn
+{
+public:
+    explicit DigitalIn(PinName pin, PinMode mode = PullDefault);
+    int read();
+    void mode(PinMode pull);
+    int is_connected() { return m_pin != NC; }
+    operator int() { return read(); }
+
+private:
+    PinName m_pin;
+};
+
+class DigitalInOut
+{
+public:
+    explicit DigitalInOut(PinName pin) : m_pin(pin) {}
+    void write(int value);
+    int read();
+    void output() {}
+    void input() {}
+    void mode(PinMode) {}
+    DigitalInOut& operator=(int value)
+    {
+        write(value);
+        return *this;
+    }
+    operator int() { return read(); }
+
+private:
+    PinName m_pin;
+};
+
+class InterruptIn
+{
+public:
+    explicit InterruptIn(PinName pin, PinMode mode = PullDefault);
+    virtual ~InterruptIn();
+    InterruptIn(const InterruptIn&) = delete;
+    InterruptIn& operator=(const InterruptIn&) = delete;
+
+    int read();
+    operator int() { return read(); }
+    void rise(Callback<void()> func) { m_rise = func; }
+    void fall(Callback<void()> func) { m_fall = func; }
+    void mode(PinMode) {}
+    void enable_irq() { m_enabled = true; }
+    void disable_irq() { m_enabled = false; }
+
+private:
+    friend struct mbed_host_pin_access;
+    PinName m_pin;
+    Callback<void()> m_rise;
+    Callback<void()> m_fall;
+    bool m_enabled{true};
+};
+
+class AnalogIn
+{
+public:
+    explicit AnalogIn(PinName pin, float vref = 3.3f) : m_pin(pin), m_vref(vref) {}
+    float read();
+    unsigned short read_u16();
+    float read_voltage() { return read() * m_vref; }
+    void set_reference_voltage(float vref) { m_vref = vref; }
+    float get_reference_voltage() const { return m_vref; }
+    operator float() { return read(); }
+
+private:
+    PinName m_pin;
+    float m_vref;
+};
+
+class PwmOut
+{
+public:
+    explicit PwmOut(PinName pin);
+    virtual ~PwmOut() = default;
+
+    void write(float value);
+    float read();
+    void period(float seconds) { m_period_us = 1.0e6f * seconds; }
+    void period_ms(int ms) { m_period_us = 1000.0f * static_cast<float>(ms); }
+    void period_us(int us) { m_period_us = static_cast<float>(us); }
+    float read_period() { return 1.0e-6f * m_period_us; }
+    void pulsewidth(float seconds) { write(1.0e6f * seconds / m_period_us); }
+    void pulsewidth_ms(int ms) { write(1000.0f * static_cast<float>(ms) / m_period_us); }
+    void pulsewidth_us(int us) { write(static_cast<float>(us) / m_period_us); }
+    int read_pulsewitdth_us() { return static_cast<int>(read() * m_period_us); }
+    void suspend() {}
+    void resume() {}
+    PwmOut& operator=(float value)
+    {
+        write(value);
+        return *this;
+    }
+    operator float() { return read(); }
+
+protected:
+    PinName m_pin;
+    float m_period_us{20000.0f};
+};
+
+// I2C
+
+#define I2C_EVENT_ERROR (1 << 1)
+#define I2C_EVENT_ERROR_NO_SLAVE (1 << 2)
+#define I2C_EVENT_TRANSFER_COMPLETE (1 << 3)
+#define I2C_EVENT_TRANSFER_EARLY_NACK (1 << 4)
+#define I2C_EVENT_ALL (I2C_EVENT_ERROR | I2C_EVENT_TRANSFER_COMPLETE | I2C_EVENT_ERROR_NO_SLAVE | I2C_EVENT_TRANSFER_EARLY_NACK)
+
+typedef Callback<void(int)> event_callback_t;
+
+class I2C
+{
+public:
+    enum Acknowledge { NoACK = 0, ACK = 1 };
+
+    I2C(PinName sda, PinName scl) : m_sda(sda), m_scl(scl) {}
+    virtual ~I2C() { abort_transfer(); }
+    I2C(const I2C&) = delete;
+    I2C& operator=(const I2C&) = delete;
+
+    void frequency(int hz) { m_frequency = hz; }
+
+    // return 0 on success (ack), non-0 on failure (nack), address is the 8 bit address
+    int read(int address, char* data, int length, bool repeated = false);
+    int write(int address, const char* data, int length, bool repeated = false);
+
+    // the transfer is executed when it is started, the callback is called after the bus time of the
+    // transfer at the frequency, returns 0 if the transfer was started, -1 if the bus is busy
+    int transfer(int address,
+                 const char* tx_buffer,
+                 int tx_length,
+                 char* rx_buffer,
+                 int rx_length,
+                 const event_callback_t& callback,
+                 int event = I2C_EVENT_TRANSFER_COMPLETE,
+                 bool repeated = false);
+    void abort_transfer();
+
+    void lock() {}
+    void unlock() {}
+
+private:
+    PinName m_sda;
+    PinName m_scl;
+    int m_frequency{100000};
+    uint64_t m_event{0};
+};
+
+// serial
+
+class SerialBase
+{
+public:
+    enum IrqType { RxIrq = 0, TxIrq, IrqCnt };
+    enum Parity { None = 0, Odd, Even, Forced1, Forced0 };
+
+    virtual ~SerialBase();
+    SerialBase(const SerialBase&) = delete;
+    SerialBase& operator=(const SerialBase&) = delete;
+
+    void baud(int baudrate) { m_baud = baudrate; }
+    void format(int bits = 8, Parity parity = None, int stop_bits = 1) {}
+    int readable();
+    int writeable() { return 1; }
+    void attach(Callback<void()> func, IrqType type = RxIrq);
+    void attach(std::nullptr_t, IrqType type = RxIrq) { attach(Callback<void()>(), type); }
+    void send_break() {}
+
+protected:
+    SerialBase(PinName tx, PinName rx, int baud);
+
+    int _base_getc();
+    int _base_putc(int c);
+
+private:
+    void onPoll();
+
+    int m_fd;
+    int m_baud;
+    Callback<void()> m_irq[IrqCnt];
+    Ticker m_Poll;
+    bool m_is_polling{false};
+};
+
+class BufferedSerial
+{
+public:
+    BufferedSerial(PinName tx, PinName rx, int baud = 9600);
+    virtual ~BufferedSerial() = default;
+    BufferedSerial(const BufferedSerial&) = delete;
+    BufferedSerial& operator=(const BufferedSerial&) = delete;
+
+    ssize_t write(const void* buffer, size_t length);
+    ssize_t read(void* buffer, size_t length);
+    bool writable() const { return true; }
+    bool readable() const;
+    int set_blocking(bool blocking)
+    {
+        m_blocking = blocking;
+        return 0;
+    }
+    bool is_blocking() const { return m_blocking; }
+    void set_baud(int baud) { m_baud = baud; }
+    void set_format(int bits = 8, SerialBase::Parity parity = SerialBase::None, int stop_bits = 1) {}
+    int sync() { return 0; }
+    void sigio(Callback<void()> func) { m_sigio = func; }
+
+private:
+    int m_fd;
+    int m_baud;
+    bool m_blocking{true};
+    Callback<void()> m_sigio;
+};
+
+typedef BufferedSerial UnbufferedSerial;
+
+void wait_us(int us);
+void wait_ns(unsigned int ns);
+
+} // namespace mbed
+
+namespace rtos {
+
+using mbed::Callback;
+
+class Thread
+{
+public:
+    enum State {
+        Inactive,
+        Ready,
+        Running,
+        WaitingDelay,
+        WaitingJoin,
+        WaitingThreadFlag,
+        WaitingEventFlag,
+        WaitingMutex,
+        WaitingSemaphore,
+        WaitingMemoryPool,
+        WaitingMessageGet,
+        WaitingMessagePut,
+        WaitingInterval,
+        WaitingOr,
+        WaitingAnd,
+        WaitingMailbox,
+        Deleted,
+    };
+
+    explicit Thread(osPriority priority = osPriorityNormal,
+                    uint32_t stack_size = OS_STACK_SIZE,
+                    unsigned char* stack_mem = nullptr,
+                    const char* name = nullptr);
+    virtual ~Thread();
+    Thread(const Thread&) = delete;
+    Thread& operator=(const Thread&) = delete;
+
+    osStatus start(Callback<void()> task);
+    osStatus join();
+    osStatus terminate();
+    osStatus set_priority(osPriority priority);
+    osPriority get_priority() const;
+    uint32_t flags_set(uint32_t flags);
+    State get_state() const;
+    uint32_t stack_size() const { return m_stack_size; }
+    const char* get_name() const { return m_name; }
+    osThreadId_t get_id() const;
+
+private:
+    mbed_host::Fiber* m_fiber;
+    uint32_t m_stack_size;
+    const char* m_name;
+};
+
+namespace ThisThread {
+uint32_t flags_clear(uint32_t flags);
+uint32_t flags_get();
+uint32_t flags_wait_all(uint32_t flags, bool clear = true);
+uint32_t flags_wait_any(uint32_t flags, bool clear = true);
+uint32_t flags_wait_all_for(uint32_t flags, std::chrono::milliseconds rel_time, bool clear = true);
+uint32_t flags_wait_any_for(uint32_t flags, std::chrono::milliseconds rel_time, bool clear = true);
+void sleep_for(uint32_t millisec);
+void sleep_for(std::chrono::milliseconds rel_time);
+void yield();
+osThreadId_t get_id();
+const char* get_name();
+} // namespace ThisThread
+
+class Mutex
+{
+public:
+    Mutex() = default;
+    explicit Mutex(const char*) {}
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    void lock();
+    bool trylock();
+    bool trylock_for(std::chrono::milliseconds rel_time);
+    void unlock();
+    osThreadId_t get_owner() { return m_owner; }
+
+private:
+    mbed_host::Fiber* m_owner{nullptr};
+    uint32_t m_count{0};
+};
+
+class Semaphore
+{
+public:
+    explicit Semaphore(int32_t count = 0, uint16_t max_count = 0xFFFF) : m_count(count), m_max_count(max_count) {}
+    Semaphore(const Semaphore&) = delete;
+    Semaphore& operator=(const Semaphore&) = delete;
+
+    void acquire();
+    bool try_acquire();
+    bool try_acquire_for(std::chrono::milliseconds rel_time);
+    osStatus release();
+
+private:
+    int32_t m_count;
+    uint16_t m_max_count;
+};
+
+namespace Kernel {
+struct Clock {
+    using duration = std::chrono::milliseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<Clock>;
+    static constexpr bool is_steady = true;
+    static time_point now();
+};
+uint64_t get_ms_count();
+} // namespace Kernel
+
+void thread_sleep_for(uint32_t millisec);
+
+} // namespace rtos
+
+namespace events {
+
+using mbed::Callback;
+
+// events are executed in interrupt context of the simulation, see the file comment
+class EventQueue
+{
+public:
+    explicit EventQueue(unsigned size = 32 * 8, unsigned char* buffer = nullptr) {}
+    virtual ~EventQueue();
+    EventQueue(const EventQueue&) = delete;
+    EventQueue& operator=(const EventQueue&) = delete;
+
+    // returns the id of the event, 0 if it could not be posted
+    int call(Callback<void()> func) { return post(0, 0, func); }
+    template <typename T, typename R>
+    int call(T* obj, R (T::*method)()) { return call(mbed::callback(obj, method)); }
+    int call_in(std::chrono::milliseconds ms, Callback<void()> func) { return post(ms.count(), 0, func); }
+    template <typename T, typename R>
+    int call_in(std::chrono::milliseconds ms, T* obj, R (T::*method)()) { return call_in(ms, mbed::callback(obj, method)); }
+    int call_every(std::chrono::milliseconds ms, Callback<void()> func) { return post(ms.count(), ms.count(), func); }
+    template <typename T, typename R>
+    int call_every(std::chrono::milliseconds ms, T* obj, R (T::*method)()) { return call_every(ms, mbed::callback(obj, method)); }
+    bool cancel(int id);
+
+    void dispatch_forever();
+    void break_dispatch();
+
+private:
+    int post(int64_t delay_ms, int64_t period_ms, Callback<void()> func);
+
+    int m_id{0};
+    bool m_break{false};
+};
+
+EventQueue* mbed_event_queue();
+EventQueue* mbed_highprio_event_queue();
+
+} // namespace events
+
+namespace mbed {
+using events::EventQueue;
+} // namespace mbed
+
+#include "mbed_host.h"
+
+#if !defined(MBED_NO_GLOBAL_USING_DIRECTIVE)
+using namespace mbed;
+using namespace rtos;
+using namespace events;
+using namespace std;
+#endif
+
+#endif /* MBED_HOST_MBED_H_ */
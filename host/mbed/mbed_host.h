@@ -0,0 +1,133 @@
+/**
+ * @file mbed_host.h
+ * @brief Control of the simulation behind the host mbed.h: virtual time, pins, encoders, I2C devices,
+ * serial ports and the sd card.
+ *
+ * The program runs in the main thread of the simulation. It lets the drivers run by waiting in virtual
+ * time, and it plays the environment of the board through the functions below, e.g.
+ * ```cpp
+ * DCMotor motor(PB_PWM_M1, PB_ENC_A_M1, PB_ENC_B_M1, 78.125f, 180.0f / 12.0f, 12.0f);
+ * motor.setVelocity(1.0f);
+ * for (int i = 0; i < 2000; i++) {
+ *     mbed_host::setEncoder(PB_ENC_A_M1, count);    // encoder count of the simulated motor
+ *     mbed_host::runFor(500);                       // 500 us of virtual time, the motor thread runs once
+ *     const float pwm = mbed_host::getPwm(PB_PWM_M1);
+ * }
+ * ```
+ *
+ * Pins, encoders and analog inputs can also be scripted with a source that is called at the time the
+ * driver reads them, and I2C devices are modelled by deriving from I2CDevice or I2CRegisterDevice and
+ * attaching them to their 8 bit address.
+ *
+ * Serial ports are pseudo terminals, the name of the slave side is printed when a port is opened
+ * (connect e.g. with `screen /dev/pts/N`), without a reader the data is dropped. The sd card is the
+ * directory of the environment variable MBED_HOST_SD_DIR (default ./sd), "/sd/data/000.bin" is
+ * written to "$MBED_HOST_SD_DIR/data/000.bin".
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef MBED_HOST_H_
+#define MBED_HOST_H_
+
+#include <functional>
+#include <stdint.h>
+
+namespace mbed_host {
+
+// virtual time
+
+// virtual time in us since the start of the program
+int64_t getTime_us();
+// lets the threads and the timed events run for time_us of virtual time, the calling thread waits
+void runFor(int64_t time_us);
+void runUntil(int64_t time_us);
+// executes func in interrupt context at time_us, returns an id for cancelEvent()
+uint64_t postEvent(int64_t time_us, std::function<void()> func);
+void cancelEvent(uint64_t id);
+// number of executed timed events and thread switches, e.g. to measure the overhead of the simulation
+uint64_t getNumOfEvents();
+uint64_t getNumOfSwitches();
+
+// pins, the value of a pin is its digital level, analog value in [0, 1] or pwm duty cycle in [0, 1]
+
+// sets the digital level of an input, rising and falling edges call the InterruptIn handlers
+void setDigital(int pin, int level);
+int getDigital(int pin);
+void setAnalog(int pin, float value);
+void setAnalogSource(int pin, std::function<float()> source);
+float getPwm(int pin);
+
+// quadrature encoders, identified by the pin of channel A like the EncoderCounter
+
+void setEncoder(int pin_a, int16_t count);
+void setEncoderSource(int pin_a, std::function<int16_t()> source);
+int16_t getEncoder(int pin_a);
+
+// I2C devices
+
+class I2CDevice
+{
+public:
+    explicit I2CDevice(uint8_t address);
+    virtual ~I2CDevice();
+    I2CDevice(const I2CDevice&) = delete;
+    I2CDevice& operator=(const I2CDevice&) = delete;
+
+    uint8_t getAddress() const { return m_address; }
+
+    // one write or read of a transaction, return false to answer with a nack
+    virtual bool write(const uint8_t* data, int length) = 0;
+    virtual bool read(uint8_t* data, int length) = 0;
+
+private:
+    uint8_t m_address;
+};
+
+// register device, the first byte of a write sets the register pointer, reads and further writes
+// continue at the register pointer
+class I2CRegisterDevice : public I2CDevice
+{
+public:
+    explicit I2CRegisterDevice(uint8_t address, bool is_auto_increment = true);
+    virtual ~I2CRegisterDevice() = default;
+
+    bool write(const uint8_t* data, int length) override;
+    bool read(uint8_t* data, int length) override;
+
+    uint8_t getRegister(uint8_t reg) const { return m_registers[reg]; }
+    void setRegister(uint8_t reg, uint8_t value) { m_registers[reg] = value; }
+    void setRegisters(uint8_t reg, const uint8_t* data, int length);
+    void setAutoIncrement(bool is_auto_increment) { m_is_auto_increment = is_auto_increment; }
+
+    // number of transactions that read (data was requested) and that wrote registers
+    uint32_t getNumOfReads() const { return m_num_of_reads; }
+    uint32_t getNumOfWrites() const { return m_num_of_writes; }
+
+protected:
+    // called for every register that is written or read, e.g. to model a fifo or a status register
+    virtual void onWrite(uint8_t reg, uint8_t value) {}
+    virtual uint8_t onRead(uint8_t reg) { return m_registers[reg]; }
+
+    uint8_t m_registers[256];
+
+private:
+    uint8_t m_pointer{0};
+    bool m_is_auto_increment;
+    uint32_t m_num_of_reads{0};
+    uint32_t m_num_of_writes{0};
+};
+
+// serial ports
+
+// name of the pseudo terminal of the port on tx, nullptr if it is not open
+const char* getSerialPortName(int pin_tx);
+
+// sd card
+
+// maps a path on the sd card ("/sd/...") to the host directory, other paths are returned unchanged
+const char* getSdPath(const char* path, char* buffer, int size);
+
+} // namespace mbed_host
+
+#endif /* MBED_HOST_H_ */
@@ -0,0 +1,523 @@
+// simulated pins, encoders, I2C devices, serial ports and sd card of the host mbed.h
+
+#include "mbed.h"
+#include "mbed_host_internal.h"
+
+#include "FATFileSystem.h"
+#undef fopen
+#undef opendir
+#undef mkdir
+
+#include <fcntl.h>
+#include <map>
+#include <poll.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+namespace mbed {
+
+// access of the simulation to the handlers of an InterruptIn
+struct mbed_host_pin_access {
+    static PinName pin(const InterruptIn* irq) { return irq->m_pin; }
+    static bool enabled(const InterruptIn* irq) { return irq->m_enabled; }
+    static const Callback<void()>& rise(const InterruptIn* irq) { return irq->m_rise; }
+    static const Callback<void()>& fall(const InterruptIn* irq) { return irq->m_fall; }
+};
+
+} // namespace mbed
+
+namespace mbed_host {
+
+namespace {
+
+struct pin_t {
+    int level{0};
+    float analog{0.0f};
+    std::function<float()> analog_source;
+    float pwm{0.0f};
+    int16_t encoder{0};
+    std::function<int16_t()> encoder_source;
+    std::vector<mbed::InterruptIn*> irqs;
+};
+
+std::map<int, pin_t>& pins()
+{
+    static std::map<int, pin_t>* pins = new std::map<int, pin_t>;
+    return *pins;
+}
+
+std::map<uint8_t, I2CDevice*>& i2cDevices()
+{
+    static std::map<uint8_t, I2CDevice*>* devices = new std::map<uint8_t, I2CDevice*>;
+    return *devices;
+}
+
+I2CDevice* findI2CDevice(int address)
+{
+    auto it = i2cDevices().find(static_cast<uint8_t>(address & 0xFE));
+    return (it == i2cDevices().end()) ? nullptr : it->second;
+}
+
+struct port_t {
+    int fd{-1};
+    std::string name;
+};
+
+std::map<int, port_t>& ports()
+{
+    static std::map<int, port_t>* ports = new std::map<int, port_t>;
+    return *ports;
+}
+
+// the pseudo terminal of the port, ports are shared by all objects on the same pins like on the target,
+// returns -1 if the port is not available, then written data is dropped
+int openPort(PinName tx, PinName rx)
+{
+    const int key = (tx != NC) ? static_cast<int>(tx) : static_cast<int>(rx);
+    auto it = ports().find(key);
+    if (it != ports().end())
+        return it->second.fd;
+
+    port_t port;
+    const char* serial = getenv("MBED_HOST_SERIAL");
+    if (!serial || strcmp(serial, "none") != 0) {
+        port.fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (port.fd >= 0 && (grantpt(port.fd) != 0 || unlockpt(port.fd) != 0)) {
+            close(port.fd);
+            port.fd = -1;
+        }
+    }
+    if (port.fd >= 0) {
+        struct termios tio;
+        if (tcgetattr(port.fd, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(port.fd, TCSANOW, &tio);
+        }
+        fcntl(port.fd, F_SETFL, fcntl(port.fd, F_GETFL) | O_NONBLOCK);
+        port.name = ptsname(port.fd);
+        fprintf(stderr, "mbed_host: serial port on pin %d is %s\n", key, port.name.c_str());
+    } else {
+        fprintf(stderr, "mbed_host: serial port on pin %d is not available, data is dropped\n", key);
+    }
+    ports()[key] = port;
+    return port.fd;
+}
+
+bool isReadable(int fd)
+{
+    if (fd < 0)
+        return false;
+    struct pollfd pfd = {fd, POLLIN, 0};
+    return (poll(&pfd, 1, 0) > 0) && (pfd.revents & POLLIN);
+}
+
+const char* getSdDirectory()
+{
+    const char* dir = getenv("MBED_HOST_SD_DIR");
+    return (dir && dir[0]) ? dir : "sd";
+}
+
+} // namespace
+
+void setDigital(int pin, int level)
+{
+    pin_t& p = pins()[pin];
+    level = level ? 1 : 0;
+    if (p.level == level)
+        return;
+    p.level = level;
+
+    // a handler can delete an InterruptIn, so the handlers are collected first
+    std::vector<mbed::Callback<void()>> handlers;
+    for (mbed::InterruptIn* irq : p.irqs) {
+        if (!mbed::mbed_host_pin_access::enabled(irq))
+            continue;
+        const mbed::Callback<void()>& handler = level ? mbed::mbed_host_pin_access::rise(irq)
+                                                      : mbed::mbed_host_pin_access::fall(irq);
+        if (handler)
+            handlers.push_back(handler);
+    }
+    for (const mbed::Callback<void()>& handler : handlers)
+        runInterrupt(handler);
+}
+
+int getDigital(int pin)
+{
+    return pins()[pin].level;
+}
+
+void setAnalog(int pin, float value)
+{
+    pin_t& p = pins()[pin];
+    p.analog = value;
+    p.analog_source = nullptr;
+}
+
+void setAnalogSource(int pin, std::function<float()> source)
+{
+    pins()[pin].analog_source = std::move(source);
+}
+
+float getPwm(int pin)
+{
+    return pins()[pin].pwm;
+}
+
+void setEncoder(int pin_a, int16_t count)
+{
+    pin_t& p = pins()[pin_a];
+    p.encoder = count;
+    p.encoder_source = nullptr;
+}
+
+void setEncoderSource(int pin_a, std::function<int16_t()> source)
+{
+    pins()[pin_a].encoder_source = std::move(source);
+}
+
+int16_t getEncoder(int pin_a)
+{
+    const pin_t& p = pins()[pin_a];
+    return p.encoder_source ? p.encoder_source() : p.encoder;
+}
+
+I2CDevice::I2CDevice(uint8_t address) : m_address(address & 0xFE)
+{
+    if (findI2CDevice(m_address))
+        fprintf(stderr, "mbed_host: I2C device 0x%02X is replaced\n", m_address);
+    i2cDevices()[m_address] = this;
+}
+
+I2CDevice::~I2CDevice()
+{
+    auto it = i2cDevices().find(m_address);
+    if (it != i2cDevices().end() && it->second == this)
+        i2cDevices().erase(it);
+}
+
+I2CRegisterDevice::I2CRegisterDevice(uint8_t address, bool is_auto_increment) : I2CDevice(address)
+                                                                              , m_is_auto_increment(is_auto_increment)
+{
+    memset(m_registers, 0, sizeof(m_registers));
+}
+
+bool I2CRegisterDevice::write(const uint8_t* data, int length)
+{
+    if (length < 1)
+        return true;
+    m_pointer = data[0];
+    if (length > 1)
+        m_num_of_writes++;
+    for (int i = 1; i < length; i++) {
+        m_registers[m_pointer] = data[i];
+        onWrite(m_pointer, data[i]);
+        if (m_is_auto_increment)
+            m_pointer++;
+    }
+    return true;
+}
+
+bool I2CRegisterDevice::read(uint8_t* data, int length)
+{
+    m_num_of_reads++;
+    for (int i = 0; i < length; i++) {
+        data[i] = onRead(m_pointer);
+        if (m_is_auto_increment)
+            m_pointer++;
+    }
+    return true;
+}
+
+void I2CRegisterDevice::setRegisters(uint8_t reg, const uint8_t* data, int length)
+{
+    for (int i = 0; i < length; i++)
+        m_registers[static_cast<uint8_t>(reg + i)] = data[i];
+}
+
+const char* getSerialPortName(int pin_tx)
+{
+    auto it = ports().find(pin_tx);
+    return (it == ports().end() || it->second.fd < 0) ? nullptr : it->second.name.c_str();
+}
+
+const char* getSdPath(const char* path, char* buffer, int size)
+{
+    if (strncmp(path, "/sd", 3) != 0 || (path[3] != '/' && path[3] != '\0'))
+        return path;
+    snprintf(buffer, size, "%s%s", getSdDirectory(), &path[3]);
+    return buffer;
+}
+
+FILE* sdFopen(const char* path, const char* mode)
+{
+    char buffer[512];
+    return fopen(getSdPath(path, buffer, sizeof(buffer)), mode);
+}
+
+DIR* sdOpendir(const char* path)
+{
+    char buffer[512];
+    return opendir(getSdPath(path, buffer, sizeof(buffer)));
+}
+
+int sdMkdir(const char* path, mode_t mode)
+{
+    char buffer[512];
+    return mkdir(getSdPath(path, buffer, sizeof(buffer)), mode);
+}
+
+} // namespace mbed_host
+
+int FATFileSystem::mount(BlockDevice* bd)
+{
+    if (mkdir(mbed_host::getSdDirectory(), 0777) != 0 && errno != EEXIST) {
+        fprintf(stderr, "mbed_host: can not create the sd card directory %s\n", mbed_host::getSdDirectory());
+        return -1;
+    }
+    return 0;
+}
+
+namespace mbed {
+
+DigitalOut::DigitalOut(PinName pin, int value) : m_pin(pin)
+{
+    write(value);
+}
+
+void DigitalOut::write(int value)
+{
+    mbed_host::setDigital(m_pin, value);
+}
+
+int DigitalOut::read()
+{
+    return mbed_host::getDigital(m_pin);
+}
+
+DigitalIn::DigitalIn(PinName pin, PinMode mode) : m_pin(pin)
+{
+    this->mode(mode);
+}
+
+int DigitalIn::read()
+{
+    return mbed_host::getDigital(m_pin);
+}
+
+void DigitalIn::mode(PinMode pull)
+{
+    // a pull up sets the level of an input that is not driven by the program yet
+    if (pull == PullUp && mbed_host::pins().find(m_pin) == mbed_host::pins().end())
+        mbed_host::pins()[m_pin].level = 1;
+}
+
+void DigitalInOut::write(int value)
+{
+    mbed_host::setDigital(m_pin, value);
+}
+
+int DigitalInOut::read()
+{
+    return mbed_host::getDigital(m_pin);
+}
+
+InterruptIn::InterruptIn(PinName pin, PinMode mode) : m_pin(pin)
+{
+    if (mode == PullUp && mbed_host::pins().find(m_pin) == mbed_host::pins().end())
+        mbed_host::pins()[m_pin].level = 1;
+    mbed_host::pins()[m_pin].irqs.push_back(this);
+}
+
+InterruptIn::~InterruptIn()
+{
+    std::vector<InterruptIn*>& irqs = mbed_host::pins()[m_pin].irqs;
+    for (auto it = irqs.begin(); it != irqs.end(); ++it) {
+        if (*it == this) {
+            irqs.erase(it);
+            break;
+        }
+    }
+}
+
+int InterruptIn::read()
+{
+    return mbed_host::getDigital(m_pin);
+}
+
+float AnalogIn::read()
+{
+    const mbed_host::pin_t& p = mbed_host::pins()[m_pin];
+    const float value = p.analog_source ? p.analog_source() : p.analog;
+    return (value < 0.0f) ? 0.0f : (value > 1.0f) ? 1.0f : value;
+}
+
+unsigned short AnalogIn::read_u16()
+{
+    return static_cast<unsigned short>(read() * 65535.0f + 0.5f);
+}
+
+PwmOut::PwmOut(PinName pin) : m_pin(pin)
+{
+    write(0.0f);
+}
+
+void PwmOut::write(float value)
+{
+    mbed_host::pins()[m_pin].pwm = (value < 0.0f) ? 0.0f : (value > 1.0f) ? 1.0f : value;
+}
+
+float PwmOut::read()
+{
+    return mbed_host::pins()[m_pin].pwm;
+}
+
+int I2C::read(int address, char* data, int length, bool repeated)
+{
+    mbed_host::I2CDevice* device = mbed_host::findI2CDevice(address);
+    if (!device)
+        return -1;
+    return device->read(reinterpret_cast<uint8_t*>(data), length) ? 0 : -1;
+}
+
+int I2C::write(int address, const char* data, int length, bool repeated)
+{
+    mbed_host::I2CDevice* device = mbed_host::findI2CDevice(address);
+    if (!device)
+        return -1;
+    return device->write(reinterpret_cast<const uint8_t*>(data), length) ? 0 : -1;
+}
+
+int I2C::transfer(int address,
+                  const char* tx_buffer,
+                  int tx_length,
+                  char* rx_buffer,
+                  int rx_length,
+                  const event_callback_t& callback,
+                  int event,
+                  bool repeated)
+{
+    if (m_event)
+        return -1;
+
+    int result = I2C_EVENT_TRANSFER_COMPLETE;
+    mbed_host::I2CDevice* device = mbed_host::findI2CDevice(address);
+    if (!device)
+        result = I2C_EVENT_ERROR_NO_SLAVE;
+    else if (tx_length > 0 && !device->write(reinterpret_cast<const uint8_t*>(tx_buffer), tx_length))
+        result = I2C_EVENT_ERROR | I2C_EVENT_TRANSFER_EARLY_NACK;
+    else if (rx_length > 0 && !device->read(reinterpret_cast<uint8_t*>(rx_buffer), rx_length))
+        result = I2C_EVENT_ERROR;
+
+    // time on the bus: address and data bytes of 9 bits each plus start and stop
+    int num_of_bytes = 0;
+    if (tx_length > 0)
+        num_of_bytes += 1 + tx_length;
+    if (rx_length > 0)
+        num_of_bytes += 1 + rx_length;
+    const int64_t time_us = (9 * num_of_bytes + 2) * 1000000LL / m_frequency + 1;
+
+    event_callback_t done = callback;
+    const int events = result & event;
+    m_event = mbed_host::postEvent(mbed_host::getTime_us() + time_us, [this, done, events]() {
+        m_event = 0;
+        if (events && done)
+            done(events);
+    });
+    return 0;
+}
+
+void I2C::abort_transfer()
+{
+    if (m_event)
+        mbed_host::cancelEvent(m_event);
+    m_event = 0;
+}
+
+#define MBED_HOST_SERIAL_POLL_PERIOD_US 1000
+
+SerialBase::SerialBase(PinName tx, PinName rx, int baud) : m_fd(mbed_host::openPort(tx, rx))
+                                                          , m_baud(baud)
+{
+}
+
+SerialBase::~SerialBase()
+{
+    m_Poll.detach();
+}
+
+int SerialBase::readable()
+{
+    return mbed_host::isReadable(m_fd) ? 1 : 0;
+}
+
+// the interrupts are emulated by polling the pseudo terminal while a handler is attached
+void SerialBase::attach(Callback<void()> func, IrqType type)
+{
+    m_irq[type] = func;
+    const bool is_attached = m_irq[RxIrq] || m_irq[TxIrq];
+    if (is_attached && !m_is_polling)
+        m_Poll.attach(callback(this, &SerialBase::onPoll), std::chrono::microseconds{MBED_HOST_SERIAL_POLL_PERIOD_US});
+    else if (!is_attached && m_is_polling)
+        m_Poll.detach();
+    m_is_polling = is_attached;
+}
+
+int SerialBase::_base_getc()
+{
+    unsigned char c;
+    return (m_fd >= 0 && ::read(m_fd, &c, 1) == 1) ? c : -1;
+}
+
+int SerialBase::_base_putc(int c)
+{
+    const unsigned char byte = static_cast<unsigned char>(c);
+    if (m_fd >= 0 && ::write(m_fd, &byte, 1) != 1) {
+        // dropped, nobody reads the pseudo terminal
+    }
+    return c;
+}
+
+void SerialBase::onPoll()
+{
+    // the transmit register is always empty
+    if (m_irq[TxIrq])
+        m_irq[TxIrq]();
+    if (m_irq[RxIrq] && readable())
+        m_irq[RxIrq]();
+}
+
+BufferedSerial::BufferedSerial(PinName tx, PinName rx, int baud) : m_fd(mbed_host::openPort(tx, rx))
+                                                                  , m_baud(baud)
+{
+}
+
+ssize_t BufferedSerial::write(const void* buffer, size_t length)
+{
+    if (m_fd < 0)
+        return static_cast<ssize_t>(length);
+    const ssize_t written = ::write(m_fd, buffer, length);
+    if (written >= 0)
+        return written;
+    // without a reader the data is dropped, a blocking write would never return
+    return m_blocking ? static_cast<ssize_t>(length) : -EAGAIN;
+}
+
+ssize_t BufferedSerial::read(void* buffer, size_t length)
+{
+    while (!readable()) {
+        if (!m_blocking)
+            return -EAGAIN;
+        rtos::ThisThread::sleep_for(std::chrono::milliseconds{1});
+    }
+    const ssize_t num_of_read = ::read(m_fd, buffer, length);
+    return (num_of_read >= 0) ? num_of_read : -EAGAIN;
+}
+
+bool BufferedSerial::readable() const
+{
+    return mbed_host::isReadable(m_fd);
+}
+
+} // namespace mbed
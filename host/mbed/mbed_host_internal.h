@@ -0,0 +1,15 @@
+// functions of the simulation that are shared by the parts of the host mbed.h
+
+#ifndef MBED_HOST_INTERNAL_H_
+#define MBED_HOST_INTERNAL_H_
+
+#include "mbed.h"
+
+namespace mbed_host {
+
+// executes func in interrupt context and then lets a woken thread with a higher priority run
+void runInterrupt(const mbed::Callback<void()>& func);
+
+} // namespace mbed_host
+
+#endif /* MBED_HOST_INTERNAL_H_ */
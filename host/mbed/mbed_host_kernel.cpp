@@ -0,0 +1,779 @@
+// threads, virtual time and synchronisation of the host mbed.h
+
+#include "mbed.h"
+#include "mbed_host_internal.h"
+
+#include <map>
+#include <ucontext.h>
+#include <unordered_map>
+#include <vector>
+
+#define MBED_HOST_STACK_SIZE_MIN (256 * 1024) // printf and Eigen need more stack on the host than on the target
+
+namespace mbed_host {
+
+enum class FiberState { Inactive, Ready, Blocked, Deleted };
+
+struct Fiber {
+    ucontext_t context;
+    char* stack{nullptr};
+    mbed::Callback<void()> task;
+    osPriority priority{osPriorityNormal};
+    FiberState state{FiberState::Inactive};
+    rtos::Thread::State wait_state{rtos::Thread::Inactive};
+    const void* wait_object{nullptr};
+    uint32_t flags{0};
+    uint32_t wait_flags{0};
+    bool is_wait_all{false};
+    uint64_t wait_id{0};
+    uint64_t timeout_event{0};
+    bool is_timed_out{false};
+    uint64_t ready_sequence{0};
+    const char* name{nullptr};
+};
+
+namespace {
+
+struct Kernel {
+    Fiber main_fiber;
+    Fiber* current;
+    std::vector<Fiber*> fibers;
+
+    // timed events ordered by time and then by the order they were posted
+    std::map<std::pair<int64_t, uint64_t>, std::function<void()>> events;
+    std::unordered_map<uint64_t, int64_t> event_times;
+
+    int64_t time_us{0};
+    uint64_t event_id{0};
+    uint64_t wait_id{0};
+    uint64_t ready_sequence{0};
+    int isr_depth{0};
+
+    uint64_t num_of_events{0};
+    uint64_t num_of_switches{0};
+
+    Kernel()
+    {
+        main_fiber.state = FiberState::Ready;
+        main_fiber.name = "main";
+        current = &main_fiber;
+        fibers.push_back(&main_fiber);
+    }
+};
+
+// never destroyed, drivers with static storage duration can use it until the end of the program
+Kernel& kernel()
+{
+    static Kernel* k = new Kernel;
+    return *k;
+}
+
+bool isInterrupt()
+{
+    return kernel().isr_depth > 0;
+}
+
+void makeReady(Fiber* fiber)
+{
+    fiber->state = FiberState::Ready;
+    fiber->ready_sequence = ++kernel().ready_sequence;
+}
+
+// the ready fiber with the highest priority, within a priority the one that waits the longest
+Fiber* pickReady()
+{
+    Fiber* next = nullptr;
+    for (Fiber* fiber : kernel().fibers) {
+        if (fiber->state != FiberState::Ready)
+            continue;
+        if (!next || fiber->priority > next->priority ||
+            (fiber->priority == next->priority && fiber->ready_sequence < next->ready_sequence))
+            next = fiber;
+    }
+    return next;
+}
+
+void switchTo(Fiber* next)
+{
+    Kernel& k = kernel();
+    if (next == k.current)
+        return;
+    Fiber* previous = k.current;
+    k.current = next;
+    k.num_of_switches++;
+    swapcontext(&previous->context, &next->context);
+}
+
+void runNextEvent()
+{
+    Kernel& k = kernel();
+    auto it = k.events.begin();
+    k.time_us = it->first.first;
+    k.event_times.erase(it->first.second);
+    std::function<void()> func = std::move(it->second);
+    k.events.erase(it);
+    k.num_of_events++;
+
+    k.isr_depth++;
+    func();
+    k.isr_depth--;
+}
+
+// continues with the ready fiber with the highest priority, if no fiber is ready then virtual time
+// advances to the next event until one is
+void schedule()
+{
+    Kernel& k = kernel();
+    while (true) {
+        Fiber* next = pickReady();
+        if (next) {
+            switchTo(next);
+            return;
+        }
+        if (k.events.empty()) {
+            fprintf(stderr, "mbed_host: all threads wait and no event is pending at %lld us\n",
+                    static_cast<long long>(k.time_us));
+            exit(EXIT_FAILURE);
+        }
+        runNextEvent();
+    }
+}
+
+// lets a ready fiber with a higher priority run, like the scheduler of the target after an interrupt
+void yieldToHigherPriority()
+{
+    Kernel& k = kernel();
+    if (isInterrupt() || k.current->state != FiberState::Ready)
+        return;
+    Fiber* next = pickReady();
+    if (next && next != k.current && next->priority > k.current->priority) {
+        makeReady(k.current);
+        schedule();
+    }
+}
+
+void wake(Fiber* fiber)
+{
+    if (fiber->state != FiberState::Blocked)
+        return;
+    makeReady(fiber);
+    yieldToHigherPriority();
+}
+
+void wakeAll(const void* object)
+{
+    for (Fiber* fiber : kernel().fibers) {
+        if (fiber->state == FiberState::Blocked && fiber->wait_object == object)
+            makeReady(fiber);
+    }
+    yieldToHigherPriority();
+}
+
+// the current fiber waits until it is woken or until time_us if time_us >= 0, returns false on timeout
+bool blockUntil(int64_t time_us, rtos::Thread::State wait_state, const void* object)
+{
+    Kernel& k = kernel();
+    if (isInterrupt())
+        assertFailed("blocking call in interrupt context", __FILE__, __LINE__);
+
+    Fiber* fiber = k.current;
+    const uint64_t wait_id = ++k.wait_id;
+    fiber->wait_id = wait_id;
+    fiber->wait_state = wait_state;
+    fiber->wait_object = object;
+    fiber->is_timed_out = false;
+    fiber->timeout_event = 0;
+    if (time_us >= 0) {
+        fiber->timeout_event = postEvent(time_us, [fiber, wait_id]() {
+            if (fiber->state == FiberState::Blocked && fiber->wait_id == wait_id) {
+                fiber->timeout_event = 0;
+                fiber->is_timed_out = true;
+                wake(fiber);
+            }
+        });
+    }
+
+    fiber->state = FiberState::Blocked;
+    schedule();
+
+    if (fiber->timeout_event) {
+        cancelEvent(fiber->timeout_event);
+        fiber->timeout_event = 0;
+    }
+    fiber->wait_state = rtos::Thread::Running;
+    fiber->wait_object = nullptr;
+    return !fiber->is_timed_out;
+}
+
+int64_t deadline(std::chrono::milliseconds rel_time)
+{
+    return kernel().time_us + 1000 * static_cast<int64_t>(rel_time.count());
+}
+
+bool isFlagsSet(const Fiber* fiber, uint32_t flags, bool is_wait_all)
+{
+    return is_wait_all ? ((fiber->flags & flags) == flags) : ((fiber->flags & flags) != 0);
+}
+
+uint32_t setFlags(Fiber* fiber, uint32_t flags)
+{
+    fiber->flags |= flags;
+    const uint32_t result = fiber->flags;
+    if (fiber->state == FiberState::Blocked && fiber->wait_state == rtos::Thread::WaitingThreadFlag &&
+        isFlagsSet(fiber, fiber->wait_flags, fiber->is_wait_all))
+        wake(fiber);
+    return result;
+}
+
+uint32_t waitFlags(uint32_t flags, bool is_wait_all, bool clear, int64_t time_us)
+{
+    Fiber* fiber = kernel().current;
+    while (!isFlagsSet(fiber, flags, is_wait_all)) {
+        fiber->wait_flags = flags;
+        fiber->is_wait_all = is_wait_all;
+        if (!blockUntil(time_us, rtos::Thread::WaitingThreadFlag, nullptr))
+            return osFlagsErrorTimeout;
+    }
+    const uint32_t result = fiber->flags;
+    if (clear)
+        fiber->flags &= ~flags;
+    return result;
+}
+
+[[noreturn]] void finish(Fiber* fiber)
+{
+    fiber->state = FiberState::Deleted;
+    wakeAll(fiber);
+    schedule();
+    // a deleted fiber is never continued
+    abort();
+}
+
+void fiberEntry()
+{
+    Fiber* fiber = kernel().current;
+    fiber->task();
+    finish(fiber);
+}
+
+} // namespace
+
+[[noreturn]] void assertFailed(const char* expr, const char* file, int line)
+{
+    fprintf(stderr, "mbed_host: assertion \"%s\" failed in %s:%d\n", expr, file, line);
+    abort();
+}
+
+int64_t getTime_us()
+{
+    return kernel().time_us;
+}
+
+void runFor(int64_t time_us)
+{
+    runUntil(kernel().time_us + time_us);
+}
+
+void runUntil(int64_t time_us)
+{
+    while (kernel().time_us < time_us)
+        blockUntil(time_us, rtos::Thread::WaitingDelay, nullptr);
+}
+
+uint64_t postEvent(int64_t time_us, std::function<void()> func)
+{
+    Kernel& k = kernel();
+    if (time_us < k.time_us)
+        time_us = k.time_us;
+    const uint64_t id = ++k.event_id;
+    k.events.emplace(std::make_pair(time_us, id), std::move(func));
+    k.event_times.emplace(id, time_us);
+    return id;
+}
+
+void cancelEvent(uint64_t id)
+{
+    Kernel& k = kernel();
+    auto it = k.event_times.find(id);
+    if (it == k.event_times.end())
+        return;
+    k.events.erase(std::make_pair(it->second, id));
+    k.event_times.erase(it);
+}
+
+uint64_t getNumOfEvents()
+{
+    return kernel().num_of_events;
+}
+
+uint64_t getNumOfSwitches()
+{
+    return kernel().num_of_switches;
+}
+
+// called by the devices for interrupts that are caused by the program, e.g. an edge of setDigital()
+void runInterrupt(const mbed::Callback<void()>& func)
+{
+    Kernel& k = kernel();
+    k.isr_depth++;
+    func();
+    k.isr_depth--;
+    yieldToHigherPriority();
+}
+
+} // namespace mbed_host
+
+using mbed_host::Fiber;
+using mbed_host::FiberState;
+using mbed_host::kernel;
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags)
+{
+    if (!thread_id)
+        return osFlagsErrorParameter;
+    return mbed_host::setFlags(static_cast<Fiber*>(thread_id), flags);
+}
+
+namespace mbed {
+
+void wait_us(int us)
+{
+    // the program does not take virtual time, so there is nothing to wait for in interrupt context
+    if (mbed_host::isInterrupt() || us <= 0)
+        return;
+    mbed_host::runFor(us);
+}
+
+void wait_ns(unsigned int ns)
+{
+    wait_us(static_cast<int>(ns / 1000));
+}
+
+void Timer::start()
+{
+    if (m_running)
+        return;
+    m_start_us = mbed_host::getTime_us();
+    m_running = true;
+}
+
+void Timer::stop()
+{
+    if (!m_running)
+        return;
+    m_elapsed_us += mbed_host::getTime_us() - m_start_us;
+    m_running = false;
+}
+
+void Timer::reset()
+{
+    m_start_us = mbed_host::getTime_us();
+    m_elapsed_us = 0;
+}
+
+std::chrono::microseconds Timer::elapsed_time() const
+{
+    const int64_t elapsed_us = m_elapsed_us + (m_running ? mbed_host::getTime_us() - m_start_us : 0);
+    return std::chrono::microseconds{elapsed_us};
+}
+
+void Ticker::attach(Callback<void()> func, std::chrono::microseconds t)
+{
+    detach();
+    m_func = func;
+    m_period_us = (t.count() > 0) ? t.count() : 1;
+    m_next_us = mbed_host::getTime_us() + m_period_us;
+    m_event = mbed_host::postEvent(m_next_us, [this]() { onEvent(); });
+}
+
+void Ticker::detach()
+{
+    if (m_event)
+        mbed_host::cancelEvent(m_event);
+    m_event = 0;
+}
+
+void Ticker::onEvent()
+{
+    // the next event is posted first, so the callback can detach the ticker
+    m_next_us += m_period_us;
+    m_event = mbed_host::postEvent(m_next_us, [this]() { onEvent(); });
+    Callback<void()> func = m_func;
+    if (func)
+        func();
+}
+
+void Timeout::attach(Callback<void()> func, std::chrono::microseconds t)
+{
+    detach();
+    m_func = func;
+    m_event = mbed_host::postEvent(mbed_host::getTime_us() + t.count(), [this]() { onEvent(); });
+}
+
+void Timeout::detach()
+{
+    if (m_event)
+        mbed_host::cancelEvent(m_event);
+    m_event = 0;
+}
+
+void Timeout::onEvent()
+{
+    m_event = 0;
+    Callback<void()> func = m_func;
+    if (func)
+        func();
+}
+
+} // namespace mbed
+
+namespace rtos {
+
+Thread::Thread(osPriority priority, uint32_t stack_size, unsigned char* stack_mem, const char* name)
+    : m_fiber(new Fiber), m_stack_size(stack_size), m_name(name)
+{
+    m_fiber->priority = priority;
+    m_fiber->name = name;
+}
+
+Thread::~Thread()
+{
+    terminate();
+    std::vector<Fiber*>& fibers = kernel().fibers;
+    for (auto it = fibers.begin(); it != fibers.end(); ++it) {
+        if (*it == m_fiber) {
+            fibers.erase(it);
+            break;
+        }
+    }
+    // the stack of the current fiber can not be released
+    if (m_fiber != kernel().current) {
+        free(m_fiber->stack);
+        delete m_fiber;
+    }
+}
+
+osStatus Thread::start(Callback<void()> task)
+{
+    if (m_fiber->state != FiberState::Inactive)
+        return osErrorParameter;
+
+    const size_t stack_size = (m_stack_size > MBED_HOST_STACK_SIZE_MIN) ? m_stack_size : MBED_HOST_STACK_SIZE_MIN;
+    m_fiber->stack = static_cast<char*>(malloc(stack_size));
+    if (!m_fiber->stack)
+        return osErrorResource;
+    m_fiber->task = task;
+    getcontext(&m_fiber->context);
+    m_fiber->context.uc_stack.ss_sp = m_fiber->stack;
+    m_fiber->context.uc_stack.ss_size = stack_size;
+    m_fiber->context.uc_link = nullptr;
+    makecontext(&m_fiber->context, mbed_host::fiberEntry, 0);
+
+    kernel().fibers.push_back(m_fiber);
+    mbed_host::makeReady(m_fiber);
+    mbed_host::yieldToHigherPriority();
+    return osOK;
+}
+
+osStatus Thread::join()
+{
+    if (m_fiber == kernel().current)
+        return osError;
+    while (m_fiber->state == FiberState::Ready || m_fiber->state == FiberState::Blocked)
+        mbed_host::blockUntil(-1, WaitingJoin, m_fiber);
+    return osOK;
+}
+
+osStatus Thread::terminate()
+{
+    if (m_fiber->state == FiberState::Inactive || m_fiber->state == FiberState::Deleted)
+        return osErrorResource;
+    if (m_fiber->timeout_event) {
+        mbed_host::cancelEvent(m_fiber->timeout_event);
+        m_fiber->timeout_event = 0;
+    }
+    if (m_fiber == kernel().current)
+        mbed_host::finish(m_fiber);
+    m_fiber->state = FiberState::Deleted;
+    mbed_host::wakeAll(m_fiber);
+    return osOK;
+}
+
+osStatus Thread::set_priority(osPriority priority)
+{
+    m_fiber->priority = priority;
+    mbed_host::yieldToHigherPriority();
+    return osOK;
+}
+
+osPriority Thread::get_priority() const
+{
+    return m_fiber->priority;
+}
+
+uint32_t Thread::flags_set(uint32_t flags)
+{
+    return mbed_host::setFlags(m_fiber, flags);
+}
+
+Thread::State Thread::get_state() const
+{
+    switch (m_fiber->state) {
+        case FiberState::Inactive:
+            return Inactive;
+        case FiberState::Ready:
+            return (m_fiber == kernel().current) ? Running : Ready;
+        case FiberState::Blocked:
+            return m_fiber->wait_state;
+        default:
+            return Deleted;
+    }
+}
+
+osThreadId_t Thread::get_id() const
+{
+    return m_fiber;
+}
+
+namespace ThisThread {
+
+uint32_t flags_clear(uint32_t flags)
+{
+    Fiber* fiber = kernel().current;
+    const uint32_t result = fiber->flags;
+    fiber->flags &= ~flags;
+    return result;
+}
+
+uint32_t flags_get()
+{
+    return kernel().current->flags;
+}
+
+uint32_t flags_wait_all(uint32_t flags, bool clear)
+{
+    return mbed_host::waitFlags(flags, true, clear, -1);
+}
+
+uint32_t flags_wait_any(uint32_t flags, bool clear)
+{
+    return mbed_host::waitFlags(flags, false, clear, -1);
+}
+
+uint32_t flags_wait_all_for(uint32_t flags, std::chrono::milliseconds rel_time, bool clear)
+{
+    return mbed_host::waitFlags(flags, true, clear, mbed_host::deadline(rel_time));
+}
+
+uint32_t flags_wait_any_for(uint32_t flags, std::chrono::milliseconds rel_time, bool clear)
+{
+    return mbed_host::waitFlags(flags, false, clear, mbed_host::deadline(rel_time));
+}
+
+void sleep_for(uint32_t millisec)
+{
+    mbed_host::runFor(1000 * static_cast<int64_t>(millisec));
+}
+
+void sleep_for(std::chrono::milliseconds rel_time)
+{
+    mbed_host::runFor(1000 * static_cast<int64_t>(rel_time.count()));
+}
+
+void yield()
+{
+    mbed_host::makeReady(kernel().current);
+    mbed_host::schedule();
+}
+
+osThreadId_t get_id()
+{
+    return kernel().current;
+}
+
+const char* get_name()
+{
+    return kernel().current->name;
+}
+
+} // namespace ThisThread
+
+void Mutex::lock()
+{
+    Fiber* fiber = kernel().current;
+    while (m_owner && m_owner != fiber)
+        mbed_host::blockUntil(-1, Thread::WaitingMutex, this);
+    m_owner = fiber;
+    m_count++;
+}
+
+bool Mutex::trylock()
+{
+    Fiber* fiber = kernel().current;
+    if (m_owner && m_owner != fiber)
+        return false;
+    m_owner = fiber;
+    m_count++;
+    return true;
+}
+
+bool Mutex::trylock_for(std::chrono::milliseconds rel_time)
+{
+    const int64_t time_us = mbed_host::deadline(rel_time);
+    while (!trylock()) {
+        if (!mbed_host::blockUntil(time_us, Thread::WaitingMutex, this))
+            return false;
+    }
+    return true;
+}
+
+void Mutex::unlock()
+{
+    if (m_owner != kernel().current || m_count == 0)
+        mbed_host::assertFailed("mutex unlocked by a thread that does not own it", __FILE__, __LINE__);
+    if (--m_count == 0) {
+        m_owner = nullptr;
+        mbed_host::wakeAll(this);
+    }
+}
+
+void Semaphore::acquire()
+{
+    while (m_count <= 0)
+        mbed_host::blockUntil(-1, Thread::WaitingSemaphore, this);
+    m_count--;
+}
+
+bool Semaphore::try_acquire()
+{
+    if (m_count <= 0)
+        return false;
+    m_count--;
+    return true;
+}
+
+bool Semaphore::try_acquire_for(std::chrono::milliseconds rel_time)
+{
+    const int64_t time_us = mbed_host::deadline(rel_time);
+    while (m_count <= 0) {
+        if (!mbed_host::blockUntil(time_us, Thread::WaitingSemaphore, this))
+            return false;
+    }
+    m_count--;
+    return true;
+}
+
+osStatus Semaphore::release()
+{
+    if (m_count >= static_cast<int32_t>(m_max_count))
+        return osErrorResource;
+    m_count++;
+    mbed_host::wakeAll(this);
+    return osOK;
+}
+
+namespace Kernel {
+
+Clock::time_point Clock::now()
+{
+    return time_point(duration(mbed_host::getTime_us() / 1000));
+}
+
+uint64_t get_ms_count()
+{
+    return static_cast<uint64_t>(mbed_host::getTime_us() / 1000);
+}
+
+} // namespace Kernel
+
+void thread_sleep_for(uint32_t millisec)
+{
+    ThisThread::sleep_for(millisec);
+}
+
+} // namespace rtos
+
+namespace events {
+
+namespace {
+
+// kernel events of the posted events, by queue and id
+std::map<std::pair<const EventQueue*, int>, uint64_t>& queueEvents()
+{
+    static std::map<std::pair<const EventQueue*, int>, uint64_t>* events = new std::map<std::pair<const EventQueue*, int>, uint64_t>;
+    return *events;
+}
+
+void postQueueEvent(const EventQueue* queue, int id, int64_t time_us, int64_t period_us, Callback<void()> func)
+{
+    queueEvents()[std::make_pair(queue, id)] = mbed_host::postEvent(time_us, [queue, id, time_us, period_us, func]() {
+        if (period_us > 0)
+            postQueueEvent(queue, id, time_us + period_us, period_us, func);
+        else
+            queueEvents().erase(std::make_pair(queue, id));
+        func();
+    });
+}
+
+} // namespace
+
+EventQueue::~EventQueue()
+{
+    std::map<std::pair<const EventQueue*, int>, uint64_t>& events = queueEvents();
+    for (auto it = events.begin(); it != events.end();) {
+        if (it->first.first == this) {
+            mbed_host::cancelEvent(it->second);
+            it = events.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool EventQueue::cancel(int id)
+{
+    std::map<std::pair<const EventQueue*, int>, uint64_t>& events = queueEvents();
+    auto it = events.find(std::make_pair(static_cast<const EventQueue*>(this), id));
+    if (it == events.end())
+        return false;
+    mbed_host::cancelEvent(it->second);
+    events.erase(it);
+    return true;
+}
+
+void EventQueue::dispatch_forever()
+{
+    // the events are executed by the simulation, the dispatching thread only waits
+    m_break = false;
+    while (!m_break)
+        rtos::ThisThread::sleep_for(std::chrono::milliseconds{1000});
+}
+
+void EventQueue::break_dispatch()
+{
+    m_break = true;
+}
+
+int EventQueue::post(int64_t delay_ms, int64_t period_ms, Callback<void()> func)
+{
+    if (!func)
+        return 0;
+    if (++m_id <= 0)
+        m_id = 1;
+    postQueueEvent(this, m_id, mbed_host::getTime_us() + 1000 * delay_ms, 1000 * period_ms, func);
+    return m_id;
+}
+
+EventQueue* mbed_event_queue()
+{
+    static EventQueue* queue = new EventQueue;
+    return queue;
+}
+
+EventQueue* mbed_highprio_event_queue()
+{
+    static EventQueue* queue = new EventQueue;
+    return queue;
+}
+
+} // namespace events
@@ -0,0 +1,173 @@
+// closed-loop benchmark of the DCMotor against the DCMotorPlant, faster than real time on the host. the
+// DCMotor is compiled with DC_MOTOR_DO_USE_PLANT_SIMULATION, step() runs the real IIR filter, motion
+// planner and PID code and the plant model, every call is one period TS of virtual time.
+//
+// the scenarios of docs/solutions/main_dc_motor_plant_simulation.cpp are printed one by one, then sweeps of
+// velocity and rotation steps and ramps are run to measure the throughput. the program fails if a scenario
+// does not reach 90% of its target or ends with a large error, so controller changes can be regression
+// tested with ctest
+//
+// build and run from the repository root:
+//   cmake -S host -B build_host && cmake --build build_host -j
+//   ./build_host/dc_motor_plant_simulation
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "mbed.h"
+#include "PESBoardPinMap.h"
+#include "DCMotor.h"
+
+#if !DC_MOTOR_DO_USE_PLANT_SIMULATION
+    #error "compile with DC_MOTOR_DO_USE_PLANT_SIMULATION set to true"
+#endif
+
+typedef struct scenario_s {
+    const char* name;
+    bool is_rotation;        // true: setRotation(), false: setVelocity()
+    float target;            // in rotations or as fraction of the max. physical velocity
+    bool use_motion_planner;
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    {"velocity step 25%",           false, 0.25f, false},
+    {"velocity step 50%",           false, 0.50f, false},
+    {"velocity step 90%",           false, 0.90f, false}, // 100% is not reached because of the friction
+    {"velocity ramp 50%",           false, 0.50f, true },
+    {"rotation step 1 turn",        true,  1.00f, false},
+    {"rotation step 5 turns",       true,  5.00f, false},
+    {"rotation ramp 5 turns",       true,  5.00f, true }
+};
+
+// results of one scenario
+typedef struct result_s {
+    float target;            // in rotations or rotations per second
+    float rise_time_ms;      // from 10% to 90% of the target, -1 if 90% was never reached
+    float overshoot_percent;
+    float error_end;         // target minus output at the end of the simulation
+    float tick_time_mean_ns; // cpu time per call of step()
+    float tick_time_max_ns;
+} result_t;
+
+static const float VOLTAGE_MAX = 12.0f;
+static const float GEAR_RATIO = 78.125f;
+static const float KN = 180.0f / 12.0f;
+
+static result_t run_scenario(const scenario_t& scenario, float sim_time_s)
+{
+    // the motor is created for every scenario, so all states start at zero
+    DCMotor motor(PB_PWM_M1, PB_ENC_A_M1, PB_ENC_B_M1, GEAR_RATIO, KN, VOLTAGE_MAX);
+    if (scenario.use_motion_planner)
+        motor.enableMotionPlanner();
+
+    float target = scenario.target;
+    if (scenario.is_rotation) {
+        motor.setRotation(target);
+    } else {
+        target *= motor.getMaxPhysicalVelocity();
+        motor.setVelocity(target);
+    }
+
+    result_t result = {target, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    float time_10_s = -1.0f;
+    float output_max = 0.0f;
+    float output = 0.0f;
+    int64_t tick_time_sum_ns = 0;
+    int64_t tick_time_max_ns = 0;
+
+    const int num_of_ticks = static_cast<int>(sim_time_s / DCMotor::TS);
+    for (int i = 0; i < num_of_ticks; i++) {
+        // only the control code and the plant are measured
+        const auto tick_start = std::chrono::steady_clock::now();
+        motor.step();
+        const int64_t tick_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tick_start).count();
+        tick_time_sum_ns += tick_time_ns;
+        if (tick_time_ns > tick_time_max_ns)
+            tick_time_max_ns = tick_time_ns;
+
+        // evaluate step response
+        const float time_s = static_cast<float>(i + 1) * DCMotor::TS;
+        output = scenario.is_rotation ? motor.getRotation() : motor.getVelocity();
+        if (output > output_max)
+            output_max = output;
+        if (time_10_s < 0.0f && output >= 0.1f * target)
+            time_10_s = time_s;
+        if (result.rise_time_ms < 0.0f && output >= 0.9f * target)
+            result.rise_time_ms = 1.0e3f * (time_s - time_10_s);
+    }
+
+    result.overshoot_percent = (output_max > target) ? 100.0f * (output_max - target) / target : 0.0f;
+    result.error_end = target - output;
+    result.tick_time_mean_ns = static_cast<float>(tick_time_sum_ns) / static_cast<float>(num_of_ticks);
+    result.tick_time_max_ns = static_cast<float>(tick_time_max_ns);
+
+    return result;
+}
+
+static int num_of_errors = 0;
+
+// a scenario passes if it reaches 90% of the target and ends within 2% of it, rotations within
+// 0.01 turns (twice ROTATION_ERROR_MAX of the DCMotor)
+static void check(const char* name, const scenario_t& scenario, const result_t& result)
+{
+    const float error_max = scenario.is_rotation ? 0.01f : 0.02f * result.target;
+    if (result.rise_time_ms < 0.0f || fabsf(result.error_end) > error_max) {
+        printf("%s, target %.3f: rise time %.2f ms, end error %.4f FAILED\n", name, result.target, result.rise_time_ms, result.error_end);
+        num_of_errors++;
+    }
+}
+
+int main()
+{
+    const float sim_time_s = 3.0f; // simulated time per scenario
+    const int num_of_scenarios = sizeof(scenarios) / sizeof(scenarios[0]);
+
+    printf("scenario, rise time (ms), overshoot (%%), end error, tick mean (ns), tick max (ns), real-time factor\n");
+    for (int i = 0; i < num_of_scenarios; i++) {
+        const result_t result = run_scenario(scenarios[i], sim_time_s);
+        printf("%s, %.2f, %.2f, %.4f, %.1f, %.1f, %.0f\n", scenarios[i].name,
+                                                            result.rise_time_ms,
+                                                            result.overshoot_percent,
+                                                            result.error_end,
+                                                            result.tick_time_mean_ns,
+                                                            result.tick_time_max_ns,
+                                                            1.0e9f * DCMotor::TS / result.tick_time_mean_ns);
+        check(scenarios[i].name, scenarios[i], result);
+    }
+
+    // sweeps of steps and ramps, 1 s each
+    const float sweep_time_s = 1.0f;
+    const int num_of_targets = 250;
+    int num_of_runs = 0;
+    float rise_time_max_ms = 0.0f;
+    float overshoot_max_percent = 0.0f;
+    float tick_time_mean_sum_ns = 0.0f;
+    const auto sweep_start = std::chrono::steady_clock::now();
+    for (int k = 0; k < 4; k++) {
+        for (int i = 1; i <= num_of_targets; i++) {
+            scenario_t scenario;
+            scenario.is_rotation = k >= 2;
+            scenario.use_motion_planner = (k % 2) == 1;
+            // velocities from 10% to 90%, rotations from 0.1 to 1 turn, so every run settles within the sweep time
+            scenario.target = scenario.is_rotation ? 0.1f + 0.9f * static_cast<float>(i) / num_of_targets
+                                                   : 0.1f + 0.8f * static_cast<float>(i) / num_of_targets;
+            scenario.name = scenario.is_rotation ? (scenario.use_motion_planner ? "sweep rotation ramp" : "sweep rotation step")
+                                                 : (scenario.use_motion_planner ? "sweep velocity ramp" : "sweep velocity step");
+            const result_t result = run_scenario(scenario, sweep_time_s);
+            check(scenario.name, scenario, result);
+            rise_time_max_ms = fmaxf(rise_time_max_ms, result.rise_time_ms);
+            overshoot_max_percent = fmaxf(overshoot_max_percent, result.overshoot_percent);
+            tick_time_mean_sum_ns += result.tick_time_mean_ns;
+            num_of_runs++;
+        }
+    }
+    const double sweep_time_wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - sweep_start).count();
+
+    printf("sweeps, %d scenarios of %.1f s in %.3f s wall time, %.0f scenarios per second\n", num_of_runs, sweep_time_s, sweep_time_wall_s,
+                                                                                            num_of_runs / sweep_time_wall_s);
+    printf("sweeps, rise time max %.2f ms, overshoot max %.2f %%, tick mean %.1f ns\n", rise_time_max_ms, overshoot_max_percent,
+                                                                                      tick_time_mean_sum_ns / num_of_runs);
+    printf("%d errors\n", num_of_errors);
+    return num_of_errors > 0 ? 1 : 0;
+}
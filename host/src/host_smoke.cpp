@@ -0,0 +1,323 @@
+// smoke test of the host build, the drivers of lib/ run unchanged against the simulated mbed of host/mbed in
+// virtual time: a DCMotor drives a DCMotorPlant, the I2CBus merges register reads, the IMU and the SensorBar
+// read scripted I2C devices on a shared I2CBus, the LineFollower reads the SensorBar, the SDLogger writes to a
+// temporary directory, the SerialStream and the GPA send to pseudo terminals
+//
+// build and run from the repository root:
+//   cmake -S host -B build_host && cmake --build build_host -j
+//   ./build_host/host_smoke
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mbed.h"
+#include "PESBoardPinMap.h"
+#include "DCMotor.h"
+#include "DCMotorPlant.h"
+#include "I2CBus.h"
+#include "IMU.h"
+#include "SensorBar.h"
+#include "LineFollower.h"
+#include "SDLogger.h"
+#include "SerialStream.h"
+#include "GPA.h"
+
+// period of the DCMotor thread
+static const int64_t MOTOR_PERIOD_MUS = 500;
+
+static int num_of_errors = 0;
+
+static void check(const char* name, bool ok)
+{
+    printf("%-70s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok)
+        num_of_errors++;
+}
+
+// LSM9DS1 accelerometer and gyro, at rest and level, a new sample is always available
+class LSM9DS1XG : public mbed_host::I2CRegisterDevice
+{
+public:
+    LSM9DS1XG() : I2CRegisterDevice(0xD6)
+    {
+        setRegister(0x0F, 0x68); // WHO_AM_I_XG
+        setRegister(0x17, 0x07); // STATUS_REG_0, temperature, gyro and acc data available
+        setRegister(0x27, 0x07); // STATUS_REG_1
+        const uint8_t acc[6] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x40}; // 1 g in z, 16384 at +/- 2 g
+        setRegisters(0x28, acc, 6);
+    }
+};
+
+// LSM9DS1 magnetometer
+class LSM9DS1M : public mbed_host::I2CRegisterDevice
+{
+public:
+    LSM9DS1M() : I2CRegisterDevice(0x3C)
+    {
+        setRegister(0x0F, 0x3D); // WHO_AM_I_M
+        setRegister(0x27, 0x0F); // STATUS_REG_M
+        const uint8_t mag[6] = {0x00, 0x10, 0x00, 0x00, 0x00, 0x00};
+        setRegisters(0x28, mag, 6);
+    }
+};
+
+// SX1509 of the sensor bar, port A carries the 8 line sensors
+class SX1509 : public mbed_host::I2CRegisterDevice
+{
+public:
+    SX1509() : I2CRegisterDevice(0x3E << 1)
+    {
+        setRegister(0x13, 0xFF); // REG_INTERRUPT_MASK_A, reset value 0xFF00 of the communication test
+        setRegister(0x14, 0x00);
+    }
+    void setLine(uint8_t bits) { setRegister(0x11, bits); } // REG_DATA_A
+};
+
+// register reads that are queued at the same time and continue each other are read in one burst
+static void checkI2CBusMerge()
+{
+    mbed_host::I2CRegisterDevice device(0x40);
+    const uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    device.setRegisters(0x20, data, 8);
+
+    // the bus thread runs below the main thread, so all reads are queued before the first is executed
+    I2CBus bus(PB_IMU_SDA, PB_IMU_SCL, I2C_BUS_FREQUENCY_DEFAULT, osPriorityBelowNormal);
+    bus.addDevice(0x40);
+    uint8_t dest[4][2] = {};
+    int results[4] = {-1, -1, -1, -1};
+    for (int i = 0; i < 4; i++)
+        bus.readRegisters(0x40, 0x20 + 2 * i, dest[i], 2, [&results, i](int result) { results[i] = result; });
+    mbed_host::runFor(10000);
+
+    bool is_data_ok = true;
+    for (int i = 0; i < 4; i++)
+        is_data_ok = is_data_ok && results[i] == 0 && dest[i][0] == data[2 * i] && dest[i][1] == data[2 * i + 1];
+    check("i2c bus, merged reads complete with their data", is_data_ok);
+    check("i2c bus, four reads in one burst", device.getNumOfReads() == 1 && bus.getStatistics(0x40).num_of_merged == 3);
+
+    // a device without auto increment is read register by register
+    device.setAutoIncrement(false);
+    bus.addDevice(0x40, false);
+    for (int i = 0; i < 4; i++)
+        bus.readRegisters(0x40, 0x20 + 2 * i, dest[i], 1, nullptr);
+    mbed_host::runFor(10000);
+    check("i2c bus, no merging without auto increment", device.getNumOfReads() == 5 && bus.getStatistics(0x40).num_of_merged == 3);
+}
+
+static void checkDCMotor()
+{
+    const float gear_ratio = 78.125f;
+    const float kn = 180.0f / 12.0f;
+    const float voltage_max = 12.0f;
+    DCMotorPlant plant(gear_ratio, kn, voltage_max, 20, 1.0e-6f * MOTOR_PERIOD_MUS);
+    mbed_host::setEncoderSource(PB_ENC_A_M1, [&plant]() { return plant.readEncoder(); });
+
+    DCMotor motor(PB_PWM_M1, PB_ENC_A_M1, PB_ENC_B_M1, gear_ratio, kn, voltage_max);
+
+    // the plant is stepped with the period of the motor, it sees the pwm of the previous tick
+    Ticker plant_ticker;
+    plant_ticker.attach([&plant]() { plant.update(mbed_host::getPwm(PB_PWM_M1)); }, std::chrono::microseconds(MOTOR_PERIOD_MUS));
+
+    motor.setVelocity(1.5f);
+    mbed_host::runFor(1000000);
+    check("dc motor, velocity 1.5 rps after 1 s", fabsf(motor.getVelocity() - 1.5f) < 0.075f);
+    check("dc motor, plant velocity matches the encoder velocity", fabsf(plant.getVelocity() - motor.getVelocity()) < 0.075f);
+
+    motor.setVelocity(0.0f);
+    mbed_host::runFor(1000000);
+    check("dc motor, stops", fabsf(motor.getVelocity()) < 0.075f);
+
+    plant_ticker.detach();
+    mbed_host::setEncoderSource(PB_ENC_A_M1, nullptr);
+}
+
+static void checkIMUAndSensorBar()
+{
+    LSM9DS1XG xg;
+    LSM9DS1M m;
+    SX1509 sx1509;
+    sx1509.setLine(0x18); // the two center sensors
+
+    I2CBus bus(PB_IMU_SDA, PB_IMU_SCL);
+    IMU imu(bus);
+    SensorBar sensor_bar(bus, 0.1f);
+
+    // 1 s offset calibration of the imu, then the filter converges
+    mbed_host::runFor(3000000);
+    const ImuData imu_data = imu.getImuData();
+    check("imu, acc z is 1 g after the calibration", fabsf(imu_data.acc(2) - 9.81f) < 0.1f);
+    check("imu, level", fabsf(imu_data.rpy(0)) < 0.02f && fabsf(imu_data.rpy(1)) < 0.02f && imu_data.tilt < 0.02f);
+    check("imu, the accelerometer and gyro are read", xg.getNumOfReads() > 100);
+
+    check("sensor bar, raw value", sensor_bar.getRaw() == 0x18);
+    check("sensor bar, two leds active", sensor_bar.getNrOfLedsActive() == 2);
+    check("sensor bar, line in the center", fabsf(sensor_bar.getAngleRad()) < 1.0e-4f);
+    check("sensor bar, samples every 4 ms", sensor_bar.getSampleCount() >= 3000000 / SensorBar::PERIOD_MUS - 10);
+
+    sx1509.setLine(0x80); // the outermost sensor of one side
+    mbed_host::runFor(100000);
+    check("sensor bar, line at the side", sensor_bar.getNrOfLedsActive() == 1 && fabsf(sensor_bar.getAngleRad()) > 0.1f);
+}
+
+static void checkLineFollower()
+{
+    SX1509 sx1509;
+    sx1509.setLine(0x18);
+    LineFollower line_follower(PB_IMU_SDA, PB_IMU_SCL, 0.1f, 0.05f, 0.15f, 2.0f);
+    mbed_host::runFor(100000);
+    check("line follower, line in the center", fabsf(line_follower.getAngleRadians()) < 1.0e-4f);
+
+    // the step of the next period already uses the sample of the same period
+    sx1509.setLine(0x80);
+    mbed_host::runFor(SensorBar::PERIOD_MUS);
+    check("line follower, reacts within one period", fabsf(line_follower.getAngleRadians()) > 1.0e-3f);
+}
+
+static void checkSDLogger(const char* sd_dir)
+{
+    const int num_of_records = 1000;
+    {
+        SDLogger sd_logger(PB_SD_MOSI, PB_SD_MISO, PB_SD_SCK, PB_SD_CS, 4);
+        for (int i = 0; i < num_of_records; i++) {
+            for (int j = 0; j < 4; j++)
+                sd_logger.write(static_cast<float>(4 * i + j));
+            mbed_host::runFor(1000);
+        }
+        // the destructor writes the rest of the buffer and closes the file
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/data/000.bin", sd_dir);
+    FILE* file = fopen(path, "rb");
+    check("sd logger, file /sd/data/000.bin", file != nullptr);
+    if (!file)
+        return;
+    struct stat file_stat;
+    fstat(fileno(file), &file_stat);
+    check("sd logger, header byte and every record", file_stat.st_size == 1 + num_of_records * 4 * static_cast<off_t>(sizeof(float)));
+
+    uint8_t num_of_floats = 0;
+    float values[4 * 2] = {0};
+    const bool read_ok = fread(&num_of_floats, 1, 1, file) == 1 && fread(values, sizeof(float), 8, file) == 8;
+    fclose(file);
+    check("sd logger, header is the number of floats", read_ok && num_of_floats == 4);
+    bool values_ok = read_ok;
+    for (int i = 0; i < 8; i++)
+        values_ok = values_ok && values[i] == static_cast<float>(i);
+    check("sd logger, first records", values_ok);
+}
+
+// reads length bytes from the non-blocking fd, lets the simulation run while waiting
+static int readAll(int fd, uint8_t* data, int length)
+{
+    int num_of_bytes = 0;
+    for (int i = 0; i < 100 && num_of_bytes < length; i++) {
+        mbed_host::runFor(1000);
+        const ssize_t n = read(fd, data + num_of_bytes, length - num_of_bytes);
+        if (n > 0)
+            num_of_bytes += static_cast<int>(n);
+    }
+    return num_of_bytes;
+}
+
+static void checkSerialStream()
+{
+    SerialStream serial_stream(PB_UNUSED_UART_TX, PB_UNUSED_UART_RX, 3);
+    const char* port_name = mbed_host::getSerialPortName(PB_UNUSED_UART_TX);
+    if (!port_name) {
+        printf("serial stream, no pseudo terminal, skipped\n");
+        return;
+    }
+    const int fd = open(port_name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    check("serial stream, pseudo terminal opens", fd >= 0);
+    if (fd < 0)
+        return;
+
+    const uint8_t start_byte = S_STREAM_START_BYTE;
+    check("serial stream, start byte written", write(fd, &start_byte, 1) == 1);
+    bool start_byte_received = false;
+    for (int i = 0; i < 100 && !start_byte_received; i++) {
+        mbed_host::runFor(1000);
+        start_byte_received = serial_stream.startByteReceived();
+    }
+    check("serial stream, start byte received", start_byte_received);
+
+    serial_stream.write(1.0f);
+    serial_stream.write(2.0f);
+    serial_stream.write(3.0f);
+    serial_stream.send();
+
+    // number of floats once, then the frame header and the floats
+    uint8_t data[1 + S_STREAM_FRAME_HEADER_SIZE + 3 * sizeof(float)];
+    const int num_of_bytes = readAll(fd, data, sizeof(data));
+    close(fd);
+    check("serial stream, number of floats and the first frame", num_of_bytes == static_cast<int>(sizeof(data)) && data[0] == 3);
+    float values[3];
+    memcpy(values, data + 1 + S_STREAM_FRAME_HEADER_SIZE, sizeof(values));
+    check("serial stream, values of the frame", values[0] == 1.0f && values[1] == 2.0f && values[2] == 3.0f);
+}
+
+static void checkGPA()
+{
+    const float Ts = 0.001f;
+    GPA gpa(2.0f, 50.0f, 5, 3, 200, Ts, 0.5f, 0.5f, 0, 0, false, true);
+
+    // static gain of 2, every frequency point has a magnitude of 2
+    float exc = 0.0f;
+    int num_of_points = 0;
+    bool gain_ok = true;
+    GPA::gpadata_t data = gpa.getGPAdata();
+    for (int i = 0; i < 200000 && !data.MeasFinished; i++) {
+        exc = gpa.update(exc, 2.0f * exc);
+        data = gpa.getGPAdata();
+        if (data.MeasPointFinished) {
+            num_of_points++;
+            const float U = hypotf(data.Ureal, data.Uimag);
+            const float Y = hypotf(data.Yreal, data.Yimag);
+            gain_ok = gain_ok && U > 0.0f && fabsf(Y / U - 2.0f) < 0.01f;
+        }
+        if (i % 10 == 0)
+            mbed_host::runFor(10 * static_cast<int64_t>(1.0e6f * Ts));
+    }
+    check("gpa, measurement finished", data.MeasFinished);
+    check("gpa, every frequency point", num_of_points == gpa.getNumOfFreqPoints());
+    check("gpa, magnitude of a static gain", gain_ok);
+
+    // one output is measured, channel 0 is the output of getGPAdata() and other channels are invalid
+    const GPA::gpadata_t data_0 = gpa.getGPAdata(0);
+    const GPA::gpadata_t data_1 = gpa.getGPAdata(1);
+    check("gpa, channel 0 is the measured output", data_0.Yreal == data.Yreal && data_0.Yimag == data.Yimag && data_0.ind == data.ind);
+    check("gpa, a channel that is not measured is zeroed", data_1.ind == -1 && data_1.Yreal == 0.0f && data_1.fexc == 0.0f &&
+                                                           gpa.getGPAdata(-1).ind == -1);
+}
+
+int main()
+{
+    // the sd card is a temporary directory unless MBED_HOST_SD_DIR is set
+    char sd_dir[] = "/tmp/pm3_host_sd_XXXXXX";
+    if (!getenv("MBED_HOST_SD_DIR")) {
+        if (!mkdtemp(sd_dir)) {
+            printf("host smoke, can not create %s\n", sd_dir);
+            return 1;
+        }
+        setenv("MBED_HOST_SD_DIR", sd_dir, 1);
+    }
+
+    checkDCMotor();
+    checkI2CBusMerge();
+    checkIMUAndSensorBar();
+    checkLineFollower();
+    checkSDLogger(getenv("MBED_HOST_SD_DIR"));
+    checkSerialStream();
+    checkGPA();
+
+    printf("%.3f s of virtual time, %llu events, %llu thread switches\n", 1.0e-6 * mbed_host::getTime_us(),
+           static_cast<unsigned long long>(mbed_host::getNumOfEvents()), static_cast<unsigned long long>(mbed_host::getNumOfSwitches()));
+    printf("%d errors\n", num_of_errors);
+    return num_of_errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+#include "AdcScan.h"
+
+#if defined(TARGET_STM32F4)
+#include "pinmap.h"
+#include "PeripheralPins.h"
+#endif
+
+AdcScan* AdcScan::s_instance = nullptr;
+
+AdcScan::AdcScan()
+{
+    if (s_instance) {
+        printf("AdcScan: only one object can use ADC2\n");
+        return;
+    }
+    s_instance = this;
+
+#if defined(TARGET_STM32F4)
+    // enable clocks of ADC2 and DMA2
+    RCC->APB2ENR |= RCC_APB2ENR_ADC2EN;
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+
+    // adc clock is PCLK2 / 4 like AnalogIn uses it, the prescaler is shared by all ADCs
+    ADC123_COMMON->CCR = (ADC123_COMMON->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0;
+#else
+    printf("AdcScan: the target is not supported\n");
+#endif
+}
+
+AdcScan::~AdcScan()
+{
+    if (s_instance != this)
+        return;
+    stop();
+    s_instance = nullptr;
+}
+
+int AdcScan::addChannel(PinName pin)
+{
+#if defined(TARGET_STM32F4)
+    if (s_instance != this || m_num_of_channels == ADC_SCAN_NUM_OF_CHANNELS_MAX) {
+        printf("AdcScan: no channel left for the pin\n");
+        return -1;
+    }
+
+    // channels 0 - 15 are the pins, ADC2 has the same pins as ADC1 (internal channels are only on ADC1)
+    const uint32_t function = pinmap_find_function(pin, PinMap_ADC);
+    if (function == static_cast<uint32_t>(NC) || STM_PIN_CHANNEL(function) > 15) {
+        printf("AdcScan: the pin is not connected to ADC2\n");
+        return -1;
+    }
+    // analog mode
+    pin_function(pin, function);
+
+    stop();
+    const int channel = m_num_of_channels;
+    m_adc_channels[channel] = static_cast<uint8_t>(STM_PIN_CHANNEL(function));
+    m_num_of_channels++;
+    start();
+
+    return channel;
+#else
+    (void)pin;
+    return -1;
+#endif
+}
+
+float AdcScan::readmV(int channel) const
+{
+    if (channel < 0 || channel >= m_num_of_channels)
+        return 0.0f;
+    return m_data_published.read().mV[channel];
+}
+
+AdcScanData AdcScan::getData() const
+{
+    return m_data_published.read();
+}
+
+void AdcScan::start()
+{
+#if defined(TARGET_STM32F4)
+    const int n = m_num_of_channels;
+
+    // the averages start again with the first block
+    m_blocks_idx = 0;
+    m_is_first_block = true;
+
+    // scan mode, 12 bit, sampling time and regular sequence of all channels
+    ADC2->CR1 = ADC_CR1_SCAN;
+    ADC2->SMPR1 = 0;
+    ADC2->SMPR2 = 0;
+    ADC2->SQR1 = static_cast<uint32_t>(n - 1) << 20; // sequence length L
+    ADC2->SQR2 = 0;
+    ADC2->SQR3 = 0;
+    for (int i = 0; i < n; i++) {
+        const uint32_t adc_channel = m_adc_channels[i];
+        if (adc_channel < 10)
+            ADC2->SMPR2 |= ADC_SCAN_SAMPLE_TIME << (3 * adc_channel);
+        else
+            ADC2->SMPR1 |= ADC_SCAN_SAMPLE_TIME << (3 * (adc_channel - 10));
+        if (i < 6)
+            ADC2->SQR3 |= adc_channel << (5 * i);
+        else if (i < 12)
+            ADC2->SQR2 |= adc_channel << (5 * (i - 6));
+        else
+            ADC2->SQR1 |= adc_channel << (5 * (i - 12));
+    }
+
+    // dma2 stream 2 channel 1 copies ADC2->DR into the circular buffer, with an interrupt after each half
+    DMA2->LIFCR = DMA_LIFCR_CFEIF2 | DMA_LIFCR_CDMEIF2 | DMA_LIFCR_CTEIF2 | DMA_LIFCR_CHTIF2 | DMA_LIFCR_CTCIF2;
+    DMA2_Stream2->PAR = reinterpret_cast<uint32_t>(&ADC2->DR);
+    DMA2_Stream2->M0AR = reinterpret_cast<uint32_t>(m_buffer);
+    DMA2_Stream2->NDTR = 2 * ADC_SCAN_OVERSAMPLING * n;
+    DMA2_Stream2->FCR = 0; // direct mode
+    DMA2_Stream2->CR = DMA_SxCR_CHSEL_0 |  // channel 1
+                       DMA_SxCR_PL_1 |     // high priority
+                       DMA_SxCR_MSIZE_0 |  // 16 bit
+                       DMA_SxCR_PSIZE_0 |  // 16 bit
+                       DMA_SxCR_MINC |
+                       DMA_SxCR_CIRC |
+                       DMA_SxCR_HTIE |
+                       DMA_SxCR_TCIE;
+    NVIC_SetVector(DMA2_Stream2_IRQn, reinterpret_cast<uint32_t>(&AdcScan::onDmaInterrupt));
+    NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+    DMA2_Stream2->CR |= DMA_SxCR_EN;
+
+    // continuous conversions, dma requests as long as the dma is enabled
+    ADC2->CR2 = ADC_CR2_CONT | ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_ADON;
+    wait_us(3); // stabilisation time of the ADC
+    ADC2->CR2 |= ADC_CR2_SWSTART;
+#endif
+}
+
+void AdcScan::stop()
+{
+#if defined(TARGET_STM32F4)
+    ADC2->CR2 = 0;
+    DMA2_Stream2->CR &= ~DMA_SxCR_EN;
+    while (DMA2_Stream2->CR & DMA_SxCR_EN) {};
+    NVIC_DisableIRQ(DMA2_Stream2_IRQn);
+    ADC2->SR = 0;
+#endif
+}
+
+// called from the dma interrupt, a block holds ADC_SCAN_OVERSAMPLING scans of all channels
+void AdcScan::processBlock(const uint16_t* block)
+{
+    const int n = m_num_of_channels;
+    for (int i = 0; i < n; i++) {
+        uint32_t sum = 0;
+        for (int k = 0; k < ADC_SCAN_OVERSAMPLING; k++)
+            sum += block[k * n + i];
+        const uint16_t value = static_cast<uint16_t>(sum >> OVERSAMPLING_SHIFT);
+
+        // moving average, the first block fills the whole window
+        if (m_is_first_block) {
+            for (int j = 0; j < ADC_SCAN_AVG_N; j++)
+                m_blocks[i][j] = value;
+            m_blocks_sum[i] = ADC_SCAN_AVG_N * static_cast<uint32_t>(value);
+        } else {
+            m_blocks_sum[i] += value;
+            m_blocks_sum[i] -= m_blocks[i][m_blocks_idx];
+            m_blocks[i][m_blocks_idx] = value;
+        }
+        m_data.mV[i] = static_cast<float>(m_blocks_sum[i]) * (VOLTAGE_MV / (RESOLUTION * ADC_SCAN_AVG_N));
+    }
+    if (++m_blocks_idx == ADC_SCAN_AVG_N)
+        m_blocks_idx = 0;
+    m_is_first_block = false;
+
+    m_data.num_of_blocks++;
+    m_data_published.publish(m_data);
+}
+
+void AdcScan::onDmaInterrupt()
+{
+#if defined(TARGET_STM32F4)
+    const uint32_t flags = DMA2->LISR;
+    DMA2->LIFCR = DMA_LIFCR_CFEIF2 | DMA_LIFCR_CDMEIF2 | DMA_LIFCR_CTEIF2 | DMA_LIFCR_CHTIF2 | DMA_LIFCR_CTCIF2;
+
+    AdcScan* scan = s_instance;
+    if (!scan)
+        return;
+
+    // first half is complete, the dma writes the second half now and vice versa
+    if (flags & DMA_LISR_HTIF2)
+        scan->processBlock(&scan->m_buffer[0]);
+    if (flags & DMA_LISR_TCIF2)
+        scan->processBlock(&scan->m_buffer[ADC_SCAN_OVERSAMPLING * scan->m_num_of_channels]);
+#endif
+}
@@ -0,0 +1,106 @@
+/**
+ * @file AdcScan.h
+ * @brief Samples several analog pins continuously with the ADC and DMA, without a thread
+ *
+ * The ADC converts all channels one after the other in scan mode and starts over immediately
+ * (continuous mode), the DMA writes the conversions into a circular buffer that holds two blocks
+ * of ADC_SCAN_OVERSAMPLING scans. Whenever a block is complete the DMA interrupt
+ * - sums the ADC_SCAN_OVERSAMPLING samples of every channel and keeps 14 bit (16x oversampling, +2 bit),
+ * - averages the last ADC_SCAN_AVG_N blocks of every channel with integer arithmetic,
+ * - publishes the values of all channels in millivolts as one snapshot.
+ * No cpu time is spent on the single conversions and adding a channel does not add a thread.
+ *
+ * The engine uses ADC2 and DMA2 stream 2 of the STM32F4, so AnalogIn objects (they use ADC1) can be used
+ * at the same time, and only one AdcScan object can exist. The pins have to be connected to ADC2, on the
+ * NUCLEO_F446RE these are PA_0 - PA_7, PB_0, PB_1 and PC_0 - PC_5.
+ *
+ * With 480 cycles sampling time one conversion takes about 22 us, so a block takes
+ * 16 * 22 us * number of channels, e.g. 1.4 ms for 4 channels and the average spans 8 blocks.
+ *
+ * @dependencies
+ * This class relies on the following components:
+ * - **ADC2**, **DMA2**: Registers of the STM32F4
+ * - **Published**: For the snapshot of all channels
+ *
+ * @example
+ * ```cpp
+ * AdcScan adc_scan;
+ * const int channel = adc_scan.addChannel(PC_2);
+ * const float ir_mV = adc_scan.readmV(channel);
+ *
+ * // or let the IRSensor use the scan instead of an own thread and AnalogIn
+ * IRSensor ir_sensor(adc_scan, PC_2, 2.574e+04f, -29.37f);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef ADC_SCAN_H_
+#define ADC_SCAN_H_
+
+#include "mbed.h"
+
+#include "Published.h"
+
+#define ADC_SCAN_NUM_OF_CHANNELS_MAX 16 // length of the regular sequence of the ADC
+#define ADC_SCAN_OVERSAMPLING 16        // samples per block, 16 samples give 2 additional bits
+#define ADC_SCAN_AVG_N 8                // averaged blocks
+#define ADC_SCAN_SAMPLE_TIME 7          // SMPx bits, 7 = 480 cycles for sensors with a high output impedance
+
+// snapshot of all channels after a block
+class AdcScanData
+{
+public:
+    AdcScanData() = default;
+    ~AdcScanData() = default;
+
+    float mV[ADC_SCAN_NUM_OF_CHANNELS_MAX]{};
+    uint32_t num_of_blocks{0};
+};
+
+class AdcScan
+{
+public:
+    explicit AdcScan();
+    virtual ~AdcScan();
+
+    // adds a pin to the sequence and restarts the scan, returns the channel or -1 if the pin
+    // is not connected to ADC2 or there are already ADC_SCAN_NUM_OF_CHANNELS_MAX channels
+    int addChannel(PinName pin);
+    int getNumOfChannels() const { return m_num_of_channels; }
+
+    // averaged voltage of the channel in millivolts
+    float readmV(int channel) const;
+
+    AdcScanData getData() const;
+
+private:
+    static constexpr float VOLTAGE_MV = 3300.0f;
+    static constexpr uint32_t OVERSAMPLING_SHIFT = 2; // sum of 16 * 12 bit >> 2 = 14 bit
+    static constexpr float RESOLUTION = 16384.0f;     // 14 bit
+    // 4^n samples give n additional bits
+    static_assert(ADC_SCAN_OVERSAMPLING == (1 << (2 * OVERSAMPLING_SHIFT)), "ADC_SCAN_OVERSAMPLING does not match OVERSAMPLING_SHIFT");
+
+    static AdcScan* s_instance; // the dma interrupt has no argument
+
+    uint8_t m_adc_channels[ADC_SCAN_NUM_OF_CHANNELS_MAX];
+    int m_num_of_channels{0};
+
+    // two blocks, the dma fills one while the interrupt processes the other
+    uint16_t m_buffer[2 * ADC_SCAN_OVERSAMPLING * ADC_SCAN_NUM_OF_CHANNELS_MAX];
+
+    // moving average over the last ADC_SCAN_AVG_N blocks of every channel, only used in the interrupt
+    uint16_t m_blocks[ADC_SCAN_NUM_OF_CHANNELS_MAX][ADC_SCAN_AVG_N];
+    uint32_t m_blocks_sum[ADC_SCAN_NUM_OF_CHANNELS_MAX];
+    uint8_t m_blocks_idx{0};
+    bool m_is_first_block{true};
+
+    AdcScanData m_data;
+    Published<AdcScanData> m_data_published;
+
+    void start();
+    void stop();
+    void processBlock(const uint16_t* block);
+    static void onDmaInterrupt();
+};
+#endif /* ADC_SCAN_H_ */
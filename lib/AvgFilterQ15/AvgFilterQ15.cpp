@@ -0,0 +1,61 @@
+#include "AvgFilterQ15.h"
+
+#include <stdlib.h>
+
+AvgFilterQ15::AvgFilterQ15(uint8_t N)
+{
+    init(N);
+}
+
+AvgFilterQ15::~AvgFilterQ15() {
+    if (m_ring_buffer) {
+        free(m_ring_buffer);
+        m_ring_buffer = nullptr;
+    }
+}
+
+void AvgFilterQ15::init(uint8_t N)
+{
+    m_N = N;
+    // allocate space for the ring buffer (each element is a q15_t)
+    m_ring_buffer = (q15_t*)malloc(m_N * sizeof(q15_t));
+    // reset the filter (fills ring buffer with zeros by default)
+    reset();
+}
+
+q15_t AvgFilterQ15::reset(q15_t val)
+{
+    // start writing at index 0
+    m_idx = 0;
+
+    // fill the ring buffer with val
+    for (uint8_t i = 0; i < m_N; i++)
+        m_ring_buffer[i] = val;
+
+    m_sum = static_cast<int32_t>(val) * m_N;
+    m_val = val;
+
+    return m_val;
+}
+
+q15_t AvgFilterQ15::apply(q15_t inp)
+{
+    // replace the oldest sample in the sum, at most 255 * 2^15 so it can not overflow
+    m_sum += static_cast<int32_t>(inp) - m_ring_buffer[m_idx];
+    m_ring_buffer[m_idx] = inp;
+
+    // move to the next position in the ring buffer (wrap around if needed)
+    m_idx++;
+    if (m_idx == m_N)
+        m_idx = 0;
+
+    m_val = average();
+    return m_val;
+}
+
+q15_t AvgFilterQ15::average() const
+{
+    // integer division rounded to nearest, half away from zero
+    const int32_t half = m_N / 2;
+    return fixedSaturateQ15((m_sum >= 0) ? (m_sum + half) / m_N : (m_sum - half) / m_N);
+}
@@ -0,0 +1,50 @@
+/**
+ * @file AvgFilterQ15.h
+ * @brief Fixed-point variant of AvgFilter for Q15 signals.
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef AVG_FILTER_Q15_H_
+#define AVG_FILTER_Q15_H_
+
+#include "FixedPoint.h"
+
+/**
+ * Moving average of N Q15 samples. The sum of the samples is kept exactly in an int32, so unlike
+ * the float version it does not drift, the average is rounded to the nearest Q15 value.
+ */
+class AvgFilterQ15
+{
+public:
+    // default constructor (does nothing by itself)
+    explicit AvgFilterQ15() {};
+
+    // constructor that initializes the filter with N samples
+    explicit AvgFilterQ15(uint8_t N);
+
+    // destructor
+    virtual ~AvgFilterQ15();
+
+    // initializes/allocates the ring buffer for N samples
+    void init(uint8_t N);
+
+    // resets the filter to 'val' (all samples become 'val')
+    q15_t reset(q15_t val = 0);
+
+    // applies the filter to a new input 'inp' and returns the updated average
+    q15_t apply(q15_t inp);
+
+    // returns the current average
+    q15_t read() const { return m_val; }
+
+private:
+    q15_t   m_val{0};                 // rounded average
+    int32_t m_sum{0};                 // exact sum of the samples
+    uint8_t m_N{0};                   // number of samples in the filter
+    uint8_t m_idx{0};                 // current index for the ring buffer
+    q15_t*  m_ring_buffer{nullptr};   // dynamically allocated array storing the samples
+
+    q15_t average() const;
+};
+
+#endif /* AVG_FILTER_Q15_H_ */
@@ -0,0 +1,114 @@
+/**
+ * @file BiquadBank.h
+ * @brief N second order IIR filters that are applied in one loop.
+ *
+ * The coefficients and states of all channels are stored as parallel arrays (structure of arrays),
+ * apply() updates all channels in one loop with a fixed trip count and without branches, so the
+ * compiler can unroll it and keep the coefficients in registers. Every channel is a second order
+ * filter in transposed direct form II like IIRFilter, a first order filter has b2 = a2 = 0.
+ *
+ * The filters are designed with IIRFilter and copied into the bank with setFilter(), apply(ch, input)
+ * is the scalar fallback for a single channel. docs/dev/dev_controller_bank compares the bank with
+ * IIRFilter objects on the host.
+ *
+ * Example:
+ * ```
+ * IIRFilter lowpass, notch;
+ * lowpass.lowPass2Init(15.0f, 1.0f, TS);
+ * notch.notchInit(120.0f, 0.5f, TS);
+ *
+ * BiquadBank<2> filters;
+ * filters.setFilter(0, lowpass);
+ * filters.setFilter(1, notch);
+ *
+ * // every period
+ * filters.apply(inputs, outputs);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef BIQUAD_BANK_H_
+#define BIQUAD_BANK_H_
+
+#include <stddef.h>
+
+#include "IIRFilter.h"
+
+template <size_t N>
+class BiquadBank
+{
+public:
+    explicit BiquadBank()
+    {
+        for (size_t i = 0; i < N; i++) {
+            // pass through
+            m_b0[i] = 1.0f;
+            m_b1[i] = m_b2[i] = m_a1[i] = m_a2[i] = 0.0f;
+            m_w1[i] = m_w2[i] = 0.0f;
+        }
+    }
+    virtual ~BiquadBank() = default;
+
+    static constexpr size_t size() { return N; }
+
+    // copies the coefficients and the state of filter to channel ch
+    void setFilter(size_t ch, const IIRFilter& filter)
+    {
+        float B[3], A[2], w[2];
+        filter.getBiquad(B, A, w);
+        setCoefficients(ch, B[0], B[1], B[2], A[0], A[1]);
+        m_w1[ch] = w[0];
+        m_w2[ch] = w[1];
+    }
+
+    // y = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2) x, the state is kept
+    void setCoefficients(size_t ch, float b0, float b1, float b2, float a1, float a2)
+    {
+        m_b0[ch] = b0;
+        m_b1[ch] = b1;
+        m_b2[ch] = b2;
+        m_a1[ch] = a1;
+        m_a2[ch] = a2;
+    }
+
+    // the output of channel ch is output for a constant input of output (unity DC gain)
+    void reset(size_t ch, float output)
+    {
+        m_w1[ch] = output * (1.0f - m_b0[ch]);
+        m_w2[ch] = output * (m_b2[ch] - m_a2[ch]);
+    }
+
+    void reset(float output = 0.0f)
+    {
+        for (size_t i = 0; i < N; i++)
+            reset(i, output);
+    }
+
+    // applies all channels, input and output hold N values and may be the same array
+    void apply(const float* input, float* output)
+    {
+        for (size_t i = 0; i < N; i++) {
+            const float x = input[i];
+            const float y = m_b0[i] * x + m_w1[i];
+            m_w1[i] = m_b1[i] * x + m_w2[i] - m_a1[i] * y;
+            m_w2[i] = m_b2[i] * x - m_a2[i] * y;
+            output[i] = y;
+        }
+    }
+
+    // scalar fallback, applies channel ch only
+    float apply(size_t ch, float input)
+    {
+        const float y = m_b0[ch] * input + m_w1[ch];
+        m_w1[ch] = m_b1[ch] * input + m_w2[ch] - m_a1[ch] * y;
+        m_w2[ch] = m_b2[ch] * input - m_a2[ch] * y;
+        return y;
+    }
+
+private:
+    float m_b0[N], m_b1[N], m_b2[N];
+    float m_a1[N], m_a2[N];
+    float m_w1[N], m_w2[N];
+};
+#endif /* BIQUAD_BANK_H_ */
@@ -0,0 +1,163 @@
+#include "ControlSchedule.h"
+
+#include <stdio.h>
+
+ControlSchedule::ControlSchedule(uint32_t period_us) : m_period_us(period_us)
+{
+    for (int i = 0; i < CONTROL_SCHEDULER_NUM_OF_TASKS_MAX; i++)
+        m_order[i] = i;
+}
+
+int ControlSchedule::addTask(uint32_t divisor)
+{
+    if (divisor == 0) {
+        printf("ControlScheduler: invalid divisor\n");
+        return -1;
+    }
+
+    int id = -1;
+    for (int i = 0; i < CONTROL_SCHEDULER_NUM_OF_TASKS_MAX; i++) {
+        if (!m_tasks[i].is_active) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0) {
+        printf("ControlScheduler: all %d task slots are in use\n", CONTROL_SCHEDULER_NUM_OF_TASKS_MAX);
+        return -1;
+    }
+
+    m_tasks[id].divisor = divisor;
+    m_tasks[id].cntr = 0; // execute in the next tick
+    m_tasks[id].deadline_miss_cntr = 0;
+    m_tasks[id].exec_time_max_us = 0;
+    m_tasks[id].is_active = true;
+    updateOrder();
+    return id;
+}
+
+int ControlSchedule::addTaskWithPeriod(int64_t period_us)
+{
+    const int64_t base_period_us = static_cast<int64_t>(m_period_us);
+    if (period_us < base_period_us || (period_us % base_period_us) != 0) {
+        printf("ControlScheduler: period of %d us is not a multiple of %d us\n",
+               static_cast<int>(period_us),
+               static_cast<int>(base_period_us));
+        return -1;
+    }
+
+    return addTask(static_cast<uint32_t>(period_us / base_period_us));
+}
+
+void ControlSchedule::removeTask(int id)
+{
+    if (!isValidId(id))
+        return;
+
+    m_tasks[id].is_active = false;
+    updateOrder();
+}
+
+void ControlSchedule::beginTick(int64_t time_us)
+{
+    m_ind = 0;
+    m_tick_start_us = time_us;
+    m_task_start_us = time_us;
+}
+
+int ControlSchedule::nextTask()
+{
+    // tasks are sorted by divisor, so tasks with the shortest period are executed first
+    while (m_ind < m_num_of_tasks) {
+        const int id = m_order[m_ind++];
+        task_t& task = m_tasks[id];
+        const bool is_due = (task.cntr == 0);
+        if (is_due)
+            task.cntr = task.divisor;
+        task.cntr--;
+        if (is_due)
+            return id;
+    }
+    return -1;
+}
+
+void ControlSchedule::endTask(int id, int64_t time_us)
+{
+    // measure execution time and check if the task finished within its own period
+    task_t& task = m_tasks[id];
+    const uint32_t exec_time_us = static_cast<uint32_t>(time_us - m_task_start_us);
+    if (exec_time_us > task.exec_time_max_us)
+        task.exec_time_max_us = exec_time_us;
+    if (time_us - m_tick_start_us > static_cast<int64_t>(task.divisor) * m_period_us)
+        task.deadline_miss_cntr++;
+    m_task_start_us = time_us;
+}
+
+void ControlSchedule::endTick(int64_t time_us)
+{
+    // a tick longer than the period means that at least one thread flag got lost
+    const uint32_t tick_exec_time_us = static_cast<uint32_t>(time_us - m_tick_start_us);
+    if (tick_exec_time_us > m_tick_exec_time_max_us)
+        m_tick_exec_time_max_us = tick_exec_time_us;
+    if (tick_exec_time_us > m_period_us)
+        m_tick_overrun_cntr++;
+}
+
+uint32_t ControlSchedule::getDivisor(int id) const
+{
+    return isValidId(id) ? m_tasks[id].divisor : 0;
+}
+
+uint32_t ControlSchedule::getDeadlineMissCount(int id) const
+{
+    return isValidId(id) ? m_tasks[id].deadline_miss_cntr : 0;
+}
+
+uint32_t ControlSchedule::getExecTimeMax_us(int id) const
+{
+    return isValidId(id) ? m_tasks[id].exec_time_max_us : 0;
+}
+
+void ControlSchedule::resetDiagnostics()
+{
+    for (int i = 0; i < CONTROL_SCHEDULER_NUM_OF_TASKS_MAX; i++) {
+        m_tasks[i].deadline_miss_cntr = 0;
+        m_tasks[i].exec_time_max_us = 0;
+    }
+    m_tick_overrun_cntr = 0;
+    m_tick_exec_time_max_us = 0;
+}
+
+void ControlSchedule::printDiagnostics() const
+{
+    printf("ControlScheduler: %lu tasks, tick overruns: %lu, max. tick time: %lu us of %lu us\n",
+           static_cast<unsigned long>(m_num_of_tasks), static_cast<unsigned long>(m_tick_overrun_cntr),
+           static_cast<unsigned long>(m_tick_exec_time_max_us), static_cast<unsigned long>(m_period_us));
+    for (uint32_t i = 0; i < m_num_of_tasks; i++) {
+        const task_t& task = m_tasks[m_order[i]];
+        printf("  task %d: divisor %lu, deadline misses: %lu, max. exec. time: %lu us\n",
+               m_order[i], static_cast<unsigned long>(task.divisor),
+               static_cast<unsigned long>(task.deadline_miss_cntr), static_cast<unsigned long>(task.exec_time_max_us));
+    }
+}
+
+bool ControlSchedule::isValidId(int id) const
+{
+    return (id >= 0) && (id < CONTROL_SCHEDULER_NUM_OF_TASKS_MAX);
+}
+
+void ControlSchedule::updateOrder()
+{
+    // collect active tasks and sort them by divisor (insertion sort, stable)
+    m_num_of_tasks = 0;
+    for (int i = 0; i < CONTROL_SCHEDULER_NUM_OF_TASKS_MAX; i++) {
+        if (!m_tasks[i].is_active)
+            continue;
+        uint32_t j = m_num_of_tasks++;
+        while (j > 0 && m_tasks[m_order[j - 1]].divisor > m_tasks[i].divisor) {
+            m_order[j] = m_order[j - 1];
+            j--;
+        }
+        m_order[j] = i;
+    }
+}
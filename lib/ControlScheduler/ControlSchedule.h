@@ -0,0 +1,91 @@
+/**
+ * @file ControlSchedule.h
+ * @brief Rate-monotonic schedule of the ControlScheduler without mbed dependencies
+ *
+ * Holds the task table of the ControlScheduler: the period divisors, the rate-monotonic order and
+ * the deadline, execution time and overrun counters. It does not call the tasks and does not read
+ * a clock, the caller passes the time stamps, so the same schedule runs in the ControlScheduler
+ * thread and on the host against a virtual clock (docs/dev/dev_control_scheduler).
+ *
+ * One tick:
+ * ```cpp
+ * schedule.beginTick(time_us);
+ * for (int id = schedule.nextTask(); id >= 0; id = schedule.nextTask()) {
+ *     tasks[id]();
+ *     schedule.endTask(id, time_us);
+ * }
+ * schedule.endTick(time_us);
+ * ```
+ *
+ * A task with divisor n is due in the tick after it was added and then every n-th tick. Within a
+ * tick the tasks with the shortest period come first, tasks with the same period in the order of
+ * their ids.
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef CONTROL_SCHEDULE_H_
+#define CONTROL_SCHEDULE_H_
+
+#include <stdint.h>
+
+#define CONTROL_SCHEDULER_NUM_OF_TASKS_MAX 16
+
+class ControlSchedule
+{
+public:
+    explicit ControlSchedule(uint32_t period_us);
+    virtual ~ControlSchedule() = default;
+
+    uint32_t getPeriod_us() const { return m_period_us; }
+
+    // returns the task id >= 0 or -1 if the divisor is 0 or all slots are in use
+    int addTask(uint32_t divisor);
+    // returns the task id >= 0 or -1 if the period is not a multiple of the base period
+    int addTaskWithPeriod(int64_t period_us);
+    void removeTask(int id);
+
+    // one tick, the time stamps are in us of any clock that does not wrap
+    void beginTick(int64_t time_us);
+    // returns the id of the next task that is due in this tick, -1 if the tick is done
+    int nextTask();
+    void endTask(int id, int64_t time_us);
+    void endTick(int64_t time_us);
+
+    // diagnostics
+    uint32_t getNumOfTasks() const { return m_num_of_tasks; }
+    uint32_t getTickOverrunCount() const { return m_tick_overrun_cntr; }
+    uint32_t getTickExecTimeMax_us() const { return m_tick_exec_time_max_us; }
+    uint32_t getDivisor(int id) const;
+    uint32_t getDeadlineMissCount(int id) const;
+    uint32_t getExecTimeMax_us(int id) const;
+    void resetDiagnostics();
+    void printDiagnostics() const;
+
+private:
+    typedef struct task_s {
+        uint32_t divisor{0};
+        uint32_t cntr{0};
+        uint32_t deadline_miss_cntr{0};
+        uint32_t exec_time_max_us{0};
+        bool is_active{false};
+    } task_t;
+
+    uint32_t m_period_us;
+    task_t m_tasks[CONTROL_SCHEDULER_NUM_OF_TASKS_MAX];
+    uint8_t m_order[CONTROL_SCHEDULER_NUM_OF_TASKS_MAX]; // task ids sorted by divisor
+    uint32_t m_num_of_tasks{0};
+
+    // state of the current tick
+    uint32_t m_ind{0};
+    int64_t m_tick_start_us{0};
+    int64_t m_task_start_us{0};
+
+    uint32_t m_tick_overrun_cntr{0};
+    uint32_t m_tick_exec_time_max_us{0};
+
+    bool isValidId(int id) const;
+    void updateOrder();
+};
+
+#endif /* CONTROL_SCHEDULE_H_ */
@@ -0,0 +1,76 @@
+#include "ControlScheduler.h"
+
+ControlScheduler::ControlScheduler(uint32_t period_us,
+                                   osPriority priority,
+                                   uint32_t stack_size) : RealTimeThread(period_us, priority, stack_size)
+                                                        , m_Schedule(period_us)
+{
+    m_Timer.start();
+}
+
+int ControlScheduler::registerTask(Callback<void()> task, uint32_t divisor)
+{
+    if (!task) {
+        printf("ControlScheduler: invalid task\n");
+        return -1;
+    }
+
+    m_Mutex.lock();
+    const int id = m_Schedule.addTask(divisor);
+    if (id >= 0)
+        m_callbacks[id] = task;
+    m_Mutex.unlock();
+
+    return id;
+}
+
+int ControlScheduler::registerTaskWithPeriod(Callback<void()> task, int64_t period_us)
+{
+    if (!task) {
+        printf("ControlScheduler: invalid task\n");
+        return -1;
+    }
+
+    m_Mutex.lock();
+    const int id = m_Schedule.addTaskWithPeriod(period_us);
+    if (id >= 0)
+        m_callbacks[id] = task;
+    m_Mutex.unlock();
+
+    return id;
+}
+
+void ControlScheduler::unregisterTask(int id)
+{
+    if (id < 0 || id >= CONTROL_SCHEDULER_NUM_OF_TASKS_MAX)
+        return;
+
+    m_Mutex.lock();
+    m_Schedule.removeTask(id);
+    m_callbacks[id] = nullptr;
+    m_Mutex.unlock();
+}
+
+void ControlScheduler::resetDiagnostics()
+{
+    m_Mutex.lock();
+    m_Schedule.resetDiagnostics();
+    m_Mutex.unlock();
+}
+
+void ControlScheduler::executeTask()
+{
+    m_Mutex.lock();
+    m_Schedule.beginTick(getTime_us());
+    for (int id = m_Schedule.nextTask(); id >= 0; id = m_Schedule.nextTask()) {
+        m_callbacks[id]();
+        m_Schedule.endTask(id, getTime_us());
+    }
+    m_Schedule.endTick(getTime_us());
+    m_Mutex.unlock();
+}
+
+int64_t ControlScheduler::getTime_us() const
+{
+    return duration_cast<microseconds>(m_Timer.elapsed_time()).count();
+}
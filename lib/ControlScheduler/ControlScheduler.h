@@ -0,0 +1,112 @@
+/**
+ * @file ControlScheduler.h
+ * @brief Shared single-thread rate-monotonic scheduler for periodic drivers
+ *
+ * The ControlScheduler class executes the step() functions of several periodic drivers
+ * (DCMotor, Servo, IMU, IRSensor, UltrasonicSensor, SensorBar, LineFollower) in one single
+ * high-priority RealTimeThread. Every task is registered with a period divisor, so a task with
+ * divisor 4 is executed every 4th tick of the scheduler. Tasks with a shorter period are executed
+ * first within a tick (rate-monotonic order), tasks with the same period in registration order.
+ *
+ * Compared to one Thread, Ticker and ThreadFlag per driver this saves one stack per driver,
+ * avoids the context switches between the driver threads and only needs a single thread flag.
+ *
+ * For every task the scheduler keeps track of the maximum execution time and counts deadline
+ * misses, e.g. when a task finished later than its own period after the start of the tick.
+ * Additionally ticks that took longer than the scheduler period are counted as overruns.
+ *
+ * The task table, the order and the counters are kept by ControlSchedule, which does not depend on
+ * mbed, docs/dev/dev_control_scheduler runs it on the host against a virtual clock.
+ *
+ * @dependencies
+ * This class relies on the following components:
+ * - **ControlSchedule**: For the task table, the rate-monotonic order and the diagnostics
+ * - **RealTimeThread**: For the periodic high-priority thread
+ * - **Timer**: For the execution time and deadline measurement
+ * - **Mutex**: For thread-safe registration of tasks
+ *
+ * @usage
+ * 1. Create a ControlScheduler with the base period, e.g. 500 us
+ * 2. Create the drivers with the ControlScheduler as first argument, they register themselves
+ * 3. Call enable() to start the execution
+ *
+ * @example
+ * ```cpp
+ * ControlScheduler scheduler(500); // 2 kHz base rate
+ * DCMotor motor_M1(scheduler, PB_PWM_M1, PB_ENC_A_M1, PB_ENC_B_M1, gear_ratio, kn, voltage_max); // every tick
+ * IRSensor ir_sensor(scheduler, PC_2);                                                          // every 4th tick
+ * scheduler.enable();
+ * ```
+ *
+ * Tasks are executed in a thread, so blocking calls are allowed but delay all other tasks.
+ * Register slow I/O like the SDLogger not here but keep it in its own low-priority thread.
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef CONTROL_SCHEDULER_H_
+#define CONTROL_SCHEDULER_H_
+
+#include "ControlSchedule.h"
+#include "RealTimeThread.h"
+
+class ControlScheduler : public RealTimeThread
+{
+public:
+    /**
+     * @brief Construct a ControlScheduler
+     * @param period_us Base period in microseconds (default: 500 us = 2 kHz)
+     * @param priority Thread priority (default: osPriorityHigh1)
+     * @param stack_size Stack size in bytes, shared by all tasks (default: OS_STACK_SIZE = 4096)
+     */
+    explicit ControlScheduler(uint32_t period_us = 500,
+                              osPriority priority = osPriorityHigh1,
+                              uint32_t stack_size = OS_STACK_SIZE);
+
+    virtual ~ControlScheduler() = default;
+
+    /**
+     * @brief Register a task that is executed every divisor-th tick
+     * @param task The function to execute, e.g. callback(this, &DCMotor::step)
+     * @param divisor Period of the task in ticks, must be > 0
+     * @return int Task id >= 0 or -1 if the task could not be registered
+     */
+    int registerTask(Callback<void()> task, uint32_t divisor = 1);
+
+    /**
+     * @brief Register a task with a period in microseconds
+     * @param task The function to execute
+     * @param period_us Period of the task, must be a multiple of the scheduler period
+     * @return int Task id >= 0 or -1 if the task could not be registered
+     */
+    int registerTaskWithPeriod(Callback<void()> task, int64_t period_us);
+
+    /**
+     * @brief Remove a task, afterwards the task id can be reused
+     * @param id Task id returned by registerTask()
+     */
+    void unregisterTask(int id);
+
+    // diagnostics
+    uint32_t getNumOfTasks() const { return m_Schedule.getNumOfTasks(); }
+    uint32_t getTickOverrunCount() const { return m_Schedule.getTickOverrunCount(); }
+    uint32_t getTickExecTimeMax_us() const { return m_Schedule.getTickExecTimeMax_us(); }
+    uint32_t getDeadlineMissCount(int id) const { return m_Schedule.getDeadlineMissCount(id); }
+    uint32_t getExecTimeMax_us(int id) const { return m_Schedule.getExecTimeMax_us(id); }
+    void resetDiagnostics();
+    void printDiagnostics() const { m_Schedule.printDiagnostics(); }
+
+protected:
+    void executeTask() override;
+
+private:
+    ControlSchedule m_Schedule;
+    Callback<void()> m_callbacks[CONTROL_SCHEDULER_NUM_OF_TASKS_MAX]; // indexed by the task id
+
+    Timer m_Timer;
+    Mutex m_Mutex; // protects the task list while (un)registering
+
+    int64_t getTime_us() const;
+};
+
+#endif /* CONTROL_SCHEDULER_H_ */
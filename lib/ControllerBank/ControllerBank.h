@@ -0,0 +1,138 @@
+/**
+ * @file ControllerBank.h
+ * @brief N PID controllers that are updated in one loop.
+ *
+ * Same controller as PIDCntrl (backward Euler integrator, Tustin D part with filter tau_f, Tustin
+ * roll-off tau_ro, anti-windup by saturating the integrator and the output, feedforward F * w), but
+ * the parameters and states of all channels are stored as parallel arrays (structure of arrays) and
+ * update() updates all channels in one loop with a fixed trip count.
+ *
+ * - PIDCntrl skips the integrator if I = 0, here the integrator limits of such a channel are set to 0
+ *   instead, so the loop has no branch and the result is the same.
+ * - update(ch, ...) is the scalar fallback for a single channel.
+ *
+ * docs/dev/dev_controller_bank compares the bank with PIDCntrl objects on the host.
+ *
+ * Example:
+ * ```
+ * ControllerBank<2> cntrl;
+ * cntrl.setup(0, KP, KI, KD, TAU_F, TAU_RO, TS, -12.0f, 12.0f);
+ * cntrl.setup(1, KP, KI, KD, TAU_F, TAU_RO, TS, -12.0f, 12.0f);
+ *
+ * // every period, one value per channel
+ * cntrl.update(w, y, y, y, u);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef CONTROLLER_BANK_H_
+#define CONTROLLER_BANK_H_
+
+#include <stddef.h>
+
+template <size_t N>
+class ControllerBank
+{
+public:
+    explicit ControllerBank()
+    {
+        for (size_t i = 0; i < N; i++) {
+            m_P[i] = m_I[i] = m_bi[i] = m_bd[i] = m_ad[i] = m_F[i] = 0.0f;
+            // no roll-off, same as tau_ro = 0
+            m_bf[i] = m_af[i] = 1.0f;
+            m_u_min[i] = m_u_max[i] = m_u_i_min[i] = m_u_i_max[i] = 0.0f;
+            reset(i);
+        }
+    }
+    virtual ~ControllerBank() = default;
+
+    static constexpr size_t size() { return N; }
+
+    // parameters like PIDCntrl::setup(), tau_ro = 0 disables the roll-off, the state of the channel is reset
+    void setup(size_t ch, float P, float I, float D, float tau_f, float tau_ro, float Ts, float u_min, float u_max)
+    {
+        const double Ts_d = static_cast<double>(Ts);
+        const double tau_f_d = static_cast<double>(tau_f);
+        const double tau_ro_d = static_cast<double>(tau_ro);
+        m_P[ch] = P;
+        m_I[ch] = I;
+        m_bi[ch] = static_cast<float>(static_cast<double>(I) * Ts_d);
+        m_bd[ch] = static_cast<float>(2.0 * static_cast<double>(D) / (Ts_d + 2.0 * tau_f_d));
+        m_ad[ch] = static_cast<float>((Ts_d - 2.0 * tau_f_d) / (Ts_d + 2.0 * tau_f_d));
+        m_bf[ch] = static_cast<float>(Ts_d / (Ts_d + 2.0 * tau_ro_d));
+        m_af[ch] = static_cast<float>((Ts_d - 2.0 * tau_ro_d) / (Ts_d + 2.0 * tau_ro_d));
+        setLimits(ch, u_min, u_max);
+        reset(ch);
+    }
+
+    void setParamF(size_t ch, float F) { m_F[ch] = F; }
+
+    void setLimits(size_t ch, float u_min, float u_max)
+    {
+        m_u_min[ch] = u_min;
+        m_u_max[ch] = u_max;
+        setIntegratorLimits(ch, u_min, u_max);
+    }
+
+    void setIntegratorLimits(size_t ch, float u_i_min, float u_i_max)
+    {
+        // a channel without integrator keeps its integrator at 0
+        const bool has_integrator = (m_I[ch] != 0.0f);
+        m_u_i_min[ch] = has_integrator ? u_i_min : 0.0f;
+        m_u_i_max[ch] = has_integrator ? u_i_max : 0.0f;
+    }
+
+    void reset(size_t ch, float init_value = 0.0f)
+    {
+        m_i_part[ch] = init_value;
+        m_d_part[ch] = 0.0f;
+        m_d_old[ch] = 0.0f;
+        m_u_old[ch] = init_value;
+        m_uf[ch] = init_value;
+    }
+
+    // updates all channels like PIDCntrl::update(w, y_p, y_i, y_d), all arrays hold N values
+    void update(const float* w, const float* y_p, const float* y_i, const float* y_d, float* u)
+    {
+        for (size_t i = 0; i < N; i++)
+            u[i] = updateChannel(i, w[i], y_p[i], y_i[i], y_d[i]);
+    }
+
+    // updates all channels like PIDCntrl::update(e), w = 0 so that there is no feedforward like in PIDCntrl
+    void update(const float* e, float* u)
+    {
+        for (size_t i = 0; i < N; i++)
+            u[i] = updateChannel(i, 0.0f, -e[i], -e[i], -e[i]);
+    }
+
+    // scalar fallback, updates channel ch only
+    float update(size_t ch, float w, float y_p, float y_i, float y_d)
+    {
+        return updateChannel(ch, w, y_p, y_i, y_d);
+    }
+
+    float getCurrentOutput(size_t ch) const { return m_uf[ch]; }
+
+private:
+    float m_P[N], m_I[N], m_bi[N], m_bd[N], m_ad[N], m_bf[N], m_af[N], m_F[N];
+    float m_u_min[N], m_u_max[N], m_u_i_min[N], m_u_i_max[N];
+    float m_i_part[N], m_d_part[N], m_d_old[N], m_u_old[N], m_uf[N];
+
+    static float saturate(float u, float u_min, float u_max)
+    {
+        return (u > u_max) ? u_max : (u < u_min) ? u_min : u;
+    }
+
+    inline float updateChannel(size_t i, float w, float y_p, float y_i, float y_d)
+    {
+        m_i_part[i] = saturate(m_i_part[i] + m_bi[i] * (w - y_i), m_u_i_min[i], m_u_i_max[i]);
+        m_d_part[i] = m_bd[i] * (y_d - m_d_old[i]) - m_ad[i] * m_d_part[i];
+        m_d_old[i] = y_d;
+        const float u = m_P[i] * (w - y_p) + m_i_part[i] - m_d_part[i] + m_F[i] * w;
+        m_uf[i] = saturate(m_bf[i] * (u + m_u_old[i]) - m_af[i] * m_uf[i], m_u_min[i], m_u_max[i]);
+        m_u_old[i] = u;
+        return m_uf[i];
+    }
+};
+#endif /* CONTROLLER_BANK_H_ */
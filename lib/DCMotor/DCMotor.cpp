@@ -1,17 +1,85 @@
 #include "DCMotor.h"
 
+#include "MotionGroup.h"
+
 DCMotor::DCMotor(PinName pwm_pin,
                  PinName enc_a_pin,
                  PinName enc_b_pin,
                  float gear_ratio,
                  float kn,
                  float voltage_max,
-                 float counts_per_turn) : m_FastPWM(pwm_pin),
+                 float counts_per_turn) : DCMotor(nullptr,
+                                                  nullptr,
+                                                  pwm_pin,
+                                                  enc_a_pin,
+                                                  enc_b_pin,
+                                                  gear_ratio,
+                                                  kn,
+                                                  voltage_max,
+                                                  counts_per_turn)
+{
+}
+
+DCMotor::DCMotor(ControlScheduler& scheduler,
+                 PinName pwm_pin,
+                 PinName enc_a_pin,
+                 PinName enc_b_pin,
+                 float gear_ratio,
+                 float kn,
+                 float voltage_max,
+                 float counts_per_turn) : DCMotor(&scheduler,
+                                                  nullptr,
+                                                  pwm_pin,
+                                                  enc_a_pin,
+                                                  enc_b_pin,
+                                                  gear_ratio,
+                                                  kn,
+                                                  voltage_max,
+                                                  counts_per_turn)
+{
+}
+
+DCMotor::DCMotor(MotionGroup& group,
+                 PinName pwm_pin,
+                 PinName enc_a_pin,
+                 PinName enc_b_pin,
+                 float gear_ratio,
+                 float kn,
+                 float voltage_max,
+                 float counts_per_turn) : DCMotor(nullptr,
+                                                  &group,
+                                                  pwm_pin,
+                                                  enc_a_pin,
+                                                  enc_b_pin,
+                                                  gear_ratio,
+                                                  kn,
+                                                  voltage_max,
+                                                  counts_per_turn)
+{
+}
+
+DCMotor::DCMotor(ControlScheduler* scheduler,
+                 MotionGroup* group,
+                 PinName pwm_pin,
+                 PinName enc_a_pin,
+                 PinName enc_b_pin,
+                 float gear_ratio,
+                 float kn,
+                 float voltage_max,
+                 float counts_per_turn) :
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+                                          m_DCMotorPlant(gear_ratio, kn, voltage_max, counts_per_turn, TS),
+#else
+                                          m_FastPWM(pwm_pin),
                                           m_EncoderCounter(enc_a_pin, enc_b_pin),
+#endif
                                           m_Thread(osPriorityHigh1)
 #if PERFORM_CHIRP_MEAS
                                           , m_BufferedSerial(USBTX, USBRX)
 #endif
+                                          , m_scheduler(scheduler)
+                                          , m_group(group)
+                                          , m_task_id(-1)
 {
     // motor parameters
     m_counts_per_turn = gear_ratio * counts_per_turn;
@@ -30,16 +98,26 @@ DCMotor::DCMotor(PinName pwm_pin,
     m_IIR_Filter_velocity.lowPass2Init(15.0f, 1.0f, TS);
 
     // initialise control signals
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+    m_count = m_count_previous = m_DCMotorPlant.readEncoder();
+#else
     m_count = m_count_previous = m_EncoderCounter.read();
+#endif
     m_rotation_initial = static_cast<float>(m_count) / m_counts_per_turn;
     m_rotation_target = m_rotation_initial;
     m_rotation_setpoint = m_rotation_initial;
     m_rotation = m_rotation_initial;
+    m_rotation_increment = 0.0f;
+    m_velocity_feedforward = 0.0f;
     m_velocity_target = 0.0f;
     m_velocity_setpoint = 0.0f;
     m_velocity = 0.0f;
     m_voltage = 0.0f;
     m_pwm = 0.0f;
+    DCMotorData data;
+    data.rotation_setpoint = m_rotation_setpoint;
+    data.count = m_count;
+    m_data.publish(data);
 
     // initilise motion planner, parameters adapted from gear ratio 78:1 tune
     m_enable_motion_planner = false;
@@ -63,6 +141,8 @@ DCMotor::DCMotor(PinName pwm_pin,
     const float Tsweep = 0.3f;
     const int   Nsweep = (int)ceilf(Tsweep/TS);
     m_GPA.init(fMin, fMax, NfexcDes, NperMin, NmeasMin, TS, Aexc0, Aexc1, Nstart, Nsweep, true, true);
+    // measure velocity and control error in one sweep, the control error gives the sensitivity function
+    m_GPA.setNumOfOutputs(2);
 #endif
 
 #if PERFORM_CHIRP_MEAS
@@ -75,6 +155,30 @@ DCMotor::DCMotor(PinName pwm_pin,
     m_timer.start();
 #endif
 
+    if (m_scheduler) {
+#if PERFORM_GPA_MEAS
+        // print some gpa info
+        m_GPA.printGPAmeasPara();
+#endif
+        // let the scheduler execute step(), the own thread and thread flag are not used
+        m_ThreadFlag.release();
+        m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &DCMotor::step), PERIOD_MUS);
+        return;
+    }
+
+    if (m_group) {
+        // the group executes sample(), update() and actuate() of all its motors
+        m_ThreadFlag.release();
+        m_group->addMotor(*this);
+        return;
+    }
+
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+    // step() is called by the user, e.g. faster than real time
+    m_ThreadFlag.release();
+    return;
+#endif
+
     // start thread
     m_Thread.start(callback(this, &DCMotor::threadTask));
 
@@ -84,6 +188,18 @@ DCMotor::DCMotor(PinName pwm_pin,
 
 DCMotor::~DCMotor()
 {
+    if (m_scheduler) {
+        m_scheduler->unregisterTask(m_task_id);
+        return;
+    }
+    if (m_group) {
+        // waits for a running step() of the group, so the group never executes a destroyed motor
+        m_group->removeMotor(*this);
+        return;
+    }
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+    return;
+#endif
     m_Ticker.detach();
     m_Thread.terminate();
 }
@@ -106,6 +222,13 @@ void DCMotor::setRotationRelative(float rotation_relative)
     m_rotation_target = getRotation() + rotation_relative;
 }
 
+void DCMotor::setRotationSetpoint(float rotation_setpoint, float velocity_feedforward)
+{
+    m_rotation_setpoint = m_rotation_initial + rotation_setpoint;
+    m_velocity_feedforward = velocity_feedforward;
+    m_cntrlMode = CntrlMode::Setpoint;
+}
+
 float DCMotor::getRotationTarget() const
 {
     return m_rotation_target;
@@ -113,12 +236,12 @@ float DCMotor::getRotationTarget() const
 
 float DCMotor::getRotationSetpoint() const
 {
-    return m_rotation_setpoint;
+    return m_data.read().rotation_setpoint;
 }
 
 float DCMotor::getRotation() const
 {
-    return m_rotation - m_rotation_initial;
+    return m_data.read().rotation;
 }
 
 float DCMotor::getVelocityTarget() const
@@ -128,22 +251,27 @@ float DCMotor::getVelocityTarget() const
 
 float DCMotor::getVelocitySetpoint() const
 {
-    return m_velocity_setpoint;
+    return m_data.read().velocity_setpoint;
 }
 
 float DCMotor::getVelocity() const
 {
-    return m_velocity;
+    return m_data.read().velocity;
 }
 
 float DCMotor::getVoltage() const
 {
-    return m_voltage;
+    return m_data.read().voltage;
 }
 
 float DCMotor::getPWM() const
 {
-    return m_pwm;
+    return m_data.read().pwm;
+}
+
+DCMotorData DCMotor::getData() const
+{
+    return m_data.read();
 }
 
 void DCMotor::setVelocityCntrl(float kp, float ki, float kd)
@@ -194,6 +322,7 @@ float DCMotor::getMaxPhysicalVelocity() const
 
 void DCMotor::setMaxAcceleration(float acceleration)
 {
+    m_acceleration_max = acceleration;
     m_Motion.setProfileAcceleration(acceleration);
     m_Motion.setProfileDeceleration(acceleration);
 }
@@ -215,7 +344,7 @@ void DCMotor::disableMotionPlanner()
 
 long DCMotor::getEncoderCount() const
 {
-    return m_count;
+    return m_data.read().count;
 }
 
 void DCMotor::setMotionPlanerVelocity(float velocity) {
@@ -229,7 +358,9 @@ void DCMotor::setMotionPlanerPosition(float position) {
 void DCMotor::setFastPWMPeriod_mus(int period_mus)
 {
     // set the period of the PWM signal in microseconds
+#if !DC_MOTOR_DO_USE_PLANT_SIMULATION
     m_FastPWM.period_mus(period_mus);
+#endif
 }
 
 #if PERFORM_GPA_MEAS
@@ -260,103 +391,148 @@ void DCMotor::threadTask()
 
     while (true) {
         ThisThread::flags_wait_any(m_ThreadFlag);
+        step();
+    }
+}
 
-        // update counts (avoid overflow)
-        const short count_actual = m_EncoderCounter.read();
-        const short count_delta = count_actual - m_count_previous; // avoid overflow
-        m_count_previous = count_actual;
+void DCMotor::step()
+{
+    sample();
+    update();
+    actuate();
+}
 
-        // update rotation
-        m_count += count_delta;
-        m_rotation = static_cast<float>(m_count) / m_counts_per_turn;
+void DCMotor::sample()
+{
+    // update counts (avoid overflow)
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+    const short count_actual = m_DCMotorPlant.readEncoder();
+#else
+    const short count_actual = m_EncoderCounter.read();
+#endif
+    const short count_delta = count_actual - m_count_previous; // avoid overflow
+    m_count_previous = count_actual;
 
-        // update velocity
-        const float rotation_increment = static_cast<float>(count_delta) / m_counts_per_turn;
-        m_velocity = m_IIR_Filter_velocity.apply(rotation_increment / TS);
+    // update rotation
+    m_count += count_delta;
+    m_rotation = static_cast<float>(m_count) / m_counts_per_turn;
 
-        float velocity_setpoint = 0.0f;
+    // update velocity
+    m_rotation_increment = static_cast<float>(count_delta) / m_counts_per_turn;
+    m_velocity = m_IIR_Filter_velocity.apply(m_rotation_increment / TS);
+}
 
-        switch (m_cntrlMode) {
+void DCMotor::update()
+{
+    float velocity_setpoint = 0.0f;
+
+    switch (m_cntrlMode) {
+
+        case CntrlMode::Rotation:
+            if (m_enable_motion_planner) {
+                // use motion planner
+                m_Motion.incrementToPosition(m_rotation_target, TS);
+                m_rotation_setpoint = m_Motion.getPosition();
+                if ((fabs(m_rotation_setpoint - m_rotation) > ROTATION_ERROR_MAX) || (fabs(m_Motion.getVelocity()) > 0.0f))
+                    velocity_setpoint = m_p * (m_rotation_setpoint - m_rotation) + m_Motion.getVelocity();
+            } else {
+                m_rotation_setpoint = m_rotation_target;
+                if (fabs(m_rotation_setpoint - m_rotation) > ROTATION_ERROR_MAX)
+                    velocity_setpoint = m_p * (m_rotation_setpoint - m_rotation);
+            }
 
-            case CntrlMode::Rotation:
-                if (m_enable_motion_planner) {
-                    // use motion planner
-                    m_Motion.incrementToPosition(m_rotation_target, TS);
-                    m_rotation_setpoint = m_Motion.getPosition();
-                    if ((fabs(m_rotation_setpoint - m_rotation) > ROTATION_ERROR_MAX) || (fabs(m_Motion.getVelocity()) > 0.0f))
-                        velocity_setpoint = m_p * (m_rotation_setpoint - m_rotation) + m_Motion.getVelocity();
-                } else {
-                    m_rotation_setpoint = m_rotation_target;
-                    if (fabs(m_rotation_setpoint - m_rotation) > ROTATION_ERROR_MAX)
-                        velocity_setpoint = m_p * (m_rotation_setpoint - m_rotation);
-                }
+            break;
 
-                break;
+        case CntrlMode::Velocity:
+            if (m_enable_motion_planner) {
+                // use motion planner
+                m_Motion.incrementToVelocity(m_velocity_target, TS);
+                velocity_setpoint = m_Motion.getVelocity();
+            } else {
+                velocity_setpoint = m_velocity_target;
+            }
 
-            case CntrlMode::Velocity:
-                if (m_enable_motion_planner) {
-                    // use motion planner
-                    m_Motion.incrementToVelocity(m_velocity_target, TS);
-                    velocity_setpoint = m_Motion.getVelocity();
-                } else {
-                    velocity_setpoint = m_velocity_target;
-                }
+            break;
 
-                break;
+        case CntrlMode::Setpoint:
+            // rotation setpoint and velocity feedforward are given by the MotionGroup
+            if ((fabs(m_rotation_setpoint - m_rotation) > ROTATION_ERROR_MAX) || (fabs(m_velocity_feedforward) > 0.0f))
+                velocity_setpoint = m_p * (m_rotation_setpoint - m_rotation) + m_velocity_feedforward;
 
-            default:
+            break;
 
-                break; // should not happen
-        }
+        default:
+
+            break; // should not happen
+    }
 
-        // constrain velocity to (-m_velocity_max, m_velocity_max)
-        velocity_setpoint = (velocity_setpoint >  m_velocity_max) ?  m_velocity_max :
-                            (velocity_setpoint < -m_velocity_max) ? -m_velocity_max :
-                             velocity_setpoint;
+    // constrain velocity to (-m_velocity_max, m_velocity_max)
+    velocity_setpoint = (velocity_setpoint >  m_velocity_max) ?  m_velocity_max :
+                        (velocity_setpoint < -m_velocity_max) ? -m_velocity_max :
+                         velocity_setpoint;
 
 #if PERFORM_GPA_MEAS
-        static float exc = 0.0f;
-        // closed-loop measurement
-        const float voltage = m_PIDCntrl_velocity.update(0.6f * m_velocity_max - m_velocity + exc);
-        if (m_start_gpa) {
-            exc = m_GPA.update(voltage, m_velocity);
-        }
+    static float exc = 0.0f;
+    // closed-loop measurement
+    const float error = 0.6f * m_velocity_max - m_velocity + exc;
+    const float voltage = m_PIDCntrl_velocity.update(error);
+    if (m_start_gpa) {
+        const float out[2] = {m_velocity, error};
+        exc = m_GPA.update(voltage, out);
+    }
 #elif PERFORM_CHIRP_MEAS
-        const float magnitude = 4.0f;
-        const float offset = 5.0f;
-        float voltage = offset;
-        if (m_start_chirp && m_chirp.update()) {
-            const float time_ms = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(m_timer.elapsed_time()).count()) * 1.0e-3f;
-            m_timer.reset();
-            const float exc = m_chirp.getExc();
-            const float fchirp = m_chirp.getFreq();
-            const float sinarg = m_chirp.getSinarg();
-            voltage = magnitude * exc + offset;
-            if (m_BufferedSerial.writable()) {
-                memcpy(&m_buffer[0 ], &time_ms, 4);
-                memcpy(&m_buffer[4 ], &voltage, 4);
-                memcpy(&m_buffer[8 ], &fchirp, 4);
-                memcpy(&m_buffer[12], &sinarg, 4);
-                memcpy(&m_buffer[16], &m_rotation, 4);
-                m_BufferedSerial.write(m_buffer, 20);
-            }
+    const float magnitude = 4.0f;
+    const float offset = 5.0f;
+    float voltage = offset;
+    if (m_start_chirp && m_chirp.update()) {
+        const float time_ms = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(m_timer.elapsed_time()).count()) * 1.0e-3f;
+        m_timer.reset();
+        const float exc = m_chirp.getExc();
+        const float fchirp = m_chirp.getFreq();
+        const float sinarg = m_chirp.getSinarg();
+        voltage = magnitude * exc + offset;
+        if (m_BufferedSerial.writable()) {
+            memcpy(&m_buffer[0 ], &time_ms, 4);
+            memcpy(&m_buffer[4 ], &voltage, 4);
+            memcpy(&m_buffer[8 ], &fchirp, 4);
+            memcpy(&m_buffer[12], &sinarg, 4);
+            memcpy(&m_buffer[16], &m_rotation, 4);
+            m_BufferedSerial.write(m_buffer, 20);
         }
+    }
 #else
-        const float voltage = m_PIDCntrl_velocity.update(velocity_setpoint,       // w
-                                                         m_velocity,              // y_p
-                                                         rotation_increment / TS, // y_i
-                                                         m_velocity);             // y_d
+    const float voltage = m_PIDCntrl_velocity.update(velocity_setpoint,         // w
+                                                     m_velocity,                // y_p
+                                                     m_rotation_increment / TS, // y_i
+                                                     m_velocity);               // y_d
 #endif
 
-        // calculate pwm and write output
-        const float pwm = 0.5f + 0.5f * voltage / m_voltage_max;
-        m_FastPWM.write(pwm);
+    // calculate pwm, it is written in actuate()
+    const float pwm = 0.5f + 0.5f * voltage / m_voltage_max;
 
-        // update signals
-        m_velocity_setpoint = velocity_setpoint;
-        m_voltage = voltage;
-        m_pwm = pwm;
-    }
+    // update signals
+    m_velocity_setpoint = velocity_setpoint;
+    m_voltage = voltage;
+    m_pwm = pwm;
+}
+
+void DCMotor::actuate()
+{
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+    m_DCMotorPlant.update(m_pwm);
+#else
+    m_FastPWM.write(m_pwm);
+#endif
+
+    DCMotorData data;
+    data.rotation = m_rotation - m_rotation_initial;
+    data.rotation_setpoint = m_rotation_setpoint;
+    data.velocity = m_velocity;
+    data.velocity_setpoint = m_velocity_setpoint;
+    data.voltage = m_voltage;
+    data.pwm = m_pwm;
+    data.count = m_count;
+    m_data.publish(data);
 }
 
 void DCMotor::sendThreadFlag()
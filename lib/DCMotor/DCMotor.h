@@ -30,6 +30,21 @@
  * motor.getRotation(); // read current rotation
  * ```
  *
+ * Instead of running in its own thread the motor can be executed by a shared ControlScheduler:
+ * ```
+ * ControlScheduler scheduler(500);
+ * DCMotor motor(scheduler, PWM_PIN, ENC_A_PIN, ENC_B_PIN, COUNTS_PER_TURN, KN, VOLTAGE_MAX);
+ * scheduler.enable();
+ * ```
+ *
+ * Several motors can also be executed by a MotionGroup, which moves them on a shared trajectory
+ * (see MotionGroup.h):
+ * ```
+ * MotionGroup group;
+ * DCMotor motor_M1(group, PWM_PIN_M1, ENC_A_PIN_M1, ENC_B_PIN_M1, COUNTS_PER_TURN, KN, VOLTAGE_MAX);
+ * DCMotor motor_M2(group, PWM_PIN_M2, ENC_A_PIN_M2, ENC_B_PIN_M2, COUNTS_PER_TURN, KN, VOLTAGE_MAX);
+ * ```
+ *
  * @author M. Peter / pmic / pichim
  */
 
@@ -40,8 +55,9 @@
 
 #include "EncoderCounter.h"
 #include "FastPWM.h"
-#include "Motion.h"
 #include "ThreadFlag.h"
+#include "ControlScheduler.h"
+#include "Published.h"
 #include "PIDCntrl.h"
 #include "IIRFilter.h"
 
@@ -53,6 +69,26 @@
 #define PERFORM_GPA_MEAS false
 #define PERFORM_CHIRP_MEAS false
 
+// if this is true then FastPWM and EncoderCounter are replaced by the DCMotorPlant model, the motor does
+// not start its own thread and step() has to be called by the user (or a ControlScheduler), the host
+// build sets it for host/src/dc_motor_plant_simulation.cpp
+#ifndef DC_MOTOR_DO_USE_PLANT_SIMULATION
+#define DC_MOTOR_DO_USE_PLANT_SIMULATION false
+#endif
+
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+#include "DCMotorPlant.h"
+#endif
+
+// if this is true then the motion planner uses the jerk limited SCurve instead of the trapezoidal Motion profile
+#define DC_MOTOR_DO_USE_S_CURVE false
+
+#if DC_MOTOR_DO_USE_S_CURVE
+#include "SCurve.h"
+#else
+#include "Motion.h"
+#endif
+
 #if PERFORM_GPA_MEAS
 #include "GPA.h"
 #endif
@@ -63,6 +99,24 @@
 #define BUFFER_LENGTH 20 // 5 float values
 #endif
 
+class MotionGroup;
+
+// snapshot of the signals of one control period
+class DCMotorData
+{
+public:
+    DCMotorData() = default;
+    ~DCMotorData() = default;
+
+    float rotation{0.0f};          // rotations relative to the initial rotation
+    float rotation_setpoint{0.0f};
+    float velocity{0.0f};          // rotations per second
+    float velocity_setpoint{0.0f};
+    float voltage{0.0f};
+    float pwm{0.0f};
+    long count{0};
+};
+
 class DCMotor
 {
 public:
@@ -85,6 +139,36 @@ public:
                      float voltage_max = 12.0f,
                      float counts_per_turn = 20.0f);
 
+    /**
+     * @brief Construct a new DCMotor object that is executed by a shared ControlScheduler.
+     *
+     * @param scheduler The scheduler that executes the motor, its period has to be a divisor of 500 us.
+     * @param ... see above.
+     */
+    explicit DCMotor(ControlScheduler& scheduler,
+                     PinName pwm_pin,
+                     PinName enc_a_pin,
+                     PinName enc_b_pin,
+                     float gear_ratio,
+                     float kn,
+                     float voltage_max = 12.0f,
+                     float counts_per_turn = 20.0f);
+
+    /**
+     * @brief Construct a new DCMotor object that is executed by a MotionGroup.
+     *
+     * @param group The group that executes the motor together with the other motors of the group.
+     * @param ... see above.
+     */
+    explicit DCMotor(MotionGroup& group,
+                     PinName pwm_pin,
+                     PinName enc_a_pin,
+                     PinName enc_b_pin,
+                     float gear_ratio,
+                     float kn,
+                     float voltage_max = 12.0f,
+                     float counts_per_turn = 20.0f);
+
     /**
      * @brief Destroy the DCMotor object.
      */
@@ -167,6 +251,13 @@ public:
      */
     float getPWM() const;
 
+    /**
+     * @brief Get all signals of the same control period, e.g. rotation and velocity for logging.
+     *
+     * @return DCMotorData Snapshot of the last control period.
+     */
+    DCMotorData getData() const;
+
     /**
      * @brief Set the control parameters for the velocity PID controller.
      *
@@ -271,9 +362,22 @@ public:
     void startChrip();
 #endif
 
-private:
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+    /**
+     * @brief Execute one control period of TS (read encoder, filter, motion planner, controller, write pwm).
+     *
+     * Without the plant simulation this is called by the own thread or the ControlScheduler, with it the
+     * user calls it, e.g. to run the control loop faster than real time.
+     */
+    void step();
+
+    DCMotorPlant& getPlant() { return m_DCMotorPlant; }
+#endif
+
     static constexpr int64_t PERIOD_MUS = 500;
     static constexpr float TS = 1.0e-6f * static_cast<float>(PERIOD_MUS);
+
+private:
     static constexpr float PWM_MIN = 0.01f;
     static constexpr float PWM_MAX = 0.99f;
     static constexpr float ROTATION_ERROR_MAX = 5.0e-3f;
@@ -283,9 +387,17 @@ private:
     static constexpr float KD = 0.0192f;
     static constexpr float P = 16.0f;
 
+#if DC_MOTOR_DO_USE_PLANT_SIMULATION
+    DCMotorPlant m_DCMotorPlant;
+#else
     FastPWM m_FastPWM;
     EncoderCounter m_EncoderCounter;
+#endif
+#if DC_MOTOR_DO_USE_S_CURVE
+    SCurve m_Motion;
+#else
     Motion m_Motion;
+#endif
     PIDCntrl m_PIDCntrl_velocity;
     IIRFilter m_IIR_Filter_velocity;
 #if PERFORM_GPA_MEAS
@@ -303,10 +415,14 @@ private:
     Thread m_Thread;
     Ticker m_Ticker;
     ThreadFlag m_ThreadFlag;
+    ControlScheduler* m_scheduler;
+    MotionGroup* m_group;
+    int m_task_id;
 
     enum CntrlMode {
         Rotation = 0,
         Velocity,
+        Setpoint,
     };
     CntrlMode m_cntrlMode = CntrlMode::Velocity;
 
@@ -329,12 +445,45 @@ private:
     float m_rotation_target;
     float m_rotation_setpoint;
     float m_rotation;
+    float m_rotation_increment;
+    float m_velocity_feedforward;
     float m_velocity_target;
     float m_velocity_setpoint;
     float m_velocity;
     float m_voltage;
     float m_pwm;
 
+    // signals of the last control period for the getters, published in actuate()
+    Published<DCMotorData> m_data;
+
+    explicit DCMotor(ControlScheduler* scheduler,
+                     MotionGroup* group,
+                     PinName pwm_pin,
+                     PinName enc_a_pin,
+                     PinName enc_b_pin,
+                     float gear_ratio,
+                     float kn,
+                     float voltage_max,
+                     float counts_per_turn);
+
+#if !DC_MOTOR_DO_USE_PLANT_SIMULATION
+    void step();
+#endif
+
+    // the MotionGroup executes the parts of step() and sets the setpoints of its motors
+    friend class MotionGroup;
+
+    // the three parts of step(), a MotionGroup samples all motors, then updates all motors and then writes
+    // all pwms, so the motors of the group are executed at the same time
+    void sample();
+    void update();
+    void actuate();
+
+    // sets the rotation setpoint and the velocity feedforward directly, the motion planner is bypassed,
+    // setRotation() or setVelocity() leave this mode
+    void setRotationSetpoint(float rotation_setpoint, float velocity_feedforward);
+    bool isSetpointMode() const { return m_cntrlMode == CntrlMode::Setpoint; }
+
     void threadTask();
     void sendThreadFlag();
 };
@@ -0,0 +1,52 @@
+#include "DCMotorPlant.h"
+
+DCMotorPlant::DCMotorPlant(float gear_ratio,
+                           float kn,
+                           float voltage_max,
+                           float counts_per_turn,
+                           float Ts,
+                           float tau,
+                           float voltage_friction) : m_Ts(Ts)
+                                                   , m_voltage_max(voltage_max)
+                                                   , m_gain(kn / 60.0f)
+                                                   , m_counts_per_turn(gear_ratio * counts_per_turn)
+                                                   , m_voltage_friction(fabsf(voltage_friction))
+{
+    setMechanicalTimeConstant(tau);
+}
+
+void DCMotorPlant::reset(float rotation)
+{
+    m_voltage = 0.0f;
+    m_velocity = 0.0f;
+    m_rotation = static_cast<double>(rotation);
+}
+
+void DCMotorPlant::setMechanicalTimeConstant(float tau)
+{
+    // exact discretisation of the first order system, tau <= 0 means no dynamics
+    m_a = (tau > 0.0f) ? expf(-m_Ts / tau) : 0.0f;
+}
+
+void DCMotorPlant::update(float pwm)
+{
+    // constrain pwm and convert to voltage, inverse of the mapping in DCMotor
+    pwm = (pwm > 1.0f) ? 1.0f : (pwm < 0.0f) ? 0.0f : pwm;
+    m_voltage = (2.0f * pwm - 1.0f) * m_voltage_max;
+
+    // static friction modelled as deadband
+    float voltage_eff = fabsf(m_voltage) - m_voltage_friction;
+    voltage_eff = (voltage_eff > 0.0f) ? copysignf(voltage_eff, m_voltage) : 0.0f;
+
+    // first order velocity dynamics and trapezoidal integration of the rotation
+    const float velocity_previous = m_velocity;
+    m_velocity = m_a * m_velocity + (1.0f - m_a) * m_gain * voltage_eff;
+    m_rotation += 0.5 * static_cast<double>(m_Ts) * static_cast<double>(velocity_previous + m_velocity);
+}
+
+int16_t DCMotorPlant::readEncoder() const
+{
+    // the hardware counter is 16 bit and wraps around, DCMotor handles the overflow
+    const long count = static_cast<long>(floor(m_rotation * static_cast<double>(m_counts_per_turn)));
+    return static_cast<int16_t>(static_cast<uint16_t>(count & 0xFFFF));
+}
@@ -0,0 +1,86 @@
+/**
+ * @file DCMotorPlant.h
+ * @brief Discrete-time model of a DC motor with gearbox and quadrature encoder.
+ *
+ * The DCMotorPlant class replaces the FastPWM output and the EncoderCounter input of the DCMotor
+ * class if DC_MOTOR_DO_USE_PLANT_SIMULATION is set to true (see DCMotor.h). It is parametrised
+ * exactly like the DCMotor constructor, so the real control code (IIR filter, Motion planner and
+ * PID controller) runs against the model and can be stepped faster than real time.
+ *
+ * Model (per sample Ts, zero-order hold on the voltage):
+ * - voltage from pwm:      u = (2 * pwm - 1) * voltage_max
+ * - friction as deadband:  u_eff = sign(u) * max(|u| - voltage_friction, 0)
+ * - first order velocity:  w[k+1] = a * w[k] + (1 - a) * kn / 60 * u_eff, a = exp(-Ts / tau)
+ * - rotation (trapezoid):  r[k+1] = r[k] + Ts / 2 * (w[k] + w[k+1])
+ * - encoder:               count = floor(r * gear_ratio * counts_per_turn) as 16 bit counter
+ *
+ * The mechanical time constant tau and the friction voltage are not known from the data sheet,
+ * identify them for your motor, e.g. with a chirp or GPA measurement (see DCMotor.h).
+ *
+ * Example:
+ * ```
+ * DCMotorPlant plant(78.125f, 180.0f / 12.0f, 12.0f, 20.0f, 500.0e-6f);
+ * plant.update(0.75f);                 // apply pwm for one sample
+ * int16_t count = plant.readEncoder(); // read encoder like EncoderCounter::read()
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef DC_MOTOR_PLANT_H_
+#define DC_MOTOR_PLANT_H_
+
+#include <math.h>
+#include <stdint.h>
+
+class DCMotorPlant
+{
+public:
+    /**
+     * @brief Construct a new DCMotorPlant object.
+     *
+     * @param gear_ratio The gear ratio of the gear box.
+     * @param kn The motor constant at the output shaft [rpm/V], same as for DCMotor.
+     * @param voltage_max The maximum voltage for the motor.
+     * @param counts_per_turn The number of encoder counts per turn of the motor.
+     * @param Ts The sampling time in seconds.
+     * @param tau The mechanical time constant in seconds (default: 0.05f).
+     * @param voltage_friction The voltage needed to overcome static friction (default: 0.5f).
+     */
+    explicit DCMotorPlant(float gear_ratio,
+                          float kn,
+                          float voltage_max,
+                          float counts_per_turn,
+                          float Ts,
+                          float tau = 0.05f,
+                          float voltage_friction = 0.5f);
+    virtual ~DCMotorPlant() = default;
+
+    void reset(float rotation = 0.0f);
+    void setMechanicalTimeConstant(float tau);
+    void setFrictionVoltage(float voltage_friction) { m_voltage_friction = fabsf(voltage_friction); }
+
+    // apply the pwm [0, 1] for one sample, 0.5 corresponds to zero voltage
+    void update(float pwm);
+
+    // returns the encoder count as 16 bit counter, same as EncoderCounter::read()
+    int16_t readEncoder() const;
+
+    float getVoltage() const { return m_voltage; }
+    float getVelocity() const { return m_velocity; } // in rotations per second of the output shaft
+    float getRotation() const { return static_cast<float>(m_rotation); }
+
+private:
+    float m_Ts;
+    float m_voltage_max;
+    float m_gain; // kn / 60, rotations per second of the output shaft per volt
+    float m_counts_per_turn;
+    float m_a;
+    float m_voltage_friction;
+
+    float m_voltage{0.0f};
+    float m_velocity{0.0f};
+    double m_rotation{0.0}; // avoid losing encoder counts on long simulations
+};
+
+#endif /* DC_MOTOR_PLANT_H_ */
@@ -0,0 +1,111 @@
+/**
+ * @file FixedPoint.h
+ * @brief Q15/Q31 types, conversions and saturation for the fixed-point filters and controllers.
+ *
+ * A Q31 value x represents x / 2^31 of a full scale that is chosen by the user, e.g. a velocity with
+ * full scale 100 rps is converted with fixedFloatToQ31(velocity / 100.0f). Coefficients are stored with
+ * a shift, a coefficient c is round(c * 2^(31 - shift)), so |c| < 2^shift can be represented.
+ *
+ * Everything in the update path is integer arithmetic (64 bit accumulation, rounding right shift,
+ * saturation), so the results are bit-exact on the target and on the host and the update path does
+ * not use the FPU. On the Cortex-M4 the compiler maps the accumulation to SMLAL. Rounding is round half
+ * up, saturation clamps to the representable range (no wrap around).
+ *
+ * IIRFilterQ31, PIDCntrlQ31 and AvgFilterQ15 are the fixed-point variants of IIRFilter, PIDCntrl and
+ * AvgFilter, docs/dev/dev_fixed_point compares them with the float versions on the host.
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef FIXED_POINT_H_
+#define FIXED_POINT_H_
+
+#include <math.h>
+#include <stdint.h>
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+#define FIXED_POINT_Q31_MAX INT32_MAX
+#define FIXED_POINT_Q31_MIN INT32_MIN
+#define FIXED_POINT_Q15_MAX INT16_MAX
+#define FIXED_POINT_Q15_MIN INT16_MIN
+#define FIXED_POINT_SHIFT_MAX 30 // coefficients up to 2^30 in magnitude
+
+static inline q31_t fixedSaturateQ31(int64_t x)
+{
+    return (x > FIXED_POINT_Q31_MAX) ? FIXED_POINT_Q31_MAX : (x < FIXED_POINT_Q31_MIN) ? FIXED_POINT_Q31_MIN : static_cast<q31_t>(x);
+}
+
+static inline q15_t fixedSaturateQ15(int32_t x)
+{
+    return (x > FIXED_POINT_Q15_MAX) ? FIXED_POINT_Q15_MAX : (x < FIXED_POINT_Q15_MIN) ? FIXED_POINT_Q15_MIN : static_cast<q15_t>(x);
+}
+
+static inline q31_t fixedSaturate(q31_t x, q31_t x_min, q31_t x_max)
+{
+    return (x > x_max) ? x_max : (x < x_min) ? x_min : x;
+}
+
+// rounding right shift of an accumulator, shift > 0
+static inline int64_t fixedShiftRound(int64_t acc, uint8_t shift)
+{
+    return (acc + (static_cast<int64_t>(1) << (shift - 1))) >> shift;
+}
+
+// float in [-1, 1) to Q31 and Q15, values outside are saturated
+static inline q31_t fixedFloatToQ31(float x)
+{
+    if (!(x > -1.0f))
+        return (x == x) ? FIXED_POINT_Q31_MIN : 0; // nan is 0
+    if (x >= 1.0f)
+        return FIXED_POINT_Q31_MAX;
+    return fixedSaturateQ31(static_cast<int64_t>(floorf(x * 2147483648.0f + 0.5f)));
+}
+
+static inline q15_t fixedFloatToQ15(float x)
+{
+    if (!(x > -1.0f))
+        return (x == x) ? FIXED_POINT_Q15_MIN : 0;
+    if (x >= 1.0f)
+        return FIXED_POINT_Q15_MAX;
+    return fixedSaturateQ15(static_cast<int32_t>(floorf(x * 32768.0f + 0.5f)));
+}
+
+static inline float fixedQ31ToFloat(q31_t x)
+{
+    return static_cast<float>(x) * (1.0f / 2147483648.0f);
+}
+
+static inline float fixedQ15ToFloat(q15_t x)
+{
+    return static_cast<float>(x) * (1.0f / 32768.0f);
+}
+
+// coefficient quantisation
+// ----------------------------------------------------------------------------
+
+// smallest shift so that all coefficients with |c| <= coefficient_abs_max can be represented
+static inline uint8_t fixedCoefficientShift(float coefficient_abs_max)
+{
+    uint8_t shift = 0;
+    while (shift < FIXED_POINT_SHIFT_MAX && coefficient_abs_max >= ldexpf(1.0f, shift))
+        shift++;
+    return shift;
+}
+
+// coefficient as round(c * 2^(31 - shift)), saturated
+static inline q31_t fixedCoefficient(float coefficient, uint8_t shift)
+{
+    const double scaled = static_cast<double>(coefficient) * ldexp(1.0, 31 - shift);
+    const double bound = 2147483647.0;
+    return static_cast<q31_t>(floor(((scaled > bound) ? bound : (scaled < -bound - 1.0) ? -bound - 1.0 : scaled) + 0.5));
+}
+
+// value of a quantised coefficient, e.g. to check the quantisation error
+static inline float fixedCoefficientToFloat(q31_t coefficient, uint8_t shift)
+{
+    return static_cast<float>(ldexp(static_cast<double>(coefficient), shift - 31));
+}
+
+#endif /* FIXED_POINT_H_ */
@@ -129,6 +129,10 @@
         k+1. The FRF data are plotted to a terminal (Putty) over a serial
         connection and look as follows:
 
+        If GPA_DO_USE_BINARY_STREAM is true (default) each frequency point is sent as a crc protected
+        binary frame by a low priority thread instead, decode it with docs/solutions/python/GPAStream.py.
+        The decoded data has the same columns as the printed data.
+
     In MATLAB you can use:
         U = data(:,2) + 1i*data(:,3);
         Y = data(:,4) + 1i*data(:,5);
@@ -140,6 +144,19 @@
         SC = S*C;
         SP = S*P;
 
+    Multiple outputs:
+        Up to GPA_NUM_OF_OUTPUTS_MAX outputs can be measured in one sweep against the same excitation, e.g.
+        the plant output y and the control error e (sensitivity function):
+
+            gpa.setNumOfOutputs(2);
+            ...
+            const float out[2] = {y, e};
+            exc = gpa(u, out);
+
+        The additional outputs are appended to each printed line, so the first 9 columns stay the same:
+        E = data(:,10) + 1i*data(:,11);
+        S = frd(E./R, data(:,1), Ts, 'Units', 'Hz');
+
     If you're evaluating more than one measurement which contain equal frequency points use:
         data = [data1; data2];
         [~, ind] = unique(data(:,1), 'stable');
@@ -201,7 +218,6 @@ GPA::GPA(float f0, float f1, float *fexcDes, int NfexcDes, int NperMin, int Nmea
 
     calculateDecreasingAmplitudeCoefficients(Aexc0, Aexc1);
     initializeConstants(Ts);
-    assignFilterStorage();
     reset();
     if(doPrecalcParam) {
         assignAndResetParamStorage();
@@ -224,7 +240,6 @@ GPA::GPA(float *fexcDes, int NfexcDes, int NperMin, int NmeasMin, float Ts, floa
 
     calculateDecreasingAmplitudeCoefficients(Aexc0, Aexc1);
     initializeConstants(Ts);
-    assignFilterStorage();
     reset();
     if(doPrecalcParam) {
         assignAndResetParamStorage();
@@ -250,40 +265,45 @@ void GPA::init(float fMin, float fMax, int NfexcDes, int NperMin, int NmeasMin,
 
     calculateDecreasingAmplitudeCoefficients(Aexc0, Aexc1);
     initializeConstants(Ts);
-    assignFilterStorage();
     reset();
     if(doPrecalcParam) {
         assignAndResetParamStorage();
         precalcParam();
     }
+#if GPA_DO_USE_BINARY_STREAM
+    if(doPrint)
+        startStreamThread();
+#endif
 }
 
 void GPA::reset()
 {
     m_print_cntr = 0;
+#if GPA_DO_USE_BINARY_STREAM
+    m_frames_dropped = 0;
+#endif
 
     memset(&gpaData, 0, sizeof(gpaData));
 
     Nmeas = 0;
     Nper = 0;
-    dfexc = 0.0;
-    fexc = 0.0;
+    dfexc = 0.0f;
+    fexc = 0.0f;
     fexcPast = 0.0f;
     dfexcj = 0.0f;
     i = 1; // iterating through desired frequency points
     j = 1; // iterating through measurement points w.r.t. reachable frequency
-    scaleG = 0.0;
-    cr = 0.0;
-    ci = 0.0;
-    for(int i = 0; i < 3; i++) {
-        sU[i] = 0.0;
-        sY[i] = 0.0;
+    filterU.reset();
+    for(int ch = 0; ch < GPA_NUM_OF_OUTPUTS_MAX; ch++) {
+        filterY[ch].reset();
+        Yreal[ch] = 0.0f;
+        Yimag[ch] = 0.0f;
+    }
 #if GPA_EXC_VIA_FILTER
-        sR[i] = 0.0;
+    filterR.reset();
 #endif
-    }
     exc = 0.0f;
-    sinarg = 0.0;
+    phase.reset();
     sinargR = 0.0f;
     NmeasTotal = 0;
     Aexc = 0.0f;
@@ -307,16 +327,23 @@ void GPA::reset()
 // -----------------------------------------------------------------------------
 
 float GPA::update(float inp, float out)
+{
+    return update(inp, &out);
+}
+
+float GPA::update(float inp, const float* out)
 {
     static bool do_reset_timer{true};
     static Timer timer;
 
     // a new frequency point has been reached
     if(j == 1) {
+#if !GPA_DO_USE_BINARY_STREAM
         // user info
         if(i == 1 && doPrint) {
             printf("   fexc[Hz]       Ureal         Uimag         Yreal         Yimag         Rreal         Rimag     T avg. mus   Cntr\n");
         }
+#endif
         // get a new unique frequency point
         while(fexc == fexcPast) {
             if(doPrecalcParam) {
@@ -352,19 +379,14 @@ float GPA::update(float inp, float out)
                 }
             }
         }
-        // filter scaling
-        scaleG = 1.0/sqrt((double)Nmeas);
-        // filter coefficients
-        cr = cos(pi2Tsfexc);
-        ci = sin(pi2Tsfexc);
-        // set filter storage zero
-        for(int i = 0; i < 3; i++) {
-            sU[i] = 0.0;
-            sY[i] = 0.0;
+        // filter scaling and coefficients, this also sets the filter storage zero
+        const double scaleG = 1.0/sqrt((double)Nmeas);
+        filterU.init(scaleG, pi2Tsfexc);
+        for(int ch = 0; ch < NumOfOutputs; ch++)
+            filterY[ch].init(scaleG, pi2Tsfexc);
 #if GPA_EXC_VIA_FILTER
-            sR[i] = 0.0;
+        filterR.init(scaleG, pi2Tsfexc);
 #endif
-        }
         gpaData.MeasPointFinished = false;
     }
     // perfomre the sweep or measure
@@ -382,18 +404,13 @@ float GPA::update(float inp, float out)
         dfexc = fexc;
         AexcOut = Aexc;
         // one point DFT filter step for signal su
-        sU[0] = scaleG*(double)(inp) + 2.0*cr*sU[1] - sU[2];
-        sU[2] = sU[1];
-        sU[1] = sU[0];
-        // one point DFT filter step for signal sy
-        sY[0] = scaleG*(double)(out) + 2.0*cr*sY[1] - sY[2];
-        sY[2] = sY[1];
-        sY[1] = sY[0];
+        filterU.apply(inp);
+        // one point DFT filter step for signals sy, the coefficients are shared
+        for(int ch = 0; ch < NumOfOutputs; ch++)
+            filterY[ch].apply(out[ch]);
 #if GPA_EXC_VIA_FILTER
         // one point DFT filter step for signal sr
-        sR[0] = scaleG*(double)(exc) + 2.0*cr*sR[1] - sR[2];
-        sR[2] = sR[1];
-        sR[1] = sR[0];
+        filterR.apply(exc);
 #endif
         if (do_reset_timer) {
             do_reset_timer = false;
@@ -403,7 +420,7 @@ float GPA::update(float inp, float out)
     }
     // copy starting value for angle(R)
     if(j == 1 || j == Nsweep_i + 1)
-        sinargR = sinarg;
+        sinargR = phase.getAngle();
     // measurement of frequencypoint is finished
     if(j == Nmeas + Nsweep_i) {
         const uint32_t meas_time = std::chrono::duration_cast<std::chrono::microseconds>(timer.elapsed_time()).count();
@@ -412,13 +429,13 @@ float GPA::update(float inp, float out)
         Nsweep_i = Nsweep;
         // calculate real and imaginary pars of the signal spectras
         gpaData.fexc  = (float)fexc;
-        gpaData.Ureal = (float)(2.0*scaleG*(cr*sU[1] - sU[2]));
-        gpaData.Uimag = (float)(2.0*scaleG*ci*sU[1]);
-        gpaData.Yreal = (float)(2.0*scaleG*(cr*sY[1] - sY[2]));
-        gpaData.Yimag = (float)(2.0*scaleG*ci*sY[1]);
+        filterU.getDFT(gpaData.Ureal, gpaData.Uimag);
+        for(int ch = 0; ch < NumOfOutputs; ch++)
+            filterY[ch].getDFT(Yreal[ch], Yimag[ch]);
+        gpaData.Yreal = Yreal[0];
+        gpaData.Yimag = Yimag[0];
 #if GPA_EXC_VIA_FILTER
-        gpaData.Rreal = (float)(2.0*scaleG*(cr*sR[1] - sR[2]));
-        gpaData.Rimag = (float)(2.0*scaleG*ci*sR[1]);
+        filterR.getDFT(gpaData.Rreal, gpaData.Rimag);
 #else
         gpaData.Rreal = Aexc*cosf(sinargR - piDiv2);
         gpaData.Rimag = Aexc*sinf(sinargR - piDiv2);
@@ -427,20 +444,33 @@ float GPA::update(float inp, float out)
         gpaData.ind++;
         // user info
         if(doPrint) {
-            const float avg_time = static_cast<float>(meas_time) / static_cast<float>(Nmeas - 1);           
-            const int buffer_length = snprintf(m_buffer, BUFFER_LENGTH,
-                                               "%12.5e %13.6e %13.6e %13.6e %13.6e %13.6e %13.6e %11.4e %4d\r\n",
-                                               gpaData.fexc,
-                                               gpaData.Ureal, gpaData.Uimag,
-                                               gpaData.Yreal, gpaData.Yimag,
-                                               gpaData.Rreal, gpaData.Rimag,
-                                               avg_time, m_print_cntr);
+            const float avg_time = static_cast<float>(meas_time) / static_cast<float>(Nmeas - 1);
+#if GPA_DO_USE_BINARY_STREAM
+            // only copies the data, the frame is sent by the low priority stream thread
+            queueFrame(avg_time);
+#else
+            int buffer_length = snprintf(m_buffer, BUFFER_LENGTH,
+                                         "%12.5e %13.6e %13.6e %13.6e %13.6e %13.6e %13.6e %11.4e %4d",
+                                         gpaData.fexc,
+                                         gpaData.Ureal, gpaData.Uimag,
+                                         gpaData.Yreal, gpaData.Yimag,
+                                         gpaData.Rreal, gpaData.Rimag,
+                                         avg_time, m_print_cntr);
+            // additional outputs are appended, so the first 9 columns stay the same
+            for(int ch = 1; ch < NumOfOutputs; ch++) {
+                if (buffer_length >= 0 && buffer_length < BUFFER_LENGTH)
+                    buffer_length += snprintf(&m_buffer[buffer_length], BUFFER_LENGTH - buffer_length,
+                                              " %13.6e %13.6e", Yreal[ch], Yimag[ch]);
+            }
+            if (buffer_length >= 0 && buffer_length < BUFFER_LENGTH)
+                buffer_length += snprintf(&m_buffer[buffer_length], BUFFER_LENGTH - buffer_length, "\r\n");
             if (buffer_length >= 0 && buffer_length < BUFFER_LENGTH) {
                 if (m_BufferedSerial.writable()) {
                     m_BufferedSerial.write(m_buffer, buffer_length);
                     m_print_cntr++;
                 }
             }
+#endif
         }
         i += 1;
         j = 1;
@@ -449,9 +479,9 @@ float GPA::update(float inp, float out)
         j += 1;
     }
     // calculate the excitation
-    sinarg = fmod(sinarg + pi2Ts*dfexc, pi2);
+    phase.apply(Ts*dfexc);
     NmeasTotal += 1;
-    exc = AexcOut*sinf(sinarg);
+    exc = AexcOut*sinf(phase.getAngle());
     return exc;
 }
 
@@ -488,15 +518,6 @@ void GPA::initializeConstants(float Ts)
     this->div812pi = 8.0f / (12.0f * M_PIf);
 }
 
-void GPA::assignFilterStorage()
-{
-    sU = (double*)malloc(3*sizeof(double));
-    sY = (double*)malloc(3*sizeof(double));
-#if GPA_EXC_VIA_FILTER
-    sR = (double*)malloc(3*sizeof(double));
-#endif
-}
-
 void GPA::assignAndResetParamStorage()
 {
     Nper_vec  = (int*)malloc(NfexcDes*sizeof(int));
@@ -620,7 +641,117 @@ void GPA::printPrecalcParam()
     for(int i = 0; i < NfexcAct; i++) printf(" %6i %6i %9.3e %9.3e\n", Nper_vec[i], Nmeas_vec[i], fexc_vec[i], Aexc_vec[i]);
 }
 
+bool GPA::getMeasPara(int ind, float& fexc_ind, int& Nmeas_ind) const
+{
+    // the precalculated vectors are not compressed, so skip the unreachable frequency points
+    if(!doPrecalcParam)
+        return false;
+    int cntr = 0;
+    for(int i = 0; i < NfexcDes; i++) {
+        if(Nmeas_vec[i] == 0)
+            continue;
+        if(cntr == ind) {
+            fexc_ind = (float)fexc_vec[i];
+            Nmeas_ind = Nmeas_vec[i];
+            return true;
+        }
+        cntr++;
+    }
+    return false;
+}
+
 GPA::gpadata_t GPA::getGPAdata()
 {
     return gpaData;
 }
+
+GPA::gpadata_t GPA::getGPAdata(int ch)
+{
+    // an output that is not measured gets zeroed data with ind -1, like before the first frequency point
+    if(ch < 0 || ch >= NumOfOutputs) {
+        gpadata_t gpaData_invalid = {};
+        gpaData_invalid.ind = -1;
+        return gpaData_invalid;
+    }
+    gpadata_t gpaData_ch = gpaData;
+    gpaData_ch.Yreal = Yreal[ch];
+    gpaData_ch.Yimag = Yimag[ch];
+    return gpaData_ch;
+}
+
+#if GPA_DO_USE_BINARY_STREAM
+void GPA::startStreamThread()
+{
+    if(m_stream_thread_started)
+        return;
+    m_stream_thread_started = true;
+    m_stream_thread.start(callback(this, &GPA::streamTask));
+}
+
+void GPA::streamTask()
+{
+    // this thread has a low priority, so blocking writes do not disturb the control loop
+    m_BufferedSerial.set_blocking(true);
+    char buffer[GPA_FRAME_LENGTH_MAX];
+    while(true) {
+        while(!m_frame_pipe.empty()) {
+            const size_t length = m_frame_pipe.read(buffer, GPA_FRAME_LENGTH_MAX);
+            m_BufferedSerial.write(buffer, length);
+        }
+        thread_sleep_for(GPA_STREAM_PERIOD_MS);
+    }
+}
+
+void GPA::queueFrame(float avg_time)
+{
+    // frame layout, all values little endian:
+    // sync_0, sync_1, num of outputs, ind (uint16), fexc, Ureal, Uimag, Yreal, Yimag, Rreal, Rimag, avg_time,
+    // Yreal and Yimag of the additional outputs, crc16 over everything after the sync bytes
+    const int length = GPA_FRAME_LENGTH(NumOfOutputs);
+    const uint16_t ind = static_cast<uint16_t>(gpaData.ind);
+    m_frame[0] = (char)GPA_FRAME_SYNC_0;
+    m_frame[1] = (char)GPA_FRAME_SYNC_1;
+    m_frame[2] = (char)NumOfOutputs;
+    memcpy(&m_frame[3], &ind, 2);
+
+    const float values[8] = {gpaData.fexc, gpaData.Ureal, gpaData.Uimag, gpaData.Yreal, gpaData.Yimag,
+                             gpaData.Rreal, gpaData.Rimag, avg_time};
+    memcpy(&m_frame[GPA_FRAME_HEADER_LENGTH], values, sizeof(values));
+    int byte_cntr = GPA_FRAME_HEADER_LENGTH + sizeof(values);
+    for(int ch = 1; ch < NumOfOutputs; ch++) {
+        memcpy(&m_frame[byte_cntr], &Yreal[ch], 4);
+        memcpy(&m_frame[byte_cntr + 4], &Yimag[ch], 4);
+        byte_cntr += 8;
+    }
+    const uint16_t crc = crc16(&m_frame[2], byte_cntr - 2);
+    memcpy(&m_frame[byte_cntr], &crc, 2);
+
+    // never write partial frames, the receiver detects dropped frames via ind
+    if(m_frame_pipe.free() >= (size_t)length)
+        m_frame_pipe.write(m_frame, length);
+    else
+        m_frames_dropped++;
+}
+
+uint16_t GPA::crc16(const char* data, int length)
+{
+    // crc-16/ccitt-false, poly 0x1021, init 0xffff
+    uint16_t crc = 0xFFFF;
+    for(int i = 0; i < length; i++) {
+        crc ^= (uint16_t)((uint8_t)data[i]) << 8;
+        for(int k = 0; k < 8; k++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+#endif
+
+void GPA::setNumOfOutputs(int num_of_outputs)
+{
+    if(num_of_outputs < 1 || num_of_outputs > GPA_NUM_OF_OUTPUTS_MAX) {
+        printf("Warning: GPA number of outputs has to be between 1 and %d\n", GPA_NUM_OF_OUTPUTS_MAX);
+        num_of_outputs = (num_of_outputs < 1) ? 1 : GPA_NUM_OF_OUTPUTS_MAX;
+    }
+    NumOfOutputs = num_of_outputs;
+    reset();
+}
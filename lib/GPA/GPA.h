@@ -11,6 +11,16 @@
 
 #include "math.h"
 
+#include "GPAFilter.h"
+
+#define GPA_DO_USE_BINARY_STREAM true // if this is true then the measured frequency points are sent as crc protected binary
+                                      // frames by a low priority thread (decode them with GPAStream.py), otherwise they
+                                      // are formatted and printed in update()
+
+#if GPA_DO_USE_BINARY_STREAM
+    #include "SPSCRingBuffer.h"
+#endif
+
 #ifndef M_PIf
     #define M_PIf 3.14159265358979323846f // pi
 #endif
@@ -20,7 +30,31 @@
 #endif
 
 #define GPA_EXC_VIA_FILTER false
-#define BUFFER_LENGTH 120
+#define GPA_DO_USE_FLOAT_FILTER false // if this is true then the one point DFT filters and the excitation phase are
+                                      // calculated in single precision (see GPAFilter.h), which is much faster
+                                      // on the Cortex-M4F, use main_gpa_filter_benchmark.cpp to compare
+#define GPA_NUM_OF_OUTPUTS_MAX 3 // number of outputs that can be measured in parallel against the same excitation
+#define BUFFER_LENGTH (120 + 28 * (GPA_NUM_OF_OUTPUTS_MAX - 1))
+
+// binary frame: sync (2 bytes), num of outputs (1 byte), ind (2 bytes), floats, crc16 (2 bytes)
+#define GPA_FRAME_SYNC_0 0xA5
+#define GPA_FRAME_SYNC_1 0x5A
+#define GPA_FRAME_HEADER_LENGTH 5
+#define GPA_FRAME_NUM_OF_FLOATS(num_of_outputs) (8 + 2 * ((num_of_outputs) - 1))
+#define GPA_FRAME_LENGTH(num_of_outputs) (GPA_FRAME_HEADER_LENGTH + 4 * GPA_FRAME_NUM_OF_FLOATS(num_of_outputs) + 2)
+#define GPA_FRAME_LENGTH_MAX GPA_FRAME_LENGTH(GPA_NUM_OF_OUTPUTS_MAX)
+#define GPA_FRAME_QUEUE_LENGTH (8 * GPA_FRAME_LENGTH_MAX) // frames that can be queued before they get dropped
+#define GPA_STREAM_PERIOD_MS 10
+
+#if GPA_DO_USE_FLOAT_FILTER
+typedef float gpa_real_t;
+typedef GPAFilterFloat GPAFilter_t;
+typedef GPAPhaseFloat GPAPhase_t;
+#else
+typedef double gpa_real_t;
+typedef GPAFilterDouble GPAFilter_t;
+typedef GPAPhaseDouble GPAPhase_t;
+#endif
 
 using namespace std;
 
@@ -53,11 +87,22 @@ public:
         return update(inp, out);
     }
 
+    float operator()(float inp, const float* out)
+    {
+        return update(inp, out);
+    }
+
     ~GPA() = default;
 
     void    init(float fMin, float fMax, int NfexcDes, int NperMin, int NmeasMin, float Ts, float Aexc0, float Aexc1, int Nstart, int Nsweep, bool doPrint, bool doPrecalcParam);
     void    reset();
     float   update(float inp, float out);
+    // out has to contain getNumOfOutputs() values
+    float   update(float inp, const float* out);
+
+    // set the number of outputs before the measurement starts, this resets the gpa
+    void    setNumOfOutputs(int num_of_outputs);
+    int     getNumOfOutputs() const { return NumOfOutputs; }
 
     void    printGPAfexcDes();
     void    printGPAmeasPara();
@@ -65,7 +110,17 @@ public:
     void    printNfexcDes();
     void    printPrecalcParam();
 
+    // precalculated parameters, only valid if doPrecalcParam is true
+    int     getNumOfFreqPoints() const { return NfexcAct; }
+    bool    getMeasPara(int ind, float& fexc_ind, int& Nmeas_ind) const;
+
+#if GPA_DO_USE_BINARY_STREAM
+    uint16_t getNumOfDroppedFrames() const { return m_frames_dropped; }
+#endif
+
     gpadata_t getGPAdata();
+    // Yreal and Yimag correspond to output ch, the other data is shared, zeroed with ind -1 if ch is not measured
+    gpadata_t getGPAdata(int ch);
 
 private:
     BufferedSerial m_BufferedSerial;
@@ -73,6 +128,18 @@ private:
     void setUpBufferedSerial();
     uint16_t m_print_cntr;
 
+#if GPA_DO_USE_BINARY_STREAM
+    SPSCRingBuffer<char> m_frame_pipe{GPA_FRAME_QUEUE_LENGTH}; // lock free, written in update() and read by m_stream_thread
+    char m_frame[GPA_FRAME_LENGTH_MAX];
+    Thread m_stream_thread{osPriorityLow, 1024};
+    bool m_stream_thread_started = false;
+    uint16_t m_frames_dropped;
+    void startStreamThread();
+    void streamTask();
+    void queueFrame(float avg_time);
+    static uint16_t crc16(const char* data, int length);
+#endif
+
     int     NfexcDes;
     int     NperMin;
     int     NmeasMin;
@@ -92,22 +159,20 @@ private:
 
     int     Nmeas;
     int     Nper;
-    double  dfexc;
-    double  fexc;
+    gpa_real_t dfexc;
+    gpa_real_t fexc;
     float   fexcPast;
     float   dfexcj;
     int     i;
     int     j;
-    double  scaleG;
-    double  cr;
-    double  ci;
-    double *sU;
-    double *sY;
+    int     NumOfOutputs = 1;
+    GPAFilter_t filterU;
+    GPAFilter_t filterY[GPA_NUM_OF_OUTPUTS_MAX];
 #if GPA_EXC_VIA_FILTER
-    double *sR;
+    GPAFilter_t filterR;
 #endif
     float   exc;
-    double  sinarg;
+    GPAPhase_t phase;
     float   sinargR;
     int     NmeasTotal;
     float   Aexc;
@@ -127,12 +192,13 @@ private:
     int     NfexcAct;
 
     gpadata_t gpaData;
+    float   Yreal[GPA_NUM_OF_OUTPUTS_MAX];
+    float   Yimag[GPA_NUM_OF_OUTPUTS_MAX];
     bool    doPrint;
 
     void    assignParameters(int NfexcDes, int NperMin, int NmeasMin, float Ts, int Nstart, int Nsweep);
     void    calculateDecreasingAmplitudeCoefficients(float Aexc0, float Aexc1);
     void    initializeConstants(float Ts);
-    void    assignFilterStorage();
     void    assignAndResetParamStorage();
     void    fexcDesLogspace(float fMin, float fMax, int NfexcDes);
     void    calcGPAmeasPara(float fexcDes_i);
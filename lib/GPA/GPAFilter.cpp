@@ -0,0 +1,123 @@
+#include "GPAFilter.h"
+
+#include <math.h>
+
+#ifndef M_PI
+    #define M_PI 3.141592653589793238462643383279502884 // pi
+#endif
+
+void GPAFilterDouble::init(double scale, double w)
+{
+    m_scale = scale;
+    m_cr = cos(w);
+    m_ci = sin(w);
+    reset();
+}
+
+void GPAFilterDouble::reset()
+{
+    m_s1 = 0.0;
+    m_s2 = 0.0;
+}
+
+void GPAFilterDouble::apply(float x)
+{
+    // one point DFT filter step
+    const double s0 = m_scale * (double)x + 2.0 * m_cr * m_s1 - m_s2;
+    m_s2 = m_s1;
+    m_s1 = s0;
+}
+
+void GPAFilterDouble::getDFT(float& real, float& imag) const
+{
+    real = (float)(2.0 * m_scale * (m_cr * m_s1 - m_s2));
+    imag = (float)(2.0 * m_scale * m_ci * m_s1);
+}
+
+void GPAFilterFloat::init(double scale, double w)
+{
+    // coefficients are calculated once per frequency point, so double is fine here
+    m_scale = (float)scale;
+    m_ci = (float)sin(w);
+    m_is_low_freq = (cos(w) >= 0.0);
+    if (m_is_low_freq) {
+        const double sin_w2 = sin(0.5 * w);
+        m_lambda = (float)(4.0 * sin_w2 * sin_w2);
+    } else {
+        const double cos_w2 = cos(0.5 * w);
+        m_lambda = (float)(-4.0 * cos_w2 * cos_w2);
+    }
+    reset();
+}
+
+void GPAFilterFloat::reset()
+{
+    m_s = 0.0f;
+    m_d = 0.0f;
+    m_s_comp = 0.0f;
+    m_d_comp = 0.0f;
+}
+
+void GPAFilterFloat::apply(float x)
+{
+    float y, t;
+    if (m_is_low_freq) {
+        // d[k] = d[k-1] - lambda*s[k-1] + x[k], s[k] = s[k-1] + d[k]
+        y = m_scale * x - m_lambda * m_s - m_d_comp;
+        t = m_d + y;
+        m_d_comp = (t - m_d) - y;
+        m_d = t;
+
+        y = m_d - m_s_comp;
+        t = m_s + y;
+        m_s_comp = (t - m_s) - y;
+        m_s = t;
+    } else {
+        // d[k] = -d[k-1] - lambda*s[k-1] + x[k], s[k] = d[k] - s[k-1]
+        // the sign flips also apply to the compensations
+        y = m_scale * x - m_lambda * m_s + m_d_comp;
+        t = -m_d + y;
+        m_d_comp = (t + m_d) - y;
+        m_d = t;
+
+        y = m_s_comp - m_s;
+        t = m_d + y;
+        m_s_comp = (t - m_d) - y;
+        m_s = t;
+    }
+}
+
+void GPAFilterFloat::getDFT(float& real, float& imag) const
+{
+    // cos(w)*s[N] - s[N-1] expressed with d[N] and lambda
+    if (m_is_low_freq)
+        real = 2.0f * m_scale * (m_d - 0.5f * m_lambda * m_s);
+    else
+        real = 2.0f * m_scale * (-0.5f * m_lambda * m_s - m_d);
+    imag = 2.0f * m_scale * m_ci * m_s;
+}
+
+void GPAPhaseDouble::apply(double increment)
+{
+    m_sinarg = fmod(m_sinarg + 2.0 * M_PI * increment, 2.0 * M_PI);
+}
+
+void GPAPhaseFloat::reset()
+{
+    m_phase = 0.0f;
+    m_phase_comp = 0.0f;
+}
+
+void GPAPhaseFloat::apply(float increment)
+{
+    const float y = increment - m_phase_comp;
+    const float t = m_phase + y;
+    m_phase_comp = (t - m_phase) - y;
+    // subtracting 1 from a value in [1, 2) is exact, so the compensation stays valid
+    m_phase = (t >= 1.0f) ? t - 1.0f : t;
+}
+
+float GPAPhaseFloat::getAngle() const
+{
+    return 6.28318530717958647692f * m_phase;
+}
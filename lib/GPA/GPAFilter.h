@@ -0,0 +1,107 @@
+/**
+ * @file GPAFilter.h
+ * @brief One point DFT filters (Goertzel) and excitation phase accumulators used by the GPA class.
+ *
+ * GPAFilterDouble is the classic Goertzel recursion in double precision as it was used in GPA
+ * so far. Double precision is emulated in software on the Cortex-M4F and therefore slow.
+ *
+ * GPAFilterFloat computes the same one point DFT in single precision. The classic recursion
+ * s[k] = x[k] + 2*cos(w)*s[k-1] - s[k-2] loses its accuracy in float for small w (cos(w) -> 1),
+ * which are exactly the low frequency points of a GPA sweep. Therefore the Reinsch modification
+ * is used, it propagates the difference d[k] = s[k] -/+ s[k-1] with the well conditioned
+ * coefficient lambda = 4*sin(w/2)^2 (w <= pi/2) or lambda = -4*cos(w/2)^2 (w > pi/2), and both
+ * accumulations are Kahan compensated.
+ *
+ * Both filters scale the input with scale = 1/sqrt(Nmeas) and return
+ * X = 2*scale * (cos(w)*s[N] - s[N-1] + 1i*sin(w)*s[N]) after N samples.
+ *
+ * The phase accumulators integrate the excitation frequency. GPAPhaseDouble wraps the angle with
+ * fmod() in double, GPAPhaseFloat accumulates in cycles [0, 1) with Kahan summation, where the
+ * wrap around is exact in float.
+ *
+ * IMPORTANT: do not compile this with -ffast-math, it removes the Kahan compensation.
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef GPA_FILTER_H_
+#define GPA_FILTER_H_
+
+class GPAFilterDouble
+{
+public:
+    explicit GPAFilterDouble() {};
+    virtual ~GPAFilterDouble() = default;
+
+    // set the filter coefficients for the normalised frequency w = 2*pi*fexc*Ts and reset the storage
+    void init(double scale, double w);
+    void reset();
+    void apply(float x);
+    void getDFT(float& real, float& imag) const;
+
+private:
+    double m_scale{0.0};
+    double m_cr{0.0};
+    double m_ci{0.0};
+    double m_s1{0.0};
+    double m_s2{0.0};
+};
+
+class GPAFilterFloat
+{
+public:
+    explicit GPAFilterFloat() {};
+    virtual ~GPAFilterFloat() = default;
+
+    // set the filter coefficients for the normalised frequency w = 2*pi*fexc*Ts and reset the storage
+    void init(double scale, double w);
+    void reset();
+    void apply(float x);
+    void getDFT(float& real, float& imag) const;
+
+private:
+    float m_scale{0.0f};
+    float m_lambda{0.0f};
+    float m_ci{0.0f};
+    bool m_is_low_freq{true}; // w <= pi/2
+
+    float m_s{0.0f};
+    float m_d{0.0f};
+    float m_s_comp{0.0f}; // Kahan compensation of m_s
+    float m_d_comp{0.0f}; // Kahan compensation of m_d
+};
+
+class GPAPhaseDouble
+{
+public:
+    explicit GPAPhaseDouble() {};
+    virtual ~GPAPhaseDouble() = default;
+
+    void reset() { m_sinarg = 0.0; }
+    // increment in cycles, e.g. fexc*Ts
+    void apply(double increment);
+    // angle in rad within [0, 2*pi)
+    float getAngle() const { return (float)m_sinarg; }
+
+private:
+    double m_sinarg{0.0};
+};
+
+class GPAPhaseFloat
+{
+public:
+    explicit GPAPhaseFloat() {};
+    virtual ~GPAPhaseFloat() = default;
+
+    void reset();
+    // increment in cycles, e.g. fexc*Ts
+    void apply(float increment);
+    // angle in rad within [0, 2*pi)
+    float getAngle() const;
+
+private:
+    float m_phase{0.0f};      // in cycles
+    float m_phase_comp{0.0f}; // Kahan compensation of m_phase
+};
+
+#endif /* GPA_FILTER_H_ */
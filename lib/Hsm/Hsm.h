@@ -0,0 +1,277 @@
+/**
+ * @file Hsm.h
+ * @brief Small event driven hierarchical state machine with entry/exit actions and timer events
+ *
+ * A state is a handler (member function of the derived class) and a parent state, the states form a tree.
+ * An event is dispatched to the current (innermost) state first, if the handler returns HSM_UNHANDLED
+ * the event is passed to the parent, so the common reactions of several states are handled once in the
+ * parent. A handler changes the state with `return transition(&target);`, the state machine then
+ * - exits the states from the current one up to the common ancestor of the handling state and the target
+ *   (HSM_SIG_EXIT, innermost first),
+ * - enters the states down to the target (HSM_SIG_ENTRY, outermost first),
+ * - sends HSM_SIG_INIT to the target, which can choose one of its substates with another transition.
+ * Transitions are not allowed in the entry and exit actions.
+ *
+ * The timers are identified by the signal they send. armTimer() restarts a timer, when the time passed to
+ * update() reaches it the signal is dispatched once. There is no thread and no tick: the caller sleeps until
+ * an input event arrives or getTimeToNextTimerMs() elapsed and then calls update(), so the class runs on the
+ * target (time from the kernel) as well as on the host with a virtual time (docs/dev/dev_car_jack).
+ *
+ * dispatch() and update() have to be called from the same thread, interrupts only wake this thread.
+ *
+ * @example
+ * ```cpp
+ * class Blinky : public Hsm<Blinky>
+ * {
+ * public:
+ *     enum { SIG_TOGGLE = HSM_SIG_USER };
+ *     void begin(uint32_t time_ms) { start(&s_on, time_ms); }
+ * private:
+ *     static const State s_on;
+ *     HsmStatus on(const HsmEvent& e)
+ *     {
+ *         switch (e.signal) {
+ *             case HSM_SIG_ENTRY: armTimer(SIG_TOGGLE, 500); return HSM_HANDLED;
+ *             case SIG_TOGGLE: return transition(&s_on); // exits and enters the state again
+ *         }
+ *         return HSM_UNHANDLED;
+ *     }
+ * };
+ * const Blinky::State Blinky::s_on = {"on", nullptr, &Blinky::on};
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef HSM_H_
+#define HSM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define HSM_NUM_OF_TIMERS_MAX 8
+#define HSM_DEPTH_MAX 8            // nesting levels of the state tree
+#define HSM_DO_PRINT_STATES false  // prints every entered state
+
+enum HsmSignal : uint8_t {
+    HSM_SIG_ENTRY = 0,
+    HSM_SIG_EXIT,
+    HSM_SIG_INIT,
+    HSM_SIG_USER // first signal of the derived class
+};
+
+enum HsmStatus {
+    HSM_HANDLED,
+    HSM_UNHANDLED,
+    HSM_TRANSITION
+};
+
+struct HsmEvent {
+    uint8_t signal;
+    uint16_t parameter;
+};
+
+template <typename T>
+class Hsm
+{
+public:
+    typedef HsmStatus (T::*Handler)(const HsmEvent& event);
+
+    struct State {
+        const char* name;
+        const State* parent; // nullptr for the top states
+        Handler handler;
+    };
+
+    Hsm() = default;
+    virtual ~Hsm() = default;
+
+    // enters the initial state and its substates
+    void start(const State* initial, uint32_t time_ms)
+    {
+        m_time_ms = time_ms;
+        m_state = nullptr;
+        enter(nullptr, initial);
+        init();
+    }
+
+    void dispatch(const HsmEvent& event)
+    {
+        for (const State* state = m_state; state; state = state->parent) {
+            const HsmStatus status = call(state, event);
+            if (status == HSM_HANDLED)
+                return;
+            if (status == HSM_TRANSITION) {
+                doTransition(state, m_target);
+                return;
+            }
+        }
+    }
+
+    void dispatch(uint8_t signal, uint16_t parameter = 0)
+    {
+        const HsmEvent event = {signal, parameter};
+        dispatch(event);
+    }
+
+    // advances the time and dispatches the signals of the expired timers in the order they expired
+    void update(uint32_t time_ms)
+    {
+        m_time_ms = time_ms;
+        while (true) {
+            int idx = -1;
+            for (int i = 0; i < HSM_NUM_OF_TIMERS_MAX; i++) {
+                if (!m_timers[i].is_armed || remaining(m_timers[i]) > 0)
+                    continue;
+                if (idx < 0 || remaining(m_timers[i]) < remaining(m_timers[idx]))
+                    idx = i;
+            }
+            if (idx < 0)
+                return;
+            // the handler may arm the timer again
+            m_timers[idx].is_armed = false;
+            dispatch(m_timers[idx].signal);
+        }
+    }
+
+    // time until the next timer expires, -1 if no timer is armed
+    int32_t getTimeToNextTimerMs() const
+    {
+        int32_t time_ms = -1;
+        for (int i = 0; i < HSM_NUM_OF_TIMERS_MAX; i++) {
+            if (!m_timers[i].is_armed)
+                continue;
+            const int32_t t = (remaining(m_timers[i]) > 0) ? remaining(m_timers[i]) : 0;
+            if (time_ms < 0 || t < time_ms)
+                time_ms = t;
+        }
+        return time_ms;
+    }
+
+    // true if the state is the current state or one of its parents
+    bool isIn(const State* state) const
+    {
+        for (const State* s = m_state; s; s = s->parent)
+            if (s == state)
+                return true;
+        return false;
+    }
+
+    const State* getState() const { return m_state; }
+    uint32_t getTimeMs() const { return m_time_ms; }
+
+protected:
+    HsmStatus transition(const State* target)
+    {
+        m_target = target;
+        return HSM_TRANSITION;
+    }
+
+    // (re)starts the timer of the signal, the signal is dispatched once after delay_ms
+    void armTimer(uint8_t signal, uint32_t delay_ms)
+    {
+        int idx = findTimer(signal);
+        if (idx < 0)
+            idx = findTimer(signal, false);
+        if (idx < 0) {
+            printf("Hsm: no timer left for signal %d\n", signal);
+            return;
+        }
+        m_timers[idx].signal = signal;
+        m_timers[idx].time_ms = m_time_ms + delay_ms;
+        m_timers[idx].is_armed = true;
+    }
+
+    void disarmTimer(uint8_t signal)
+    {
+        const int idx = findTimer(signal);
+        if (idx >= 0)
+            m_timers[idx].is_armed = false;
+    }
+
+    bool isTimerArmed(uint8_t signal) const { return findTimer(signal) >= 0; }
+
+private:
+    struct hsm_timer_t {
+        uint8_t signal;
+        bool is_armed;
+        uint32_t time_ms;
+    };
+
+    const State* m_state{nullptr};
+    const State* m_target{nullptr};
+    hsm_timer_t m_timers[HSM_NUM_OF_TIMERS_MAX]{};
+    uint32_t m_time_ms{0};
+
+    HsmStatus call(const State* state, const HsmEvent& event)
+    {
+        return (static_cast<T*>(this)->*(state->handler))(event);
+    }
+
+    void send(const State* state, uint8_t signal)
+    {
+        const HsmEvent event = {signal, 0};
+        call(state, event);
+    }
+
+    // the time stamps wrap around after 49 days, the difference does not
+    int32_t remaining(const hsm_timer_t& timer) const { return static_cast<int32_t>(timer.time_ms - m_time_ms); }
+
+    int findTimer(uint8_t signal, bool is_armed = true) const
+    {
+        for (int i = 0; i < HSM_NUM_OF_TIMERS_MAX; i++)
+            if (m_timers[i].is_armed == is_armed && (!is_armed || m_timers[i].signal == signal))
+                return i;
+        return -1;
+    }
+
+    static bool isProperAncestor(const State* ancestor, const State* state)
+    {
+        for (const State* s = state->parent; s; s = s->parent)
+            if (s == ancestor)
+                return true;
+        return false;
+    }
+
+    // enters the states below from (exclusive) down to the target
+    void enter(const State* from, const State* target)
+    {
+        const State* path[HSM_DEPTH_MAX];
+        int depth = 0;
+        for (const State* s = target; s != from && depth < HSM_DEPTH_MAX; s = s->parent)
+            path[depth++] = s;
+        while (depth > 0) {
+            m_state = path[--depth];
+#if HSM_DO_PRINT_STATES
+            printf("Hsm: %lu ms enter %s\n", static_cast<unsigned long>(m_time_ms), m_state->name);
+#endif
+            send(m_state, HSM_SIG_ENTRY);
+        }
+    }
+
+    // follows the initial transitions of the current state, they have to target substates
+    void init()
+    {
+        while (true) {
+            const HsmEvent event = {HSM_SIG_INIT, 0};
+            if (call(m_state, event) != HSM_TRANSITION || !isProperAncestor(m_state, m_target))
+                return;
+            enter(m_state, m_target);
+        }
+    }
+
+    void doTransition(const State* source, const State* target)
+    {
+        // exit up to the common ancestor, the source itself is left if the target is not below it
+        const State* lca = isProperAncestor(source, target) ? source : source->parent;
+        while (lca && !isProperAncestor(lca, target))
+            lca = lca->parent;
+        while (m_state != lca) {
+            send(m_state, HSM_SIG_EXIT);
+            m_state = m_state->parent;
+        }
+        enter(lca, target);
+        init();
+    }
+};
+#endif /* HSM_H_ */
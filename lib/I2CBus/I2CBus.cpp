@@ -0,0 +1,337 @@
+#include "I2CBus.h"
+
+I2CBus::I2CBus(PinName sda, PinName scl, int frequency, osPriority priority) : m_i2c(sda, scl)
+                                                                              , m_Thread(priority)
+{
+    m_i2c.frequency(frequency);
+
+    for (int i = 0; i < I2C_BUS_NUM_OF_DEVICES_MAX; i++) {
+        m_devices[i].address = 0;
+        m_devices[i].is_auto_increment = false;
+    }
+    for (int i = 0; i < I2C_BUS_QUEUE_SIZE; i++) {
+        m_queue[i].state = State::Free;
+    }
+    m_Timer.start();
+
+    // start thread
+    m_Thread.start(callback(this, &I2CBus::threadTask));
+}
+
+I2CBus::~I2CBus()
+{
+    m_Thread.terminate();
+#if I2C_BUS_USE_ASYNC_TRANSFER
+    m_i2c.abort_transfer();
+#endif
+}
+
+bool I2CBus::addDevice(uint8_t address, bool is_auto_increment)
+{
+    CriticalSectionLock lock;
+    int device = findDevice(address);
+    if (device < 0) {
+        if (m_num_of_devices == I2C_BUS_NUM_OF_DEVICES_MAX)
+            return false;
+        device = m_num_of_devices++;
+        m_devices[device].address = address;
+        m_devices[device].statistics = Statistics{};
+    }
+    m_devices[device].is_auto_increment = is_auto_increment;
+    return true;
+}
+
+bool I2CBus::transfer(uint8_t address,
+                      const uint8_t* tx,
+                      uint8_t tx_length,
+                      uint8_t* rx,
+                      uint8_t rx_length,
+                      Callback<void(int)> done,
+                      Priority priority)
+{
+    return submit(address, false, tx, tx_length, rx, rx_length, done, priority);
+}
+
+bool I2CBus::readRegisters(uint8_t address,
+                           uint8_t reg,
+                           uint8_t* dest,
+                           uint8_t length,
+                           Callback<void(int)> done,
+                           Priority priority)
+{
+    return submit(address, true, &reg, 1, dest, length, done, priority);
+}
+
+bool I2CBus::writeRegisters(uint8_t address,
+                            uint8_t reg,
+                            const uint8_t* data,
+                            uint8_t length,
+                            Callback<void(int)> done,
+                            Priority priority)
+{
+    if (length > I2C_BUS_TX_SIZE_MAX - 1)
+        return false;
+    uint8_t tx[I2C_BUS_TX_SIZE_MAX];
+    tx[0] = reg;
+    for (int i = 0; i < length; i++)
+        tx[1 + i] = data[i];
+    return submit(address, false, tx, length + 1, nullptr, 0, done, priority);
+}
+
+int I2CBus::transferBlocking(uint8_t address,
+                             const uint8_t* tx,
+                             uint8_t tx_length,
+                             uint8_t* rx,
+                             uint8_t rx_length,
+                             Priority priority)
+{
+    blocking_t blocking;
+    if (!transfer(address, tx, tx_length, rx, rx_length, callback(&blocking, &blocking_t::done), priority))
+        return -1;
+    blocking.semaphore.acquire();
+    return blocking.result;
+}
+
+int I2CBus::readRegistersBlocking(uint8_t address, uint8_t reg, uint8_t* dest, uint8_t length, Priority priority)
+{
+    blocking_t blocking;
+    if (!readRegisters(address, reg, dest, length, callback(&blocking, &blocking_t::done), priority))
+        return -1;
+    blocking.semaphore.acquire();
+    return blocking.result;
+}
+
+int I2CBus::writeRegistersBlocking(uint8_t address, uint8_t reg, const uint8_t* data, uint8_t length, Priority priority)
+{
+    blocking_t blocking;
+    if (!writeRegisters(address, reg, data, length, callback(&blocking, &blocking_t::done), priority))
+        return -1;
+    blocking.semaphore.acquire();
+    return blocking.result;
+}
+
+I2CBus::Statistics I2CBus::getStatistics(uint8_t address) const
+{
+    CriticalSectionLock lock;
+    for (int i = 0; i < m_num_of_devices; i++) {
+        if (m_devices[i].address == address)
+            return m_devices[i].statistics;
+    }
+    return Statistics{};
+}
+
+void I2CBus::resetStatistics(uint8_t address)
+{
+    CriticalSectionLock lock;
+    const int device = findDevice(address);
+    if (device >= 0)
+        m_devices[device].statistics = Statistics{};
+}
+
+int I2CBus::findDevice(uint8_t address)
+{
+    for (int i = 0; i < m_num_of_devices; i++) {
+        if (m_devices[i].address == address)
+            return i;
+    }
+    return -1;
+}
+
+bool I2CBus::submit(uint8_t address,
+                    bool is_register_read,
+                    const uint8_t* tx,
+                    uint8_t tx_length,
+                    uint8_t* rx,
+                    uint8_t rx_length,
+                    Callback<void(int)> done,
+                    Priority priority)
+{
+    if (tx_length > I2C_BUS_TX_SIZE_MAX || (tx_length == 0 && rx_length == 0))
+        return false;
+
+    // unknown devices are registered with their first transaction, without merging of register reads
+    if (findDevice(address) < 0 && !addDevice(address, false))
+        return false;
+
+    {
+        CriticalSectionLock lock;
+        transaction_t* transaction = nullptr;
+        for (int i = 0; i < I2C_BUS_QUEUE_SIZE; i++) {
+            if (m_queue[i].state == State::Free) {
+                transaction = &m_queue[i];
+                break;
+            }
+        }
+        if (!transaction)
+            return false;
+
+        transaction->is_register_read = is_register_read;
+        transaction->priority = priority;
+        transaction->device = static_cast<uint8_t>(findDevice(address));
+        for (int i = 0; i < tx_length; i++)
+            transaction->tx[i] = tx[i];
+        transaction->tx_length = tx_length;
+        transaction->rx = rx;
+        transaction->rx_length = rx_length;
+        transaction->sequence = m_sequence++;
+        transaction->time_submit_us = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(m_Timer.elapsed_time()).count());
+        transaction->done = done;
+        transaction->state = State::Queued;
+    }
+
+    sendThreadFlag();
+    return true;
+}
+
+// the oldest queued transaction with the highest priority, it is marked active
+I2CBus::transaction_t* I2CBus::popNext()
+{
+    CriticalSectionLock lock;
+    transaction_t* next = nullptr;
+    for (int i = 0; i < I2C_BUS_QUEUE_SIZE; i++) {
+        transaction_t* transaction = &m_queue[i];
+        if (transaction->state != State::Queued)
+            continue;
+        if (!next || transaction->priority < next->priority ||
+            (transaction->priority == next->priority && static_cast<int32_t>(transaction->sequence - next->sequence) < 0))
+            next = transaction;
+    }
+    if (next)
+        next->state = State::Active;
+    return next;
+}
+
+// collects the queued register reads that continue first, they are marked active, returns their number
+int I2CBus::mergeReads(transaction_t* first, transaction_t** merged)
+{
+    if (!first->is_register_read || !m_devices[first->device].is_auto_increment)
+        return 0;
+
+    CriticalSectionLock lock;
+    int num_of_merged = 0;
+    int length = first->rx_length;
+    bool is_found = true;
+    while (is_found && num_of_merged < I2C_BUS_QUEUE_SIZE - 1) {
+        is_found = false;
+        const int reg_next = first->tx[0] + length;
+        for (int i = 0; i < I2C_BUS_QUEUE_SIZE; i++) {
+            transaction_t* transaction = &m_queue[i];
+            if (transaction->state != State::Queued || !transaction->is_register_read ||
+                transaction->device != first->device || transaction->tx[0] != reg_next ||
+                length + transaction->rx_length > I2C_BUS_BURST_SIZE_MAX)
+                continue;
+            transaction->state = State::Active;
+            merged[num_of_merged++] = transaction;
+            length += transaction->rx_length;
+            is_found = true;
+            break;
+        }
+    }
+    return num_of_merged;
+}
+
+// executes one transfer on the bus, returns 0 on success
+int I2CBus::execute(uint8_t address, const uint8_t* tx, uint8_t tx_length, uint8_t* rx, uint8_t rx_length)
+{
+#if I2C_BUS_USE_ASYNC_TRANSFER
+    // a late completion of an aborted transfer must not end the wait for this one
+    ThisThread::flags_clear(m_TransferFlag);
+    m_transfer_event = 0;
+    if (m_i2c.transfer(address, reinterpret_cast<const char*>(tx), tx_length,
+                       reinterpret_cast<char*>(rx), rx_length,
+                       callback(this, &I2CBus::onTransferDone), I2C_EVENT_ALL) != 0)
+        return -1;
+    const uint32_t flags = ThisThread::flags_wait_any_for(m_TransferFlag, std::chrono::milliseconds{I2C_BUS_TIMEOUT_MS});
+    if ((flags & osFlagsError) || !(flags & m_TransferFlag)) {
+        m_i2c.abort_transfer();
+        return -1;
+    }
+    const int event = m_transfer_event;
+    return (event & I2C_EVENT_TRANSFER_COMPLETE) ? 0 : (event & I2C_EVENT_ALL);
+#else
+    if (rx_length == 0)
+        return (m_i2c.write(address, reinterpret_cast<const char*>(tx), tx_length) == 0) ? 0 : -1;
+    if (tx_length > 0 && m_i2c.write(address, reinterpret_cast<const char*>(tx), tx_length, true) != 0)
+        return -1;
+    return (m_i2c.read(address, reinterpret_cast<char*>(rx), rx_length) == 0) ? 0 : -1;
+#endif
+}
+
+void I2CBus::complete(transaction_t* transaction, int result)
+{
+    const uint32_t time_us = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(m_Timer.elapsed_time()).count());
+    const uint32_t latency_us = time_us - transaction->time_submit_us;
+    Callback<void(int)> done = transaction->done;
+
+    {
+        CriticalSectionLock lock;
+        Statistics& statistics = m_devices[transaction->device].statistics;
+        statistics.num_of_transactions++;
+        if (result != 0)
+            statistics.num_of_errors++;
+        if (statistics.num_of_transactions == 1 || latency_us < statistics.latency_min_us)
+            statistics.latency_min_us = latency_us;
+        if (latency_us > statistics.latency_max_us)
+            statistics.latency_max_us = latency_us;
+        statistics.latency_mean_us += (static_cast<float>(latency_us) - statistics.latency_mean_us) / static_cast<float>(statistics.num_of_transactions);
+
+        // the slot can be reused from here on
+        transaction->state = State::Free;
+    }
+
+    if (done)
+        done(result);
+}
+
+#if I2C_BUS_USE_ASYNC_TRANSFER
+// called from the I2C interrupt
+void I2CBus::onTransferDone(int event)
+{
+    m_transfer_event = event;
+    m_Thread.flags_set(m_TransferFlag);
+}
+#endif
+
+void I2CBus::threadTask()
+{
+    transaction_t* merged[I2C_BUS_QUEUE_SIZE];
+    while (true) {
+        ThisThread::flags_wait_any(m_ThreadFlag);
+
+        transaction_t* transaction;
+        while ((transaction = popNext()) != nullptr) {
+            const int num_of_merged = mergeReads(transaction, merged);
+            if (num_of_merged == 0) {
+                complete(transaction, execute(m_devices[transaction->device].address,
+                                              transaction->tx, transaction->tx_length,
+                                              transaction->rx, transaction->rx_length));
+                continue;
+            }
+
+            // one burst read for all merged register reads, then the data is copied to the destinations
+            int length = transaction->rx_length;
+            for (int i = 0; i < num_of_merged; i++)
+                length += merged[i]->rx_length;
+            const int result = execute(m_devices[transaction->device].address, transaction->tx, 1, m_burst, length);
+
+            int offset = 0;
+            for (int i = -1; i < num_of_merged; i++) {
+                transaction_t* part = (i < 0) ? transaction : merged[i];
+                if (result == 0)
+                    memcpy(part->rx, &m_burst[offset], part->rx_length);
+                offset += part->rx_length;
+                if (i >= 0) {
+                    CriticalSectionLock lock;
+                    m_devices[part->device].statistics.num_of_merged++;
+                }
+                complete(part, result);
+            }
+        }
+    }
+}
+
+void I2CBus::sendThreadFlag()
+{
+    // set the thread flag to trigger the thread task
+    m_Thread.flags_set(m_ThreadFlag);
+}
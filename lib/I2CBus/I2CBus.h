@@ -0,0 +1,195 @@
+/**
+ * @file I2CBus.h
+ * @brief Owns an I2C peripheral and executes queued transactions of several devices
+ *
+ * Drivers that share a bus (e.g. LSM9DS1 and SensorBar) do not own an I2C object but submit
+ * transactions to the I2CBus. The bus executes them one after the other in its own thread, so the
+ * drivers do not block each other behind the mutex of the I2C object and a driver with a high
+ * priority transaction only waits for the transaction that is currently on the bus.
+ *
+ * - A transaction writes up to I2C_BUS_TX_SIZE_MAX bytes (e.g. register address and data) and then
+ *   reads rx_length bytes after a repeated start, rx_length may be 0.
+ * - The queue holds I2C_BUS_QUEUE_SIZE transactions, the next transaction is the oldest one with the
+ *   highest priority.
+ * - Register reads of the same device that are queued at the same time and continue each other
+ *   (reg + length of the first is reg of the second) are merged into one burst read if the device
+ *   supports address auto increment, see addDevice().
+ * - The callback of a transaction is executed in the bus thread with 0 on success, the I2C_EVENT_*
+ *   error bits of a failed async transfer or -1 on a timeout or nack. Keep it short, it delays the
+ *   next transaction.
+ * - For every device the bus counts transactions and errors and measures the latency from
+ *   submitting to completing a transaction.
+ *
+ * With I2C_BUS_DO_USE_ASYNC_TRANSFER and DEVICE_I2C_ASYNCH the transfers are interrupt driven and
+ * the bus thread sleeps while a transfer is on the bus, otherwise the blocking I2C functions are used.
+ *
+ * @dependencies
+ * This class relies on the following components:
+ * - **I2C**: The peripheral, async transfers if available
+ * - **Thread**, **ThreadFlag**: For the bus thread
+ * - **Semaphore**: For the blocking functions
+ * - **Timer**: For the latency measurement
+ *
+ * @example
+ * ```cpp
+ * I2CBus i2c_bus(PC_9, PA_8);
+ * IMU imu(i2c_bus);
+ * SensorBar sensor_bar(i2c_bus, bar_dist);
+ *
+ * // asynchronous register read, the callback is executed in the bus thread
+ * i2c_bus.readRegisters(address, reg, buffer, 6, callback(this, &Driver::onRead), I2CBus::Priority::High);
+ *
+ * I2CBus::Statistics statistics = i2c_bus.getStatistics(address);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef I2C_BUS_H_
+#define I2C_BUS_H_
+
+#include "mbed.h"
+
+#include "ThreadFlag.h"
+
+#define I2C_BUS_NUM_OF_DEVICES_MAX 6
+#define I2C_BUS_QUEUE_SIZE 12
+#define I2C_BUS_TX_SIZE_MAX 8     // register address and data of a write
+#define I2C_BUS_BURST_SIZE_MAX 32 // bytes of a merged register read
+#define I2C_BUS_FREQUENCY_DEFAULT 400000
+#define I2C_BUS_TIMEOUT_MS 10     // a transfer that takes longer is aborted
+
+// if this is true and the target supports asynchronous I2C then the bus thread sleeps while a transfer is on the bus
+#define I2C_BUS_DO_USE_ASYNC_TRANSFER true
+#define I2C_BUS_USE_ASYNC_TRANSFER (I2C_BUS_DO_USE_ASYNC_TRANSFER && DEVICE_I2C_ASYNCH)
+
+class I2CBus
+{
+public:
+    enum class Priority : uint8_t {High = 0, Normal, Low};
+
+    struct Statistics {
+        uint32_t num_of_transactions; // completed transactions, including errors
+        uint32_t num_of_errors;
+        uint32_t num_of_merged;       // register reads that were merged into the burst of another one
+        uint32_t latency_min_us;      // time from submitting to completing a transaction
+        uint32_t latency_max_us;
+        float latency_mean_us;
+    };
+
+    explicit I2CBus(PinName sda,
+                    PinName scl,
+                    int frequency = I2C_BUS_FREQUENCY_DEFAULT,
+                    osPriority priority = osPriorityHigh);
+    virtual ~I2CBus();
+
+    // registers a device with its 8 bit address like mbed I2C, devices are also registered with their
+    // first transaction, is_auto_increment = false prevents merging of its register reads,
+    // returns false if there are already I2C_BUS_NUM_OF_DEVICES_MAX devices
+    bool addDevice(uint8_t address, bool is_auto_increment = true);
+
+    // asynchronous transactions, return false if the queue is full or a length is too large,
+    // tx and data are copied, rx and dest have to be valid until the callback is executed
+    bool transfer(uint8_t address,
+                  const uint8_t* tx,
+                  uint8_t tx_length,
+                  uint8_t* rx,
+                  uint8_t rx_length,
+                  Callback<void(int)> done,
+                  Priority priority = Priority::Normal);
+    bool readRegisters(uint8_t address,
+                       uint8_t reg,
+                       uint8_t* dest,
+                       uint8_t length,
+                       Callback<void(int)> done,
+                       Priority priority = Priority::Normal);
+    bool writeRegisters(uint8_t address,
+                        uint8_t reg,
+                        const uint8_t* data,
+                        uint8_t length,
+                        Callback<void(int)> done,
+                        Priority priority = Priority::Normal);
+
+    // blocking versions for the initialisation of the drivers, return 0 on success, do not call them from
+    // an interrupt or a callback of the bus
+    int transferBlocking(uint8_t address,
+                         const uint8_t* tx,
+                         uint8_t tx_length,
+                         uint8_t* rx,
+                         uint8_t rx_length,
+                         Priority priority = Priority::Normal);
+    int readRegistersBlocking(uint8_t address, uint8_t reg, uint8_t* dest, uint8_t length, Priority priority = Priority::Normal);
+    int writeRegistersBlocking(uint8_t address, uint8_t reg, const uint8_t* data, uint8_t length, Priority priority = Priority::Normal);
+
+    // statistics of a device, all zero for an unknown address
+    Statistics getStatistics(uint8_t address) const;
+    void resetStatistics(uint8_t address);
+
+private:
+    struct device_t {
+        uint8_t address;
+        bool is_auto_increment;
+        Statistics statistics;
+    };
+
+    enum class State : uint8_t {Free, Queued, Active};
+
+    struct transaction_t {
+        State state;
+        bool is_register_read;
+        Priority priority;
+        uint8_t device;
+        uint8_t tx[I2C_BUS_TX_SIZE_MAX];
+        uint8_t tx_length;
+        uint8_t* rx;
+        uint8_t rx_length;
+        uint32_t sequence; // submit order within a priority
+        uint32_t time_submit_us;
+        Callback<void(int)> done;
+    };
+
+    // used by the blocking functions to wait for the callback
+    struct blocking_t {
+        Semaphore semaphore{0};
+        int result{0};
+        void done(int res)
+        {
+            result = res;
+            semaphore.release();
+        }
+    };
+
+    I2C m_i2c;
+    Thread m_Thread;
+    ThreadFlag m_ThreadFlag;
+    Timer m_Timer;
+
+    device_t m_devices[I2C_BUS_NUM_OF_DEVICES_MAX];
+    int m_num_of_devices{0};
+    transaction_t m_queue[I2C_BUS_QUEUE_SIZE];
+    uint32_t m_sequence{0};
+    uint8_t m_burst[I2C_BUS_BURST_SIZE_MAX];
+
+#if I2C_BUS_USE_ASYNC_TRANSFER
+    ThreadFlag m_TransferFlag;
+    volatile int m_transfer_event{0};
+    void onTransferDone(int event);
+#endif
+
+    int findDevice(uint8_t address);
+    bool submit(uint8_t address,
+                bool is_register_read,
+                const uint8_t* tx,
+                uint8_t tx_length,
+                uint8_t* rx,
+                uint8_t rx_length,
+                Callback<void(int)> done,
+                Priority priority);
+    transaction_t* popNext();
+    int mergeReads(transaction_t* first, transaction_t** merged);
+    int execute(uint8_t address, const uint8_t* tx, uint8_t tx_length, uint8_t* rx, uint8_t rx_length);
+    void complete(transaction_t* transaction, int result);
+    void threadTask();
+    void sendThreadFlag();
+};
+#endif /* I2C_BUS_H_ */
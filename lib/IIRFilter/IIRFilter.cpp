@@ -238,6 +238,18 @@ float IIRFilter::applyConstrained(const float input, const float yMin, const flo
     return output;
 }
 
+void IIRFilter::getBiquad(float* B, float* A, float* w) const
+{
+    const bool is_second_order = (filter.order == 2);
+    B[0] = filter.B[0];
+    B[1] = filter.B[1];
+    B[2] = is_second_order ? filter.B[2] : 0.0f;
+    A[0] = filter.A[0];
+    A[1] = is_second_order ? filter.A[1] : 0.0f;
+    w[0] = filter.w[0];
+    w[1] = is_second_order ? filter.w[1] : 0.0f;
+}
+
 void IIRFilter::applyFilterUpdate(const float input, const float output)
 {
     // https://dsp.stackexchange.com/questions/72575/transposed-direct-form-ii
@@ -43,6 +43,10 @@ public:
     float apply(const float input);
     float applyConstrained(const float input, const float yMin, const float yMax);
 
+    // coefficients and state as second order filter in transposed direct form II, the unused terms of a first
+    // order filter are 0, used to copy the filter into a BiquadBank
+    void getBiquad(float* B, float* A, float* w) const;
+
 private:
     struct IIRFilterParams{
         unsigned order;
@@ -0,0 +1,61 @@
+#include "IIRFilterQ31.h"
+
+IIRFilterQ31::IIRFilterQ31()
+{
+    // pass through
+    setCoefficients(1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+void IIRFilterQ31::setFilter(const IIRFilter& filter)
+{
+    float B[3], A[2], w[2];
+    filter.getBiquad(B, A, w);
+    setCoefficients(B[0], B[1], B[2], A[0], A[1]);
+}
+
+void IIRFilterQ31::setCoefficients(float b0, float b1, float b2, float a1, float a2)
+{
+    const float coefficients[5] = {b0, b1, b2, a1, a2};
+    float coefficient_abs_max = 0.0f;
+    for (int i = 0; i < 5; i++)
+        coefficient_abs_max = fmaxf(coefficient_abs_max, fabsf(coefficients[i]));
+    m_shift = fixedCoefficientShift(coefficient_abs_max);
+
+    for (int i = 0; i < 3; i++)
+        m_B[i] = fixedCoefficient(coefficients[i], m_shift);
+    for (int i = 0; i < 2; i++)
+        m_A[i] = fixedCoefficient(coefficients[3 + i], m_shift);
+    reset();
+}
+
+void IIRFilterQ31::reset(q31_t output)
+{
+    m_x[0] = m_x[1] = output;
+    m_y[0] = m_y[1] = output;
+}
+
+q31_t IIRFilterQ31::apply(q31_t input)
+{
+    // y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2, the products are Q(62 - shift)
+    int64_t acc = static_cast<int64_t>(m_B[0]) * input;
+    acc += static_cast<int64_t>(m_B[1]) * m_x[0];
+    acc += static_cast<int64_t>(m_B[2]) * m_x[1];
+    acc -= static_cast<int64_t>(m_A[0]) * m_y[0];
+    acc -= static_cast<int64_t>(m_A[1]) * m_y[1];
+    const q31_t output = fixedSaturateQ31(fixedShiftRound(acc, 31 - m_shift));
+
+    m_x[1] = m_x[0];
+    m_x[0] = input;
+    m_y[1] = m_y[0];
+    m_y[0] = output;
+
+    return output;
+}
+
+void IIRFilterQ31::getCoefficients(float* B, float* A) const
+{
+    for (int i = 0; i < 3; i++)
+        B[i] = fixedCoefficientToFloat(m_B[i], m_shift);
+    for (int i = 0; i < 2; i++)
+        A[i] = fixedCoefficientToFloat(m_A[i], m_shift);
+}
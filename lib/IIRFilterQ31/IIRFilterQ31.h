@@ -0,0 +1,59 @@
+/**
+ * @file IIRFilterQ31.h
+ * @brief Fixed-point variant of IIRFilter for Q31 signals.
+ *
+ * Second order filter in direct form I with Q31 states and a 64 bit accumulator, a first order filter
+ * has b2 = a2 = 0. The filter is designed with IIRFilter and quantised with setFilter(), the
+ * coefficients share one shift (see FixedPoint.h), e.g. shift 2 for a second order lowpass with
+ * a1 close to -2. Input and output have the same full scale, the output saturates at full scale.
+ * apply() only uses integer arithmetic, so it is bit-exact on the host and can run in an ISR without
+ * the FPU.
+ *
+ * Example:
+ * ```
+ * IIRFilter lowpass;
+ * lowpass.lowPass2Init(15.0f, 1.0f, TS);
+ *
+ * IIRFilterQ31 lowpass_q31;
+ * lowpass_q31.setFilter(lowpass);
+ *
+ * // velocity with full scale 100 rps
+ * const q31_t velocity_filtered = lowpass_q31.apply(fixedFloatToQ31(velocity / 100.0f));
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef IIR_FILTER_Q31_H_
+#define IIR_FILTER_Q31_H_
+
+#include "FixedPoint.h"
+#include "IIRFilter.h"
+
+class IIRFilterQ31
+{
+public:
+    explicit IIRFilterQ31();
+    virtual ~IIRFilterQ31() = default;
+
+    // quantises the coefficients of filter, the state is reset to 0
+    void setFilter(const IIRFilter& filter);
+    // y = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2) x, the state is reset to 0
+    void setCoefficients(float b0, float b1, float b2, float a1, float a2);
+
+    // the output is output for a constant input of output (unity DC gain)
+    void reset(q31_t output = 0);
+    q31_t apply(q31_t input);
+
+    uint8_t getShift() const { return m_shift; }
+    // quantised coefficients as float, B = [b0, b1, b2], A = [a1, a2]
+    void getCoefficients(float* B, float* A) const;
+
+private:
+    q31_t m_B[3];
+    q31_t m_A[2];
+    uint8_t m_shift{0};
+    q31_t m_x[2]; // [x1, x2]
+    q31_t m_y[2]; // [y1, y2]
+};
+#endif /* IIR_FILTER_Q31_H_ */
@@ -1,111 +1,196 @@
 #include "IMU.h"
 
-IMU::IMU(PinName pin_sda, PinName pin_scl) : m_ImuLSM9DS1(pin_sda, pin_scl),
-                                             m_Mahony(Parameters::kp, Parameters::ki, TS),
-                                             m_Thread(osPriorityHigh)
+IMU::IMU(PinName pin_sda, PinName pin_scl, PinName pin_fifo_int) : IMU(nullptr, nullptr, pin_sda, pin_scl, pin_fifo_int)
+{
+}
+
+IMU::IMU(ControlScheduler& scheduler, PinName pin_sda, PinName pin_scl) : IMU(&scheduler, nullptr, pin_sda, pin_scl, NC)
+{
+}
+
+IMU::IMU(I2CBus& bus, PinName pin_fifo_int) : IMU(nullptr, &bus, NC, NC, pin_fifo_int)
+{
+}
+
+IMU::IMU(ControlScheduler& scheduler, I2CBus& bus) : IMU(&scheduler, &bus, NC, NC, NC)
+{
+}
+
+IMU::IMU(ControlScheduler* scheduler,
+         I2CBus* bus,
+         PinName pin_sda,
+         PinName pin_scl,
+         PinName pin_fifo_int) : m_ImuLSM9DS1(bus, pin_sda, pin_scl, 0xD6, 0x3C),
+                                 m_Mahony(Parameters::kp, Parameters::ki, TS_SAMPLE),
+                                 m_Thread(osPriorityHigh),
+                                 m_scheduler(scheduler),
+                                 m_task_id(-1)
 {
 #if (IMU_THREAD_DO_USE_MAG_FOR_MAHONY_UPDATE && IMU_DO_USE_STATIC_MAG_CALIBRATION)
     m_magCalib.setCalibrationParameter(Parameters::A_mag, Parameters::b_mag);
 #endif
-    
+    m_gyro_offset.setZero();
+    m_acc_offset.setZero();
+    m_Timer.start();
+
+#if IMU_DO_USE_FIFO
+    // the burst reads of the FIFO would block the other tasks of a ControlScheduler, so with a scheduler gyro and
+    // acc are polled once per period like without IMU_DO_USE_FIFO
+    m_is_fifo = !m_scheduler;
+    const bool is_fifo_interrupt = m_is_fifo && (pin_fifo_int != NC);
+    if (m_is_fifo) {
+        // the FIFO holds 32 samples, about 67 ms at 476 Hz, so it does not overflow within one period
+        m_ImuLSM9DS1.enableFIFOStream(FIFO_THRESHOLD, is_fifo_interrupt);
+    } else {
+        m_Mahony.setSamplingTime(TS);
+        m_num_of_avg = N_AVG_POLLING;
+    }
+#endif
+
+    if (m_scheduler) {
+        // let the scheduler execute step(), the own thread and thread flag are not used
+        m_ThreadFlag.release();
+        m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &IMU::step), PERIOD_MUS);
+        return;
+    }
+
     // start thread
     m_Thread.start(callback(this, &IMU::threadTask));
 
     // attach sendThreadFlag() to ticker so that sendThreadFlag() is called periodically, which signals the thread to execute
     m_Ticker.attach(callback(this, &IMU::sendThreadFlag), std::chrono::microseconds{PERIOD_MUS});
+
+#if IMU_DO_USE_FIFO
+    // additionally the thread is woken up when the FIFO reached the threshold, the ticker stays as a fallback
+    // in case an edge is missed
+    if (is_fifo_interrupt) {
+        m_FifoInterrupt = new InterruptIn(pin_fifo_int);
+        m_FifoInterrupt->rise(callback(this, &IMU::sendThreadFlag));
+    }
+#endif
 }
 
 IMU::~IMU()
 {
+    if (m_scheduler) {
+        m_scheduler->unregisterTask(m_task_id);
+        return;
+    }
     m_Ticker.detach();
+#if IMU_DO_USE_FIFO
+    delete m_FifoInterrupt;
+#endif
     m_Thread.terminate();
 }
 
 ImuData IMU::getImuData() const
 {
-    return m_ImuData;
+    return m_ImuDataPublished.read();
 }
 
 void IMU::threadTask()
 {
-    static const uint16_t Navg = static_cast<uint16_t>(1.0f / TS);
-    static uint16_t avg_cntr = 0;
-    static bool imu_is_calibrated = false;
-    static Eigen::Vector3f gyro_offset;
-    static Eigen::Vector3f acc_offset;
-    gyro_offset.setZero();
-    acc_offset.setZero();
-    static Timer timer;
-    timer.start();
-
     while (true) {
         ThisThread::flags_wait_any(m_ThreadFlag);
+        step();
+    }
+}
+
+void IMU::step()
+{
+#if IMU_THREAD_DO_USE_MAG_FOR_MAHONY_UPDATE
+    // the mag is slower than gyro and acc (80 Hz), so it is read once per step
+    m_ImuLSM9DS1.updateMag();
+    Eigen::Vector3f mag(m_ImuLSM9DS1.readMagX(), m_ImuLSM9DS1.readMagY(), m_ImuLSM9DS1.readMagZ());
+    mag = m_magCalib.applyCalibration(mag);
+#else
+    static Eigen::Vector3f mag = Eigen::Vector3f::Zero();
+#endif
 
+    bool is_updated = false;
+    Eigen::Vector3f gyro, acc;
+#if IMU_DO_USE_FIFO
+    if (m_is_fifo) {
+        // every sample that was stored since the last step
+        const uint8_t num_of_samples = m_ImuLSM9DS1.readFIFO(m_fifo_gyro, m_fifo_acc, FIFO_SIZE);
+        if (num_of_samples == 0)
+            return;
+        for (int i = 0; i < num_of_samples; i++) {
+            gyro = Eigen::Vector3f(m_fifo_gyro[3 * i], m_fifo_gyro[3 * i + 1], m_fifo_gyro[3 * i + 2]);
+            acc = Eigen::Vector3f(m_fifo_acc[3 * i], m_fifo_acc[3 * i + 1], m_fifo_acc[3 * i + 2]);
+            is_updated = processSample(gyro, acc, mag);
+        }
+    } else
+#endif
+    {
         m_ImuLSM9DS1.updateGyro();
         m_ImuLSM9DS1.updateAcc();
-        Eigen::Vector3f gyro(m_ImuLSM9DS1.readGyroX(), m_ImuLSM9DS1.readGyroY(), m_ImuLSM9DS1.readGyroZ());
-        Eigen::Vector3f acc(m_ImuLSM9DS1.readAccX(), m_ImuLSM9DS1.readAccY(), m_ImuLSM9DS1.readAccZ());
+        gyro = Eigen::Vector3f(m_ImuLSM9DS1.readGyroX(), m_ImuLSM9DS1.readGyroY(), m_ImuLSM9DS1.readGyroZ());
+        acc = Eigen::Vector3f(m_ImuLSM9DS1.readAccX(), m_ImuLSM9DS1.readAccY(), m_ImuLSM9DS1.readAccZ());
+        is_updated = processSample(gyro, acc, mag);
+    }
 
-#if IMU_THREAD_DO_USE_MAG_FOR_MAHONY_UPDATE
-        m_ImuLSM9DS1.updateMag();
-        Eigen::Vector3f mag(m_ImuLSM9DS1.readMagX(), m_ImuLSM9DS1.readMagY(), m_ImuLSM9DS1.readMagZ());
-#else
-        static Eigen::Vector3f mag = Eigen::Vector3f::Zero();
+    if (is_updated) {
+        // update data object with the newest sample
+        m_ImuData.gyro = gyro - m_gyro_offset;
+        m_ImuData.acc = acc - m_acc_offset;
+        m_ImuData.mag = mag;
+        m_ImuData.quat = m_Mahony.getOrientationAsQuaternion();
+        m_ImuData.rpy = m_Mahony.getOrientationAsRPYAngles();
+        m_ImuData.pry = m_Mahony.getOrientationAsPRYAngles();
+        m_ImuData.tilt = m_Mahony.getTiltAngle();
+        m_ImuDataPublished.publish(m_ImuData);
+    }
+
+#if IMU_DO_PRINTF
+    static float time_ms_past = 0.0f;
+    float time_ms = std::chrono::duration_cast<std::chrono::microseconds>(m_Timer.elapsed_time()).count() * 1.0e-3f;
+    const float dtime_ms = time_ms - time_ms_past;
+    time_ms_past = time_ms;
+    printf("%.6f, %.6f, %.6f, %.6f, %.6f, %.6f, %.6f, %.6f, %.6f, %.6f, ", m_ImuData.gyro(0), m_ImuData.gyro(1), m_ImuData.gyro(2),
+           m_ImuData.acc(0), m_ImuData.acc(1), m_ImuData.acc(2),
+           m_ImuData.mag(0), m_ImuData.mag(1), m_ImuData.mag(2), time_ms);
+    printf("%.6f, %.6f, %.6f, %.6f, ", m_ImuData.quat.w(), m_ImuData.quat.x(), m_ImuData.quat.y(), m_ImuData.quat.z());
+    printf("%.6f, %.6f, %.6f, ", m_ImuData.rpy(0), m_ImuData.rpy(1), m_ImuData.rpy(2));
+    printf("%.6f, %.6f, %.6f, ", m_ImuData.pry(0), m_ImuData.pry(1), m_ImuData.pry(2));
+    printf("%.6f\n", m_ImuData.tilt);
 #endif
+}
 
-        if (!imu_is_calibrated) {
-            gyro_offset += gyro;
-            acc_offset += acc;
-            avg_cntr++;
-            if (avg_cntr == Navg) {
-                imu_is_calibrated = true;
-                gyro_offset /= avg_cntr;
-                acc_offset /= avg_cntr;
-                // we have to keep gravity in acc z direction
-                acc_offset(2) = 0.0f;
+// offset calibration during the first second, afterwards the sample is passed to the Mahony filter,
+// returns true if the filter was updated
+bool IMU::processSample(Eigen::Vector3f gyro, Eigen::Vector3f acc, const Eigen::Vector3f& mag)
+{
+    if (!m_imu_is_calibrated) {
+        m_gyro_offset += gyro;
+        m_acc_offset += acc;
+        m_avg_cntr++;
+        if (m_avg_cntr == m_num_of_avg) {
+            m_imu_is_calibrated = true;
+            m_gyro_offset /= m_avg_cntr;
+            m_acc_offset /= m_avg_cntr;
+            // we have to keep gravity in acc z direction
+            m_acc_offset(2) = 0.0f;
 #if IMU_DO_USE_STATIC_ACC_CALIBRATION
-                acc_offset = Parameters::b_acc;
+            m_acc_offset = Parameters::b_acc;
 #else
-                printf("Averaged acc offset: %.7ff, %.7ff, %.7f\n", acc_offset(0), acc_offset(1), acc_offset(2));
+            printf("Averaged acc offset: %.7ff, %.7ff, %.7f\n", m_acc_offset(0), m_acc_offset(1), m_acc_offset(2));
 #endif
-            }
         }
+    }
 
-        if (imu_is_calibrated) {
-            gyro -= gyro_offset;
-            acc -= acc_offset;
+    if (m_imu_is_calibrated) {
+        gyro -= m_gyro_offset;
+        acc -= m_acc_offset;
 
 #if IMU_THREAD_DO_USE_MAG_FOR_MAHONY_UPDATE
-            mag = m_magCalib.applyCalibration(mag);
-            m_Mahony.update(gyro, acc, mag);
+        m_Mahony.update(gyro, acc, mag);
 #else
-            m_Mahony.update(gyro, acc);
-#endif
-
-            // update data object
-            m_ImuData.gyro = gyro;
-            m_ImuData.acc = acc;
-            m_ImuData.mag = mag;
-            m_ImuData.quat = m_Mahony.getOrientationAsQuaternion();
-            m_ImuData.rpy = m_Mahony.getOrientationAsRPYAngles();
-            m_ImuData.pry = m_Mahony.getOrientationAsPRYAngles();
-            m_ImuData.tilt = m_Mahony.getTiltAngle();
-        }
-
-#if IMU_DO_PRINTF
-        static float time_ms_past = 0.0f;
-        float time_ms = std::chrono::duration_cast<std::chrono::microseconds>(timer.elapsed_time()).count() * 1.0e-3f;
-        const float dtime_ms = time_ms - time_ms_past;
-        time_ms_past = time_ms;
-        printf("%.6f, %.6f, %.6f, %.6f, %.6f, %.6f, %.6f, %.6f, %.6f, %.6f, ", m_ImuData.gyro(0), m_ImuData.gyro(1), m_ImuData.gyro(2),
-               m_ImuData.acc(0), m_ImuData.acc(1), m_ImuData.acc(2),
-               m_ImuData.mag(0), m_ImuData.mag(1), m_ImuData.mag(2), time_ms);
-        printf("%.6f, %.6f, %.6f, %.6f, ", m_ImuData.quat.w(), m_ImuData.quat.x(), m_ImuData.quat.y(), m_ImuData.quat.z());
-        printf("%.6f, %.6f, %.6f, ", m_ImuData.rpy(0), m_ImuData.rpy(1), m_ImuData.rpy(2));
-        printf("%.6f, %.6f, %.6f, ", m_ImuData.pry(0), m_ImuData.pry(1), m_ImuData.pry(2));
-        printf("%.6f\n", m_ImuData.tilt);
+        m_Mahony.update(gyro, acc);
 #endif
+        return true;
     }
+    return false;
 }
 
 void IMU::sendThreadFlag()
@@ -14,11 +14,18 @@
 #include "LinearCharacteristics3.h"
 #include "Mahony.h"
 #include "ThreadFlag.h"
+#include "ControlScheduler.h"
+#include "Published.h"
 
 #define IMU_DO_PRINTF false
 #define IMU_DO_USE_STATIC_ACC_CALIBRATION true  // if this is false then acc gets averaged at the beginning and printed to the console
 #define IMU_DO_USE_STATIC_MAG_CALIBRATION false // if this is false then no mag calibration gets applied, e.g. A_mag = I, b_mag = 0
 #define IMU_THREAD_DO_USE_MAG_FOR_MAHONY_UPDATE false
+// if this is true then the LSM9DS1 streams gyro and acc into its FIFO and every stored sample is processed by the
+// Mahony filter at the sensor ODR, otherwise gyro and acc are polled once per period. every sample is one burst
+// read of 22 bytes, about 5 ms per period at 400 kHz, which would block the other tasks of a ControlScheduler, so
+// an IMU that is executed by a scheduler polls gyro and acc once per period anyway
+#define IMU_DO_USE_FIFO false
 
 namespace Parameters
 {
@@ -77,7 +84,14 @@ public:
 class IMU
 {
 public:
-    explicit IMU(PinName pin_sda, PinName pin_scl);
+    // with IMU_DO_USE_FIFO and pin_fifo_int connected to INT1_A/G the thread also wakes up on the FIFO threshold
+    explicit IMU(PinName pin_sda, PinName pin_scl, PinName pin_fifo_int = NC);
+    // executed by a shared ControlScheduler instead of an own thread, with IMU_DO_USE_FIFO the FIFO is not used and
+    // gyro and acc are polled once per period
+    explicit IMU(ControlScheduler& scheduler, PinName pin_sda, PinName pin_scl);
+    // the LSM9DS1 is on a shared I2CBus
+    explicit IMU(I2CBus& bus, PinName pin_fifo_int = NC);
+    explicit IMU(ControlScheduler& scheduler, I2CBus& bus);
     virtual ~IMU();
 
     ImuData getImuData() const;
@@ -85,8 +99,20 @@ public:
 private:
     static constexpr int64_t PERIOD_MUS = 20000;
     static constexpr float TS = 1.0e-6f * static_cast<float>(PERIOD_MUS);
+#if IMU_DO_USE_FIFO
+    // gyro and acc ODR of the LSM9DS1 (sampleRate = 5), every sample is processed with this sampling time
+    static constexpr float FIFO_ODR_HZ = 476.0f;
+    static constexpr float TS_SAMPLE = 1.0f / FIFO_ODR_HZ;
+    static constexpr uint8_t FIFO_SIZE = 32;
+    static constexpr uint8_t FIFO_THRESHOLD = 8; // interrupt every 8 samples, about 60 Hz
+    static constexpr uint16_t N_AVG_POLLING = static_cast<uint16_t>(1.0f / TS); // N_AVG if the FIFO is not used
+#else
+    static constexpr float TS_SAMPLE = TS;
+#endif
+    static constexpr uint16_t N_AVG = static_cast<uint16_t>(1.0f / TS_SAMPLE); // samples within 1 sec for the offset calibration
 
-    ImuData m_ImuData;
+    ImuData m_ImuData;                    // written by step() only
+    Published<ImuData> m_ImuDataPublished; // copy of m_ImuData for getImuData(), published at the end of step()
     LSM9DS1 m_ImuLSM9DS1;
     LinearCharacteristics3 m_magCalib;
     Mahony m_Mahony;
@@ -94,7 +120,28 @@ private:
     Thread m_Thread;
     Ticker m_Ticker;
     ThreadFlag m_ThreadFlag;
+    ControlScheduler* m_scheduler;
+    int m_task_id;
+
+    // gyro and acc offset calibration
+    uint16_t m_avg_cntr{0};
+    uint16_t m_num_of_avg{N_AVG};
+    bool m_imu_is_calibrated{false};
+    Eigen::Vector3f m_gyro_offset;
+    Eigen::Vector3f m_acc_offset;
+    Timer m_Timer;
+
+#if IMU_DO_USE_FIFO
+    bool m_is_fifo{false}; // false with a ControlScheduler, gyro and acc are then polled once per period
+    InterruptIn* m_FifoInterrupt{nullptr};
+    float m_fifo_gyro[3 * FIFO_SIZE];
+    float m_fifo_acc[3 * FIFO_SIZE];
+#endif
+
+    explicit IMU(ControlScheduler* scheduler, I2CBus* bus, PinName pin_sda, PinName pin_scl, PinName pin_fifo_int);
 
+    void step();
+    bool processSample(Eigen::Vector3f gyro, Eigen::Vector3f acc, const Eigen::Vector3f& mag);
     void threadTask();
     void sendThreadFlag();
 };
@@ -1,22 +1,51 @@
 #include "IRSensor.h"
 
-IRSensor::IRSensor(PinName pin) : m_AnalogIn(pin),
-                                  m_AvgFilter(N),
-                                  m_Thread(osPriorityNormal)
+IRSensor::IRSensor(PinName pin) : IRSensor(nullptr, pin)
 {
-    // start thread
-    m_Thread.start(callback(this, &IRSensor::threadTask));
+}
 
-    // attach sendThreadFlag() to ticker so that sendThreadFlag() is called periodically, which signals the thread to execute
-    m_Ticker.attach(callback(this, &IRSensor::sendThreadFlag), std::chrono::microseconds{PERIOD_MUS});
+IRSensor::IRSensor(PinName pin, float a, float b) : IRSensor(nullptr, pin)
+{
+    // calibrate the sensor
+    setCalibration(a, b);
+}
+
+IRSensor::IRSensor(ControlScheduler& scheduler, PinName pin) : IRSensor(&scheduler, pin)
+{
 }
 
-IRSensor::IRSensor(PinName pin, float a, float b) : m_AnalogIn(pin),
-                                                    m_AvgFilter(N),
-                                                    m_Thread(osPriorityNormal)
+IRSensor::IRSensor(ControlScheduler& scheduler, PinName pin, float a, float b) : IRSensor(&scheduler, pin)
 {
     // calibrate the sensor
     setCalibration(a, b);
+}
+
+IRSensor::IRSensor(AdcScan& scan, PinName pin) : m_AvgFilter(N),
+                                                 m_Thread(osPriorityNormal),
+                                                 m_scheduler(nullptr)
+{
+    // the scan samples and averages the pin, nothing has to be executed periodically
+    m_scan = &scan;
+    m_scan_channel = m_scan->addChannel(pin);
+}
+
+IRSensor::IRSensor(AdcScan& scan, PinName pin, float a, float b) : IRSensor(scan, pin)
+{
+    // calibrate the sensor
+    setCalibration(a, b);
+}
+
+IRSensor::IRSensor(ControlScheduler* scheduler, PinName pin) : m_AnalogIn(new AnalogIn(pin)),
+                                                               m_AvgFilter(N),
+                                                               m_Thread(osPriorityNormal),
+                                                               m_scheduler(scheduler)
+{
+    if (m_scheduler) {
+        // let the scheduler execute step(), the own thread and thread flag are not used
+        m_ThreadFlag.release();
+        m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &IRSensor::step), PERIOD_MUS);
+        return;
+    }
 
     // start thread
     m_Thread.start(callback(this, &IRSensor::threadTask));
@@ -27,27 +56,27 @@ IRSensor::IRSensor(PinName pin, float a, float b) : m_AnalogIn(pin),
 
 IRSensor::~IRSensor()
 {
-    m_Ticker.detach();
-    m_Thread.terminate();
+    // stop the task that reads m_AnalogIn before it is deleted
+    if (m_scheduler) {
+        m_scheduler->unregisterTask(m_task_id);
+    } else if (!m_scan) {
+        m_Ticker.detach();
+        m_Thread.terminate();
+    }
+    delete m_AnalogIn;
 }
 
 float IRSensor::reset()
 {
+    // the scan keeps its own average
+    if (m_scan)
+        return read();
+
     // readout in millivolts
-    m_distance_mV = m_AnalogIn.read() * 3300.0f;
+    m_distance_mV = m_AnalogIn->read() * 3300.0f;
 
     // apply calibration to cm (if calibrated)
-    float distance_cm = 0.0f;
-    if (m_is_calibrated) {
-        distance_cm = applyCalibration(m_distance_mV, m_a, m_b);
-        // constrain distance to [IR_SENSOR_DISTANCE_MIN, IR_SENSOR_DISTANCE_MAX]
-        distance_cm = (distance_cm > IR_SENSOR_DISTANCE_MAX) ? IR_SENSOR_DISTANCE_MAX :
-                      (distance_cm < IR_SENSOR_DISTANCE_MIN) ? IR_SENSOR_DISTANCE_MIN :
-                       distance_cm;
-    } else {
-        distance_cm = m_distance_mV;
-    }
-    m_distance_cm = distance_cm;
+    m_distance_cm = calibrateAndConstrain(m_distance_mV);
 
     // reset the filter to the current readout
     m_distance_avg = m_AvgFilter.reset(m_distance_cm);
@@ -55,6 +84,28 @@ float IRSensor::reset()
     return m_distance_avg;
 }
 
+float IRSensor::read() const
+{
+    // the average of the scan is in millivolts, so the calibration is applied to the average
+    if (m_scan)
+        return calibrateAndConstrain(m_scan->readmV(m_scan_channel));
+    return m_distance_avg;
+}
+
+float IRSensor::readmV() const
+{
+    if (m_scan)
+        return m_scan->readmV(m_scan_channel);
+    return m_distance_mV;
+}
+
+float IRSensor::readcm() const
+{
+    if (m_scan)
+        return calibrateAndConstrain(m_scan->readmV(m_scan_channel));
+    return m_distance_cm;
+}
+
 void IRSensor::setCalibration(float a, float b)
 {
     m_a = a;
@@ -66,34 +117,40 @@ void IRSensor::threadTask()
 {
     while (true) {
         ThisThread::flags_wait_any(m_ThreadFlag);
-
-        // readout in millivolts
-        m_distance_mV = m_AnalogIn.read() * 3300.0f;
-
-        // apply calibration to cm (if calibrated)
-        float distance_cm = 0.0f;
-        if (m_is_calibrated) {
-            distance_cm = applyCalibration(m_distance_mV, m_a, m_b);
-            // constrain distance to [IR_SENSOR_DISTANCE_MIN, IR_SENSOR_DISTANCE_MAX]
-            distance_cm = (distance_cm > IR_SENSOR_DISTANCE_MAX) ? IR_SENSOR_DISTANCE_MAX :
-                          (distance_cm < IR_SENSOR_DISTANCE_MIN) ? IR_SENSOR_DISTANCE_MIN :
-                           distance_cm;
-        } else {
-            distance_cm = m_distance_mV;
-        }
-        m_distance_cm = distance_cm;
-
-        // average filtered distance
-        static bool is_first_run = true;
-        if (is_first_run) {
-            is_first_run = false;
-            m_distance_avg = m_AvgFilter.reset(m_distance_cm);
-        } else
-            m_distance_avg = m_AvgFilter.apply(m_distance_cm);
+        step();
     }
 }
 
-float IRSensor::applyCalibration(float ir_distance_mV, float a, float b)
+void IRSensor::step()
+{
+    // readout in millivolts
+    m_distance_mV = m_AnalogIn->read() * 3300.0f;
+
+    // apply calibration to cm (if calibrated)
+    m_distance_cm = calibrateAndConstrain(m_distance_mV);
+
+    // average filtered distance
+    static bool is_first_run = true;
+    if (is_first_run) {
+        is_first_run = false;
+        m_distance_avg = m_AvgFilter.reset(m_distance_cm);
+    } else
+        m_distance_avg = m_AvgFilter.apply(m_distance_cm);
+}
+
+float IRSensor::calibrateAndConstrain(float ir_distance_mV) const
+{
+    if (!m_is_calibrated)
+        return ir_distance_mV;
+
+    const float distance_cm = applyCalibration(ir_distance_mV, m_a, m_b);
+    // constrain distance to [IR_SENSOR_DISTANCE_MIN, IR_SENSOR_DISTANCE_MAX]
+    return (distance_cm > IR_SENSOR_DISTANCE_MAX) ? IR_SENSOR_DISTANCE_MAX :
+           (distance_cm < IR_SENSOR_DISTANCE_MIN) ? IR_SENSOR_DISTANCE_MIN :
+            distance_cm;
+}
+
+float IRSensor::applyCalibration(float ir_distance_mV, float a, float b) const
 {
     // // insert values that you got from the MATLAB or Python file
     // static const float a = 2.574e+04f;
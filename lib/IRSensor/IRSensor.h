@@ -10,7 +10,9 @@
 #include "mbed.h"
 
 #include "ThreadFlag.h"
+#include "ControlScheduler.h"
 #include "AvgFilter.h"
+#include "AdcScan.h"
 
 #define IR_SENSOR_DISTANCE_MIN 0.0f
 #define IR_SENSOR_DISTANCE_MAX 200.0f
@@ -20,27 +22,37 @@ class IRSensor
 public:
     explicit IRSensor(PinName pin);
     explicit IRSensor(PinName pin, float a, float b);
+    // executed by a shared ControlScheduler instead of an own thread
+    explicit IRSensor(ControlScheduler& scheduler, PinName pin);
+    explicit IRSensor(ControlScheduler& scheduler, PinName pin, float a, float b);
+    // sampled and averaged by a shared AdcScan, no own thread, the calibration is applied when reading
+    explicit IRSensor(AdcScan& scan, PinName pin);
+    explicit IRSensor(AdcScan& scan, PinName pin, float a, float b);
     virtual ~IRSensor();
 
     // resets the filter to the current readout
     float reset();
 
     // returns the current average
-    float read() const { return m_distance_avg; }
-    float readmV() const { return m_distance_mV; }
-    float readcm() const { return m_distance_cm; } // equal to m_distance_mV if not calibrated
+    float read() const;
+    float readmV() const;
+    float readcm() const; // equal to readmV() if not calibrated
     void setCalibration(float a, float b);
 
 private:
     static constexpr int64_t PERIOD_MUS = 2000;
     static constexpr uint8_t N = 31;
 
-    AnalogIn m_AnalogIn;
+    AnalogIn* m_AnalogIn{nullptr}; // own readout, nullptr if the AdcScan is used
+    AdcScan* m_scan{nullptr};
+    int m_scan_channel{-1};
     AvgFilter m_AvgFilter;
 
     Thread m_Thread;
     Ticker m_Ticker;
     ThreadFlag m_ThreadFlag;
+    ControlScheduler* m_scheduler{nullptr};
+    int m_task_id{-1};
 
     bool m_is_calibrated{false};
     float m_distance_mV{0.0f};
@@ -49,8 +61,12 @@ private:
     float m_a{0.0f};
     float m_b{0.0f};
 
-    float applyCalibration(float ir_distance_mV, float a, float b);
+    explicit IRSensor(ControlScheduler* scheduler, PinName pin);
 
+    float applyCalibration(float ir_distance_mV, float a, float b) const;
+    float calibrateAndConstrain(float ir_distance_mV) const;
+
+    void step();
     void threadTask();
     void sendThreadFlag();
 };
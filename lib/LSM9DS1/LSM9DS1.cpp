@@ -1,24 +1,49 @@
 #include "LSM9DS1.h"
 
+#include "I2CBus.h"
+
 #define LSM9DS1_COMMUNICATION_TIMEOUT 1000
+#define LSM9DS1_I2C_FREQUENCY 400000 // fast mode, the default of mbed is 100 kHz
 
 float magSensitivity[4] = {0.00014, 0.00029, 0.00043, 0.00058};
 //extern Serial pc;
 
 LSM9DS1::LSM9DS1(PinName sda, PinName scl, uint8_t xgAddr, uint8_t mAddr)
-    :i2c(sda, scl)
+    :LSM9DS1(nullptr, sda, scl, xgAddr, mAddr)
 {
-    init(IMU_MODE_I2C, xgAddr, mAddr); // dont know about 0xD6 or 0x3B
-    begin();
 }
 
 LSM9DS1::LSM9DS1(PinName sda, PinName scl)
-    :i2c(sda, scl)
+    :LSM9DS1(nullptr, sda, scl, 0xD6, 0x3C) // dont know about 0xD6 or 0x3B
+{
+}
+
+LSM9DS1::LSM9DS1(I2CBus& bus, uint8_t xgAddr, uint8_t mAddr)
+    :LSM9DS1(&bus, NC, NC, xgAddr, mAddr)
 {
-    init(IMU_MODE_I2C, 0xD6, 0x3C); // dont know about 0xD6 or 0x3B
+}
+
+LSM9DS1::LSM9DS1(I2CBus* bus, PinName sda, PinName scl, uint8_t xgAddr, uint8_t mAddr)
+    :i2c(bus ? nullptr : new I2C(sda, scl))
+    ,bus(bus)
+{
+    if (bus) {
+        // the accel/gyro increments the register address in burst reads (IF_ADD_INC), the mag only
+        // with the msb of the sub address set, so only reads of the accel/gyro are merged
+        bus->addDevice(xgAddr, true);
+        bus->addDevice(mAddr, false);
+    } else {
+        i2c->frequency(LSM9DS1_I2C_FREQUENCY);
+    }
+    init(IMU_MODE_I2C, xgAddr, mAddr);
     begin();
 }
 
+LSM9DS1::~LSM9DS1()
+{
+    delete i2c;
+}
+
 /*
 LSM9DS1::LSM9DS1()
 {
@@ -511,6 +536,11 @@ void LSM9DS1::updateAcc()
 {
     uint8_t temp[6]; // We'll read six bytes from the accelerometer into temp   
     xgReadBytes(OUT_X_L_XL, temp, 6); // Read 6 bytes, beginning at OUT_X_L_XL
+    storeAcc(temp);
+}
+
+void LSM9DS1::storeAcc(const uint8_t * temp)
+{
     ax = (temp[1] << 8) | temp[0]; // Store x-axis values into ax
     ay = (temp[3] << 8) | temp[2]; // Store y-axis values into ay
     az = (temp[5] << 8) | temp[4]; // Store z-axis values into az
@@ -569,6 +599,11 @@ void LSM9DS1::updateGyro()
 {
     uint8_t temp[6]; // We'll read six bytes from the gyro into temp
     xgReadBytes(OUT_X_L_G, temp, 6); // Read 6 bytes, beginning at OUT_X_L_G
+    storeGyro(temp);
+}
+
+void LSM9DS1::storeGyro(const uint8_t * temp)
+{
     gx = (temp[1] << 8) | temp[0]; // Store x-axis values into gx
     gy = (temp[3] << 8) | temp[2]; // Store y-axis values into gy
     gz = (temp[5] << 8) | temp[4]; // Store z-axis values into gz
@@ -964,6 +999,46 @@ uint8_t LSM9DS1::getFIFOSamples()
     return (xgReadByte(FIFO_SRC) & 0x3F);
 }
 
+void LSM9DS1::enableFIFOStream(uint8_t fifoThs, bool enableInterrupt)
+{
+    // start with an empty FIFO, switching to bypass mode resets it
+    setFIFO(FIFO_OFF, 0x00);
+    if (enableInterrupt)
+        configInt(XG_INT1, INT_FTH, INT_ACTIVE_HIGH, INT_PUSH_PULL);
+    enableFIFO(true);
+    setFIFO(FIFO_CONT, fifoThs);
+}
+
+void LSM9DS1::disableFIFOStream()
+{
+    xgWriteByte(INT1_CTRL, 0x00);
+    enableFIFO(false);
+    setFIFO(FIFO_OFF, 0x00);
+}
+
+uint8_t LSM9DS1::readFIFO(float * gyro, float * acc, uint8_t maxSamples)
+{
+    // number of unread samples, one sample is popped with every read of the gyro and accel outputs
+    uint8_t samples = getFIFOSamples();
+    if (samples > maxSamples)
+        samples = maxSamples;
+    for (int i = 0; i < samples; i++) {
+        // gyro and accel of one sample in a single burst from OUT_X_L_G to OUT_Z_H_XL, so both are from the
+        // same FIFO slot and every sample is one transaction on the bus
+        uint8_t temp[OUT_Z_H_XL - OUT_X_L_G + 1];
+        xgReadBytes(OUT_X_L_G, temp, sizeof(temp));
+        storeGyro(&temp[0]);
+        storeAcc(&temp[OUT_X_L_XL - OUT_X_L_G]);
+        gyro[3 * i + 0] = gyroX;
+        gyro[3 * i + 1] = gyroY;
+        gyro[3 * i + 2] = gyroZ;
+        acc[3 * i + 0] = accX;
+        acc[3 * i + 1] = accY;
+        acc[3 * i + 2] = accZ;
+    }
+    return samples;
+}
+
 void LSM9DS1::constrainScales()
 {
     if ((settings.gyro.scale != 245) && (settings.gyro.scale != 500) && 
@@ -1133,8 +1208,12 @@ void LSM9DS1::I2CwriteByte(uint8_t address, uint8_t subAddress, uint8_t data)
     Wire.write(data);                 // Put data in Tx buffer
     Wire.endTransmission();           // Send the Tx buffer
     */
+    if (bus) {
+        bus->writeRegistersBlocking(address, subAddress, &data, 1);
+        return;
+    }
     char temp_data[2] = {subAddress, data};
-    i2c.write(address, temp_data, 2);
+    i2c->write(address, temp_data, 2);
 }
 
 uint8_t LSM9DS1::I2CreadByte(uint8_t address, uint8_t subAddress)
@@ -1156,15 +1235,20 @@ uint8_t LSM9DS1::I2CreadByte(uint8_t address, uint8_t subAddress)
     data = Wire.read();                      // Fill Rx buffer with result
     return data;                             // Return data read from slave register
     */
+    if (bus) {
+        uint8_t data = 0;
+        bus->readRegistersBlocking(address, subAddress, &data, 1);
+        return data;
+    }
     char data;
     char temp[2] = {subAddress};
     
-    i2c.write(address, temp, 1);
+    i2c->write(address, temp, 1);
     //i2c.write(address & 0xFE);
     temp[1] = 0x00;
-    i2c.write(address, temp, 1);
+    i2c->write(address, temp, 1);
     //i2c.write( address | 0x01);
-    i2c.read(address, &data, 1);
+    i2c->read(address, &data, 1);
     return data;
 }
 
@@ -1193,11 +1277,15 @@ uint8_t LSM9DS1::I2CreadBytes(uint8_t address, uint8_t subAddress, uint8_t * des
     }
     return count;
     */
+    if (bus) {
+        bus->readRegistersBlocking(address, subAddress, dest, count);
+        return count;
+    }
     int i;
-    char temp_dest[10]; // char temp_dest[count];
+    char temp_dest[32]; // char temp_dest[count]; the FIFO burst of readFIFO() is 22 bytes
     char temp[1] = {subAddress};
-    i2c.write(address, temp, 1);
-    i2c.read(address, temp_dest, count);
+    i2c->write(address, temp, 1);
+    i2c->read(address, temp_dest, count);
     
     //i2c doesn't take uint8_ts, but rather chars so do this nasty af conversion
     for (i=0; i < count; i++) {
@@ -3,6 +3,8 @@
 
 #include "mbed.h"
 
+class I2CBus;
+
 /////////////////////////////////////////
 // LSM9DS1 Accel/Gyro (XL/G) Registers //
 /////////////////////////////////////////
@@ -239,7 +241,7 @@ enum fifoMode_type
     FIFO_THS = 1,
     FIFO_CONT_TRIGGER = 3,
     FIFO_OFF_TRIGGER = 4,
-    FIFO_CONT = 5
+    FIFO_CONT = 6 // FMODE = 110, 5 is reserved
 };
 
 struct gyroSettings
@@ -364,6 +366,11 @@ public:
     */
     LSM9DS1(PinName sda, PinName scl, uint8_t xgAddr, uint8_t mAddr);
     LSM9DS1(PinName sda, PinName scl);
+    // the sensor is on a shared I2CBus, all register accesses are transactions of the bus
+    LSM9DS1(I2CBus& bus, uint8_t xgAddr = 0xD6, uint8_t mAddr = 0x3C);
+    // uses the bus if it is not nullptr, otherwise an own I2C object on sda and scl
+    LSM9DS1(I2CBus* bus, PinName sda, PinName scl, uint8_t xgAddr, uint8_t mAddr);
+    ~LSM9DS1();
     //LSM9DS1(interface_mode interface, uint8_t xgAddr, uint8_t mAddr);
     //LSM9DS1();
        
@@ -658,6 +665,23 @@ public:
     
     //! getFIFOSamples() - Get number of FIFO samples
     uint8_t getFIFOSamples();
+
+    /** enableFIFOStream() - Stream gyro and accel samples continuously into the FIFO
+    * The FIFO keeps the newest 32 samples at the gyro/accel ODR.
+    * Input:
+    *  - fifoThs: FIFO threshold level, 0-0x1F
+    *  - enableInterrupt: true = the threshold interrupt is routed to INT1_A/G (active high, push-pull)
+    */
+    void enableFIFOStream(uint8_t fifoThs, bool enableInterrupt = false);
+    void disableFIFOStream();
+
+    /** readFIFO() - Read the samples that are stored in the FIFO, oldest first
+    * Input:
+    *  - gyro, acc: arrays for 3 * maxSamples values, gyro in rad/s and acc in m/s^2 like readGyroX(), readAccX()
+    *  - maxSamples: maximum number of samples to read
+    * Output: Number of samples read
+    */
+    uint8_t readFIFO(float * gyro, float * acc, uint8_t maxSamples);
         
 
 protected:  
@@ -851,7 +875,12 @@ protected:
     uint8_t I2CreadBytes(uint8_t address, uint8_t subAddress, uint8_t * dest, uint8_t count);
     
 private:
-    I2C i2c;
+    // storeGyro() and storeAcc() convert the six output registers read by updateGyro(), updateAcc() or readFIFO()
+    void storeGyro(const uint8_t * temp);
+    void storeAcc(const uint8_t * temp);
+
+    I2C* i2c;    // own I2C object, nullptr if the bus is used
+    I2CBus* bus; // shared bus, nullptr if the own I2C object is used
     float gyroX, gyroY, gyroZ; // x, y, and z axis readings of the gyroscope (float value)
     float accX, accY, accZ; // x, y, and z axis readings of the accelerometer (float value)
     float magX, magY, magZ; // x, y, and z axis readings of the magnetometer (float value)
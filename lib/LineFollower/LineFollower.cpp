@@ -2,12 +2,45 @@
 
 // Constructor
 LineFollower::LineFollower(PinName sda_pin,
+                           PinName scl_pin,
+                           float bar_dist,
+                           float d_wheel,
+                           float b_wheel,
+                           float max_motor_vel_rps) : LineFollower(nullptr,
+                                                                   sda_pin,
+                                                                   scl_pin,
+                                                                   bar_dist,
+                                                                   d_wheel,
+                                                                   b_wheel,
+                                                                   max_motor_vel_rps)
+{
+}
+
+LineFollower::LineFollower(ControlScheduler& scheduler,
+                           PinName sda_pin,
+                           PinName scl_pin,
+                           float bar_dist,
+                           float d_wheel,
+                           float b_wheel,
+                           float max_motor_vel_rps) : LineFollower(&scheduler,
+                                                                   sda_pin,
+                                                                   scl_pin,
+                                                                   bar_dist,
+                                                                   d_wheel,
+                                                                   b_wheel,
+                                                                   max_motor_vel_rps)
+{
+}
+
+LineFollower::LineFollower(ControlScheduler* scheduler,
+                           PinName sda_pin,
                            PinName scl_pin,
                            float bar_dist,
                            float d_wheel,
                            float b_wheel,
                            float max_motor_vel_rps) : m_SensorBar(sda_pin, scl_pin, bar_dist, false),
-                                                      m_Thread(osPriorityAboveNormal2)
+                                                      m_Thread(osPriorityAboveNormal2),
+                                                      m_scheduler(scheduler)
 {
     // set default gains of the controllers
     setRotationalVelocityControllerGains();
@@ -24,6 +57,19 @@ LineFollower::LineFollower(PinName sda_pin,
     m_motor_vel_max_rps = max_motor_vel_rps;
     m_wheel_vel_max_rps = m_motor_vel_max_rps;
 
+    if (m_scheduler) {
+        // the scheduler starts the samples and step() is executed with every new sample, the own thread and
+        // thread flags are not used
+        m_ThreadFlag.release();
+        m_SampleFlag.release();
+        m_SensorBar.attachSampleCallback(callback(this, &LineFollower::step));
+        m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &LineFollower::startSample), SensorBar::PERIOD_MUS);
+        return;
+    }
+
+    // the thread waits for every new sample
+    m_SensorBar.attachSampleCallback(callback(this, &LineFollower::sendSampleFlag));
+
     // start thread
     m_Thread.start(callback(this, &LineFollower::followLine));
 
@@ -34,6 +80,11 @@ LineFollower::LineFollower(PinName sda_pin,
 // Deconstructor
 LineFollower::~LineFollower()
 {
+    m_SensorBar.attachSampleCallback(nullptr);
+    if (m_scheduler) {
+        m_scheduler->unregisterTask(m_task_id);
+        return;
+    }
     m_Ticker.detach();
     m_Thread.terminate();
 }
@@ -57,37 +108,42 @@ void LineFollower::setMaxWheelVelocity(float wheel_vel_max)
 
 float LineFollower::getAngleRadians() const
 {
-    return m_angle;
+    return m_data.read().angle;
 }
 
 float LineFollower::getAngleDegrees() const
 {
-    return m_angle * 180.0f / M_PIf;
+    return m_data.read().angle * 180.0f / M_PIf;
 }
 
 float LineFollower::getRotationalVelocity() const
 {
-    return m_robot_coord(1);
+    return m_data.read().rotational_velocity;
 }
 
 float LineFollower::getTranslationalVelocity() const
 {
-    return m_robot_coord(0);
+    return m_data.read().translational_velocity;
 }
 
 float LineFollower::getRightWheelVelocity() const
 {
-    return m_wheel_right_velocity_rps;
+    return m_data.read().wheel_right_velocity_rps;
 }
 
 float LineFollower::getLeftWheelVelocity() const
 {
-    return m_wheel_left_velocity_rps;
+    return m_data.read().wheel_left_velocity_rps;
 }
 
 bool LineFollower::isLedActive() const
 {
-    return is_any_led_active;
+    return m_data.read().is_any_led_active;
+}
+
+LineFollowerData LineFollower::getData() const
+{
+    return m_data.read();
 }
 
 // Thread task
@@ -96,29 +152,50 @@ void LineFollower::followLine()
     while (true) {
         ThisThread::flags_wait_any(m_ThreadFlag);
 
-        // update sensor bar readings
+        // with SENSOR_BAR_USE_ASYNC_I2C update() only starts the sample, so wait until it is published, a
+        // sample that is not done within the period is skipped
+        ThisThread::flags_clear(m_SampleFlag);
         m_SensorBar.update();
+        if (ThisThread::flags_wait_any_for(m_SampleFlag, std::chrono::milliseconds{SensorBar::PERIOD_MUS / 1000}) & m_SampleFlag)
+            step();
+    }
+}
 
-        // only update sensor bar angle if an led is triggered
-        is_any_led_active = m_SensorBar.isAnyLedActive();
-        if (is_any_led_active) {
-            m_angle = m_SensorBar.getAvgAngleRad();
-        }
-
-        // control algorithm for robot velocities
-        m_robot_coord(1) = ang_cntrl_fcn(m_Kp, m_Kp_nl, m_angle);
-        m_robot_coord(0) = vel_cntrl_fcn(m_wheel_vel_max_rps * 2 * M_PIf,
-                                         m_rotation_to_wheel_vel,
-                                         m_robot_coord(1),
-                                         m_Cwheel2robot);
-
-        // map robot velocities to wheel velocities in rad/sec
-        Eigen::Vector2f wheel_speed = m_Cwheel2robot.inverse() * m_robot_coord;
-
-        // setpoints for the dc motors in rps
-        m_wheel_right_velocity_rps = wheel_speed(0) / (2.0f * M_PIf);
-        m_wheel_left_velocity_rps = wheel_speed(1) / (2.0f * M_PIf);
+void LineFollower::startSample()
+{
+    m_SensorBar.update();
+}
+
+void LineFollower::step()
+{
+    // the sensor bar published a new sample, only update sensor bar angle if an led is triggered
+    is_any_led_active = m_SensorBar.isAnyLedActive();
+    if (is_any_led_active) {
+        m_angle = m_SensorBar.getAvgAngleRad();
     }
+
+    // control algorithm for robot velocities
+    m_robot_coord(1) = ang_cntrl_fcn(m_Kp, m_Kp_nl, m_angle);
+    m_robot_coord(0) = vel_cntrl_fcn(m_wheel_vel_max_rps * 2 * M_PIf,
+                                     m_rotation_to_wheel_vel,
+                                     m_robot_coord(1),
+                                     m_Cwheel2robot);
+
+    // map robot velocities to wheel velocities in rad/sec
+    Eigen::Vector2f wheel_speed = m_Cwheel2robot.inverse() * m_robot_coord;
+
+    // setpoints for the dc motors in rps
+    m_wheel_right_velocity_rps = wheel_speed(0) / (2.0f * M_PIf);
+    m_wheel_left_velocity_rps = wheel_speed(1) / (2.0f * M_PIf);
+
+    LineFollowerData data;
+    data.angle = m_angle;
+    data.rotational_velocity = m_robot_coord(1);
+    data.translational_velocity = m_robot_coord(0);
+    data.wheel_right_velocity_rps = m_wheel_right_velocity_rps;
+    data.wheel_left_velocity_rps = m_wheel_left_velocity_rps;
+    data.is_any_led_active = is_any_led_active;
+    m_data.publish(data);
 }
 
 float LineFollower::ang_cntrl_fcn(float Kp, float Kp_nl, float angle)
@@ -149,3 +226,9 @@ void LineFollower::sendThreadFlag()
     // set the thread flag to trigger the thread task
     m_Thread.flags_set(m_ThreadFlag);
 }
+
+void LineFollower::sendSampleFlag()
+{
+    // the sample the thread waits for is published
+    m_Thread.flags_set(m_SampleFlag);
+}
@@ -1,6 +1,12 @@
 /**
  * @file LineFollower.h
  * @brief This file defines the LineFollower class.
+ *
+ * Every step uses the sample of the sensor bar that was started in the same period. With
+ * SENSOR_BAR_USE_ASYNC_I2C the sensor bar only starts the transfer in update(), so the own thread waits
+ * for the published sample, and with a ControlScheduler the step is executed by the sample callback of
+ * the sensor bar on the shared high priority event queue. Without it update() blocks until the sample is
+ * read and the step follows directly.
  * @author M. Peter / pmic / pichim
  */
 
@@ -12,6 +18,7 @@
 #include <math.h>
 
 #include "SensorBar.h"
+#include "Published.h"
 
 #include <Eigen/Dense>
 
@@ -19,6 +26,21 @@
     #define M_PIf 3.14159265358979323846f // pi
 #endif
 
+// snapshot of the outputs of one step
+class LineFollowerData
+{
+public:
+    LineFollowerData() = default;
+    ~LineFollowerData() = default;
+
+    float angle{0.0f};                      // angle of the line in radians
+    float rotational_velocity{0.0f};        // robot velocities
+    float translational_velocity{0.0f};
+    float wheel_right_velocity_rps{0.0f};   // setpoints of the wheels
+    float wheel_left_velocity_rps{0.0f};
+    bool is_any_led_active{false};
+};
+
 class LineFollower
 {
 public:
@@ -39,6 +61,21 @@ public:
                           float b_wheel,
                           float max_motor_vel_rps);
 
+    /**
+     * @brief Construct a new Line Follower object that is executed by a shared ControlScheduler.
+     *
+     * @param scheduler The scheduler that starts the samples, its period has to be a divisor of SensorBar::PERIOD_MUS.
+     *                  The step is executed when the sample is published (see above).
+     * @param ... see above.
+     */
+    explicit LineFollower(ControlScheduler& scheduler,
+                          PinName sda_pin,
+                          PinName scl_pin,
+                          float bar_dist,
+                          float d_wheel,
+                          float b_wheel,
+                          float max_motor_vel_rps);
+
     /**
      * @brief Destroy the Line Follower object.
      */
@@ -109,6 +146,12 @@ public:
      */
     bool isLedActive() const;
 
+    /**
+     * @brief Get all outputs of the same step, e.g. both wheel velocities.
+     *
+     * @return LineFollowerData Snapshot of the last step.
+     */
+    LineFollowerData getData() const;
 
 private:
     // rotational velocity controller
@@ -133,10 +176,24 @@ private:
     Eigen::Matrix2f m_Cwheel2robot; // transforms robot to wheel coordinates
     Eigen::Vector2f m_robot_coord;  // contains w and v (robot rot. and trans. velocities)
 
+    // outputs of the last step for the getters, they can be called from any thread
+    Published<LineFollowerData> m_data;
+
     // thread objects
     Thread m_Thread;
     Ticker m_Ticker;
     ThreadFlag m_ThreadFlag;
+    ThreadFlag m_SampleFlag; // set by the sensor bar when the sample the thread waits for is published
+    ControlScheduler* m_scheduler;
+    int m_task_id{-1};
+
+    explicit LineFollower(ControlScheduler* scheduler,
+                          PinName sda_pin,
+                          PinName scl_pin,
+                          float bar_dist,
+                          float d_wheel,
+                          float b_wheel,
+                          float max_motor_vel_rps);
 
     // velocity controller functions
     float ang_cntrl_fcn(float Kp, float Kp_nl, float angle);
@@ -146,8 +203,11 @@ private:
                         Eigen::Matrix2f Cwheel2robot);
 
     // thread functions
+    void startSample();
+    void step();
     void followLine();
     void sendThreadFlag();
+    void sendSampleFlag();
 };
 
 #endif /* LINE_FOLLOWER_H_ */
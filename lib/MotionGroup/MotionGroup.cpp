@@ -0,0 +1,207 @@
+#include "MotionGroup.h"
+
+#include <math.h>
+
+#define MOTION_GROUP_DISTANCE_MIN 1.0e-6f // motors that move less are not used to limit the path
+
+MotionGroup::MotionGroup() : MotionGroup(nullptr)
+{
+}
+
+MotionGroup::MotionGroup(ControlScheduler& scheduler) : MotionGroup(&scheduler)
+{
+}
+
+MotionGroup::MotionGroup(ControlScheduler* scheduler) : m_Thread(osPriorityHigh1)
+                                                      , m_scheduler(scheduler)
+{
+    for (int i = 0; i < MOTION_GROUP_NUM_OF_MOTORS_MAX; i++) {
+        m_motors[i] = nullptr;
+        m_rotations_target[i] = 0.0f;
+        m_rotations_start[i] = 0.0f;
+        m_distances[i] = 0.0f;
+    }
+
+    if (m_scheduler) {
+        // let the scheduler execute step(), the own thread and thread flag are not used
+        m_ThreadFlag.release();
+        m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &MotionGroup::step), PERIOD_MUS);
+        return;
+    }
+
+    // start thread
+    m_Thread.start(callback(this, &MotionGroup::threadTask));
+
+    // attach sendThreadFlag() to ticker so that sendThreadFlag() is called periodically, which signals the thread to execute
+    m_Ticker.attach(callback(this, &MotionGroup::sendThreadFlag), std::chrono::microseconds{PERIOD_MUS});
+}
+
+MotionGroup::~MotionGroup()
+{
+    if (m_scheduler) {
+        m_scheduler->unregisterTask(m_task_id);
+        return;
+    }
+    m_Ticker.detach();
+    m_Thread.terminate();
+}
+
+int MotionGroup::addMotor(DCMotor& motor)
+{
+    m_Mutex.lock();
+    if (m_num_of_motors == MOTION_GROUP_NUM_OF_MOTORS_MAX) {
+        m_Mutex.unlock();
+        printf("MotionGroup: more than %d motors are not supported\n", MOTION_GROUP_NUM_OF_MOTORS_MAX);
+        return -1;
+    }
+    m_motors[m_num_of_motors] = &motor;
+    const int index = m_num_of_motors++;
+    m_Mutex.unlock();
+    return index;
+}
+
+void MotionGroup::removeMotor(DCMotor& motor)
+{
+    // waits for a running step(), afterwards the motor is not executed anymore and can be destroyed
+    m_Mutex.lock();
+    for (int i = 0; i < m_num_of_motors; i++) {
+        if (m_motors[i] != &motor)
+            continue;
+        for (int j = i; j < m_num_of_motors - 1; j++)
+            m_motors[j] = m_motors[j + 1];
+        m_motors[--m_num_of_motors] = nullptr;
+        break;
+    }
+    m_Mutex.unlock();
+}
+
+void MotionGroup::setRotations(const float* rotations)
+{
+    for (int i = 0; i < m_num_of_motors; i++)
+        m_rotations_target[i] = rotations[i];
+    m_is_moving.store(true);
+    // the move is planned in the next period by step()
+    m_is_new_target.store(true);
+}
+
+void MotionGroup::setRotationsRelative(const float* rotations_relative)
+{
+    float rotations[MOTION_GROUP_NUM_OF_MOTORS_MAX];
+    for (int i = 0; i < m_num_of_motors; i++)
+        rotations[i] = m_motors[i]->getRotation() + rotations_relative[i];
+    setRotations(rotations);
+}
+
+void MotionGroup::step()
+{
+    m_Mutex.lock();
+
+    if (m_is_new_target.exchange(false))
+        plan();
+
+    for (int i = 0; i < m_num_of_motors; i++)
+        m_motors[i]->sample();
+
+    if (m_is_active) {
+        // path parameter and its velocity, the motors move along the straight line from start to target
+        float s = 1.0f;
+        float s_dot = 0.0f;
+        if (m_time < m_duration) {
+            m_Path.incrementToPosition(1.0, TS);
+            m_time += TS;
+            s = static_cast<float>(m_Path.getPosition());
+            s_dot = m_Path.getVelocity();
+        }
+        if (m_time >= m_duration)
+            m_is_moving.store(false);
+
+        for (int i = 0; i < m_num_of_motors; i++) {
+            // motors that got a velocity or rotation command in the meantime are left alone
+            if (m_motors[i]->isSetpointMode())
+                m_motors[i]->setRotationSetpoint(m_rotations_start[i] + s * m_distances[i], s_dot * m_distances[i]);
+        }
+    }
+
+    for (int i = 0; i < m_num_of_motors; i++)
+        m_motors[i]->update();
+    for (int i = 0; i < m_num_of_motors; i++)
+        m_motors[i]->actuate();
+
+    m_Mutex.unlock();
+}
+
+void MotionGroup::plan()
+{
+    // current state on the path, the new move starts at the current setpoints
+    const bool is_on_path = m_is_active && (m_time < m_duration);
+    const float s = is_on_path ? static_cast<float>(m_Path.getPosition()) : 1.0f;
+    const float s_dot = is_on_path ? m_Path.getVelocity() : 0.0f;
+#if MOTION_GROUP_DO_USE_S_CURVE
+    const float s_ddot = is_on_path ? m_Path.getAcceleration() : 0.0f;
+#else
+    const float s_ddot = 0.0f;
+#endif
+
+    float velocity_max = 1.0e6f;
+    float acceleration_max = 1.0e6f;
+    float velocity_times_distance = 0.0f;
+    float acceleration_times_distance = 0.0f;
+    float distance_squared = 0.0f;
+    for (int i = 0; i < m_num_of_motors; i++) {
+        DCMotor& motor = *m_motors[i];
+
+        // motors that are not on the path start at their measured rotation and their velocity setpoint
+        float rotation = motor.getRotation();
+        float velocity = motor.getVelocitySetpoint();
+        float acceleration = 0.0f;
+        if (m_is_active && motor.isSetpointMode()) {
+            rotation = m_rotations_start[i] + s * m_distances[i];
+            velocity = s_dot * m_distances[i];
+            acceleration = s_ddot * m_distances[i];
+        }
+        const float distance = m_rotations_target[i] - rotation;
+        m_rotations_start[i] = rotation;
+        m_distances[i] = distance;
+
+        // motor i moves distance times faster than the path parameter
+        if (fabsf(distance) > MOTION_GROUP_DISTANCE_MIN) {
+            velocity_max = fminf(velocity_max, motor.getMaxVelocity() / fabsf(distance));
+            acceleration_max = fminf(acceleration_max, motor.getMaxAcceleration() / fabsf(distance));
+        }
+        velocity_times_distance += velocity * distance;
+        acceleration_times_distance += acceleration * distance;
+        distance_squared += distance * distance;
+
+        // from here on the group writes the setpoints of the motor
+        motor.setRotationSetpoint(rotation, velocity);
+    }
+
+    // the initial path velocity and acceleration are the parts of the motor velocities and accelerations along
+    // the path, so a retarget during a move keeps the acceleration continuous
+    const float s_dot_initial = (distance_squared > 0.0f) ? velocity_times_distance / distance_squared : 0.0f;
+#if MOTION_GROUP_DO_USE_S_CURVE
+    const float s_ddot_initial = (distance_squared > 0.0f) ? acceleration_times_distance / distance_squared : 0.0f;
+    m_Path.set(0.0, s_dot_initial, s_ddot_initial);
+#else
+    // the trapezoidal profile has no acceleration state
+    m_Path.set(0.0, s_dot_initial);
+#endif
+    m_Path.setLimits(velocity_max, acceleration_max, acceleration_max);
+    m_duration = (distance_squared > 0.0f) ? m_Path.getTimeToPosition(1.0) : 0.0f;
+    m_time = 0.0f;
+    m_is_active = true;
+}
+
+void MotionGroup::threadTask()
+{
+    while (true) {
+        ThisThread::flags_wait_any(m_ThreadFlag);
+        step();
+    }
+}
+
+void MotionGroup::sendThreadFlag()
+{
+    // set the thread flag to trigger the thread task
+    m_Thread.flags_set(m_ThreadFlag);
+}
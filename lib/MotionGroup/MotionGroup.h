@@ -0,0 +1,111 @@
+/**
+ * @file MotionGroup.h
+ * @brief Executes several DCMotors in one thread and moves them on a shared trajectory.
+ *
+ * The motors of a group are executed in one period: first all encoders are sampled, then all
+ * controllers are updated and then all pwms are written back-to-back, so there is no phase shift
+ * between the motors and only one thread, ticker and thread flag for all of them.
+ *
+ * setRotations() moves all motors along one straight line from their current setpoints to the
+ * target rotations. A single motion planner runs on the path parameter s from 0 to 1, the setpoint
+ * of motor i is start_i + s * (target_i - start_i) and its velocity feedforward ds/dt * (target_i -
+ * start_i). The limits of the path are the tightest of the motor limits scaled by the distances, so
+ * all motors start and finish at the same time and the slowest one moves at its limits. For a
+ * differential drive this keeps the ratio of the wheel rotations constant during the whole move.
+ *
+ * Velocity commands and moves of single motors are still possible with setVelocity(), setRotation()
+ * of the DCMotor, the group keeps executing the motor but leaves its setpoint alone.
+ *
+ * Example:
+ * ```
+ * MotionGroup group;
+ * DCMotor motor_M1(group, PB_PWM_M1, PB_ENC_A_M1, PB_ENC_B_M1, gear_ratio, kn, voltage_max);
+ * DCMotor motor_M2(group, PB_PWM_M2, PB_ENC_A_M2, PB_ENC_B_M2, gear_ratio, kn, voltage_max);
+ *
+ * const float rotations[2] = {2.0f, -1.0f};
+ * group.setRotations(rotations);
+ * while (group.isMoving()) {}
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef MOTION_GROUP_H_
+#define MOTION_GROUP_H_
+
+#include <atomic>
+
+#include "ThreadFlag.h"
+#include "ControlScheduler.h"
+#include "DCMotor.h"
+
+#define MOTION_GROUP_NUM_OF_MOTORS_MAX 4
+
+// if this is true then the path is planned with the jerk limited SCurve instead of the trapezoidal Motion profile
+#define MOTION_GROUP_DO_USE_S_CURVE true
+
+#if MOTION_GROUP_DO_USE_S_CURVE
+#include "SCurve.h"
+#else
+#include "Motion.h"
+#endif
+
+class MotionGroup
+{
+public:
+    explicit MotionGroup();
+    // the group is executed by a shared ControlScheduler instead of its own thread
+    explicit MotionGroup(ControlScheduler& scheduler);
+    virtual ~MotionGroup();
+
+    // called by the DCMotor constructor and destructor, returns the index of the motor or -1 if the group is full
+    int addMotor(DCMotor& motor);
+    void removeMotor(DCMotor& motor);
+    int getNumOfMotors() const { return m_num_of_motors; }
+
+    // moves all motors to rotations (one per motor, in the order the motors were created) at the same time
+    void setRotations(const float* rotations);
+    void setRotationsRelative(const float* rotations_relative);
+    // true until all motors reached the setpoints of the last setRotations()
+    bool isMoving() const { return m_is_moving.load(); }
+    // duration of the last planned move in seconds
+    float getDuration() const { return m_duration; }
+
+    // executes one period of all motors, called by the own thread or the ControlScheduler
+    void step();
+
+private:
+    static constexpr int64_t PERIOD_MUS = DCMotor::PERIOD_MUS;
+    static constexpr float TS = DCMotor::TS;
+
+    DCMotor* m_motors[MOTION_GROUP_NUM_OF_MOTORS_MAX];
+    int m_num_of_motors{0};
+
+#if MOTION_GROUP_DO_USE_S_CURVE
+    SCurve m_Path;
+#else
+    Motion m_Path;
+#endif
+    float m_rotations_target[MOTION_GROUP_NUM_OF_MOTORS_MAX];
+    float m_rotations_start[MOTION_GROUP_NUM_OF_MOTORS_MAX];
+    float m_distances[MOTION_GROUP_NUM_OF_MOTORS_MAX];
+    float m_duration{0.0f};
+    float m_time{0.0f};
+    bool m_is_active{false}; // the group writes the setpoints of the motors
+    std::atomic<bool> m_is_new_target{false};
+    std::atomic<bool> m_is_moving{false};
+
+    Mutex m_Mutex; // protects the motor list, held by step() and while a motor is added or removed
+
+    Thread m_Thread;
+    Ticker m_Ticker;
+    ThreadFlag m_ThreadFlag;
+    ControlScheduler* m_scheduler{nullptr};
+    int m_task_id{-1};
+
+    explicit MotionGroup(ControlScheduler* scheduler);
+    void plan();
+    void threadTask();
+    void sendThreadFlag();
+};
+#endif /* MOTION_GROUP_H_ */
@@ -0,0 +1,104 @@
+#include "PIDCntrlQ31.h"
+
+void PIDCntrlQ31::setup(float P, float I, float D, float tau_f, float tau_ro, float Ts, float uMin, float uMax, float input_scale, float output_scale)
+{
+    m_P = P;
+    m_I = I;
+    m_D = D;
+    m_tau_f = tau_f;
+    m_tau_ro = tau_ro;
+    m_Ts = Ts;
+    m_input_scale = input_scale;
+    m_output_scale = output_scale;
+    quantise();
+    setLimits(uMin, uMax);
+    reset();
+}
+
+void PIDCntrlQ31::setParamF(float F)
+{
+    m_F = F;
+    quantise();
+}
+
+void PIDCntrlQ31::setLimits(float uMin, float uMax)
+{
+    m_u_min = fixedFloatToQ31(uMin / m_output_scale);
+    m_u_max = fixedFloatToQ31(uMax / m_output_scale);
+    setIntegratorLimits(uMin, uMax);
+}
+
+void PIDCntrlQ31::setIntegratorLimits(float uIMin, float uIMax)
+{
+    m_u_i_min = fixedFloatToQ31(uIMin / m_output_scale);
+    m_u_i_max = fixedFloatToQ31(uIMax / m_output_scale);
+}
+
+void PIDCntrlQ31::reset(q31_t initValue)
+{
+    m_i_part = initValue;
+    m_d_part = 0;
+    m_d_old = 0;
+    m_u_old = initValue;
+    m_uf = initValue;
+}
+
+q31_t PIDCntrlQ31::update(q31_t e)
+{
+    // same as PIDCntrl::update(e), the D part acts on e with positive sign
+    return update(e, 0, 0, fixedSaturateQ31(-static_cast<int64_t>(e)));
+}
+
+q31_t PIDCntrlQ31::update(q31_t w, q31_t y_p, q31_t y_i, q31_t y_d)
+{
+    if (m_bi != 0) {
+        const q31_t e_i = fixedSaturateQ31(static_cast<int64_t>(w) - y_i);
+        m_i_part = fixedSaturate(fixedSaturateQ31(static_cast<int64_t>(m_i_part) + shift(multiply(m_bi, e_i))), m_u_i_min, m_u_i_max);
+    } else {
+        m_i_part = 0;
+    }
+
+    const q31_t dy_d = fixedSaturateQ31(static_cast<int64_t>(y_d) - m_d_old);
+    m_d_part = shift(multiply(m_bd, dy_d) - multiply(m_ad, m_d_part));
+    m_d_old = y_d;
+
+    const q31_t e_p = fixedSaturateQ31(static_cast<int64_t>(w) - y_p);
+    const q31_t u = fixedSaturateQ31(static_cast<int64_t>(shift(multiply(m_kp, e_p) + multiply(m_kf, w))) + m_i_part - m_d_part);
+
+    m_uf = fixedSaturate(shift(multiply(m_bf, u) + multiply(m_bf, m_u_old) - multiply(m_af, m_uf)), m_u_min, m_u_max);
+    m_u_old = u;
+
+    return m_uf;
+}
+
+void PIDCntrlQ31::quantise()
+{
+    // same coefficients as PIDCntrl, the gains are scaled from input to output full scale
+    const double Ts = static_cast<double>(m_Ts);
+    const double tau_f = static_cast<double>(m_tau_f);
+    const double tau_ro = static_cast<double>(m_tau_ro);
+    const double k = static_cast<double>(m_input_scale) / static_cast<double>(m_output_scale);
+    const float coefficients[7] = {static_cast<float>(static_cast<double>(m_P) * k),
+                                   static_cast<float>(static_cast<double>(m_I) * Ts * k),
+                                   static_cast<float>(2.0 * static_cast<double>(m_D) / (Ts + 2.0 * tau_f) * k),
+                                   static_cast<float>((Ts - 2.0 * tau_f) / (Ts + 2.0 * tau_f)),
+                                   static_cast<float>(Ts / (Ts + 2.0 * tau_ro)),
+                                   static_cast<float>((Ts - 2.0 * tau_ro) / (Ts + 2.0 * tau_ro)),
+                                   static_cast<float>(static_cast<double>(m_F) * k)};
+
+    float coefficient_abs_max = 0.0f;
+    for (int i = 0; i < 7; i++)
+        coefficient_abs_max = fmaxf(coefficient_abs_max, fabsf(coefficients[i]));
+    // at least shift 1, bf * (u + u_old) would overflow the accumulator otherwise
+    m_shift = fixedCoefficientShift(coefficient_abs_max);
+    if (m_shift < 1)
+        m_shift = 1;
+
+    m_kp = fixedCoefficient(coefficients[0], m_shift);
+    m_bi = fixedCoefficient(coefficients[1], m_shift);
+    m_bd = fixedCoefficient(coefficients[2], m_shift);
+    m_ad = fixedCoefficient(coefficients[3], m_shift);
+    m_bf = fixedCoefficient(coefficients[4], m_shift);
+    m_af = fixedCoefficient(coefficients[5], m_shift);
+    m_kf = fixedCoefficient(coefficients[6], m_shift);
+}
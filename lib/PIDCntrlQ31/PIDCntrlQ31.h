@@ -0,0 +1,80 @@
+/**
+ * @file PIDCntrlQ31.h
+ * @brief Fixed-point variant of PIDCntrl for Q31 signals.
+ *
+ * Same controller as PIDCntrl (backward Euler integrator, Tustin D part with filter tau_f, Tustin
+ * roll-off tau_ro, anti-windup by saturating the integrator and the output, feedforward F * w). The
+ * parameters are given in physical units like for PIDCntrl together with the full scale of the input
+ * (w, y) and of the output (u), the gains are scaled and quantised with one shift (see FixedPoint.h).
+ *
+ * Saturation semantics:
+ * - The integrator is saturated to the integrator limits and the output to the output limits like in
+ *   PIDCntrl::saturate().
+ * - Additionally control errors and the unfiltered output are saturated to full scale, so choose the
+ *   full scales larger than the signals and the output limits, then the result is the same as PIDCntrl
+ *   up to the quantisation.
+ *
+ * update() only uses integer arithmetic, so it is bit-exact on the host and can run in an ISR without
+ * the FPU.
+ *
+ * Example:
+ * ```
+ * // velocity controller, velocity full scale 100 rps, voltage full scale 16 V
+ * PIDCntrlQ31 cntrl;
+ * cntrl.setup(KP, KI, KD, TAU_F, TAU_RO, TS, -12.0f, 12.0f, 100.0f, 16.0f);
+ *
+ * const q31_t voltage = cntrl.update(velocity_setpoint_q31, velocity_q31, velocity_q31, velocity_q31);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef PID_CNTRL_Q31_H_
+#define PID_CNTRL_Q31_H_
+
+#include "FixedPoint.h"
+
+class PIDCntrlQ31
+{
+public:
+    explicit PIDCntrlQ31() {};
+    virtual ~PIDCntrlQ31() = default;
+
+    /**
+     * @param P, I, D, tau_f, tau_ro, Ts Parameters like PIDCntrl::setup(), tau_ro = 0 disables the roll-off.
+     * @param uMin, uMax Output limits in physical units.
+     * @param input_scale Full scale of w and y in physical units.
+     * @param output_scale Full scale of u in physical units.
+     */
+    void setup(float P, float I, float D, float tau_f, float tau_ro, float Ts, float uMin, float uMax, float input_scale, float output_scale);
+    void setParamF(float F);
+    void setLimits(float uMin, float uMax);
+    void setIntegratorLimits(float uIMin, float uIMax);
+
+    void reset(q31_t initValue = 0);
+
+    q31_t update(q31_t e);
+    q31_t update(q31_t w, q31_t y_p, q31_t y_i, q31_t y_d);
+
+    uint8_t getShift() const { return m_shift; }
+    q31_t getCurrentOutput() const { return m_uf; }
+
+private:
+    // parameters in physical units, kept to requantise if F changes
+    float m_P{0.0f}, m_I{0.0f}, m_D{0.0f}, m_tau_f{0.0f}, m_tau_ro{0.0f}, m_Ts{1.0f}, m_F{0.0f};
+    float m_input_scale{1.0f}, m_output_scale{1.0f};
+
+    // quantised coefficients with shift m_shift
+    q31_t m_kp{0}, m_bi{0}, m_bd{0}, m_ad{0}, m_bf{0}, m_af{0}, m_kf{0};
+    uint8_t m_shift{1};
+    q31_t m_u_min{FIXED_POINT_Q31_MIN}, m_u_max{FIXED_POINT_Q31_MAX};
+    q31_t m_u_i_min{FIXED_POINT_Q31_MIN}, m_u_i_max{FIXED_POINT_Q31_MAX};
+
+    // states
+    q31_t m_i_part{0}, m_d_part{0}, m_d_old{0}, m_u_old{0}, m_uf{0};
+
+    void quantise();
+    int64_t multiply(q31_t coefficient, q31_t x) const { return static_cast<int64_t>(coefficient) * x; }
+    q31_t shift(int64_t acc) const { return fixedSaturateQ31(fixedShiftRound(acc, 31 - m_shift)); }
+};
+#endif /* PID_CNTRL_Q31_H_ */
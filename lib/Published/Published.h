@@ -0,0 +1,80 @@
+/**
+ * @file Published.h
+ * @brief Consistent snapshots of data that one periodic driver writes and other threads read.
+ *
+ * The writer (the step() of a driver) calls publish() once per period with the complete data, the
+ * readers (getters called from main or other threads) get a copy with read() that always belongs to
+ * one single publish(), without a mutex and without disabling interrupts.
+ *
+ * The data is kept twice. publish() writes the slot the readers are not using and then switches the
+ * readers to it with a sequence counter (seqlock with two slots). A reader copies the current slot and
+ * retries only if a publish() completed in the meantime, so
+ * - a reader that interrupts the writer (higher priority thread or interrupt) never waits, it reads
+ *   the slot of the last complete publish(),
+ * - a reader that is interrupted by the writer retries at most once per period of the writer.
+ *
+ * There must be only one writer, the number of readers is not limited. T has to be copyable,
+ * docs/dev/dev_published stress tests the class on the host.
+ *
+ * Example:
+ * ```
+ * Published<ImuData> m_published;
+ *
+ * // writer, once per period
+ * m_published.publish(imu_data);
+ *
+ * // reader, any thread
+ * ImuData imu_data = m_published.read();
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef PUBLISHED_H_
+#define PUBLISHED_H_
+
+#include <atomic>
+#include <stdint.h>
+
+template <typename T>
+class Published
+{
+public:
+    explicit Published(const T& value = T())
+    {
+        m_slots[0] = value;
+        m_slots[1] = value;
+    }
+    virtual ~Published() = default;
+
+    // only one thread may publish
+    void publish(const T& value)
+    {
+        const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+        // the slot is not written before the readers know that the previous publish() is complete
+        std::atomic_thread_fence(std::memory_order_release);
+        m_slots[(sequence + 1) & 1] = value;
+        m_sequence.store(sequence + 1, std::memory_order_release);
+    }
+
+    // copy of the data of the last publish(), can be called from any thread or interrupt
+    T read() const
+    {
+        T value;
+        uint32_t sequence;
+        do {
+            sequence = m_sequence.load(std::memory_order_acquire);
+            value = m_slots[sequence & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (sequence != m_sequence.load(std::memory_order_relaxed));
+        return value;
+    }
+
+    // number of publish() calls, e.g. to check if there is new data
+    uint32_t getSequence() const { return m_sequence.load(std::memory_order_acquire); }
+
+private:
+    T m_slots[2];
+    std::atomic<uint32_t> m_sequence{0};
+};
+#endif /* PUBLISHED_H_ */
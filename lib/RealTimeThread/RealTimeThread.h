@@ -66,6 +66,7 @@ public:
     void enable();
     void disable();
     bool isEnabled() const { return m_enabled; } // return Ticker state
+    uint32_t getPeriod_us() const { return m_period_us; }
 
 protected:
     /**
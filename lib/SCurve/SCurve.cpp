@@ -0,0 +1,301 @@
+#include "SCurve.h"
+
+#include <math.h>
+
+#define S_CURVE_NUM_OF_ITERATIONS 24 // bisection steps, resolution of 6e-8 of the search range
+
+SCurve::SCurve()
+{
+    initProfile(m_Profile);
+}
+
+SCurve::SCurve(double position, float velocity)
+{
+    set(position, velocity);
+}
+
+void SCurve::set(double position, float velocity)
+{
+    set(position, velocity, 0.0f);
+}
+
+void SCurve::set(double position, float velocity, float acceleration)
+{
+    m_position = (float)position;
+    m_velocity = velocity;
+    m_acceleration = acceleration;
+    m_is_planned = false;
+    initProfile(m_Profile);
+}
+
+void SCurve::setPosition(double position)
+{
+    set(position, m_velocity);
+}
+
+void SCurve::setVelocity(float velocity)
+{
+    set(m_position, velocity);
+}
+
+void SCurve::setProfileVelocity(float profileVelocity)
+{
+    m_profile_velocity = (profileVelocity > MINIMUM_LIMIT) ? profileVelocity : MINIMUM_LIMIT;
+    m_is_planned = false;
+}
+
+void SCurve::setProfileAcceleration(float profileAcceleration)
+{
+    m_profile_acceleration = (profileAcceleration > MINIMUM_LIMIT) ? profileAcceleration : MINIMUM_LIMIT;
+    m_is_planned = false;
+}
+
+void SCurve::setProfileDeceleration(float profileDeceleration)
+{
+    m_profile_deceleration = (profileDeceleration > MINIMUM_LIMIT) ? profileDeceleration : MINIMUM_LIMIT;
+    m_is_planned = false;
+}
+
+void SCurve::setProfileJerk(float profileJerk)
+{
+    m_profile_jerk = (profileJerk > MINIMUM_LIMIT) ? profileJerk : 0.0f;
+    m_is_planned = false;
+}
+
+void SCurve::setLimits(float profileVelocity, float profileAcceleration, float profileDeceleration)
+{
+    setProfileVelocity(profileVelocity);
+    setProfileAcceleration(profileAcceleration);
+    setProfileDeceleration(profileDeceleration);
+}
+
+void SCurve::setLimits(float profileVelocity, float profileAcceleration, float profileDeceleration, float profileJerk)
+{
+    setLimits(profileVelocity, profileAcceleration, profileDeceleration);
+    setProfileJerk(profileJerk);
+}
+
+float SCurve::getTimeToPosition(double targetPosition)
+{
+    profile_t profile;
+    planPosition(profile, (float)targetPosition - m_position);
+    return profile.duration;
+}
+
+void SCurve::setMinimumDuration(float duration)
+{
+    m_duration_min = (duration > 0.0f) ? duration : 0.0f;
+    m_is_planned = false;
+}
+
+void SCurve::incrementToVelocity(float targetVelocity, float period)
+{
+    if (!m_is_planned || m_is_position_profile || targetVelocity != m_target)
+        startProfile(false, targetVelocity);
+    evaluate(period);
+}
+
+void SCurve::incrementToPosition(double targetPosition, float period)
+{
+    if (!m_is_planned || !m_is_position_profile || (float)targetPosition != m_target)
+        startProfile(true, (float)targetPosition);
+    evaluate(period);
+}
+
+float SCurve::getJerk() const
+{
+    if (m_profile_jerk > 0.0f)
+        return m_profile_jerk;
+    return fmaxf(m_profile_acceleration, m_profile_deceleration) * (1.0f / S_CURVE_JERK_TIME_DEFAULT);
+}
+
+float SCurve::getAccelerationMax(float velocity, float velocity_target) const
+{
+    // speeding up in the same direction uses the acceleration, everything else the deceleration limit
+    const bool is_speeding_up = (velocity * velocity_target >= 0.0f) && (fabsf(velocity_target) > fabsf(velocity));
+    return is_speeding_up ? m_profile_acceleration : m_profile_deceleration;
+}
+
+void SCurve::initProfile(profile_t& profile) const
+{
+    profile.num_of_segments = 0;
+    profile.duration = 0.0f;
+    profile.State.position = 0.0f;
+    profile.State.velocity = m_velocity;
+    profile.State.acceleration = m_acceleration;
+}
+
+void SCurve::planVelocity(profile_t& profile, float velocity) const
+{
+    initProfile(profile);
+    addVelocityChange(profile, velocity, getAccelerationMax(m_velocity, velocity));
+}
+
+void SCurve::planPosition(profile_t& profile, float distance) const
+{
+    planPositionLimited(profile, distance, m_profile_velocity);
+    if (m_duration_min <= profile.duration)
+        return;
+
+    // the duration decreases with the velocity limit, search the limit that takes duration_min
+    float velocity_low = 0.0f;
+    float velocity_high = m_profile_velocity;
+    for (int i = 0; i < S_CURVE_NUM_OF_ITERATIONS; i++) {
+        const float velocity_max = 0.5f * (velocity_low + velocity_high);
+        planPositionLimited(profile, distance, velocity_max);
+        if (profile.duration < m_duration_min)
+            velocity_high = velocity_max;
+        else
+            velocity_low = velocity_max;
+    }
+    // velocity_low is the fastest limit that is not too fast
+    if (velocity_low > 0.0f)
+        planPositionLimited(profile, distance, velocity_low);
+}
+
+void SCurve::planPositionLimited(profile_t& profile, float distance, float velocity_max) const
+{
+    // cruise with the velocity limit if the distance is long enough
+    const float distance_positive = planPositionPeak(profile, velocity_max, 0.0f);
+    if (distance >= distance_positive) {
+        planPositionPeak(profile, velocity_max, (distance - distance_positive) / velocity_max);
+        return;
+    }
+    const float distance_negative = planPositionPeak(profile, -velocity_max, 0.0f);
+    if (distance <= distance_negative) {
+        planPositionPeak(profile, -velocity_max, (distance_negative - distance) / velocity_max);
+        return;
+    }
+
+    // otherwise the distance increases with the peak velocity, search the peak without cruising
+    float velocity_low = -velocity_max;
+    float velocity_high = velocity_max;
+    for (int i = 0; i < S_CURVE_NUM_OF_ITERATIONS; i++) {
+        const float velocity_peak = 0.5f * (velocity_low + velocity_high);
+        if (planPositionPeak(profile, velocity_peak, 0.0f) < distance)
+            velocity_low = velocity_peak;
+        else
+            velocity_high = velocity_peak;
+    }
+    planPositionPeak(profile, 0.5f * (velocity_low + velocity_high), 0.0f);
+}
+
+float SCurve::planPositionPeak(profile_t& profile, float velocity_peak, float cruise_duration) const
+{
+    // change to the peak velocity, cruise and stop, returns the distance
+    initProfile(profile);
+    addVelocityChange(profile, velocity_peak, getAccelerationMax(m_velocity, velocity_peak));
+    addSegment(profile, 0.0f, cruise_duration);
+    addVelocityChange(profile, 0.0f, m_profile_deceleration);
+    return profile.State.position;
+}
+
+void SCurve::addVelocityChange(profile_t& profile, float velocity, float acceleration_max) const
+{
+    // adds up to 3 segments that change from the end state of the profile to velocity with zero acceleration:
+    // the acceleration ramps to the peak, stays constant and ramps back to zero
+    const float jerk = getJerk();
+    const float velocity_start = profile.State.velocity;
+    const float acceleration_start = profile.State.acceleration;
+
+    // velocity that is reached if the acceleration is ramped to zero right away
+    const float velocity_stop = velocity_start + 0.5f * acceleration_start * fabsf(acceleration_start) / jerk;
+    if (velocity == velocity_stop) {
+        addSegment(profile, (acceleration_start > 0.0f) ? -jerk : jerk, fabsf(acceleration_start) / jerk);
+        return;
+    }
+
+    // everything in the direction of the velocity change
+    const float sign = (velocity > velocity_stop) ? 1.0f : -1.0f;
+    const float dvelocity = sign * (velocity - velocity_start);
+    const float acceleration_start_signed = sign * acceleration_start;
+
+    float acceleration_peak = acceleration_max;
+    float t1 = fabsf(acceleration_peak - acceleration_start_signed) / jerk;
+    float t3 = acceleration_peak / jerk;
+    float t2 = (dvelocity - 0.5f * (acceleration_start_signed + acceleration_peak) * t1 - 0.5f * acceleration_peak * t3) / acceleration_peak;
+    if (t2 < 0.0f) {
+        // the peak acceleration is not reached, the velocity change is jerk up and jerk down only
+        acceleration_peak = sqrtf(fmaxf(jerk * dvelocity + 0.5f * acceleration_start_signed * acceleration_start_signed, 0.0f));
+        t1 = fmaxf(acceleration_peak - acceleration_start_signed, 0.0f) / jerk;
+        t2 = 0.0f;
+        t3 = acceleration_peak / jerk;
+    }
+
+    addSegment(profile, (acceleration_peak >= acceleration_start_signed) ? sign * jerk : -sign * jerk, t1);
+    addSegment(profile, 0.0f, t2);
+    addSegment(profile, -sign * jerk, t3);
+}
+
+void SCurve::addSegment(profile_t& profile, float jerk, float duration) const
+{
+    if (duration <= 0.0f || profile.num_of_segments >= S_CURVE_NUM_OF_SEGMENTS_MAX)
+        return;
+
+    segment_t& segment = profile.segment[profile.num_of_segments++];
+    segment.jerk = jerk;
+    segment.time = profile.duration;
+    segment.duration = duration;
+    segment.State = profile.State;
+
+    // state at the end of the segment
+    const float t = duration;
+    const state_t& s = segment.State;
+    profile.State.position = s.position + (s.velocity + (0.5f * s.acceleration + (1.0f / 6.0f) * jerk * t) * t) * t;
+    profile.State.velocity = s.velocity + (s.acceleration + 0.5f * jerk * t) * t;
+    profile.State.acceleration = s.acceleration + jerk * t;
+    profile.duration += duration;
+}
+
+void SCurve::startProfile(bool is_position_profile, float target)
+{
+    if (is_position_profile)
+        planPosition(m_Profile, target - m_position);
+    else
+        planVelocity(m_Profile, target);
+
+    m_is_planned = true;
+    m_is_position_profile = is_position_profile;
+    m_target = target;
+    m_position_start = m_position;
+    m_time = 0.0f;
+    m_segment_ind = 0;
+}
+
+void SCurve::evaluate(float period)
+{
+    m_time += period;
+
+    // the segments are passed in order, so only the current one is checked
+    while (m_segment_ind < m_Profile.num_of_segments) {
+        const segment_t& segment = m_Profile.segment[m_segment_ind];
+        if (m_time < segment.time + segment.duration)
+            break;
+        m_segment_ind++;
+    }
+
+    if (m_segment_ind == m_Profile.num_of_segments) {
+        m_acceleration = 0.0f;
+        if (m_is_position_profile) {
+            // the end state is exact, so the profile stops at the target and not at the rounded sum of the segments
+            m_position = m_target;
+            m_velocity = 0.0f;
+            return;
+        }
+        // continue with the target velocity and restart the time, so it does not lose resolution
+        m_position = m_position_start + m_Profile.State.position + m_target * (m_time - m_Profile.duration);
+        m_velocity = m_target;
+        m_position_start = m_position;
+        m_time = 0.0f;
+        m_segment_ind = 0;
+        initProfile(m_Profile);
+        return;
+    }
+
+    const segment_t& segment = m_Profile.segment[m_segment_ind];
+    const state_t& s = segment.State;
+    const float t = m_time - segment.time;
+    m_position = m_position_start + s.position + (s.velocity + (0.5f * s.acceleration + (1.0f / 6.0f) * segment.jerk * t) * t) * t;
+    m_velocity = s.velocity + (s.acceleration + 0.5f * segment.jerk * t) * t;
+    m_acceleration = s.acceleration + segment.jerk * t;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file SCurve.h
+ * @brief Jerk limited motion planner with the same interface as Motion.
+ *
+ * The SCurve class plans a time parametrised profile with up to 7 segments of constant jerk
+ * (accelerate, cruise, decelerate, each acceleration phase with a jerk up, constant and jerk down
+ * segment) from the current position, velocity and acceleration to a target position or velocity.
+ *
+ * - The profile is only planned if the target or a limit changes, every other call of
+ *   incrementToPosition() or incrementToVelocity() evaluates the current segment in closed form
+ *   with float math.
+ * - A change of the target or a limit plans from the current acceleration, so the acceleration
+ *   stays continuous.
+ * - getTimeToPosition() is the duration of the profile, setMinimumDuration() stretches the
+ *   profiles to a given duration (lower cruise velocity), so several axes can be synchronised.
+ *
+ * The position is kept as float, so the resolution is about 1e-7 of the position range.
+ *
+ * Example (two synchronised axes):
+ * ```
+ * const float duration = fmaxf(axis_x.getTimeToPosition(x), axis_y.getTimeToPosition(y));
+ * axis_x.setMinimumDuration(duration);
+ * axis_y.setMinimumDuration(duration);
+ *
+ * // every period
+ * axis_x.incrementToPosition(x, TS);
+ * axis_y.incrementToPosition(y, TS);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef S_CURVE_H_
+#define S_CURVE_H_
+
+#include <stdint.h>
+
+#define S_CURVE_NUM_OF_SEGMENTS_MAX 7
+#define S_CURVE_JERK_TIME_DEFAULT 0.1f // if no jerk is set, the acceleration limit is reached within 0.1 sec
+
+class SCurve
+{
+public:
+    explicit SCurve();
+    explicit SCurve(double position, float velocity);
+    virtual ~SCurve() = default;
+
+    void set(double position, float velocity);
+    // the next profile starts with the acceleration, e.g. to continue from the state of another profile
+    void set(double position, float velocity, float acceleration);
+    void setPosition(double position);
+    double getPosition() const { return m_position; }
+    void setVelocity(float velocity);
+    float getVelocity() const { return m_velocity; }
+    float getAcceleration() const { return m_acceleration; }
+
+    void setProfileVelocity(float profileVelocity);
+    void setProfileAcceleration(float profileAcceleration);
+    void setProfileDeceleration(float profileDeceleration);
+    // 0 uses the acceleration limit divided by S_CURVE_JERK_TIME_DEFAULT
+    void setProfileJerk(float profileJerk);
+    void setLimits(float profileVelocity, float profileAcceleration, float profileDeceleration);
+    void setLimits(float profileVelocity, float profileAcceleration, float profileDeceleration, float profileJerk);
+
+    // duration of the profile to the target position from the current state, given in [s]
+    float getTimeToPosition(double targetPosition);
+    // the profiles to a target position take at least duration [s], 0 disables the synchronisation
+    void setMinimumDuration(float duration);
+
+    void incrementToVelocity(float targetVelocity, float period);
+    void incrementToPosition(double targetPosition, float period);
+
+private:
+    static constexpr float DEFAULT_LIMIT = 1.0f;    // same as Motion
+    static constexpr float MINIMUM_LIMIT = 1.0e-9f; // smallest value allowed for limits
+
+    typedef struct state_s {
+        float position; // relative to the start of the profile
+        float velocity;
+        float acceleration;
+    } state_t;
+
+    typedef struct segment_s {
+        float jerk;
+        float time; // start of the segment
+        float duration;
+        state_t State; // at the start of the segment
+    } segment_t;
+
+    typedef struct profile_s {
+        segment_t segment[S_CURVE_NUM_OF_SEGMENTS_MAX];
+        uint8_t num_of_segments;
+        float duration;
+        state_t State; // at the end of the profile
+    } profile_t;
+
+    float m_position{0.0f};
+    float m_velocity{0.0f};
+    float m_acceleration{0.0f};
+
+    float m_profile_velocity{DEFAULT_LIMIT};
+    float m_profile_acceleration{DEFAULT_LIMIT};
+    float m_profile_deceleration{DEFAULT_LIMIT};
+    float m_profile_jerk{0.0f};
+    float m_duration_min{0.0f};
+
+    // active profile
+    profile_t m_Profile;
+    bool m_is_planned{false};
+    bool m_is_position_profile{false};
+    float m_target{0.0f};
+    float m_position_start{0.0f};
+    float m_time{0.0f};
+    uint8_t m_segment_ind{0};
+
+    float getJerk() const;
+    float getAccelerationMax(float velocity, float velocity_target) const;
+    void initProfile(profile_t& profile) const;
+    void planVelocity(profile_t& profile, float velocity) const;
+    void planPosition(profile_t& profile, float distance) const;
+    void planPositionLimited(profile_t& profile, float distance, float velocity_max) const;
+    float planPositionPeak(profile_t& profile, float velocity_peak, float cruise_duration) const;
+    void addVelocityChange(profile_t& profile, float velocity, float acceleration_max) const;
+    void addSegment(profile_t& profile, float jerk, float duration) const;
+    void startProfile(bool is_position_profile, float target);
+    void evaluate(float period);
+};
+#endif /* S_CURVE_H_ */
@@ -4,9 +4,10 @@ SDLogger::SDLogger(PinName mosi,
                    PinName miso,
                    PinName sck,
                    PinName cs,
-                   uint8_t num_of_floats) : m_SDWriter(mosi, miso, sck, cs),
-                                            m_Thread(osPriorityLow),
-                                            m_num_of_floats(num_of_floats)
+                   uint8_t num_of_floats,
+                   const float* scales) : m_SDWriter(mosi, miso, sck, cs),
+                                          m_Thread(osPriorityLow),
+                                          m_num_of_floats(num_of_floats)
 {
     // validate input parameters
     if (num_of_floats == 0 || num_of_floats > SD_LOGGER_NUM_OF_FLOATS_MAX) {
@@ -15,6 +16,11 @@ SDLogger::SDLogger(PinName mosi,
             SD_LOGGER_NUM_OF_FLOATS_MAX);
         m_num_of_floats = SD_LOGGER_NUM_OF_FLOATS_MAX;
     }
+    if (scales)
+        m_Codec = TelemetryCodec(m_num_of_floats, scales);
+
+    // only whole blocks are written, so the stdio buffer is not needed
+    m_SDWriter.setUnbuffered(true);
 
     // start thread
     m_Thread.start(callback(this, &SDLogger::threadTask));
@@ -30,15 +36,46 @@ SDLogger::SDLogger(PinName mosi,
 
 SDLogger::~SDLogger()
 {
-    closeFile();
+    // let the thread write the remaining data and return, so it never writes to a closed file
     m_Ticker.detach();
-    m_Thread.terminate();
+    m_do_stop = true;
+    sendThreadFlag();
+    m_Thread.join();
+
+    closeFile();
 }
 
 void SDLogger::write(const float val)
 {
-    // add val to the buffer
-    m_data[m_float_cntr++] = val;
+    if (m_Codec.isEnabled()) {
+        // the record is encoded as a whole with send()
+        m_values[m_float_cntr++] = val;
+        if (m_float_cntr == m_num_of_floats)
+            send();
+        return;
+    }
+
+    // check the space for the whole record with the first float, so that an overflow never splits a record
+    if (m_float_cntr == 0) {
+        const size_t buffer_usage = getBufferUsage();
+        if (buffer_usage > m_max_buffer_usage)
+            m_max_buffer_usage = buffer_usage;
+        m_record_dropped = !m_file_open || (m_RingBuffer.free() < sizeof(float) * m_num_of_floats);
+    }
+
+    // copy val directly into the ring buffer
+    if (!m_record_dropped) {
+        if (m_send_num_of_floats_once) {
+            m_RingBuffer.write(reinterpret_cast<const char*>(&val), sizeof(float));
+        } else {
+            // the first record is written behind the header byte and committed with send(), the ring buffer
+            // is still empty so the span covers the whole buffer
+            size_t span_length;
+            char* span = m_RingBuffer.write_span(span_length);
+            memcpy(&span[1 + sizeof(float) * m_float_cntr], &val, sizeof(float));
+        }
+    }
+    m_float_cntr++;
 
     // send the data if the buffer is full immediately
     if (m_float_cntr == m_num_of_floats) {
@@ -52,45 +89,57 @@ void SDLogger::send()
     if (m_float_cntr == 0)
         return;
 
-    static bool send_num_of_floats_once = false;
-    if (!send_num_of_floats_once) {
-        send_num_of_floats_once = true;
-        // write current count
-        if (!m_SDWriter.writeByte(m_float_cntr)) {
-            printf("SDLogger: writing num_of_floats byte failed\n");
-        }
+    if (m_Codec.isEnabled()) {
+        sendEncoded();
+        m_float_cntr = 0;
+        return;
     }
 
-    // write the data
-    logFloats(m_data, m_float_cntr);
+    if (!m_file_open) {
+        printf("SDLogger: File not open—discarding data.\n");
+    } else if (m_record_dropped) {
+        // buffer is full
+        m_overflow_count++;
+        printf("SDLogger: Buffer overflow, lost data!\n");
+    } else if (!m_send_num_of_floats_once) {
+        m_send_num_of_floats_once = true;
+        // write current count as first byte and hand it over together with the first record
+        size_t span_length;
+        char* span = m_RingBuffer.write_span(span_length);
+        span[0] = static_cast<char>(m_float_cntr);
+        m_RingBuffer.write_commit(1 + sizeof(float) * m_float_cntr);
+    }
     m_float_cntr = 0;
 }
 
-void SDLogger::logFloats(const float* data)
-{
-    logFloats(data, m_num_of_floats);
-}
-
-void SDLogger::logFloats(const float* data, size_t count)
+void SDLogger::sendEncoded()
 {
     if (!m_file_open) {
         printf("SDLogger: File not open—discarding data.\n");
         return;
     }
 
-    // note: i leave this as an example
-    // core_util_critical_section_enter(); 
-    // bool ok = pushFloats(data, count);
-    // core_util_critical_section_exit();
-
-    m_Mutex.lock();
-    bool ok = pushFloats(data, count);
-    m_Mutex.unlock();
+    const size_t buffer_usage = getBufferUsage();
+    if (buffer_usage > m_max_buffer_usage)
+        m_max_buffer_usage = buffer_usage;
 
-    if (!ok) {
-        // buffer is full
+    // the space is checked for the longest possible record before encoding, a record that is dropped
+    // is not encoded so the differences of the following records stay valid
+    const size_t header_size = m_send_num_of_floats_once ? 0 : m_Codec.getHeaderSize();
+    if (m_RingBuffer.free() < header_size + TELEMETRY_CODEC_RECORD_SIZE_MAX(m_num_of_floats)) {
+        m_overflow_count++;
         printf("SDLogger: Buffer overflow, lost data!\n");
+        return;
+    }
+
+    if (!m_send_num_of_floats_once) {
+        m_send_num_of_floats_once = true;
+        // the header fits into m_record, it is written before the first record
+        const int size = m_Codec.writeHeader(m_record);
+        m_RingBuffer.write(m_record, size);
     }
+    const int record_size = m_Codec.encode(m_values, m_float_cntr, m_record);
+    m_RingBuffer.write(m_record, record_size);
 }
 
 bool SDLogger::openFile()
@@ -115,6 +164,7 @@ bool SDLogger::openFile()
     //     printf("SDLogger: writing num_of_floats byte failed\n");
     //     return false;
     // }
+    m_file_offset = 0;
     m_file_open = true;
     printf("SDLogger: File opened successfully\n");
     return true;
@@ -129,62 +179,32 @@ void SDLogger::closeFile()
     }
 }
 
-void SDLogger::flushBuffer()
+void SDLogger::flushBuffer(bool write_all)
 {
     if (!m_file_open) {
         return;
     }
 
-    // drain in chunks
-    static constexpr size_t CHUNK_SIZE = 512; // increased from 256 for better throughput
-    float tmp[CHUNK_SIZE];
-
-    while (!m_CircularBuffer.empty()) {
-        size_t count_to_pop = 0;
-
-        // note: i leave this as an example
-        // core_util_critical_section_enter();
-        // while ((count_to_pop < CHUNK_SIZE) && (!m_CircularBuffer.empty())) {
-        //     m_CircularBuffer.pop(tmp[count_to_pop]);
-        //     count_to_pop++;
-        // }
-        // core_util_critical_section_exit();
-
-        m_Mutex.lock();
-        while ((count_to_pop < CHUNK_SIZE) && (!m_CircularBuffer.empty())) {
-            m_CircularBuffer.pop(tmp[count_to_pop]);
-            count_to_pop++;
+    // write the data in place, the span ends at the end of the ring buffer at the latest
+    while (true) {
+        size_t count;
+        const char* ptr = m_RingBuffer.read_span(count);
+        // only whole blocks are written, the write ends at a block boundary of the file, the end of the
+        // ring buffer is always one since BUFFER_SIZE is a multiple of BLOCK_SIZE
+        if (!write_all) {
+            count = ((m_file_offset + count) & ~(BLOCK_SIZE - 1)) - m_file_offset;
         }
-        m_Mutex.unlock();
-
-        if (count_to_pop > 0) {
-            // write that chunk
-            if (!m_SDWriter.writeFloats(tmp, count_to_pop)) {
-                printf("SDLogger: writeFloats failed\n");
-                // break to avoid infinite loop on persistent errors
-                break;
-            }
+        if (count == 0) {
+            break;
         }
-    }
-}
-
-bool SDLogger::pushFloats(const float* data, size_t count)
-{
-    for (size_t i = 0; i < count; i++) {
-        if (m_CircularBuffer.full()) {
-            m_overflow_count++;
-            return false;
+        if (!m_SDWriter.writeBytes(ptr, count)) {
+            printf("SDLogger: writeBytes failed\n");
+            // break to avoid infinite loop on persistent errors
+            break;
         }
-        m_CircularBuffer.push(data[i]);
+        m_RingBuffer.read_commit(count);
+        m_file_offset += count;
     }
-
-    // update max buffer usage for diagnostics
-    size_t current_usage = m_CircularBuffer.size();
-    if (current_usage > m_max_buffer_usage) {
-        m_max_buffer_usage = current_usage;
-    }
-    
-    return true;
 }
 
 void SDLogger::threadTask()
@@ -195,10 +215,17 @@ void SDLogger::threadTask()
     while (true) {
         ThisThread::flags_wait_any(m_ThreadFlag);
 
+        // write all data if the destructor waits for the thread
+        if (m_do_stop) {
+            flushBuffer(true);
+            return;
+        }
+
         // write any pending data
         flushBuffer();
 
-        // flush the file so data is physically on sd card
+        // flush the file so the written blocks are physically on sd card, the last partial block stays in
+        // the ring buffer, otherwise all following blocks would be shifted against the sectors of the file
         if (flush_timer.elapsed_time() >= 5s) {
             flush_timer.reset();
 
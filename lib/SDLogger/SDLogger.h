@@ -2,20 +2,28 @@
  * @file SDLogger.h
  * @brief Defines the SDLogger class for logging floating-point data to an SD card.
  *
- * The SDLogger class buffers floating-point samples using a ring buffer and writes them 
- * to an SD card in bursts from a low-priority thread. It manages thread creation, 
- * periodic flushing, and synchronization, providing a simple and efficient logging interface.
+ * The SDLogger class writes floating-point samples directly into a lock-free ring buffer that
+ * holds SD_LOGGER_NUM_OF_BLOCKS blocks of 512 bytes (one SD card sector each). Whole blocks are
+ * handed in place to the SD card from a low-priority thread, the stdio buffer of the file is
+ * disabled so no further copy is made.
+ * The producer side (write() and send()) is wait-free, it only copies the floats once and
+ * never blocks on a mutex. It manages thread creation, periodic flushing, and synchronization,
+ * providing a simple and efficient logging interface.
  *
- * Maximum throughput depends on SD card speed and buffer size. If the buffer fills up, 
- * additional data is discarded. By default, data is flushed to disk every 5 seconds 
- * to reduce data loss in case of power failure.
+ * Optionally the records are compressed with the TelemetryCodec (quantised, delta and varint coded
+ * with periodic keyframes), select it by passing the scales of the channels to the constructor.
+ *
+ * Maximum throughput depends on SD card speed and the number of blocks. If all blocks are
+ * full, the whole record is discarded. By default, the written blocks are flushed to disk every
+ * 5 seconds to reduce data loss in case of power failure. The last partial block is only written when
+ * it is full or when the logger is destroyed, so at most one block (512 bytes) is lost on power failure.
  *
  * @dependencies
  * This class relies on:
  * - **SDWriter**: Handles SD card mounting, file creation, and binary writes.
- * - **CircularBuffer<float>**: Buffers incoming float data.
  * - **ThreadFlag** and **Ticker**: Schedule periodic buffer flushing.
- * - **Mutex**: Ensures thread-safe access to the buffer.
+ * - **SPSCRingBuffer<char>**: Hands the data from the producer to the writer thread without a lock.
+ * - **TelemetryCodec**: Optional compression of the records.
  *
  * @usage
  * 1. Create an `SDLogger` instance by specifying SPI pins and the number of floats per record.
@@ -43,19 +51,25 @@
 #ifndef SD_LOGGER_H_
 #define SD_LOGGER_H_
 
+#include <atomic>
+
 #include "mbed.h"
 
 #include "SDWriter.h"
+#include "SPSCRingBuffer.h"
+#include "TelemetryCodec.h"
 #include "ThreadFlag.h"
 
-#define SD_LOGGER_NUM_OF_FLOATS_MAX 100 // tested 22 floats at 500 Hz
+#define SD_LOGGER_NUM_OF_FLOATS_MAX 100 // tested 22 floats at 500 Hz with the former float ring buffer
+#define SD_LOGGER_NUM_OF_BLOCKS 16      // 16 blocks = 8kB, has to be a power of 2, increase it for higher
+                                        // throughput if the logger is not created on the main thread stack
 
 /**
  * A minimal thread-based SD logger that:
- * - Uses a larger CircularBuffer<float, BUFFER_SIZE>.
- * - Logs data in bursts from a low-priority thread.
- * - Flushes once per second so data is physically written.
- * - Prints a message if the buffer is full or if an SD write fails.
+ * - Writes the floats directly into a ring buffer of SD_LOGGER_NUM_OF_BLOCKS blocks of SD_WRITER_BLOCK_SIZE bytes.
+ * - Logs whole blocks from a low-priority thread.
+ * - Flushes the whole blocks every 5 seconds so data is physically written.
+ * - Prints a message if all blocks are full or if an SD write fails.
  * - Writes a "m_num_of_floats" byte at the file start (like a header).
  */
 class SDLogger
@@ -68,64 +82,77 @@ public:
  * @param cs            SPI CS pin
  * @param num_of_floats Number of floats per record to write to SD card.
  *                      Must be <= SD_LOGGER_NUM_OF_FLOATS_MAX
+ * @param scales        Optional resolution per LSB of every channel, if not nullptr the records are
+ *                      compressed with the TelemetryCodec, 0 keeps a channel as raw float
  */
     explicit SDLogger(PinName mosi,
                       PinName miso,
                       PinName sck,
                       PinName cs,
-                      uint8_t num_of_floats = SD_LOGGER_NUM_OF_FLOATS_MAX);
+                      uint8_t num_of_floats = SD_LOGGER_NUM_OF_FLOATS_MAX,
+                      const float* scales = nullptr);
     virtual ~SDLogger();
 
-    // write float values one by one (appends to the ring buffer automatically, but you need to write m_num_of_floats floats)
+    // write float values one by one (copied directly into the ring buffer, but you need to write m_num_of_floats floats)
     void write(const float val);
     // send the data immediately, this will be triggered automatically if you hav writte num_of_floats floats already
     void send();
 
+    // diagnostics, buffer usage is in bytes, overflow count in records
+    size_t getBufferUsage() const { return m_RingBuffer.capacity() - m_RingBuffer.free(); }
+    size_t getMaxBufferUsage() const { return m_max_buffer_usage; }
+    uint32_t getOverflowCount() const { return m_overflow_count; }
+    void resetDiagnostics() { m_max_buffer_usage = 0; m_overflow_count = 0; }
+
 private:
-    // Increase buffer size for higher throughput / less overflow
-    // static const size_t BUFFER_SIZE = 8192; // 8k floats = 32kB
-    // static const size_t BUFFER_SIZE = 4096; // 4k floats = 16kB
-    static const size_t BUFFER_SIZE = 2048; // 2k floats = 8kB
-    // static const size_t BUFFER_SIZE = 1024; // e.g. 4kB
     static constexpr int64_t PERIOD_MUS = 20000; // 20 ms period
+    static constexpr size_t BLOCK_SIZE = SD_WRITER_BLOCK_SIZE;
+
+    static_assert((SD_LOGGER_NUM_OF_BLOCKS & (SD_LOGGER_NUM_OF_BLOCKS - 1)) == 0,
+                  "SD_LOGGER_NUM_OF_BLOCKS has to be a power of 2");
+    static_assert(1 + sizeof(float) * SD_LOGGER_NUM_OF_FLOATS_MAX < SD_WRITER_BLOCK_SIZE,
+                  "the header byte and the first record have to fit into the first block");
+    static constexpr size_t BUFFER_SIZE = SD_LOGGER_NUM_OF_BLOCKS * BLOCK_SIZE;
+    static_assert((BLOCK_SIZE & (BLOCK_SIZE - 1)) == 0, "SD_WRITER_BLOCK_SIZE has to be a power of 2");
 
-    Mutex m_Mutex; // mutex to protect the ring buffer
-    CircularBuffer<float, BUFFER_SIZE> m_CircularBuffer;
     SDWriter m_SDWriter;
 
     Thread m_Thread;
     Ticker m_Ticker;
     ThreadFlag m_ThreadFlag;
+    std::atomic<bool> m_do_stop{false}; // set by the destructor, the thread writes all data and returns
+
+    // the file offset of a byte equals its position in the ring buffer modulo BUFFER_SIZE, so blocks
+    // in the ring buffer are also blocks in the file
+    alignas(4) char m_storage[BUFFER_SIZE];
+    SPSCRingBuffer<char> m_RingBuffer{BUFFER_SIZE, m_storage};
+    size_t m_file_offset{0}; // bytes written to the file, only used by the thread
 
     uint8_t m_num_of_floats;
     uint8_t m_float_cntr{0};
     bool m_file_open{false};
-    float m_data[SD_LOGGER_NUM_OF_FLOATS_MAX];
+    bool m_send_num_of_floats_once{false};
+    bool m_record_dropped{false};
+
+    // compression, the floats of a record are collected in m_values and encoded with send()
+    TelemetryCodec m_Codec;
+    float m_values[SD_LOGGER_NUM_OF_FLOATS_MAX];
+    char m_record[TELEMETRY_CODEC_RECORD_SIZE_MAX(SD_LOGGER_NUM_OF_FLOATS_MAX)];
 
     // buffer monitoring
     size_t m_max_buffer_usage{0};
     uint32_t m_overflow_count{0};
 
-    // log some float data (appends to ring buffer)
-    void logFloats(const float* data);
-    // log some float data (appends to ring buffer)
-    void logFloats(const float* data, size_t count);
     // opens a new file on the SD card, writes the "m_num_of_floats" as a header byte
     bool openFile();
+    // encodes the collected floats and writes the header (once) and the record into the ring buffer
+    void sendEncoded();
     // closes the file
     void closeFile();
-    // helper to drain the buffer in chunks
-    void flushBuffer();
-    // helper to push floats into the ring buffer
-    bool pushFloats(const float* data, size_t count);
+    // helper to write the whole blocks, or all data if write_all is true
+    void flushBuffer(bool write_all = false);
 
     void threadTask();
     void sendThreadFlag();
-
-    // diagnostics
-    size_t getBufferUsage() const { return m_CircularBuffer.size(); }
-    size_t getMaxBufferUsage() const { return m_max_buffer_usage; }
-    uint32_t getOverflowCount() const { return m_overflow_count; }
-    void resetDiagnostics() { m_max_buffer_usage = 0; m_overflow_count = 0; }
 };
 #endif /* SD_LOGGER_H_ */
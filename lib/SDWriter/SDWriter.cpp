@@ -112,6 +112,20 @@ bool SDWriter::writeFloats(const float* data, size_t count)
     return true;
 }
 
+bool SDWriter::writeBytes(const void* data, size_t count)
+{
+    if (!m_FilePtr) {
+        return false;
+    }
+    size_t written = fwrite(data, 1, count, m_FilePtr);
+    if (written != count) {
+        printf("SDWriter: writeBytes failed (wrote %u of %u)\n",
+               (unsigned)written, (unsigned)count);
+        return false;
+    }
+    return true;
+}
+
 bool SDWriter::flush()
 {
     if (!m_FilePtr) {
@@ -121,7 +135,11 @@ bool SDWriter::flush()
         printf("SDWriter: fflush failed\n");
         return false;
     }
-    // on some systems, you could also call fsync(fileno(m_FilePtr)) if available.
+    // fflush only empties the stdio buffer, fsync also updates the file size in the fat
+    if (fsync(fileno(m_FilePtr)) != 0) {
+        printf("SDWriter: fsync failed\n");
+        return false;
+    }
     return true;
 }
 
@@ -156,6 +174,8 @@ bool SDWriter::openNumberedFile()
             // file doesn't exist yet, try to create it
             m_FilePtr = fopen(m_file_path, "wb");
             if (m_FilePtr) {
+                if (m_unbuffered)
+                    setvbuf(m_FilePtr, NULL, _IONBF, 0);
                 printf("SDWriter: opened %s\n", m_file_path);
                 return true;
             } else {
@@ -54,6 +54,8 @@
 #include <SDBlockDevice.h>
 #include <FATFileSystem.h>
 
+#define SD_WRITER_BLOCK_SIZE 512 // sector size of the sd card
+
 class SDWriter
 {
 public:
@@ -68,6 +70,9 @@ public:
 
     // opens a new file like /sd/data/001.bin, /sd/data/002.bin, etc.
     bool openNextFile();
+    // disable the stdio buffer of the files opened after this call, use this if you only write whole blocks
+    // of SD_WRITER_BLOCK_SIZE bytes, they are then passed to the file system without an additional copy
+    void setUnbuffered(bool unbuffered) { m_unbuffered = unbuffered; }
     void closeFile();
 
     // write a single byte (e.g. "number of floats" header).
@@ -79,6 +84,9 @@ public:
     // write 'count' floats to the file in binary.
     bool writeFloats(const float* data, size_t count);
 
+    // write 'count' bytes to the file in binary.
+    bool writeBytes(const void* data, size_t count);
+
     // flush data to SD so it's physically written.
     bool flush();
 
@@ -88,6 +96,7 @@ private:
 
     FILE* m_FilePtr{nullptr};
     bool  m_mounted{false};
+    bool  m_unbuffered{false};
     char  m_file_path[64];   // current file path
 
     bool ensureDirExists(const char* path);
@@ -0,0 +1,203 @@
+/**
+ * @file SPSCRingBuffer.h
+ * @brief Lock-free single-producer/single-consumer ring buffer.
+ *
+ * One context writes (producer) and one context reads (consumer), e.g. a thread and an interrupt.
+ * Neither side ever blocks or disables interrupts, so both sides can be used in an ISR.
+ *
+ * - The capacity is rounded up to a power of 2, indices are masked instead of compared and wrapped.
+ * - Head and tail are free running counters, so the whole capacity can be used.
+ * - The indices are std::atomic with acquire/release ordering, the data of an element is visible to
+ *   the consumer before the element itself is.
+ * - write_span() and read_span() return contiguous regions of the buffer, so data can be produced
+ *   and consumed in place (zero copy), the region is handed over with write_commit() and read_commit().
+ *
+ * Blocking behaviour (e.g. waiting for space) is left to the user of the class. T has to be trivially
+ * copyable, elements are copied with memcpy.
+ *
+ * Example:
+ * ```
+ * SPSCRingBuffer<char> ring_buffer(256);
+ *
+ * // producer
+ * ring_buffer.write(data, length);
+ *
+ * // consumer, zero copy
+ * size_t count;
+ * const char* ptr = ring_buffer.read_span(count);
+ * fwrite(ptr, 1, count, file);
+ * ring_buffer.read_commit(count);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef SPSC_RING_BUFFER_H_
+#define SPSC_RING_BUFFER_H_
+
+#include <atomic>
+#include <stddef.h>
+#include <string.h>
+
+template <typename T>
+class SPSCRingBuffer
+{
+public:
+    /**
+     * @param capacity The number of elements, rounded up to a power of 2, 0 creates an unusable buffer.
+     * @param buffer Optional storage with at least the rounded up capacity, if nullptr the storage is allocated.
+     */
+    explicit SPSCRingBuffer(size_t capacity, T* buffer = nullptr)
+    {
+        size_t size = (capacity > 0) ? 1 : 0;
+        while (size < capacity)
+            size <<= 1;
+        m_capacity = size;
+        m_mask = (size > 0) ? size - 1 : 0;
+        m_allocated = (buffer || size == 0) ? nullptr : new T[size];
+        m_buffer = buffer ? buffer : m_allocated;
+    }
+    virtual ~SPSCRingBuffer()
+    {
+        if (m_allocated)
+            delete[] m_allocated;
+    }
+
+    SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+    SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    // only call this if neither the producer nor the consumer is active
+    void reset()
+    {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+    // producer
+    // ------------------------------------------------------------------------
+
+    // number of elements that can be written
+    size_t free() const
+    {
+        return capacity() - (m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire));
+    }
+    bool full() const { return free() == 0; }
+
+    bool push(const T& value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == capacity())
+            return false;
+        m_buffer[head & m_mask] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // copies as many elements as possible (max. two memcpy), returns the number of elements written
+    size_t write(const T* data, size_t count)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t num_free = capacity() - (head - m_tail.load(std::memory_order_acquire));
+        if (count > num_free)
+            count = num_free;
+        if (count == 0)
+            return 0;
+        copyIn(head, data, count);
+        m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // returns the contiguous free region at the head, count is its length
+    T* write_span(size_t& count)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t num_free = capacity() - (head - m_tail.load(std::memory_order_acquire));
+        const size_t to_end = capacity() - (head & m_mask);
+        count = (num_free < to_end) ? num_free : to_end;
+        return &m_buffer[head & m_mask];
+    }
+
+    // hands count elements written via write_span() over to the consumer
+    void write_commit(size_t count)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // consumer
+    // ------------------------------------------------------------------------
+
+    // number of elements that can be read
+    size_t size() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed);
+    }
+    bool empty() const { return size() == 0; }
+
+    bool pop(T& value)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_head.load(std::memory_order_acquire) == tail)
+            return false;
+        value = m_buffer[tail & m_mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // copies as many elements as possible (max. two memcpy), returns the number of elements read
+    size_t read(T* data, size_t count)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t num_used = m_head.load(std::memory_order_acquire) - tail;
+        if (count > num_used)
+            count = num_used;
+        if (count == 0)
+            return 0;
+        copyOut(tail, data, count);
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // returns the contiguous used region at the tail, count is its length
+    const T* read_span(size_t& count)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t num_used = m_head.load(std::memory_order_acquire) - tail;
+        const size_t to_end = capacity() - (tail & m_mask);
+        count = (num_used < to_end) ? num_used : to_end;
+        return &m_buffer[tail & m_mask];
+    }
+
+    // releases count elements read via read_span() to the producer
+    void read_commit(size_t count)
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    T* m_buffer;
+    T* m_allocated;
+    size_t m_capacity;
+    size_t m_mask;
+    std::atomic<size_t> m_head{0}; // written by the producer only
+    std::atomic<size_t> m_tail{0}; // written by the consumer only
+
+    void copyIn(size_t head, const T* data, size_t count)
+    {
+        const size_t ind = head & m_mask;
+        const size_t first = (count < capacity() - ind) ? count : capacity() - ind;
+        memcpy(&m_buffer[ind], data, first * sizeof(T));
+        memcpy(&m_buffer[0], data + first, (count - first) * sizeof(T));
+    }
+
+    void copyOut(size_t tail, T* data, size_t count) const
+    {
+        const size_t ind = tail & m_mask;
+        const size_t first = (count < capacity() - ind) ? count : capacity() - ind;
+        memcpy(data, &m_buffer[ind], first * sizeof(T));
+        memcpy(data + first, &m_buffer[0], (count - first) * sizeof(T));
+    }
+};
+
+#endif /* SPSC_RING_BUFFER_H_ */
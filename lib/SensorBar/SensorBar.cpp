@@ -1,14 +1,84 @@
 #include "SensorBar.h"
 
+// position value and number of active leds for every raw byte, computed at compile time
+struct SensorBarTable {
+    uint8_t positionValue[256];
+    uint8_t nrOfLedsActive[256];
+
+    constexpr SensorBarTable() : positionValue(), nrOfLedsActive()
+    {
+        for (int raw = 0; raw < 256; raw++) {
+            //Assign values to each bit, -127 to 127, sum, and divide
+            int accumulator = 0;
+            int bitsCounted = 0;
+            for (int i = 0; i < 8; i++) {
+                if (((raw >> i) & 0x01) == 0)
+                    continue;
+                bitsCounted++;
+                //Find the vector value of each positive bit, negative side bits 7 to 4, positive side bits 0 to 3
+                accumulator += (i > 3) ? ((-32 * (i - 3)) + 1) : ((32 * (4 - i)) - 1);
+            }
+            positionValue[raw] = (bitsCounted > 0) ? static_cast<uint8_t>((accumulator / bitsCounted) & 0xFF) : 0;
+            nrOfLedsActive[raw] = static_cast<uint8_t>(bitsCounted);
+        }
+    }
+};
+
+static constexpr SensorBarTable SENSOR_BAR_TABLE{};
+
 SensorBar::SensorBar(PinName sda,
+                     PinName scl,
+                     float bar_dist,
+                     bool run_as_thread) : SensorBar(nullptr, nullptr, sda, scl, bar_dist, run_as_thread)
+{
+}
+
+SensorBar::SensorBar(ControlScheduler& scheduler,
+                     PinName sda,
+                     PinName scl,
+                     float bar_dist) : SensorBar(&scheduler, nullptr, sda, scl, bar_dist, false)
+{
+}
+
+SensorBar::SensorBar(I2CBus& bus,
+                     float bar_dist,
+                     bool run_as_thread) : SensorBar(nullptr, &bus, NC, NC, bar_dist, run_as_thread)
+{
+}
+
+SensorBar::SensorBar(ControlScheduler& scheduler,
+                     I2CBus& bus,
+                     float bar_dist) : SensorBar(&scheduler, &bus, NC, NC, bar_dist, false)
+{
+}
+
+SensorBar::SensorBar(ControlScheduler* scheduler,
+                     I2CBus* bus,
+                     PinName sda,
                      PinName scl,
                      float bar_dist,
                      bool run_as_thread) : distAxisToSensor(bar_dist)
-                                         , i2c(sda, scl)
+                                         , i2c(bus ? nullptr : new I2C(sda, scl))
+                                         , bus(bus)
                                          , thread(osPriorityAboveNormal2, 4096)
+                                         , scheduler(nullptr)
+                                         , taskId(-1)
 {
+    timer.start();
+    sampleTimeUs = 0;
+    sampleCount = 0;
+#if SENSOR_BAR_USE_ASYNC_I2C
+    sampleState = SampleState::Idle;
+    eventQueue = mbed_highprio_event_queue();
+    txData[0] = txData[1] = rxData = 0;
+    transferDoneUs = 0;
+#endif
+
     // Store the received parameters into member variables
     deviceAddress = 0x3E<<1;
+    if (bus) {
+        bus->addDevice(deviceAddress);
+    }
     pinInterrupt = 255;
     pinOscillator = 255;
     pinReset = 255;
@@ -22,23 +92,49 @@ SensorBar::SensorBar(PinName sda,
     avgFilterAngle.init(AVG_FILTER_ANGLE_N);
     isFirstAvgAngle = true;
 
+    // the history starts with all leds off like the former AvgFilter per led
+    for (int i = 0; i < AVG_FILTER_BITS_N; ++i) {
+        bitsHistory[i] = 0;
+    }
+    bitsHistoryIdx = 0;
     for (int i = 0; i < 8; ++i) {
-        avgFilterBits[i].init(AVG_FILTER_BITS_N);
+        bitsCount[i] = 0;
     }
 
     clearBarStrobe();  // to illuminate all the time
     clearInvertBits(); // to make the bar look for a dark line on a reflective surface
 
     if (run_as_thread && begin()) {
+#if SENSOR_BAR_USE_ASYNC_I2C
+        // the ticker starts the sequence directly, no own thread is needed
+        threadFlag.release();
+        ticker.attach(callback(this, &SensorBar::startSample), std::chrono::microseconds{PERIOD_MUS});
+#else
         thread.start(callback(this, &SensorBar::updateAsThread));
         ticker.attach(callback(this, &SensorBar::sendThreadFlag), std::chrono::microseconds{PERIOD_MUS});
+#endif
+    } else if (!run_as_thread) {
+        // update() is called from outside, e.g. LineFollower or ControlScheduler
+        threadFlag.release();
+        if (scheduler && begin()) {
+            this->scheduler = scheduler;
+            taskId = scheduler->registerTaskWithPeriod(callback(this, &SensorBar::update), PERIOD_MUS);
+        }
     }
 }
 
 SensorBar::~SensorBar()
 {
+    if (scheduler)
+        scheduler->unregisterTask(taskId);
     ticker.detach();
+#if SENSOR_BAR_USE_ASYNC_I2C
+    strobeTimeout.detach();
+    if (i2c && sampleState != SampleState::Idle)
+        i2c->abort_transfer();
+#endif
     thread.terminate();
+    delete i2c;
 }
 
 //Call .setBarStrobing(); to only illuminate while reading line
@@ -73,75 +169,81 @@ void SensorBar::clearInvertBits()
 
 uint8_t SensorBar::getRaw() const
 {
-    return lastBarRawValue;
+    return barData.read().rawValue;
 }
 
 int8_t SensorBar::getBinaryPosition() const
 {
-    return -lastBarPositionValue;
+    return -barData.read().positionValue;
 }
 
 float SensorBar::getAngleRad() const
 {
-    return angle;
+    return barData.read().angle;
 }
 
 float SensorBar::getAvgAngleRad() const
 {
-    return avgAngle;
+    return barData.read().avgAngle;
 }
 
 uint8_t SensorBar::getNrOfLedsActive() const
 {
-    return nrOfLedsActive;
+    return barData.read().nrOfLedsActive;
 }
 
 bool SensorBar::isAnyLedActive() const
 {
-    if(nrOfLedsActive != 0)
+    if(barData.read().nrOfLedsActive != 0)
         return true;
     return false;
 }
 
+// bitNumber 0 is the leftmost led (bit 7 of the raw value), the counts are exact so no constraining is needed
 float SensorBar::getAvgBit(int bitNumber) const {
     if (bitNumber < 0 || bitNumber >= 8)
         return 0.0f;
-    // constrain the value
-    const float avgBit = avgFilterBits[bitNumber].read();
-    return constrainIntoZeroToOne(avgBit);
+    return static_cast<float>(barData.read().bitsCount[7 - bitNumber]) * (1.0f / AVG_FILTER_BITS_N);
 }
 
 float SensorBar::getMeanThreeAvgBitsLeft() const {
     // Leftmost 3 bits
-    const float avgBits = 1.0f / 3.0f * ( avgFilterBits[0].read()
-                                        + avgFilterBits[1].read()
-                                        + avgFilterBits[2].read() );
-    return constrainIntoZeroToOne(avgBits);
+    const BarData data = barData.read();
+    return static_cast<float>(data.bitsCount[7] + data.bitsCount[6] + data.bitsCount[5]) * (1.0f / (3.0f * AVG_FILTER_BITS_N));
 }
 
 float SensorBar::getMeanThreeAvgBitsRight() const {
     // Rightmost 3 bits
-    const float avgBits = 1.0f / 3.0f * ( avgFilterBits[5].read()
-                                        + avgFilterBits[6].read()
-                                        + avgFilterBits[7].read() );
-    return constrainIntoZeroToOne(avgBits);
+    const BarData data = barData.read();
+    return static_cast<float>(data.bitsCount[2] + data.bitsCount[1] + data.bitsCount[0]) * (1.0f / (3.0f * AVG_FILTER_BITS_N));
+}
+
+uint32_t SensorBar::getSampleCount() const
+{
+    return barData.read().sampleCount;
+}
+
+uint32_t SensorBar::getSampleAgeUs() const
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(timer.elapsed_time()).count()) - barData.read().sampleTimeUs;
 }
 
 float SensorBar::getMeanFourAvgBitsCenter() const {
-    // Center 4 bits
-    const float avgBits = 1.0f / 3.0f * ( avgFilterBits[2].read()
-                                        + 1.0f / 2.0f * ( avgFilterBits[3].read() + avgFilterBits[4].read() )
-                                        + avgFilterBits[5].read() );
-    return constrainIntoZeroToOne(avgBits);
+    // Center 4 bits, the two inner bits count half
+    const BarData data = barData.read();
+    return static_cast<float>(2 * data.bitsCount[5] + data.bitsCount[4] + data.bitsCount[3] + 2 * data.bitsCount[2]) * (1.0f / (6.0f * AVG_FILTER_BITS_N));
 }
 
-void SensorBar::update()
+void SensorBar::attachSampleCallback(Callback<void()> func)
 {
-    //Assign values to each bit, -127 to 127, sum, and divide
-    int16_t accumulator = 0;
-    uint8_t bitsCounted = 0;
-    int16_t i;
+    sampleCallback = func;
+}
 
+void SensorBar::update()
+{
+#if SENSOR_BAR_USE_ASYNC_I2C
+    startSample();
+#else
     //Get the information from the wire, stores in lastBarRawValue
     if( barStrobe == 1 ) {
         writeByte(REG_DATA_B, 0x02); //Turn on IR
@@ -151,46 +253,140 @@ void SensorBar::update()
         writeByte(REG_DATA_B, 0x00); //make sure both IR and indicators are on
     }
     //Operate the I2C machine
-    lastBarRawValue = readByte( REG_DATA_A ); //Peel the data off port A
-
-    //Invert the bits if needed
-    if( invertBits == 1 ) {
-        lastBarRawValue ^= 0xFF;
-    }
+    const uint8_t rawValue = readByte( REG_DATA_A ); //Peel the data off port A
+    const uint32_t timeUs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(timer.elapsed_time()).count());
 
     //Turn off IR and feedback when done
     if( barStrobe == 1 ) {
         writeByte(REG_DATA_B, 0x03);
     }
 
-    //count bits
-    for ( i = 0; i < 8; i++ ) {
-        if ( ((lastBarRawValue >> i) & 0x01) == 1 ) {
-            bitsCounted++;
-        }
+    publish(rawValue, timeUs);
+#endif
+}
+
+#if SENSOR_BAR_USE_ASYNC_I2C
+// starts the strobe/read sequence, called by update() or the ticker, also from interrupt context
+void SensorBar::startSample()
+{
+    // a sequence that is still running is not interrupted, this sample is skipped
+    SampleState expected = SampleState::Idle;
+    if (!sampleState.compare_exchange_strong(expected, SampleState::Start))
+        return;
+    postSampleStep();
+}
+
+// I2C::transfer() locks a mutex, so the next step is not executed in the interrupt but in the event queue
+void SensorBar::postSampleStep()
+{
+    if (eventQueue->call(callback(this, &SensorBar::sampleStep)) == 0)
+        sampleState = SampleState::Idle; // queue is full
+}
+
+// one step of the sequence, every step either starts a transfer or the strobe timeout,
+// which post the next step when they are done
+void SensorBar::sampleStep()
+{
+    switch (sampleState) {
+        case SampleState::Start:
+            if( barStrobe == 1 ) {
+                sampleState = SampleState::IrOn;
+                txData[1] = 0x02; //Turn on IR
+            } else {
+                sampleState = SampleState::LedsOn;
+                txData[1] = 0x00; //make sure both IR and indicators are on
+            }
+            txData[0] = REG_DATA_B;
+            transferAsync(2, 0);
+            break;
+
+        case SampleState::IrOn:
+            // wait until the sensors settled
+            sampleState = SampleState::Settled;
+            strobeTimeout.attach(callback(this, &SensorBar::postSampleStep), std::chrono::microseconds{STROBE_SETTLE_MUS});
+            break;
+
+        case SampleState::Settled:
+            sampleState = SampleState::LedsOn;
+            txData[0] = REG_DATA_B;
+            txData[1] = 0x00; //Turn on feedback
+            transferAsync(2, 0);
+            break;
+
+        case SampleState::LedsOn:
+            sampleState = SampleState::Read;
+            txData[0] = REG_DATA_A; //Peel the data off port A
+            transferAsync(1, 1);
+            break;
+
+        case SampleState::Read:
+            publish(rxData, transferDoneUs);
+            if( barStrobe == 1 ) {
+                sampleState = SampleState::IrOff;
+                txData[0] = REG_DATA_B;
+                txData[1] = 0x03; //Turn off IR and feedback when done
+                transferAsync(2, 0);
+            } else {
+                sampleState = SampleState::Idle;
+            }
+            break;
+
+        case SampleState::IrOff:
+        default:
+            sampleState = SampleState::Idle;
+            break;
     }
+}
 
-    //Find the vector value of each positive bit and sum
-    for ( i = 7; i > 3; i-- ) { //iterate negative side bits
-        if ( ((lastBarRawValue >> i) & 0x01) == 1 ) {
-            accumulator += ((-32 * (i - 3)) + 1);
-        }
+bool SensorBar::transferAsync(int txLength, int rxLength)
+{
+    // on the shared bus the callback is executed in the bus thread with 0 on success
+    const bool isStarted = bus ? bus->transfer(deviceAddress, txData, txLength, &rxData, rxLength,
+                                               callback(this, &SensorBar::onTransferDone))
+                               : i2c->transfer(deviceAddress, reinterpret_cast<const char*>(txData), txLength,
+                                               reinterpret_cast<char*>(&rxData), rxLength,
+                                               callback(this, &SensorBar::onTransferDone), I2C_EVENT_ALL) == 0;
+    if (!isStarted) {
+        // bus is busy, the sample is skipped
+        sampleState = SampleState::Idle;
+        return false;
     }
-    for ( i = 0; i < 4; i++ ) { //iterate positive side bits
-        if ( ((lastBarRawValue >> i) & 0x01) == 1 ) {
-            accumulator += ((32 * (4 - i)) - 1);
-        }
+    return true;
+}
+
+// called from the I2C interrupt or the bus thread
+void SensorBar::onTransferDone(int event)
+{
+    if (event & (I2C_EVENT_ERROR | I2C_EVENT_ERROR_NO_SLAVE | I2C_EVENT_TRANSFER_EARLY_NACK)) {
+        // nack or bus error, the sample is skipped
+        sampleState = SampleState::Idle;
+        return;
     }
+    transferDoneUs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(timer.elapsed_time()).count());
+    postSampleStep();
+}
+#endif
 
-    if ( bitsCounted > 0 ) {
-        lastBarPositionValue = accumulator / bitsCounted;
-    } else {
-        lastBarPositionValue = 0;
+// processes a raw value and makes it available to the getters
+void SensorBar::publish(uint8_t rawValue, uint32_t timeUs)
+{
+    lastBarRawValue = rawValue;
+
+    //Invert the bits if needed
+    if( invertBits == 1 ) {
+        lastBarRawValue ^= 0xFF;
+    }
+
+    //Position and number of active leds from the table, the angle only changes with the raw value
+    const bool isRawValueChanged = (lastBarRawValue != lastBarRawValueAngle);
+    lastBarPositionValue = SENSOR_BAR_TABLE.positionValue[lastBarRawValue];
+    nrOfLedsActive = SENSOR_BAR_TABLE.nrOfLedsActive[lastBarRawValue];
+    if (isRawValueChanged) {
+        angle = updateAngleRad();
+        lastBarRawValueAngle = lastBarRawValue;
     }
 
     //Update average filters
-    angle = updateAngleRad();
-    nrOfLedsActive = updateNrOfLedsActive();
 
     if(nrOfLedsActive == 0) {
         if(!isFirstAvgAngle) {
@@ -205,10 +401,35 @@ void SensorBar::update()
         avgAngle = avgFilterAngle.apply(angle);
     }
 
-    for (int i = 0; i < 8; ++i) {
-        bool bit = (lastBarRawValue >> i) & 0x01;
-        avgFilterBits[7 - i].apply(static_cast<float>(bit));
+    //Sliding window over the last AVG_FILTER_BITS_N raw values, only the bits that differ from the
+    //value that leaves the window change the counts
+    const uint8_t oldestRawValue = bitsHistory[bitsHistoryIdx];
+    bitsHistory[bitsHistoryIdx] = lastBarRawValue;
+    if (++bitsHistoryIdx == AVG_FILTER_BITS_N)
+        bitsHistoryIdx = 0;
+    uint8_t changedBits = oldestRawValue ^ lastBarRawValue;
+    while (changedBits) {
+        const uint8_t i = __builtin_ctz(changedBits);
+        bitsCount[i] += ((lastBarRawValue >> i) & 0x01) ? 1 : -1;
+        changedBits &= changedBits - 1;
     }
+
+    sampleTimeUs = timeUs;
+    sampleCount++;
+
+    BarData data;
+    data.rawValue = lastBarRawValue;
+    data.positionValue = lastBarPositionValue;
+    data.nrOfLedsActive = nrOfLedsActive;
+    memcpy(data.bitsCount, bitsCount, sizeof(bitsCount));
+    data.angle = angle;
+    data.avgAngle = avgAngle;
+    data.sampleTimeUs = sampleTimeUs;
+    data.sampleCount = sampleCount;
+    barData.publish(data);
+
+    if (sampleCallback)
+        sampleCallback();
 }
 
 //****************************************************************************//
@@ -260,10 +481,14 @@ void SensorBar::reset()
 //
 uint8_t SensorBar::readByte(uint8_t registerAddress)
 {
-    uint8_t readValue;
+    uint8_t readValue = 0;
+    if (bus) {
+        bus->readRegistersBlocking(deviceAddress, registerAddress, &readValue, 1);
+        return readValue;
+    }
     uint8_t data[2] = {registerAddress, 0};
-    i2c.write(deviceAddress, reinterpret_cast<char*>(data), 1);
-    i2c.read(deviceAddress, reinterpret_cast<char*>(&readValue), 1);
+    i2c->write(deviceAddress, reinterpret_cast<char*>(data), 1);
+    i2c->read(deviceAddress, reinterpret_cast<char*>(&readValue), 1);
 
     return readValue;
 }
@@ -278,9 +503,13 @@ unsigned int SensorBar::readWord(uint8_t registerAddress)
     unsigned int readValue;
     unsigned int msb, lsb;
     uint8_t data[2] = {registerAddress, 0};
-    uint8_t r_data[2];
-    i2c.write(deviceAddress, reinterpret_cast<char*>(data), 1);
-    i2c.read(deviceAddress, reinterpret_cast<char*>(r_data), 2);
+    uint8_t r_data[2] = {0, 0};
+    if (bus) {
+        bus->readRegistersBlocking(deviceAddress, registerAddress, r_data, 2);
+    } else {
+        i2c->write(deviceAddress, reinterpret_cast<char*>(data), 1);
+        i2c->read(deviceAddress, reinterpret_cast<char*>(r_data), 2);
+    }
     msb = ((unsigned int)r_data[0] & 0x00FF) << 8;
     lsb = ((unsigned int)r_data[1] & 0x00FF);
     readValue = msb | lsb;
@@ -296,9 +525,13 @@ unsigned int SensorBar::readWord(uint8_t registerAddress)
 //  - No return value.
 void SensorBar::readBytes(uint8_t firstRegisterAddress, uint8_t * destination, uint8_t length)
 {
+    if (bus) {
+        bus->readRegistersBlocking(deviceAddress, firstRegisterAddress, destination, length);
+        return;
+    }
     uint8_t data[2] = {firstRegisterAddress, 0};
-    i2c.write(deviceAddress, reinterpret_cast<char*>(data), 1);
-    i2c.read(deviceAddress, reinterpret_cast<char*>(destination), length);
+    i2c->write(deviceAddress, reinterpret_cast<char*>(data), 1);
+    i2c->read(deviceAddress, reinterpret_cast<char*>(destination), length);
 }
 
 // writeByte(uint8_t registerAddress, uint8_t writeValue)
@@ -308,8 +541,12 @@ void SensorBar::readBytes(uint8_t firstRegisterAddress, uint8_t * destination, u
 //  - No return value.
 void SensorBar::writeByte(uint8_t registerAddress, uint8_t writeValue)
 {
+    if (bus) {
+        bus->writeRegistersBlocking(deviceAddress, registerAddress, &writeValue, 1);
+        return;
+    }
     uint8_t data[2] = {registerAddress, writeValue};
-    i2c.write(deviceAddress, reinterpret_cast<char*>(data), 2);
+    i2c->write(deviceAddress, reinterpret_cast<char*>(data), 2);
 }
 
 // writeWord(uint8_t registerAddress, ungisnged int writeValue)
@@ -323,7 +560,11 @@ void SensorBar::writeWord(uint8_t registerAddress, unsigned int writeValue)
     msb = ((writeValue & 0xFF00) >> 8);
     lsb = (writeValue & 0x00FF);
     uint8_t data[3] = {registerAddress, msb, lsb};
-    i2c.write(deviceAddress, reinterpret_cast<char*>(data), 3);
+    if (bus) {
+        bus->writeRegistersBlocking(deviceAddress, registerAddress, &data[1], 2);
+        return;
+    }
+    i2c->write(deviceAddress, reinterpret_cast<char*>(data), 3);
 }
 
 // writeBytes(uint8_t firstRegisterAddress, uint8_t * writeArray, uint8_t length)
@@ -340,7 +581,11 @@ void SensorBar::writeBytes(uint8_t firstRegisterAddress, const uint8_t * writeAr
     for(int i = 0; i < length; i++) {
         data[1+i] = writeArray[i];
     }
-    i2c.write(deviceAddress, reinterpret_cast<char*>(data), length+1);
+    if (bus) {
+        bus->writeRegistersBlocking(deviceAddress, firstRegisterAddress, writeArray, length);
+        return;
+    }
+    i2c->write(deviceAddress, reinterpret_cast<char*>(data), length+1);
 }
 
 void SensorBar::updateAsThread()
@@ -353,30 +598,11 @@ void SensorBar::updateAsThread()
 
 float SensorBar::updateAngleRad()
 {
-    int8_t binaryPosition  = getBinaryPosition();
+    int8_t binaryPosition  = -lastBarPositionValue;
     float position = static_cast<float>(binaryPosition) / 127.0f * 0.0445f; // 0.0445 m is half of sensor length
     return atan2f(position, distAxisToSensor);
 }
 
-uint8_t SensorBar::updateNrOfLedsActive()
-{
-    uint8_t bitsCounted = 0;
-    uint8_t i;
-
-    //count bits
-    for ( i = 0; i < 8; i++ ) {
-        if ( ((lastBarRawValue >> i) & 0x01) == 1 ) {
-            bitsCounted++;
-        }
-    }
-    return bitsCounted;
-}
-
-float SensorBar::constrainIntoZeroToOne(float val) const
-{
-    return val < 0.0f ? 0.0f : val > 1.0f ? 1.0f : val;
-}
-
 void SensorBar::sendThreadFlag()
 {
     thread.flags_set(threadFlag);
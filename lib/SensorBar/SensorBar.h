@@ -1,8 +1,19 @@
 #ifndef SENSOR_BAR_H_
 #define SENSOR_BAR_H_
 
+#include <atomic>
+
 #include "AvgFilter.h"
 #include "ThreadFlag.h"
+#include "ControlScheduler.h"
+#include "I2CBus.h"
+#include "Published.h"
+
+// if this is true and the target supports asynchronous I2C then update() only starts the strobe/read sequence,
+// the sequence continues on the I2C and timeout interrupts and the shared high priority event queue and the
+// result is published when the read is done, so neither the caller nor an own thread is blocked
+#define SENSOR_BAR_DO_USE_ASYNC_I2C true
+#define SENSOR_BAR_USE_ASYNC_I2C (SENSOR_BAR_DO_USE_ASYNC_I2C && DEVICE_I2C_ASYNCH)
 
 #define     REG_INPUT_DISABLE_B     0x00    //  RegInputDisableB Input buffer disable register _ I/O[15_8] (Bank B) 0000 0000
 #define     REG_INPUT_DISABLE_A     0x01    //  RegInputDisableA Input buffer disable register _ I/O[7_0] (Bank A) 0000 0000
@@ -161,6 +172,19 @@ public:
                        PinName scl,
                        float bar_dist,
                        bool run_as_thread = true);
+    // update() is executed by a shared ControlScheduler instead of an own thread,
+    // keep in mind that without SENSOR_BAR_USE_ASYNC_I2C and with setBarStrobe() update() blocks the scheduler for 2 ms
+    explicit SensorBar(ControlScheduler& scheduler,
+                       PinName sda,
+                       PinName scl,
+                       float bar_dist);
+    // the SX1509 is on a shared I2CBus, all register accesses are transactions of the bus
+    explicit SensorBar(I2CBus& bus,
+                       float bar_dist,
+                       bool run_as_thread = true);
+    explicit SensorBar(ControlScheduler& scheduler,
+                       I2CBus& bus,
+                       float bar_dist);
     virtual ~SensorBar();
 
     static constexpr int64_t PERIOD_MUS = 4000;
@@ -180,14 +204,24 @@ public:
     float getMeanThreeAvgBitsLeft() const;
     float getMeanThreeAvgBitsRight() const;
     float getMeanFourAvgBitsCenter() const;
+    uint32_t getSampleCount() const;  // number of published samples
+    uint32_t getSampleAgeUs() const;  // time since the published raw value was read
+    // with SENSOR_BAR_USE_ASYNC_I2C this starts a new sample and returns immediately, the getters return the
+    // last published sample until the new one is done
     void update();
+    // func is called after every published sample, in the context that read it (the shared high priority event
+    // queue with SENSOR_BAR_USE_ASYNC_I2C, otherwise the caller of update()), so it must not block, attach it
+    // before the sampling starts
+    void attachSampleCallback(Callback<void()> func);
 
 private:
     static constexpr int AVG_FILTER_ANGLE_N = 10;
     static constexpr int AVG_FILTER_BITS_N = 30;
+    static constexpr int64_t STROBE_SETTLE_MUS = 2000; // ir leds on until the sensors are read
 
     // holding variables
     uint8_t lastBarRawValue;
+    uint8_t lastBarRawValueAngle{0}; // raw value the angle was computed for
     uint8_t lastBarPositionValue;
     float distAxisToSensor;
 
@@ -214,22 +248,69 @@ private:
     void writeWord(uint8_t registerAddress, unsigned int writeValue);
     void writeBytes(uint8_t firstRegisterAddress, const uint8_t * writeArray, uint8_t length);
 
-    I2C i2c;
+    I2C* i2c;    // own I2C object, nullptr if the bus is used
+    I2CBus* bus; // shared bus, nullptr if the own I2C object is used
 
     ThreadFlag threadFlag;
     Thread     thread;
     Ticker     ticker;
+    ControlScheduler* scheduler;
+    int taskId;
+
+    Timer timer;
+    uint32_t sampleTimeUs;
+    uint32_t sampleCount;
+
+#if SENSOR_BAR_USE_ASYNC_I2C
+    enum class SampleState : uint8_t {Idle, Start, IrOn, Settled, LedsOn, Read, IrOff};
+    std::atomic<SampleState> sampleState;
+    Timeout strobeTimeout;
+    EventQueue* eventQueue;
+    uint8_t txData[2];  // buffers of the running transfer
+    uint8_t rxData;
+    uint32_t transferDoneUs;
+
+    void startSample();
+    void postSampleStep();
+    void sampleStep();
+    bool transferAsync(int txLength, int rxLength);
+    void onTransferDone(int event);
+#endif
 
     float angle, avgAngle;
     uint8_t nrOfLedsActive;
     AvgFilter avgFilterAngle;
     bool isFirstAvgAngle;
-    AvgFilter avgFilterBits[8];
+
+    // moving average of every led, the last AVG_FILTER_BITS_N raw values and how often every bit is set in them
+    uint8_t bitsHistory[AVG_FILTER_BITS_N];
+    uint8_t bitsHistoryIdx;
+    uint8_t bitsCount[8];
+
+    // everything the getters return, publish() writes it once per sample, so the getters can be called from
+    // any thread and always see one complete sample
+    struct BarData {
+        uint8_t rawValue;
+        uint8_t positionValue;
+        uint8_t nrOfLedsActive;
+        uint8_t bitsCount[8];
+        float angle, avgAngle;
+        uint32_t sampleTimeUs;
+        uint32_t sampleCount;
+    };
+    Published<BarData> barData;
+    Callback<void()> sampleCallback; // called at the end of publish()
+
+    explicit SensorBar(ControlScheduler* scheduler,
+                       I2CBus* bus,
+                       PinName sda,
+                       PinName scl,
+                       float bar_dist,
+                       bool run_as_thread);
 
     void updateAsThread();
+    void publish(uint8_t rawValue, uint32_t timeUs);
     float updateAngleRad();
-    uint8_t updateNrOfLedsActive();
-    float constrainIntoZeroToOne(float val) const;
     void sendThreadFlag();
 };
 
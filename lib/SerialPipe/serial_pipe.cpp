@@ -34,12 +34,14 @@ SerialPipe::~SerialPipe(void)
 // tx channel
 int SerialPipe::writeable(void)    
 {
-    return _pipeTx.free();
+    return (int)_pipeTx.free();
 }
 
 int SerialPipe::putc(int c)    
 {
-    c = _pipeTx.putc(c);
+    // the ring buffer does not block, wait for space here
+    while (!_pipeTx.push((char)c))
+        /* nothing / just wait */;
     txStart();
     return c;
 }
@@ -50,7 +52,7 @@ int SerialPipe::put(const void* buffer, int length, bool blocking)
     const char* ptr = (const char*)buffer;
     if (count) {
         do {
-            int written = _pipeTx.put(ptr, count, false);
+            int written = (int)_pipeTx.write(ptr, count);
             if (written) {
                 ptr += written;
                 count -= written;
@@ -69,8 +71,8 @@ int SerialPipe::put(const void* buffer, int length, bool blocking)
 
 void SerialPipe::txCopy(void)
 {
-    while (_SerialPipeBase::writeable() && _pipeTx.readable()) {
-        char c = _pipeTx.getc();
+    char c;
+    while (_SerialPipeBase::writeable() && _pipeTx.pop(c)) {
         _SerialPipeBase::_base_putc(c);
     }
 }
@@ -79,7 +81,7 @@ void SerialPipe::txIrqBuf(void)
 {
     txCopy();
     // detach tx isr if we are done 
-    if (!_pipeTx.readable()) {
+    if (_pipeTx.empty()) {
         attach(NULL, TxIrq);
     }
 }
@@ -90,7 +92,7 @@ void SerialPipe::txStart(void)
     attach(NULL, TxIrq);
     txCopy();
     // attach the tx isr to handle the remaining data
-    if (_pipeTx.readable()) {
+    if (!_pipeTx.empty()) {
         attach(callback(this, &SerialPipe::txIrqBuf), TxIrq);
     }
 }
@@ -98,21 +100,32 @@ void SerialPipe::txStart(void)
 // rx channel
 int SerialPipe::readable(void)                      
 { 
-    return _pipeRx.readable(); 
+    return (int)_pipeRx.size(); 
 } 
 
 int SerialPipe::getc(void)                          
 { 
-    if (!_pipeRx.readable()) {
+    char c;
+    if (!_pipeRx.pop(c)) {
         return EOF;
     }
 
-    return _pipeRx.getc(); 
+    return c; 
 } 
 
 int SerialPipe::get(void* buffer, int length, bool blocking) 
 { 
-    return _pipeRx.get((char*)buffer,length,blocking); 
+    int count = length;
+    char* ptr = (char*)buffer;
+    do {
+        const int read = (int)_pipeRx.read(ptr, count);
+        ptr += read;
+        count -= read;
+        // the ring buffer does not block, wait for data here
+    }
+    while (blocking && count);
+
+    return (length - count);
 }
 
 void SerialPipe::rxIrqBuf(void)
@@ -120,9 +133,7 @@ void SerialPipe::rxIrqBuf(void)
     while (_SerialPipeBase::readable())
     {
         char c = _SerialPipeBase::_base_getc();
-        if (_pipeRx.writeable()) {
-            _pipeRx.putc(c);
-        } else {
+        if (!_pipeRx.push(c)) {
             /* overflow */
         }
     }
@@ -17,7 +17,7 @@
 #define SERIAL_PIPE_H
 
 #include "mbed.h"
-#include "pipe.h"
+#include "SPSCRingBuffer.h"
 
 #define _SerialPipeBase SerialBase //!< base class used by this class
 
@@ -30,8 +30,8 @@ public:
         \param tx the trasmitting pin
         \param rx the receiving pin
         \param baudate the serial baud rate
-        \param rxSize the size of the receiving buffer
-        \param txSize the size of the transmitting buffer
+        \param rxSize the size of the receiving buffer (rounded up to a power of 2)
+        \param txSize the size of the transmitting buffer (rounded up to a power of 2)
     */
     SerialPipe(PinName tx, PinName rx, int baudrate, int rxSize = 128, int txSize = 128);
     
@@ -93,8 +93,8 @@ protected:
     void txStart(void);
     //! move bytes to hardware
     void txCopy(void);
-    Pipe<char> _pipeRx; //!< receive pipe
-    Pipe<char> _pipeTx; //!< transmit pipe
+    SPSCRingBuffer<char> _pipeRx; //!< receive pipe, written by the rx isr
+    SPSCRingBuffer<char> _pipeTx; //!< transmit pipe, read by the tx isr
 };
 
 #endif
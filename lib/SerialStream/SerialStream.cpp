@@ -3,13 +3,16 @@
 SerialStream::SerialStream(PinName tx,
                            PinName rx,
                            uint8_t num_of_floats,
-                           int baudrate) : _buffer_size(sizeof(float) * S_STREAM_CLAMP(num_of_floats))
+                           int baudrate,
+                           const float* scales) : _buffer_size(sizeof(float) * S_STREAM_CLAMP(num_of_floats))
+                                                , _Codec(S_STREAM_CLAMP(num_of_floats), scales)
 #if S_STREAM_DO_USE_SERIAL_PIPE
-                                         , _SerialPipe(tx, rx, baudrate, 1 + 1, // serial pipe extects 1 byte more
-                                                       sizeof(float) * S_STREAM_CLAMP(num_of_floats) + 1)
+                                                , _SerialPipe(tx, rx, baudrate, 1, // tx has room for two frames
+                                                              2 * (S_STREAM_FRAME_HEADER_SIZE + (scales ? TELEMETRY_CODEC_RECORD_SIZE_MAX(S_STREAM_CLAMP(num_of_floats))
+                                                                                                        : sizeof(float) * S_STREAM_CLAMP(num_of_floats))))
 {
 #else
-                                         , _BufferedSerial(tx, rx, baudrate)
+                                                , _BufferedSerial(tx, rx, baudrate)
 {
     _BufferedSerial.set_blocking(false);
 #endif
@@ -17,7 +20,10 @@ SerialStream::SerialStream(PinName tx,
 
 void SerialStream::write(const float val)
 {
-    memcpy(&_buffer[_byte_cntr], &val, sizeof(float));
+    if (_Codec.isEnabled())
+        _values[_byte_cntr / sizeof(float)] = val;
+    else
+        memcpy(&_buffer[S_STREAM_FRAME_HEADER_SIZE + _byte_cntr], &val, sizeof(float));
     _byte_cntr += sizeof(float);
 
     // send the data if the buffer is full immediately
@@ -35,16 +41,32 @@ void SerialStream::send()
     // and it will not occupy the buffer for actual data to be sent
     sendNumOfFloatsOnce();
 
-#if S_STREAM_DO_USE_SERIAL_PIPE
-    // TODO: handle case where bytes_writeable < _byte_cntr
-    const int bytes_writeable = _SerialPipe.writeable();
-    if (bytes_writeable > 0)
-        _SerialPipe.put(&_buffer, _byte_cntr, false);
-#else
-    // TODO: handle case where bytes_written < _byte_cntr
-    if (_BufferedSerial.writable())
-        ssize_t bytes_written = _BufferedSerial.write(_buffer, _byte_cntr);
-#endif
+    // continue the frame that could only be written partially before
+    if (_pending_cntr > 0) {
+        const int bytes_written = writeBytes(&_pending[_pending_ind], _pending_cntr);
+        _pending_ind += bytes_written;
+        _pending_cntr -= bytes_written;
+    }
+
+    if (_pending_cntr > 0) {
+        // the previous frame is still not sent completely, drop this one so that frames never get
+        // interleaved, the host sees the gap in the sequence numbers
+        _num_of_dropped_frames++;
+    } else {
+        memcpy(&_buffer[0], &_sequence_number, sizeof(uint16_t));
+        memcpy(&_buffer[2], &_num_of_dropped_frames, sizeof(uint16_t));
+        // only frames that are sent are encoded, so the differences stay valid if frames are dropped
+        const int frame_size = S_STREAM_FRAME_HEADER_SIZE + (_Codec.isEnabled() ? _Codec.encode(_values, _byte_cntr / sizeof(float), &_buffer[S_STREAM_FRAME_HEADER_SIZE])
+                                                                                : _byte_cntr);
+        const int bytes_written = writeBytes(_buffer, frame_size);
+        if (bytes_written < frame_size) {
+            // keep the rest, it is sent with the next call
+            _pending_ind = 0;
+            _pending_cntr = frame_size - bytes_written;
+            memcpy(_pending, &_buffer[bytes_written], _pending_cntr);
+        }
+    }
+    _sequence_number++;
     _byte_cntr = 0;
 }
 
@@ -57,6 +79,11 @@ void SerialStream::reset()
 {
     memset(&_buffer, 0, sizeof(_buffer));
     _byte_cntr = 0;
+    _pending_ind = 0;
+    _pending_cntr = 0;
+    _sequence_number = 0;
+    _num_of_dropped_frames = 0;
+    _Codec.reset();
     resetByteMsg(_start);
     _send_num_of_floats_once = false;
 }
@@ -88,12 +115,35 @@ void SerialStream::resetByteMsg(byte_msg_t& byte_msg)
     byte_msg.received = false;
 }
 
+int SerialStream::writeBytes(const char* data, int length)
+{
+#if S_STREAM_DO_USE_SERIAL_PIPE
+    return _SerialPipe.put(data, length, false);
+#else
+    if (!_BufferedSerial.writable())
+        return 0;
+    const ssize_t bytes_written = _BufferedSerial.write(data, length);
+    return (bytes_written > 0) ? static_cast<int>(bytes_written) : 0;
+#endif
+}
+
 void SerialStream::sendNumOfFloatsOnce()
 {
     if (_send_num_of_floats_once)
         return;
     else {
         _send_num_of_floats_once = true;
+        if (_Codec.isEnabled()) {
+            // the num_of_floats byte with the codec flag followed by the scales
+            char header[1 + sizeof(float) * S_STREAM_NUM_OF_FLOATS_MAX];
+            const int header_size = _Codec.writeHeader(header);
+#if S_STREAM_DO_USE_SERIAL_PIPE
+            _SerialPipe.put(header, header_size, true);
+#else
+            _BufferedSerial.write(header, header_size);
+#endif
+            return;
+        }
         const uint8_t num_of_floats = _byte_cntr / sizeof(float);
 #if S_STREAM_DO_USE_SERIAL_PIPE
         _SerialPipe.put(&num_of_floats, 1, true);
@@ -14,17 +14,23 @@
 #else
     #include "mbed.h"
 #endif
+#include "TelemetryCodec.h"
 
-#define S_STREAM_NUM_OF_FLOATS_MAX 30 // tested at 2 kHz 20 floats
+#define S_STREAM_NUM_OF_FLOATS_MAX 60 // tested at 2 kHz 20 raw floats, more channels need the TelemetryCodec
 #define S_STREAM_CLAMP(x) (x <= S_STREAM_NUM_OF_FLOATS_MAX ? x : S_STREAM_NUM_OF_FLOATS_MAX)
 #define S_STREAM_START_BYTE 255
+#define S_STREAM_FRAME_HEADER_SIZE 4 // every frame starts with the sequence number (uint16) and the number of dropped frames (uint16)
+#define S_STREAM_FRAME_SIZE_MAX (S_STREAM_FRAME_HEADER_SIZE + TELEMETRY_CODEC_RECORD_SIZE_MAX(S_STREAM_NUM_OF_FLOATS_MAX)) // encoded frames can be longer than raw ones
 
 class SerialStream {
 public:
+    // if scales is not nullptr, the frames are compressed with the TelemetryCodec, scales has to contain num_of_floats
+    // values and you need to write num_of_floats floats per frame
     explicit SerialStream(PinName tx,
                           PinName rx,
                           uint8_t num_of_floats = S_STREAM_NUM_OF_FLOATS_MAX,
-                          int baudrate = 2000000);
+                          int baudrate = 2000000,
+                          const float* scales = nullptr);
     virtual ~SerialStream() = default;
 
     void write(const float val);
@@ -32,10 +38,20 @@ public:
     bool startByteReceived();
     void reset();
 
+    // frames that were dropped because the previous frame was not sent completely yet
+    uint16_t getNumOfDroppedFrames() const { return _num_of_dropped_frames; }
+
 private:
-    char _buffer[sizeof(float) * S_STREAM_NUM_OF_FLOATS_MAX];
-    uint8_t _buffer_size;
-    uint8_t _byte_cntr{0};
+    char _buffer[S_STREAM_FRAME_SIZE_MAX]; // frame that is being assembled, header followed by the floats
+    uint16_t _buffer_size;
+    uint16_t _byte_cntr{0};
+    char _pending[S_STREAM_FRAME_SIZE_MAX]; // rest of a frame that could only be written partially
+    uint16_t _pending_ind{0};
+    uint16_t _pending_cntr{0};
+    uint16_t _sequence_number{0};
+    uint16_t _num_of_dropped_frames{0};
+    TelemetryCodec _Codec;
+    float _values[S_STREAM_NUM_OF_FLOATS_MAX]; // floats of the frame that is being assembled if the codec is used
 #if S_STREAM_DO_USE_SERIAL_PIPE
     SerialPipe _SerialPipe;
 #else
@@ -53,5 +69,7 @@ private:
     bool checkByteReceived(byte_msg_t& byte_msg, const uint8_t byte_expected);
     void resetByteMsg(byte_msg_t& byte_msg);
     void sendNumOfFloatsOnce();
+    // non blocking, returns the number of bytes written
+    int writeBytes(const char* data, int length);
 };
 #endif /* SERIAL_STREAM_H_ */
@@ -10,8 +10,23 @@ Servo::Servo(PinName pin) : m_DigitalOut(pin), m_Thread(osPriorityAboveNormal1)
     m_Thread.start(callback(this, &Servo::threadTask));
 }
 
+Servo::Servo(ControlScheduler& scheduler, PinName pin) : m_DigitalOut(pin),
+                                                         m_Thread(osPriorityAboveNormal1),
+                                                         m_scheduler(&scheduler)
+{
+    // set default motion profile
+    setMaxVelocity();
+    setMaxAcceleration();
+
+    // let the scheduler execute step(), the own thread and thread flag are not used
+    m_ThreadFlag.release();
+    m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &Servo::step), PERIOD_MUS);
+}
+
 Servo::~Servo()
 {
+    if (m_scheduler)
+        m_scheduler->unregisterTask(m_task_id);
     m_Ticker.detach();
     m_Timeout.detach();
     m_Thread.terminate();
@@ -54,7 +69,8 @@ void Servo::enable(float pulse)
     m_Motion.setPosition(m_pulse);
 
     // attach sendThreadFlag() to ticker so that sendThreadFlag() is called periodically, which signals the thread to execute
-    m_Ticker.attach(callback(this, &Servo::sendThreadFlag), std::chrono::microseconds{PERIOD_MUS});
+    if (!m_scheduler)
+        m_Ticker.attach(callback(this, &Servo::sendThreadFlag), std::chrono::microseconds{PERIOD_MUS});
 }
 
 void Servo::disable()
@@ -80,22 +96,26 @@ float Servo::calculateNormalisedPulseWidth(float pulse)
     return constrainPulse((m_pulse_max - m_pulse_min) * pulse + m_pulse_min);
 }
 
-void Servo::threadTask()
+void Servo::step()
 {
-    while (true) {
-        ThisThread::flags_wait_any(m_ThreadFlag);
+    if (isEnabled()) {
+        // increment to position
+        m_Motion.incrementToPosition(m_pulse, TS);
 
-        if (isEnabled()) {
-            // increment to position
-            m_Motion.incrementToPosition(m_pulse, TS);
+        // convert to pulse width
+        const uint16_t pulse_mus = static_cast<uint16_t>(m_Motion.getPosition() * static_cast<float>(PERIOD_MUS));
 
-            // convert to pulse width
-            const uint16_t pulse_mus = static_cast<uint16_t>(m_Motion.getPosition() * static_cast<float>(PERIOD_MUS));
+        // enable digital output and attach disableDigitalOutput() to timeout for soft PWM
+        enableDigitalOutput();
+        m_Timeout.attach(callback(this, &Servo::disableDigitalOutput), std::chrono::microseconds{pulse_mus});
+    }
+}
 
-            // enable digital output and attach disableDigitalOutput() to timeout for soft PWM
-            enableDigitalOutput();
-            m_Timeout.attach(callback(this, &Servo::disableDigitalOutput), std::chrono::microseconds{pulse_mus});
-        }
+void Servo::threadTask()
+{
+    while (true) {
+        ThisThread::flags_wait_any(m_ThreadFlag);
+        step();
     }
 }
 
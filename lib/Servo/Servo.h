@@ -27,14 +27,26 @@
  * servo.setPulseWidth(0.5f); // set servo to mid position
  * ```
  *
+ * With Servo servo(scheduler, PIN_NAME) the servo is executed by a shared ControlScheduler
+ * instead of its own thread.
+ *
  * @author M. Peter / pmic / pichim
  */
 
 #ifndef SERVO_H_
 #define SERVO_H_
 
-#include "Motion.h"
 #include "ThreadFlag.h"
+#include "ControlScheduler.h"
+
+// if this is true then the servo follows the jerk limited SCurve instead of the trapezoidal Motion profile
+#define SERVO_DO_USE_S_CURVE false
+
+#if SERVO_DO_USE_S_CURVE
+#include "SCurve.h"
+#else
+#include "Motion.h"
+#endif
 
 /**
  * @brief Class for smooth control of a servo motor.
@@ -52,6 +64,14 @@ public:
      */
     explicit Servo(PinName pin);
 
+    /**
+     * @brief Construct a new Servo object that is executed by a shared ControlScheduler.
+     *
+     * @param scheduler The scheduler that executes the servo, its period has to be a divisor of 20000 us.
+     * @param pin The pin name to which the servo is connected.
+     */
+    explicit Servo(ControlScheduler& scheduler, PinName pin);
+
     /**
      * @brief Destroy the Servo object.
      */
@@ -113,12 +133,18 @@ private:
     static constexpr float PWM_MAX = 0.99f;
 
     DigitalOut m_DigitalOut;
+#if SERVO_DO_USE_S_CURVE
+    SCurve m_Motion;
+#else
     Motion m_Motion;
+#endif
     Timeout m_Timeout;
 
     Thread m_Thread;
     Ticker m_Ticker;
     ThreadFlag m_ThreadFlag;
+    ControlScheduler* m_scheduler{nullptr};
+    int m_task_id{-1};
 
     bool m_enabled{false};
     float m_pulse{0.0f};
@@ -126,6 +152,7 @@ private:
     float m_pulse_max{1.0f};
 
     float calculateNormalisedPulseWidth(float pulse);
+    void step();
     void threadTask();
     void enableDigitalOutput();
     void disableDigitalOutput();
@@ -0,0 +1,230 @@
+#include "ServoBank.h"
+
+ServoBank::ServoBank() : m_Thread(osPriorityAboveNormal1), m_scheduler(nullptr)
+{
+    m_Timer.start();
+
+    // start thread
+    m_Thread.start(callback(this, &ServoBank::threadTask));
+
+    // attach sendThreadFlag() to ticker so that sendThreadFlag() is called periodically, which signals the thread to execute
+    m_Ticker.attach(callback(this, &ServoBank::sendThreadFlag), std::chrono::microseconds{PERIOD_MUS});
+}
+
+ServoBank::ServoBank(ControlScheduler& scheduler) : m_Thread(osPriorityAboveNormal1), m_scheduler(&scheduler)
+{
+    m_Timer.start();
+
+    // let the scheduler execute step(), the own thread and thread flag are not used
+    m_ThreadFlag.release();
+    m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &ServoBank::step), PERIOD_MUS);
+}
+
+ServoBank::~ServoBank()
+{
+    if (m_scheduler)
+        m_scheduler->unregisterTask(m_task_id);
+    m_Ticker.detach();
+    m_Timeout.detach();
+    m_Thread.terminate();
+    for (int i = 0; i < m_num_of_channels; i++) {
+        *m_channels[i].digital_out = 0;
+        delete m_channels[i].digital_out;
+    }
+}
+
+int ServoBank::addServo(PinName pin)
+{
+    if (m_num_of_channels == SERVO_BANK_NUM_OF_CHANNELS_MAX) {
+        printf("ServoBank: no channel left for the servo\n");
+        return -1;
+    }
+
+    const int channel = m_num_of_channels;
+    m_channels[channel].digital_out = new DigitalOut(pin, 0);
+    m_channels[channel].enabled = false;
+    m_channels[channel].pulse = 0.0f;
+    m_channels[channel].pulse_min = 0.0f;
+    m_channels[channel].pulse_max = 1.0f;
+    m_channels[channel].pulse_mus = 0;
+
+    // the channel is visible to step() from here on
+    m_num_of_channels++;
+
+    // set default motion profile
+    setMaxVelocity(channel);
+    setMaxAcceleration(channel);
+
+    return channel;
+}
+
+void ServoBank::calibratePulseMinMax(int channel, float pulse_min, float pulse_max)
+{
+    if (!isValidChannel(channel))
+        return;
+
+    // set minimal and maximal pulse width
+    m_channels[channel].pulse_min = pulse_min;
+    m_channels[channel].pulse_max = pulse_max;
+}
+
+void ServoBank::setMaxVelocity(int channel, float velocity)
+{
+    if (!isValidChannel(channel))
+        return;
+
+    // convert velocity from calibrated normalised pulse width to normalised pulse width
+    velocity *= (m_channels[channel].pulse_max - m_channels[channel].pulse_min);
+    m_channels[channel].motion.setProfileVelocity(velocity);
+}
+
+void ServoBank::setMaxAcceleration(int channel, float acceleration)
+{
+    if (!isValidChannel(channel))
+        return;
+
+    // convert acceleration from calibrated normalised pulse width to normalised pulse width
+    acceleration *= (m_channels[channel].pulse_max - m_channels[channel].pulse_min);
+    m_channels[channel].motion.setProfileAcceleration(acceleration);
+    m_channels[channel].motion.setProfileDeceleration(acceleration);
+}
+
+void ServoBank::setPulseWidth(int channel, float pulse)
+{
+    if (!isValidChannel(channel))
+        return;
+
+    // after calibrating the mapping from setPulseWidth() is (0, 1) -> (pulse_min, pulse_max)
+    m_channels[channel].pulse = calculateNormalisedPulseWidth(channel, pulse);
+}
+
+void ServoBank::enable(int channel, float pulse)
+{
+    if (!isValidChannel(channel))
+        return;
+
+    // set pulse width when enabled
+    m_channels[channel].pulse = calculateNormalisedPulseWidth(channel, pulse);
+    m_channels[channel].motion.setPosition(m_channels[channel].pulse);
+    m_channels[channel].enabled = true;
+}
+
+void ServoBank::disable(int channel)
+{
+    if (!isValidChannel(channel))
+        return;
+
+    // a running pulse is still ended by its edge, the channel is not part of the next frame
+    m_channels[channel].enabled = false;
+}
+
+bool ServoBank::isEnabled(int channel) const
+{
+    return isValidChannel(channel) && m_channels[channel].enabled;
+}
+
+uint16_t ServoBank::getPulseWidthMus(int channel) const
+{
+    return isValidChannel(channel) ? m_channels[channel].pulse_mus : 0;
+}
+
+float ServoBank::calculateNormalisedPulseWidth(int channel, float pulse) const
+{
+    const channel_t& ch = m_channels[channel];
+
+    // it is assumed that after the calibration pulse_min != 0.0f and if so
+    // we constrain the pulse to the range (0.0f, 1.0f)
+    if (ch.pulse_min != 0.0f)
+        pulse = (pulse > 1.0f) ? 1.0f : (pulse < 0.0f) ? 0.0f : pulse;
+    return constrainPulse((ch.pulse_max - ch.pulse_min) * pulse + ch.pulse_min);
+}
+
+float ServoBank::constrainPulse(float pulse) const
+{
+    // constrain pulse to range (PWM_MIN, PWM_MAX)
+    return (pulse > PWM_MAX) ? PWM_MAX :
+           (pulse < PWM_MIN) ? PWM_MIN :
+            pulse;
+}
+
+void ServoBank::step()
+{
+    edge_t edges[SERVO_BANK_NUM_OF_CHANNELS_MAX];
+    int num_of_edges = 0;
+
+    for (int i = 0; i < m_num_of_channels; i++) {
+        channel_t& ch = m_channels[i];
+        if (!ch.enabled) {
+            ch.pulse_mus = 0;
+            continue;
+        }
+
+        // increment to position and convert to pulse width
+        ch.motion.incrementToPosition(ch.pulse, TS);
+        ch.pulse_mus = static_cast<uint16_t>(ch.motion.getPosition() * static_cast<float>(PERIOD_MUS));
+
+        // insertion sort by pulse width, there are only a few channels
+        int j = num_of_edges++;
+        while (j > 0 && edges[j - 1].time_mus > ch.pulse_mus) {
+            edges[j] = edges[j - 1];
+            j--;
+        }
+        edges[j].time_mus = ch.pulse_mus;
+        edges[j].channel = static_cast<uint8_t>(i);
+    }
+
+    startFrame(edges, num_of_edges);
+}
+
+void ServoBank::startFrame(const edge_t* edges, int num_of_edges)
+{
+    CriticalSectionLock lock;
+
+    // pulses of the previous frame that are still running end now, this only happens if the frame
+    // starts early, the pulses are at most PWM_MAX * PERIOD_MUS long
+    m_Timeout.detach();
+    for (int i = m_edge_idx; i < m_num_of_edges; i++)
+        *m_channels[m_edges[i].channel].digital_out = 0;
+
+    for (int i = 0; i < num_of_edges; i++)
+        m_edges[i] = edges[i];
+    m_num_of_edges = num_of_edges;
+    m_edge_idx = 0;
+    if (num_of_edges == 0)
+        return;
+
+    // all pulses start together and are measured from the same timer
+    for (int i = 0; i < num_of_edges; i++)
+        *m_channels[m_edges[i].channel].digital_out = 1;
+    m_Timer.reset();
+    m_Timeout.attach(callback(this, &ServoBank::endPulses), std::chrono::microseconds{m_edges[0].time_mus});
+}
+
+// timeout interrupt, ends every pulse that is over and attaches itself to the next edge
+void ServoBank::endPulses()
+{
+    const int64_t time_mus = std::chrono::duration_cast<std::chrono::microseconds>(m_Timer.elapsed_time()).count();
+    int idx = m_edge_idx;
+    while (idx < m_num_of_edges && m_edges[idx].time_mus <= time_mus) {
+        *m_channels[m_edges[idx].channel].digital_out = 0;
+        idx++;
+    }
+    m_edge_idx = idx;
+
+    if (idx < m_num_of_edges)
+        m_Timeout.attach(callback(this, &ServoBank::endPulses), std::chrono::microseconds{m_edges[idx].time_mus - time_mus});
+}
+
+void ServoBank::threadTask()
+{
+    while (true) {
+        ThisThread::flags_wait_any(m_ThreadFlag);
+        step();
+    }
+}
+
+void ServoBank::sendThreadFlag()
+{
+    // set the thread flag to trigger the thread task
+    m_Thread.flags_set(m_ThreadFlag);
+}
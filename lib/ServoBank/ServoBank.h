@@ -0,0 +1,137 @@
+/**
+ * @file ServoBank.h
+ * @brief Soft PWM for several servos with one thread and one timeout instead of one per servo
+ *
+ * Every Servo object owns a thread, a ticker and a timeout, so with several servos the pulses are
+ * started and ended by independent interrupts that can delay each other and stretch the pulses. The
+ * ServoBank owns the pins of all its servos and generates one frame every 20 ms:
+ * - step() increments the motion profile of every enabled channel and sorts the channels by pulse width,
+ * - then all enabled outputs are set high at the same time and a timer is started,
+ * - one timeout is chained through the sorted pulse widths, every interrupt sets the outputs of all
+ *   channels low whose pulse is over and attaches itself to the next pulse width.
+ * The pulse widths are measured from the same timer, so a delayed step() shifts the whole frame but
+ * does not change the pulse widths.
+ *
+ * The channels have the same functions as Servo (calibration, motion profile, enable and disable),
+ * with the channel number returned by addServo() as the first argument.
+ *
+ * @dependencies
+ * This class relies on the following components:
+ * - **DigitalOut**: One per channel, allocated by addServo()
+ * - **Timeout**, **Timer**: For the falling edges of the pulses
+ * - **Motion** or **SCurve**: Motion profile of every channel
+ * - **Thread**, **Ticker**, **ThreadFlag** or **ControlScheduler**: For the frames
+ *
+ * @example
+ * ```cpp
+ * ServoBank servo_bank;
+ * const int servo_D0 = servo_bank.addServo(PB_D0);
+ * const int servo_D1 = servo_bank.addServo(PB_D1);
+ * servo_bank.calibratePulseMinMax(servo_D0, 0.0150f, 0.1150f);
+ * servo_bank.setMaxAcceleration(servo_D0, 0.3f);
+ * servo_bank.enable(servo_D0);
+ * servo_bank.enable(servo_D1);
+ * servo_bank.setPulseWidth(servo_D0, 0.5f); // set servo to mid position
+ * ```
+ *
+ * With ServoBank servo_bank(scheduler) the frames are executed by a shared ControlScheduler.
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef SERVO_BANK_H_
+#define SERVO_BANK_H_
+
+#include "mbed.h"
+
+#include "ThreadFlag.h"
+#include "ControlScheduler.h"
+
+#define SERVO_BANK_NUM_OF_CHANNELS_MAX 8
+
+// if this is true then the channels follow the jerk limited SCurve instead of the trapezoidal Motion profile
+#define SERVO_BANK_DO_USE_S_CURVE false
+
+#if SERVO_BANK_DO_USE_S_CURVE
+#include "SCurve.h"
+#else
+#include "Motion.h"
+#endif
+
+class ServoBank
+{
+public:
+    explicit ServoBank();
+
+    // the period of the scheduler has to be a divisor of 20000 us
+    explicit ServoBank(ControlScheduler& scheduler);
+    virtual ~ServoBank();
+
+    // adds a servo and returns its channel, -1 if there are already SERVO_BANK_NUM_OF_CHANNELS_MAX servos
+    int addServo(PinName pin);
+    int getNumOfChannels() const { return m_num_of_channels; }
+
+    // same as the functions of Servo, for the channel returned by addServo()
+    void calibratePulseMinMax(int channel, float pulse_min = 0.0f, float pulse_max = 1.0f);
+    void setMaxVelocity(int channel, float velocity = 1.0e6f);         // 1.0e6f instead of infinity
+    void setMaxAcceleration(int channel, float acceleration = 1.0e6f); // 1.0e6f instead of infinity
+    void setPulseWidth(int channel, float pulse = 0.0f);
+    void enable(int channel, float pulse = 0.0f);
+    void disable(int channel);
+    bool isEnabled(int channel) const;
+
+    // pulse width of the current frame in microseconds, 0 if the channel is disabled
+    uint16_t getPulseWidthMus(int channel) const;
+
+private:
+    static constexpr int64_t PERIOD_MUS = 20000;
+    static constexpr float TS = 1.0e-6f * static_cast<float>(PERIOD_MUS);
+    static constexpr float PWM_MIN = 0.01f;
+    static constexpr float PWM_MAX = 0.99f;
+
+    struct channel_t {
+        DigitalOut* digital_out;
+#if SERVO_BANK_DO_USE_S_CURVE
+        SCurve motion;
+#else
+        Motion motion;
+#endif
+        bool enabled;
+        float pulse;
+        float pulse_min;
+        float pulse_max;
+        uint16_t pulse_mus;
+    };
+
+    // falling edge of a channel, sorted by time within a frame
+    struct edge_t {
+        uint16_t time_mus;
+        uint8_t channel;
+    };
+
+    channel_t m_channels[SERVO_BANK_NUM_OF_CHANNELS_MAX];
+    int m_num_of_channels{0};
+
+    // edges of the running frame, only the timeout interrupt changes m_edge_idx while a frame runs
+    edge_t m_edges[SERVO_BANK_NUM_OF_CHANNELS_MAX];
+    int m_num_of_edges{0};
+    volatile int m_edge_idx{0};
+    Timeout m_Timeout;
+    Timer m_Timer;
+
+    Thread m_Thread;
+    Ticker m_Ticker;
+    ThreadFlag m_ThreadFlag;
+    ControlScheduler* m_scheduler;
+    int m_task_id{-1};
+
+    bool isValidChannel(int channel) const { return channel >= 0 && channel < m_num_of_channels; }
+    float calculateNormalisedPulseWidth(int channel, float pulse) const;
+    float constrainPulse(float pulse) const;
+    void step();
+    void startFrame(const edge_t* edges, int num_of_edges);
+    void endPulses();
+    void threadTask();
+    void sendThreadFlag();
+};
+#endif /* SERVO_BANK_H_ */
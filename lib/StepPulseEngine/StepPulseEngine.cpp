@@ -0,0 +1,162 @@
+#include "StepPulseEngine.h"
+
+#include <math.h>
+#include <stdio.h>
+
+StepPulseEngine::StepPulseEngine(float steps_per_rev,
+                                 float velocity_max,
+                                 float acceleration) : m_steps_per_rev(steps_per_rev)
+                                                     , m_Commands(STEP_PULSE_ENGINE_NUM_OF_COMMANDS)
+{
+    m_acceleration = fabsf(acceleration) * steps_per_rev;
+
+    // steps needed to reach the maximum velocity
+    const float velocity_max_steps = fabsf(velocity_max) * steps_per_rev;
+    float ramp_length = ceilf(velocity_max_steps * velocity_max_steps / (2.0f * m_acceleration));
+    if (!(ramp_length >= 1.0f))
+        ramp_length = 1.0f;
+    else if (ramp_length > STEP_PULSE_ENGINE_RAMP_STEPS_MAX) {
+        printf("StepPulseEngine: ramp limited to %d steps\n", STEP_PULSE_ENGINE_RAMP_STEPS_MAX);
+        ramp_length = STEP_PULSE_ENGINE_RAMP_STEPS_MAX;
+    }
+    m_ramp_length = static_cast<uint16_t>(ramp_length);
+
+    // step n of constant acceleration from rest happens at t_n = sqrt(2 * n / a), the time between step n and
+    // n + 1 is written as c0 / (sqrt(n + 1) + sqrt(n)) to avoid the cancellation of the difference
+    m_ramp = new uint16_t[m_ramp_length];
+    const float c0 = 1.0e6f * sqrtf(2.0f / m_acceleration);
+    for (uint16_t n = 0; n < m_ramp_length; n++) {
+        const float c = c0 / (sqrtf(static_cast<float>(n + 1)) + sqrtf(static_cast<float>(n)));
+        m_ramp[n] = (c < 65535.0f) ? static_cast<uint16_t>(c + 0.5f) : 65535;
+        if (m_ramp[n] == 0)
+            m_ramp[n] = 1;
+    }
+    m_velocity_max = 1.0e6f / static_cast<float>(m_ramp[m_ramp_length - 1]) / steps_per_rev;
+}
+
+StepPulseEngine::~StepPulseEngine()
+{
+    delete[] m_ramp;
+}
+
+StepPulseEngine::command_result_t StepPulseEngine::setTarget(int32_t steps, float velocity)
+{
+    return push({TARGET, steps, velocityToLevel(velocity)});
+}
+
+StepPulseEngine::command_result_t StepPulseEngine::setVelocity(float velocity)
+{
+    return push({VELOCITY, (velocity >= 0.0f) ? INT32_MAX : INT32_MIN, velocityToLevel(velocity)});
+}
+
+StepPulseEngine::command_result_t StepPulseEngine::setPosition(int32_t steps)
+{
+    return push({POSITION, steps, 0});
+}
+
+float StepPulseEngine::getVelocity() const
+{
+    const int32_t level_signed = m_level_signed.load(std::memory_order_relaxed);
+    if (level_signed == 0)
+        return 0.0f;
+    const int32_t level = (level_signed > 0) ? level_signed : -level_signed;
+    const float velocity = 1.0e6f / static_cast<float>(m_ramp[level - 1]) / m_steps_per_rev;
+    return (level_signed > 0) ? velocity : -velocity;
+}
+
+bool StepPulseEngine::onTimer(uint32_t& delay_mus)
+{
+    command_t command;
+    while (m_Commands.pop(command))
+        applyCommand(command);
+
+    int32_t steps = m_steps.load(std::memory_order_relaxed);
+    if (m_level == 0) {
+        // standing still, start towards the target
+        const int64_t distance = static_cast<int64_t>(m_target) - steps;
+        if (distance == 0 || m_level_cruise == 0) {
+            delay_mus = stop();
+            return false;
+        }
+        m_direction = (distance > 0) ? 1 : -1;
+    }
+
+    // emit the step
+    steps += m_direction;
+    m_steps.store(steps, std::memory_order_relaxed);
+
+    // speed level of the next interval, it changes by one at most, and it never exceeds the remaining steps
+    // so that the engine can stop at the target
+    const int64_t remaining = (static_cast<int64_t>(m_target) - steps) * m_direction;
+    const uint16_t level_decelerate = (m_level > 0) ? m_level - 1 : 0;
+    uint16_t level = level_decelerate;
+    if (remaining > 0 && m_level < m_level_cruise) {
+        level = m_level + 1;
+        if (level > remaining)
+            level = static_cast<uint16_t>(remaining);
+        if (level < level_decelerate)
+            level = level_decelerate;
+    } else if (remaining > 0 && m_level == m_level_cruise) {
+        level = (m_level > remaining) ? level_decelerate : m_level;
+    }
+    m_level = level;
+    m_level_signed.store(static_cast<int32_t>(level) * m_direction, std::memory_order_relaxed);
+
+    if (level == 0) {
+        // stopped after this step, restart from rest after the slowest interval if the target is somewhere else
+        delay_mus = (remaining == 0 || m_level_cruise == 0) ? stop() : m_ramp[0];
+        return true;
+    }
+    delay_mus = m_ramp[level - 1];
+    return true;
+}
+
+StepPulseEngine::command_result_t StepPulseEngine::push(const command_t& command)
+{
+    if (!m_Commands.push(command))
+        return COMMAND_DISCARDED;
+    // the thread that sets the flag starts the timer
+    return m_is_running.exchange(true) ? COMMAND_QUEUED : COMMAND_START_TIMER;
+}
+
+uint32_t StepPulseEngine::stop()
+{
+    m_is_running.store(false);
+    // a command that was pushed after the buffer was read found the engine running and did not start the timer
+    if (!m_Commands.empty() && !m_is_running.exchange(true))
+        return 1;
+    return 0;
+}
+
+uint16_t StepPulseEngine::velocityToLevel(float velocity) const
+{
+    // level n is reached after n steps of constant acceleration, v^2 = 2 * a * n
+    const float velocity_steps = fabsf(velocity) * m_steps_per_rev;
+    if (!(velocity_steps > 0.0f))
+        return 0;
+    const float level = velocity_steps * velocity_steps / (2.0f * m_acceleration) + 0.5f;
+    if (level < 1.0f)
+        return 1;
+    else if (level >= static_cast<float>(m_ramp_length))
+        return m_ramp_length;
+    return static_cast<uint16_t>(level);
+}
+
+void StepPulseEngine::applyCommand(const command_t& command)
+{
+    switch (command.type) {
+        case TARGET:
+        case VELOCITY:
+            m_target = command.steps;
+            m_level_cruise = command.level;
+            break;
+        case POSITION: {
+            // the target moves along, in velocity mode it stays at the end of the range
+            const int32_t offset = command.steps - m_steps.load(std::memory_order_relaxed);
+            m_steps.store(command.steps, std::memory_order_relaxed);
+            if (m_target != INT32_MAX && m_target != INT32_MIN)
+                m_target += offset;
+            break;
+        }
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file StepPulseEngine.h
+ * @brief Step pulse generator with a precomputed trapezoidal acceleration ramp.
+ *
+ * The engine decides at every timer event whether a step is emitted and how long to wait until the
+ * next event, so a stepper driver only needs one one-shot timer interrupt per step and no thread.
+ *
+ * - The ramp table holds the time between two steps for every speed level, level n is reached
+ *   after n steps of constant acceleration. The times are the exact differences of the step times
+ *   t_n = sqrt(2 n / a), not the series of AVR446, so the first steps need no 0.676 correction. It
+ *   is computed once in the constructor, the timer event only uses integer arithmetic and a table
+ *   lookup.
+ * - The speed level changes by at most one per step, so the acceleration is limited in both
+ *   directions. The engine decelerates in time to stop exactly at the target, if the target is
+ *   changed to a position that is too close or behind, it overshoots and comes back.
+ * - Targets are handed over from the thread to the timer interrupt through an SPSCRingBuffer, so
+ *   neither side blocks. The producer functions return whether the command was queued and whether
+ *   the timer has to be started, a command that was discarded (buffer full) has to be sent again.
+ *
+ * The engine does not depend on mbed, docs/dev/dev_step_pulse_engine runs it against a virtual
+ * timer on the host.
+ *
+ * Example (see Stepper in src/stepper.cpp):
+ * ```
+ * StepPulseEngine engine(400.0f, 12.0f, 12.0f); // steps per rev, rps, rps/s
+ *
+ * // thread
+ * if (engine.setTarget(4000, 5.0f) == StepPulseEngine::COMMAND_START_TIMER)
+ *     timeout.attach(on_timer, 1us);
+ *
+ * // timer interrupt
+ * uint32_t delay_mus;
+ * if (engine.onTimer(delay_mus))
+ *     ... emit a step in direction engine.getDirection()
+ * if (delay_mus > 0)
+ *     timeout.attach(on_timer, std::chrono::microseconds{delay_mus});
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef STEP_PULSE_ENGINE_H_
+#define STEP_PULSE_ENGINE_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#include "SPSCRingBuffer.h"
+
+#define STEP_PULSE_ENGINE_RAMP_STEPS_MAX 4096 // 8 kB, e.g. 12 rps at 400 steps per rev and 12 rps/s need 2400 steps
+#define STEP_PULSE_ENGINE_NUM_OF_COMMANDS 4
+
+class StepPulseEngine
+{
+public:
+    /**
+     * @param steps_per_rev Steps per revolution.
+     * @param velocity_max  Maximum velocity in rotations per second.
+     * @param acceleration  Acceleration and deceleration in rotations per second squared.
+     */
+    explicit StepPulseEngine(float steps_per_rev, float velocity_max, float acceleration);
+    virtual ~StepPulseEngine();
+
+    typedef enum command_result_e {
+        COMMAND_DISCARDED,  // the command buffer is full, the command is lost
+        COMMAND_QUEUED,     // the running engine applies the command at the next timer event
+        COMMAND_START_TIMER // queued, the engine was stopped and the caller has to start the timer
+    } command_result_t;
+
+    // producer (thread)
+    // ------------------------------------------------------------------------
+
+    // moves to steps, velocity is the magnitude in rotations per second
+    command_result_t setTarget(int32_t steps, float velocity);
+    // moves endlessly, the sign is the direction, 0 stops with the ramp
+    command_result_t setVelocity(float velocity);
+    // redefines the current position without moving, a target is shifted along
+    command_result_t setPosition(int32_t steps);
+
+    int32_t getSteps() const { return m_steps.load(std::memory_order_relaxed); }
+    // velocity in rotations per second, quantised to the ramp levels
+    float getVelocity() const;
+    float getVelocityMax() const { return m_velocity_max; }
+
+    // consumer (timer interrupt)
+    // ------------------------------------------------------------------------
+
+    // returns true if a step has to be emitted now, delay_mus is the time until the next call, 0 if the engine stopped
+    bool onTimer(uint32_t& delay_mus);
+    // direction of the step, true is positive
+    bool getDirection() const { return m_direction > 0; }
+
+private:
+    typedef enum command_type_e {
+        TARGET,
+        VELOCITY,
+        POSITION
+    } command_type_t;
+
+    typedef struct command_s {
+        command_type_t type;
+        int32_t steps;
+        uint16_t level; // speed level of the cruise velocity
+    } command_t;
+
+    float m_steps_per_rev;
+    float m_velocity_max;
+    float m_acceleration; // in steps per second squared
+    uint16_t* m_ramp;    // time between two steps in us for every speed level
+    uint16_t m_ramp_length;
+
+    SPSCRingBuffer<command_t> m_Commands;
+    std::atomic<bool> m_is_running{false};
+
+    // written by the timer interrupt only
+    std::atomic<int32_t> m_steps{0};
+    std::atomic<int32_t> m_level_signed{0}; // speed level times direction, read by getVelocity()
+    int32_t m_target{0};
+    uint16_t m_level_cruise{0};
+    uint16_t m_level{0};
+    int8_t m_direction{1};
+
+    command_result_t push(const command_t& command);
+    uint32_t stop();
+    uint16_t velocityToLevel(float velocity) const;
+    void applyCommand(const command_t& command);
+};
+#endif /* STEP_PULSE_ENGINE_H_ */
@@ -0,0 +1,90 @@
+#include "TelemetryCodec.h"
+
+#include <math.h>
+#include <string.h>
+
+TelemetryCodec::TelemetryCodec(uint8_t num_of_floats,
+                               const float* scales,
+                               uint16_t keyframe_interval) : m_keyframe_interval(keyframe_interval)
+{
+    if (scales == nullptr)
+        return;
+
+    m_num_of_floats = (num_of_floats <= TELEMETRY_CODEC_NUM_OF_FLOATS_MAX) ? num_of_floats : TELEMETRY_CODEC_NUM_OF_FLOATS_MAX;
+    if (m_keyframe_interval == 0)
+        m_keyframe_interval = 1;
+    for (uint8_t i = 0; i < m_num_of_floats; i++) {
+        m_scales[i] = (scales[i] > 0.0f) ? scales[i] : 0.0f;
+        m_scales_inv[i] = (scales[i] > 0.0f) ? 1.0f / scales[i] : 0.0f;
+    }
+    reset();
+}
+
+int TelemetryCodec::writeHeader(char* buffer) const
+{
+    buffer[0] = static_cast<char>(m_num_of_floats | TELEMETRY_CODEC_HEADER_FLAG);
+    memcpy(&buffer[1], m_scales, sizeof(float) * m_num_of_floats);
+    return getHeaderSize();
+}
+
+int TelemetryCodec::encode(const float* values, uint8_t num_of_values, char* buffer)
+{
+    const bool is_keyframe = (m_record_cntr == 0);
+    if (++m_record_cntr == m_keyframe_interval)
+        m_record_cntr = 0;
+
+    int ind = 0;
+    buffer[ind++] = is_keyframe ? TELEMETRY_CODEC_KEYFRAME : TELEMETRY_CODEC_DELTA;
+    for (uint8_t i = 0; i < m_num_of_floats; i++) {
+        if (m_scales_inv[i] == 0.0f) {
+            // raw float, channels that are not in values are sent as 0
+            const float val = (i < num_of_values) ? values[i] : 0.0f;
+            memcpy(&buffer[ind], &val, sizeof(float));
+            ind += sizeof(float);
+            continue;
+        }
+        const int32_t val = (i < num_of_values) ? quantise(values[i], m_scales_inv[i]) : m_values_past[i];
+        // the difference wraps around like the decoder does, so it is exact for every value
+        const int32_t val_out = is_keyframe ? val : static_cast<int32_t>(static_cast<uint32_t>(val) - static_cast<uint32_t>(m_values_past[i]));
+        m_values_past[i] = val;
+        ind += writeVarint(zigzag(val_out), &buffer[ind]);
+    }
+    return ind;
+}
+
+void TelemetryCodec::reset()
+{
+    m_record_cntr = 0;
+    memset(m_values_past, 0, sizeof(m_values_past));
+}
+
+int32_t TelemetryCodec::quantise(float val, float scale_inv)
+{
+    // saturate to the int32 range, nan is mapped to 0
+    const float val_scaled = roundf(val * scale_inv);
+    if (val_scaled >= 2147483520.0f)
+        return INT32_MAX;
+    else if (val_scaled <= -2147483648.0f)
+        return INT32_MIN;
+    else if (val_scaled == val_scaled)
+        return static_cast<int32_t>(val_scaled);
+    else
+        return 0;
+}
+
+int TelemetryCodec::writeVarint(uint32_t val, char* buffer)
+{
+    int ind = 0;
+    while (val >= 0x80) {
+        buffer[ind++] = static_cast<char>((val & 0x7F) | 0x80);
+        val >>= 7;
+    }
+    buffer[ind++] = static_cast<char>(val);
+    return ind;
+}
+
+uint32_t TelemetryCodec::zigzag(int32_t val)
+{
+    // 0, -1, 1, -2, 2, ... -> 0, 1, 2, 3, 4, ...
+    return (static_cast<uint32_t>(val) << 1) ^ static_cast<uint32_t>(val >> 31);
+}
@@ -0,0 +1,86 @@
+/**
+ * @file TelemetryCodec.h
+ * @brief Compresses records of floats for SerialStream and SDLogger.
+ *
+ * Every channel has a scale (resolution per LSB). A channel with scale > 0 is quantised to an
+ * int32 value q = round(val / scale), a channel with scale 0 is sent as raw float.
+ *
+ * - A keyframe contains the quantised values themselves, every other record only contains the
+ *   difference to the previous record. Keyframes are sent every keyframe_interval records, so a
+ *   decoder that lost data can continue with the next keyframe.
+ * - Values and differences are zigzag mapped (small negative numbers become small positive numbers)
+ *   and written as varint (7 bits per byte, MSB set if another byte follows), so slowly varying
+ *   signals like encoder rotations or filtered velocities only need 1 or 2 bytes instead of 4.
+ *
+ * A record is the record type byte (TELEMETRY_CODEC_DELTA or TELEMETRY_CODEC_KEYFRAME) followed by
+ * the channels, it is at most TELEMETRY_CODEC_RECORD_SIZE_MAX(num_of_floats) bytes long. The header
+ * is the num_of_floats byte with TELEMETRY_CODEC_HEADER_FLAG set followed by the scales as floats,
+ * so a reader can tell encoded data from raw floats by the first byte. Only encode records that are
+ * actually sent, a record that is dropped before encoding does not break the differences.
+ *
+ * The decoders are docs/solutions/python/TelemetryCodec.py and docs/solutions/matlab/telemetry_decode.m.
+ *
+ * Example:
+ * ```
+ * // rotations with 1e-4 rotations resolution, raw float, dtime in us
+ * const float scales[3] = {1.0e-4f, 0.0f, 1.0f};
+ * TelemetryCodec codec(3, scales);
+ *
+ * char record[TELEMETRY_CODEC_RECORD_SIZE_MAX(3)];
+ * const int record_size = codec.encode(values, 3, record);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef TELEMETRY_CODEC_H_
+#define TELEMETRY_CODEC_H_
+
+#include <stdint.h>
+
+#define TELEMETRY_CODEC_NUM_OF_FLOATS_MAX 100 // same as SD_LOGGER_NUM_OF_FLOATS_MAX
+#define TELEMETRY_CODEC_KEYFRAME_INTERVAL 200 // at 2 kHz a keyframe every 100 ms
+#define TELEMETRY_CODEC_HEADER_FLAG 0x80
+#define TELEMETRY_CODEC_DELTA 0
+#define TELEMETRY_CODEC_KEYFRAME 1
+#define TELEMETRY_CODEC_HEADER_SIZE_MAX (1 + sizeof(float) * TELEMETRY_CODEC_NUM_OF_FLOATS_MAX)
+#define TELEMETRY_CODEC_RECORD_SIZE_MAX(x) (1 + 5 * (x)) // record type and 5 bytes per varint at most
+
+class TelemetryCodec
+{
+public:
+    /**
+     * @param num_of_floats Number of floats per record, 0 disables the codec.
+     * @param scales Resolution per LSB of every channel, 0 sends the channel as raw float, nullptr disables the codec.
+     * @param keyframe_interval A keyframe is sent every keyframe_interval records.
+     */
+    explicit TelemetryCodec(uint8_t num_of_floats = 0,
+                            const float* scales = nullptr,
+                            uint16_t keyframe_interval = TELEMETRY_CODEC_KEYFRAME_INTERVAL);
+    virtual ~TelemetryCodec() = default;
+
+    bool isEnabled() const { return m_num_of_floats > 0; }
+    uint8_t getNumOfFloats() const { return m_num_of_floats; }
+    int getHeaderSize() const { return 1 + sizeof(float) * m_num_of_floats; }
+
+    // writes the header to buffer, returns the number of bytes written
+    int writeHeader(char* buffer) const;
+    // encodes num_of_values values to buffer, returns the number of bytes written, channels that are
+    // not in values keep their previous value
+    int encode(const float* values, uint8_t num_of_values, char* buffer);
+    // the next record is a keyframe
+    void reset();
+
+private:
+    uint8_t m_num_of_floats{0};
+    uint16_t m_keyframe_interval;
+    uint16_t m_record_cntr{0};
+    float m_scales[TELEMETRY_CODEC_NUM_OF_FLOATS_MAX];
+    float m_scales_inv[TELEMETRY_CODEC_NUM_OF_FLOATS_MAX];
+    int32_t m_values_past[TELEMETRY_CODEC_NUM_OF_FLOATS_MAX];
+
+    static int32_t quantise(float val, float scale_inv);
+    static int writeVarint(uint32_t val, char* buffer);
+    static uint32_t zigzag(int32_t val);
+};
+#endif /* TELEMETRY_CODEC_H_ */
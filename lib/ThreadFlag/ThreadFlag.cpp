@@ -47,6 +47,19 @@ ThreadFlag::~ThreadFlag()
     mutex.unlock();
 }
 
+/**
+ * Releases the assigned flag before the object is destroyed, afterwards isValid() returns false.
+ */
+void ThreadFlag::release()
+{
+    mutex.lock();
+
+    threadFlags &= ~threadFlag;
+    threadFlag = 0;
+
+    mutex.unlock();
+}
+
 /**
  * Gets the assigned thread flag.
  */
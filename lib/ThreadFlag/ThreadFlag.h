@@ -48,6 +48,9 @@ public:
     // Validation method to check if flag allocation was successful
     bool isValid() const { return threadFlag != 0; }
 
+    // Release the flag early, e.g. if the owning driver is executed by a ControlScheduler
+    void release();
+
     // Static utility methods for diagnostics
     static unsigned int getUsedFlagCount();
     static unsigned int getAvailableFlagCount() { return 30 - getUsedFlagCount(); }
@@ -0,0 +1,177 @@
+#include "UltrasonicArray.h"
+
+UltrasonicArray::UltrasonicArray() : m_Thread(osPriorityAboveNormal), m_scheduler(nullptr)
+{
+    m_Timer.start();
+
+    // start thread
+    m_Thread.start(callback(this, &UltrasonicArray::threadTask));
+
+    // attach sendThreadFlag() to ticker so that sendThreadFlag() is called periodically, which signals the thread to execute
+    m_Ticker.attach(callback(this, &UltrasonicArray::sendThreadFlag), std::chrono::microseconds{PERIOD_MUS});
+}
+
+UltrasonicArray::UltrasonicArray(ControlScheduler& scheduler) : m_Thread(osPriorityAboveNormal), m_scheduler(&scheduler)
+{
+    m_Timer.start();
+
+    // let the scheduler execute step(), the own thread and thread flag are not used
+    m_ThreadFlag.release();
+    m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &UltrasonicArray::step), PERIOD_MUS);
+}
+
+UltrasonicArray::~UltrasonicArray()
+{
+    if (m_scheduler)
+        m_scheduler->unregisterTask(m_task_id);
+    m_Ticker.detach();
+    m_Timeout.detach();
+    m_Thread.terminate();
+    for (int i = 0; i < m_num_of_sensors; i++) {
+        m_sensors[i].interrupt_in->disable_irq();
+        delete m_sensors[i].interrupt_in;
+        delete m_sensors[i].digital_in_out;
+    }
+}
+
+int UltrasonicArray::addSensor(PinName pin, int group)
+{
+    if (m_num_of_sensors == ULTRASONIC_ARRAY_NUM_OF_SENSORS_MAX) {
+        printf("UltrasonicArray: no channel left for the sensor\n");
+        return -1;
+    }
+
+    const int channel = m_num_of_sensors;
+    sensor_t& sensor = m_sensors[channel];
+    sensor.array = this;
+    sensor.digital_in_out = new DigitalInOut(pin);
+    sensor.interrupt_in = new InterruptIn(pin);
+    sensor.interrupt_in->disable_irq();
+    sensor.is_first_pulse = true;
+    sensor.group = (group < 0) ? m_num_of_groups : group;
+    sensor.time_rise_us = 0;
+    sensor.pulse_us = 0;
+    sensor.is_new_pulse = false;
+
+    // the sensor is visible to step() from here on
+    m_num_of_sensors++;
+    if (sensor.group >= m_num_of_groups)
+        m_num_of_groups = sensor.group + 1;
+
+    return channel;
+}
+
+float UltrasonicArray::read(int channel) const
+{
+    if (channel < 0 || channel >= m_num_of_sensors)
+        return -1.0f;
+    const UltrasonicArrayData data = m_data_published.read();
+    return data.is_valid[channel] ? data.distance_cm[channel] : -1.0f;
+}
+
+UltrasonicArrayData UltrasonicArray::getData() const
+{
+    return m_data_published.read();
+}
+
+uint32_t UltrasonicArray::getTimeUs() const
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(m_Timer.elapsed_time()).count());
+}
+
+void UltrasonicArray::step()
+{
+    // 1. step() is called once per slot, it evaluates the echoes of the last group and triggers the next group
+    // 2. stopPulsesAndWaitForEcho()
+    // 3. sensor_t::onRise() and sensor_t::onFall() of every sensor in the group
+    if (m_num_of_groups == 0)
+        return;
+
+    if (m_group_active >= 0)
+        endSlot(m_group_active);
+    m_group_active = (m_group_active + 1) % m_num_of_groups;
+
+    // change the pins of the group to output mode and set them high, this triggers the measurements
+    for (int i = 0; i < m_num_of_sensors; i++) {
+        sensor_t& sensor = m_sensors[i];
+        if (sensor.group != m_group_active)
+            continue;
+        sensor.is_new_pulse = false;
+        sensor.digital_in_out->output();
+        *sensor.digital_in_out = 1;
+    }
+    m_Timeout.attach(callback(this, &UltrasonicArray::stopPulsesAndWaitForEcho), std::chrono::microseconds{TRIGGER_MUS});
+}
+
+void UltrasonicArray::endSlot(int group)
+{
+    for (int i = 0; i < m_num_of_sensors; i++) {
+        sensor_t& sensor = m_sensors[i];
+        if (sensor.group != group)
+            continue;
+
+        // no more edges of this sensor until its next slot
+        sensor.interrupt_in->disable_irq();
+        sensor.interrupt_in->rise(nullptr);
+        sensor.interrupt_in->fall(nullptr);
+
+        m_data.is_valid[i] = sensor.is_new_pulse;
+        if (sensor.is_new_pulse) {
+            const float distance_cm = GAIN * static_cast<float>(sensor.pulse_us) + OFFSET;
+            // the first measurement initialises the median, otherwise it would return the initial value twice
+            if (sensor.is_first_pulse) {
+                sensor.is_first_pulse = false;
+                m_data.distance_cm[i] = sensor.median.reset(distance_cm);
+            } else {
+                m_data.distance_cm[i] = sensor.median.apply(distance_cm);
+            }
+        }
+    }
+    m_data.num_of_slots++;
+    m_data_published.publish(m_data);
+}
+
+// timeout interrupt, ends the trigger pulses of the active group
+void UltrasonicArray::stopPulsesAndWaitForEcho()
+{
+    for (int i = 0; i < m_num_of_sensors; i++) {
+        sensor_t& sensor = m_sensors[i];
+        if (sensor.group != m_group_active)
+            continue;
+
+        // set the digital output to low and change the pin to input mode
+        *sensor.digital_in_out = 0;
+        sensor.digital_in_out->input();
+
+        // enable interrupt and attach function to rising edge
+        sensor.interrupt_in->rise(callback(&sensor, &sensor_t::onRise));
+        sensor.interrupt_in->enable_irq();
+    }
+}
+
+void UltrasonicArray::sensor_t::onRise()
+{
+    // timestamp and attach function to falling edge
+    time_rise_us = array->getTimeUs();
+    interrupt_in->fall(callback(this, &sensor_t::onFall));
+}
+
+void UltrasonicArray::sensor_t::onFall()
+{
+    pulse_us = array->getTimeUs() - time_rise_us;
+    is_new_pulse = true;
+}
+
+void UltrasonicArray::threadTask()
+{
+    while (true) {
+        ThisThread::flags_wait_any(m_ThreadFlag);
+        step();
+    }
+}
+
+void UltrasonicArray::sendThreadFlag()
+{
+    // set the thread flag to trigger the thread task
+    m_Thread.flags_set(m_ThreadFlag);
+}
@@ -0,0 +1,128 @@
+/**
+ * @file UltrasonicArray.h
+ * @brief Measures several ultrasonic sensors (Ultrasonic Ranger V2.0) without crosstalk
+ *
+ * Several UltrasonicSensor objects ping independently every 12 ms, so a sensor can receive the echo of
+ * another one. The UltrasonicArray triggers its sensors in groups, only one group is pinging during a slot
+ * of 12 ms (the echo time for about 2 m), and the groups take turns:
+ * - by default every sensor is its own group, so the sensors are measured round-robin,
+ * - sensors that can not hear each other (e.g. front and back) can share a group, they are triggered
+ *   in the same slot, which increases the number of measurements per second.
+ *
+ * The echo edges of all sensors are timestamped with one free-running timer, every distance is filtered
+ * with a median over the last 3 measurements of its sensor to reject single outliers and at the end of
+ * every slot all distances are published as one snapshot.
+ *
+ * @dependencies
+ * This class relies on the following components:
+ * - **DigitalInOut**, **InterruptIn**: One per sensor, the trigger and the echo share the pin
+ * - **Timer**, **Timeout**: For the echo timestamps and the trigger pulse
+ * - **MedianFilter3**: For the outlier rejection
+ * - **Published**: For the snapshot of all distances
+ * - **Thread**, **Ticker**, **ThreadFlag** or **ControlScheduler**: For the slots
+ *
+ * @example
+ * ```cpp
+ * UltrasonicArray us_array;
+ * const int us_front = us_array.addSensor(PB_D3, 0);
+ * const int us_back = us_array.addSensor(PB_D2, 0); // front and back ping together
+ * const int us_left = us_array.addSensor(PB_D1, 1);
+ * const int us_right = us_array.addSensor(PB_D0, 2);
+ *
+ * const float distance_front_cm = us_array.read(us_front);
+ * UltrasonicArrayData data = us_array.getData(); // all distances of the same slot
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef ULTRASONIC_ARRAY_H_
+#define ULTRASONIC_ARRAY_H_
+
+#include "mbed.h"
+
+#include "ThreadFlag.h"
+#include "ControlScheduler.h"
+#include "MedianFilter3.h"
+#include "Published.h"
+
+#define ULTRASONIC_ARRAY_NUM_OF_SENSORS_MAX 6
+
+// snapshot of all sensors at the end of a slot
+class UltrasonicArrayData
+{
+public:
+    UltrasonicArrayData() = default;
+    ~UltrasonicArrayData() = default;
+
+    float distance_cm[ULTRASONIC_ARRAY_NUM_OF_SENSORS_MAX]{}; // median of the last 3 measurements
+    bool is_valid[ULTRASONIC_ARRAY_NUM_OF_SENSORS_MAX]{};     // the sensor answered in its last slot
+    uint32_t num_of_slots{0};
+};
+
+class UltrasonicArray
+{
+public:
+    explicit UltrasonicArray();
+
+    // the period of the scheduler has to be a divisor of 12000 us
+    explicit UltrasonicArray(ControlScheduler& scheduler);
+    virtual ~UltrasonicArray();
+
+    // adds a sensor and returns its channel, -1 if there are already ULTRASONIC_ARRAY_NUM_OF_SENSORS_MAX sensors,
+    // group = -1 creates a new group for the sensor, otherwise use consecutive group numbers starting at 0
+    int addSensor(PinName pin, int group = -1);
+    int getNumOfSensors() const { return m_num_of_sensors; }
+    int getNumOfGroups() const { return m_num_of_groups; }
+
+    // median distance of the channel in centimeters, -1.0f if the sensor did not answer in its last slot
+    float read(int channel) const;
+
+    UltrasonicArrayData getData() const;
+
+private:
+    static constexpr int64_t PERIOD_MUS = 12000; // one slot, longer than the echo of about 2 m
+    static constexpr int64_t TRIGGER_MUS = 10;
+    static constexpr float GAIN = 0.0170971f;
+    static constexpr float OFFSET = 1.7451288f;
+
+    // one sensor, the echo callbacks need to know their sensor
+    struct sensor_t {
+        UltrasonicArray* array;
+        DigitalInOut* digital_in_out;
+        InterruptIn* interrupt_in;
+        MedianFilter3 median;
+        bool is_first_pulse;
+        int group;
+        volatile uint32_t time_rise_us;
+        volatile uint32_t pulse_us;
+        volatile bool is_new_pulse;
+        void onRise();
+        void onFall();
+    };
+
+    sensor_t m_sensors[ULTRASONIC_ARRAY_NUM_OF_SENSORS_MAX];
+    int m_num_of_sensors{0};
+    int m_num_of_groups{0};
+    int m_group_active{-1};
+
+    Timer m_Timer; // free running, timestamps of all echoes
+    Timeout m_Timeout;
+
+    UltrasonicArrayData m_data;
+    Published<UltrasonicArrayData> m_data_published;
+
+    Thread m_Thread;
+    Ticker m_Ticker;
+    ThreadFlag m_ThreadFlag;
+    ControlScheduler* m_scheduler;
+    int m_task_id{-1};
+
+    uint32_t getTimeUs() const;
+    void step();
+    void endSlot(int group);
+    void stopPulsesAndWaitForEcho();
+    void threadTask();
+    void sendThreadFlag();
+};
+#endif /* ULTRASONIC_ARRAY_H_ */
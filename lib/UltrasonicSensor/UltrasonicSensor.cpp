@@ -1,12 +1,28 @@
 #include "UltrasonicSensor.h"
 
-UltrasonicSensor::UltrasonicSensor(PinName pin)
+UltrasonicSensor::UltrasonicSensor(PinName pin) : UltrasonicSensor(nullptr, pin)
+{
+}
+
+UltrasonicSensor::UltrasonicSensor(ControlScheduler& scheduler, PinName pin) : UltrasonicSensor(&scheduler, pin)
+{
+}
+
+UltrasonicSensor::UltrasonicSensor(ControlScheduler* scheduler, PinName pin)
     : m_DigitalInOut(pin),
       m_InteruptIn(pin),
-      m_Thread(osPriorityAboveNormal)
+      m_Thread(osPriorityAboveNormal),
+      m_scheduler(scheduler)
 {
     m_Timer.start();
 
+    if (m_scheduler) {
+        // let the scheduler execute step(), the own thread and thread flag are not used
+        m_ThreadFlag.release();
+        m_task_id = m_scheduler->registerTaskWithPeriod(callback(this, &UltrasonicSensor::step), PERIOD_MUS);
+        return;
+    }
+
     // start thread
     m_Thread.start(callback(this, &UltrasonicSensor::threadTask));
 
@@ -16,6 +32,8 @@ UltrasonicSensor::UltrasonicSensor(PinName pin)
 
 UltrasonicSensor::~UltrasonicSensor()
 {
+    if (m_scheduler)
+        m_scheduler->unregisterTask(m_task_id);
     m_Timeout.detach();
     m_Ticker.detach();
     m_Thread.terminate();
@@ -62,29 +80,33 @@ void UltrasonicSensor::threadTask()
 {
     while (true) {
         ThisThread::flags_wait_any(m_ThreadFlag);
-
-        // for a successful measurement the ultrasonic sensor needs to respond:
-        // the ultrasonic sensor needs to send a pulse with a rising edge followed by a falling edge
-        // the time length between the rising and falling edge is proportional to the distance
-        // 1. threadTask() is called periodically by the ticker triggers a measurement via pulse
-        // 2. stopPulseAndWaitForRisingEdge()
-        // 3. startTimerAndWaitForFallingEdge()
-        // 4. measureTimeAndUpdateDistance()
-
-        // detach interrupt
-        m_InteruptIn.disable_irq();
-        m_InteruptIn.rise(NULL);
-        m_InteruptIn.fall(NULL);
-
-        // change the pin to output mode and set the digital output to high
-        // this will generate a pulse of length m_pulsetime and trigger the ultrasonic sensor
-        // to perform a measurement
-        m_DigitalInOut.output();
-        m_DigitalInOut = 1;
-        m_Timeout.attach(callback(this, &UltrasonicSensor::stopPulseAndWaitForRisingEdge), std::chrono::microseconds{10});
+        step();
     }
 }
 
+void UltrasonicSensor::step()
+{
+    // for a successful measurement the ultrasonic sensor needs to respond:
+    // the ultrasonic sensor needs to send a pulse with a rising edge followed by a falling edge
+    // the time length between the rising and falling edge is proportional to the distance
+    // 1. step() is called periodically by the ticker or the scheduler and triggers a measurement via pulse
+    // 2. stopPulseAndWaitForRisingEdge()
+    // 3. startTimerAndWaitForFallingEdge()
+    // 4. measureTimeAndUpdateDistance()
+
+    // detach interrupt
+    m_InteruptIn.disable_irq();
+    m_InteruptIn.rise(NULL);
+    m_InteruptIn.fall(NULL);
+
+    // change the pin to output mode and set the digital output to high
+    // this will generate a pulse of length m_pulsetime and trigger the ultrasonic sensor
+    // to perform a measurement
+    m_DigitalInOut.output();
+    m_DigitalInOut = 1;
+    m_Timeout.attach(callback(this, &UltrasonicSensor::stopPulseAndWaitForRisingEdge), std::chrono::microseconds{10});
+}
+
 void UltrasonicSensor::sendThreadFlag()
 {
     // set the thread flag to trigger the thread task
@@ -37,6 +37,7 @@
 #include "mbed.h"
 
 #include "ThreadFlag.h"
+#include "ControlScheduler.h"
 
 // Time (mus), Distance (cm)
 //     10000 ,        164
@@ -54,6 +55,14 @@ public:
      */
     explicit UltrasonicSensor(PinName pin);
 
+    /**
+     * @brief Construct a new UltrasonicSensor object that is executed by a shared ControlScheduler.
+     *
+     * @param scheduler The scheduler that triggers the measurements, its period has to be a divisor of 12000 us.
+     * @param pin The pin name to which the ultrasonic sensor is connected.
+     */
+    explicit UltrasonicSensor(ControlScheduler& scheduler, PinName pin);
+
     /**
      * @brief Destroy the UltrasonicSensor object.
      */
@@ -79,6 +88,8 @@ private:
     Thread m_Thread;
     Ticker m_Ticker;
     ThreadFlag m_ThreadFlag;
+    ControlScheduler* m_scheduler{nullptr};
+    int m_task_id{-1};
 
     float m_gain = 0.0170971;
     float m_offset = 1.7451288f;
@@ -90,6 +101,9 @@ private:
     void startTimerAndWaitForFallingEdge();
     void measureTimeAndUpdateDistance();
 
+    explicit UltrasonicSensor(ControlScheduler* scheduler, PinName pin);
+
+    void step();
     void threadTask();
     void sendThreadFlag();
 };
@@ -0,0 +1,269 @@
+#include "CarJack.h"
+
+const CarJack::State CarJack::s_root = {"root", nullptr, &CarJack::root};
+const CarJack::State CarJack::s_manual = {"manual", &CarJack::s_root, &CarJack::manual};
+const CarJack::State CarJack::s_automatic = {"automatic", &CarJack::s_root, &CarJack::automatic};
+const CarJack::State CarJack::s_idle = {"idle", &CarJack::s_automatic, &CarJack::idle};
+const CarJack::State CarJack::s_down = {"down", &CarJack::s_automatic, &CarJack::down};
+const CarJack::State CarJack::s_unlatching = {"unlatching", &CarJack::s_down, &CarJack::unlatching};
+const CarJack::State CarJack::s_lowering = {"lowering", &CarJack::s_down, &CarJack::lowering};
+const CarJack::State CarJack::s_up = {"up", &CarJack::s_automatic, &CarJack::up};
+const CarJack::State CarJack::s_notInitialized = {"notInitialized", &CarJack::s_up, &CarJack::notInitialized};
+const CarJack::State CarJack::s_raising = {"raising", &CarJack::s_up, &CarJack::raising};
+
+CarJack::CarJack(CarJackIO& io) : m_io(io)
+{
+}
+
+void CarJack::begin(uint8_t inputs, uint32_t timeMs)
+{
+    m_inputs = inputs;
+    start(&s_root, timeMs);
+}
+
+void CarJack::update(uint8_t inputs, uint32_t timeMs)
+{
+    //timers that expired before the inputs changed come first
+    Hsm<CarJack>::update(timeMs);
+
+    const uint8_t changed = m_inputs ^ inputs;
+    const bool wasBothSwitches = isBothSwitches();
+    m_inputs = inputs;
+
+    if (changed & INPUT_HANDLE_SENSOR)
+        dispatch(SIG_MODE);
+    if (changed & INPUT_LIMIT_SWITCH)
+        dispatch(SIG_LIMIT_SWITCH);
+    if (changed & (INPUT_UP_SWITCH | INPUT_DOWN_SWITCH)) {
+        dispatch(SIG_SWITCHES);
+        if (wasBothSwitches != isBothSwitches())
+            dispatch(SIG_BOTH_SWITCHES);
+    }
+}
+
+HsmStatus CarJack::root(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_ENTRY:
+            if (isBothSwitches())
+                armTimer(SIG_VOICE_MODE, VOICE_MODE_DELAY_MS);
+            return HSM_HANDLED;
+        case HSM_SIG_INIT:
+            return transition(isInput(INPUT_HANDLE_SENSOR) ? &s_manual : &s_automatic);
+        case SIG_MODE:
+            return transition(isInput(INPUT_HANDLE_SENSOR) ? &s_manual : &s_automatic);
+        case SIG_BOTH_SWITCHES:
+            //voicemode toggle
+            if (isBothSwitches())
+                armTimer(SIG_VOICE_MODE, VOICE_MODE_DELAY_MS);
+            else
+                disarmTimer(SIG_VOICE_MODE);
+            return HSM_HANDLED;
+        case SIG_VOICE_MODE:
+            m_io.toggleVoiceMode();
+            return HSM_HANDLED;
+    }
+    return HSM_HANDLED; //the remaining events are ignored
+}
+
+HsmStatus CarJack::manual(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_ENTRY:
+            m_io.stop();
+            m_io.enableStepper(false);
+            setSolenoid(false);
+            m_isInitialized = false;
+            m_io.setInitialized(false);
+            m_io.play(CarJackIO::SOUND_MANUAL_MODE);
+            return HSM_HANDLED;
+    }
+    return HSM_UNHANDLED;
+}
+
+HsmStatus CarJack::automatic(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_ENTRY:
+            m_io.enableStepper(true);
+            m_io.play(CarJackIO::SOUND_AUTOMATIC_MODE);
+            if (isInput(INPUT_LIMIT_SWITCH))
+                armTimer(SIG_LIMIT_SWITCH_DEBOUNCED, LIMIT_SWITCH_DEBOUNCE_MS);
+            return HSM_HANDLED;
+        case HSM_SIG_EXIT:
+            disarmTimer(SIG_LIMIT_SWITCH_DEBOUNCED);
+            return HSM_HANDLED;
+        case HSM_SIG_INIT:
+            return transition(selectDriveState());
+        case SIG_SWITCHES: {
+            const State* target = selectDriveState();
+            if (isIn(target))
+                return HSM_HANDLED;
+            return transition(target);
+        }
+        case SIG_LIMIT_SWITCH:
+            if (isInput(INPUT_LIMIT_SWITCH))
+                armTimer(SIG_LIMIT_SWITCH_DEBOUNCED, LIMIT_SWITCH_DEBOUNCE_MS);
+            else
+                disarmTimer(SIG_LIMIT_SWITCH_DEBOUNCED);
+            return HSM_HANDLED;
+        case SIG_LIMIT_SWITCH_DEBOUNCED:
+            //sets the stepcounter to 0 once per engagement, the timer is disarmed if the switch is released
+            m_isInitialized = true;
+            m_io.setInitialized(true);
+            return HSM_HANDLED;
+    }
+    return HSM_UNHANDLED;
+}
+
+HsmStatus CarJack::idle(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_ENTRY:
+            m_io.stop();
+            updateSolenoidReleaseTimer();
+            return HSM_HANDLED;
+        case HSM_SIG_EXIT:
+            disarmTimer(SIG_SOLENOID_RELEASE);
+            return HSM_HANDLED;
+        case SIG_SWITCHES:
+            //both switches pressed keeps the solenoid, automatic selects the state afterwards
+            updateSolenoidReleaseTimer();
+            return HSM_UNHANDLED;
+        case SIG_SOLENOID_RELEASE:
+            setSolenoid(false);
+            return HSM_HANDLED;
+    }
+    return HSM_UNHANDLED;
+}
+
+HsmStatus CarJack::down(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_INIT:
+            //no delay if the solenoid is still pulled back from the last time
+            return transition(m_isSolenoidHeld ? &s_lowering : &s_unlatching);
+    }
+    return HSM_UNHANDLED;
+}
+
+HsmStatus CarJack::unlatching(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_ENTRY:
+            setSolenoid(true);
+            armTimer(SIG_SOLENOID_HOLD, DRIVE_DOWN_DELAY_MS);
+            return HSM_HANDLED;
+        case HSM_SIG_EXIT:
+            disarmTimer(SIG_SOLENOID_HOLD);
+            return HSM_HANDLED;
+        case SIG_SOLENOID_HOLD:
+            m_isSolenoidHeld = true;
+            return transition(&s_lowering);
+    }
+    return HSM_UNHANDLED;
+}
+
+HsmStatus CarJack::lowering(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_ENTRY:
+            m_isMaxVelocity = false;
+            armTimer(SIG_MOVE_POLL, 0);
+            return HSM_HANDLED;
+        case HSM_SIG_EXIT:
+            disarmTimer(SIG_MOVE_POLL);
+            return HSM_HANDLED;
+        case SIG_MOVE_POLL:
+            //ramp up the motor, then drive to the lowest pos (or down until the limit switch if not initialized)
+            if (!m_isMaxVelocity)
+                m_isMaxVelocity = m_io.rampDown();
+            if (m_isMaxVelocity && m_io.down()) {
+                playOnce(CarJackIO::SOUND_IN_LOWER_POS);
+                return HSM_HANDLED;
+            }
+            armTimer(SIG_MOVE_POLL, MOVE_POLL_MS);
+            return HSM_HANDLED;
+    }
+    return HSM_UNHANDLED;
+}
+
+HsmStatus CarJack::up(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_INIT:
+            return transition(m_isInitialized ? &s_raising : &s_notInitialized);
+    }
+    return HSM_UNHANDLED;
+}
+
+HsmStatus CarJack::notInitialized(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_ENTRY:
+            playOnce(CarJackIO::SOUND_NOT_INITIALIZED);
+            return HSM_HANDLED;
+    }
+    return HSM_UNHANDLED;
+}
+
+HsmStatus CarJack::raising(const HsmEvent& e)
+{
+    switch (e.signal) {
+        case HSM_SIG_ENTRY:
+            m_isMaxVelocity = false;
+            armTimer(SIG_MOVE_POLL, 0);
+            return HSM_HANDLED;
+        case HSM_SIG_EXIT:
+            disarmTimer(SIG_MOVE_POLL);
+            return HSM_HANDLED;
+        case SIG_MOVE_POLL:
+            //ramp up the motor, release the solenoid at full speed and drive to the top pos
+            if (!m_isMaxVelocity)
+                m_isMaxVelocity = m_io.rampUp();
+            if (m_isMaxVelocity) {
+                setSolenoid(false);
+                if (m_io.up()) {
+                    playOnce(CarJackIO::SOUND_IN_UPPER_POS);
+                    return HSM_HANDLED;
+                }
+            }
+            armTimer(SIG_MOVE_POLL, MOVE_POLL_MS);
+            return HSM_HANDLED;
+    }
+    return HSM_UNHANDLED;
+}
+
+const CarJack::State* CarJack::selectDriveState() const
+{
+    if (isInput(INPUT_DOWN_SWITCH) && !isInput(INPUT_UP_SWITCH))
+        return &s_down;
+    if (isInput(INPUT_UP_SWITCH) && !isInput(INPUT_DOWN_SWITCH))
+        return &s_up;
+    return &s_idle;
+}
+
+void CarJack::setSolenoid(bool pullBack)
+{
+    if (!pullBack)
+        m_isSolenoidHeld = false;
+    m_isSolenoidPulledBack = pullBack;
+    m_io.setSolenoid(pullBack);
+}
+
+void CarJack::playOnce(CarJackIO::Sound sound)
+{
+    if (m_lastSoundPlayed == sound)
+        return;
+    m_lastSoundPlayed = sound;
+    m_io.play(sound);
+}
+
+void CarJack::updateSolenoidReleaseTimer()
+{
+    //the delay starts when the down switch is released
+    if (!m_isSolenoidPulledBack || isInput(INPUT_DOWN_SWITCH))
+        disarmTimer(SIG_SOLENOID_RELEASE);
+    else if (!isTimerArmed(SIG_SOLENOID_RELEASE))
+        armTimer(SIG_SOLENOID_RELEASE, SOLENOID_RELEASE_DELAY_MS);
+}
@@ -0,0 +1,152 @@
+/**
+ * @file CarJack.h
+ * @brief State machine of the car jack, reacts to the input events instead of polling the inputs every 20 ms
+ *
+ * States (the inner states handle the events first, the outer ones what is left):
+ *
+ *     root                     handle sensor -> manual / automatic, up + down switch 3 s -> toggle voice mode
+ *     |- manual                stepper disabled, solenoid released
+ *     |- automatic             stepper enabled, limit switch 60 ms engaged -> rotation 0, up/down switch -> substate
+ *        |- idle               stops, releases the solenoid 3 s after the down switch was released
+ *        |- down
+ *        |  |- unlatching      pulls the solenoid back and waits 400 ms
+ *        |  |- lowering        ramps down and drives to the lowest position (homes if not initialized)
+ *        |- up
+ *           |- notInitialized  the lowest position is unknown, only plays the message
+ *           |- raising         ramps up, releases the solenoid at full speed and drives to the top position
+ *
+ * Only lowering and raising poll the stepper (every 20 ms until the end position is reached), in all other
+ * states the thread sleeps until an input changes or a timer expires.
+ *
+ * The hardware is accessed through CarJackIO, so the same state machine runs in main.cpp and on the host
+ * (docs/dev/dev_car_jack replays input traces against it).
+ *
+ * @dependencies
+ * - **Hsm**: The state machine framework
+ *
+ * @example
+ * ```cpp
+ * CarJack carJack(io);
+ * carJack.begin(inputs, time_ms);
+ * // whenever an input interrupt woke the thread or carJack.getTimeToNextTimerMs() elapsed
+ * carJack.update(inputs, time_ms);
+ * ```
+ *
+ * @author M. Peter / pmic / pichim
+ */
+
+#ifndef CAR_JACK_H_
+#define CAR_JACK_H_
+
+#include <stdint.h>
+
+#include "Hsm.h"
+
+//Actions of the state machine on the hardware
+class CarJackIO
+{
+public:
+    typedef enum {
+        SOUND_NOT_INITIALIZED,
+        SOUND_IN_UPPER_POS,
+        SOUND_IN_LOWER_POS,
+        SOUND_MANUAL_MODE,
+        SOUND_AUTOMATIC_MODE
+    } Sound;
+
+    virtual ~CarJackIO() = default;
+
+    virtual void enableStepper(bool enable) = 0;
+    virtual void setSolenoid(bool pullBack) = 0;
+    virtual void stop() = 0;                    //stops the stepper with the ramp
+    virtual bool rampUp() = 0;                  //returns true if max speed upwards has been reached
+    virtual bool rampDown() = 0;                //returns true if max speed downwards has been reached
+    virtual bool up() = 0;                      //returns true if the top pos has been reached
+    virtual bool down() = 0;                    //returns true if the lowest pos has been reached
+    virtual void setInitialized(bool isInitialized) = 0;   //true: the stepper is at the limit switch, rotation 0
+    virtual void play(Sound sound) = 0;
+    virtual void toggleVoiceMode() = 0;
+};
+
+class CarJack : public Hsm<CarJack>
+{
+public:
+    //Input levels, the bits are set if the input is active
+    typedef enum {
+        INPUT_LIMIT_SWITCH = 1 << 0,    //engaged
+        INPUT_UP_SWITCH = 1 << 1,
+        INPUT_DOWN_SWITCH = 1 << 2,
+        INPUT_HANDLE_SENSOR = 1 << 3    //manual mode
+    } Input;
+
+    static const uint32_t LIMIT_SWITCH_DEBOUNCE_MS = 60;    //time the limit switch has to be engaged
+    static const uint32_t VOICE_MODE_DELAY_MS = 3000;       //time both switches have to be pressed to toggle the voice mode
+    static const uint32_t SOLENOID_RELEASE_DELAY_MS = 3000; //delay between releasing the down switch and releasing the solenoid
+    static const uint32_t DRIVE_DOWN_DELAY_MS = 400;        //delay between pulling the solenoid back and driving the carjack down
+    static const uint32_t MOVE_POLL_MS = 20;                //period to follow the stepper while it is driving
+
+    explicit CarJack(CarJackIO& io);
+    virtual ~CarJack() = default;
+
+    //enters the state of the inputs
+    void begin(uint8_t inputs, uint32_t timeMs);
+
+    //dispatches the expired timers and the changed inputs, call it after every input interrupt and when
+    //getTimeToNextTimerMs() elapsed
+    void update(uint8_t inputs, uint32_t timeMs);
+
+    const char* getStateName() const { return getState() ? getState()->name : ""; }
+    bool isInitialized() const { return m_isInitialized; }
+
+private:
+    typedef enum {
+        SIG_MODE = HSM_SIG_USER,        //handle sensor changed
+        SIG_SWITCHES,                   //up or down switch changed
+        SIG_BOTH_SWITCHES,              //both switches got pressed or one of them released
+        SIG_LIMIT_SWITCH,               //limit switch changed
+        SIG_LIMIT_SWITCH_DEBOUNCED,
+        SIG_VOICE_MODE,
+        SIG_SOLENOID_RELEASE,
+        SIG_SOLENOID_HOLD,
+        SIG_MOVE_POLL
+    } Signal;
+
+    CarJackIO& m_io;
+
+    uint8_t m_inputs = 0;
+    bool m_isInitialized = false;
+    bool m_isSolenoidPulledBack = false;    //solenoid is on, no matter how long
+    bool m_isSolenoidHeld = false;          //solenoid has been pulled back for DRIVE_DOWN_DELAY_MS
+    bool m_isMaxVelocity = false;
+    int m_lastSoundPlayed = -1;             //to not play the end position messages repeatedly
+
+    static const State s_root;
+    static const State s_manual;
+    static const State s_automatic;
+    static const State s_idle;
+    static const State s_down;
+    static const State s_unlatching;
+    static const State s_lowering;
+    static const State s_up;
+    static const State s_notInitialized;
+    static const State s_raising;
+
+    HsmStatus root(const HsmEvent& e);
+    HsmStatus manual(const HsmEvent& e);
+    HsmStatus automatic(const HsmEvent& e);
+    HsmStatus idle(const HsmEvent& e);
+    HsmStatus down(const HsmEvent& e);
+    HsmStatus unlatching(const HsmEvent& e);
+    HsmStatus lowering(const HsmEvent& e);
+    HsmStatus up(const HsmEvent& e);
+    HsmStatus notInitialized(const HsmEvent& e);
+    HsmStatus raising(const HsmEvent& e);
+
+    bool isInput(uint8_t input) const { return (m_inputs & input) != 0; }
+    bool isBothSwitches() const { return isInput(INPUT_UP_SWITCH) && isInput(INPUT_DOWN_SWITCH); }
+    const State* selectDriveState() const;
+    void setSolenoid(bool pullBack);
+    void playOnce(CarJackIO::Sound sound);
+    void updateSolenoidReleaseTimer();
+};
+#endif /* CAR_JACK_H_ */
@@ -2,13 +2,27 @@
 #include <SerialStream.h>
 #include <iostream>
 
-#define _DEBUG
+// #define _DEBUG // traces every sent frame and received event with printf, which blocks the caller of available()
 
 
 DFRobotDFPlayerMini::DFRobotDFPlayerMini(PinName RX, PinName TX, PinName BUSY)
-    : serial(TX, RX, 9600), BusyPin(BUSY)
+    : serial(TX, RX, 9600), BusyPin(BUSY),
+      _commandQueue(DFPLAYER_COMMAND_QUEUE_SIZE), _eventQueue(DFPLAYER_EVENT_QUEUE_SIZE),
+      _thread(osPriorityBelowNormal)
 {
+  for (int i=0; i<0x10; i++) {
+    _queryValues[i] = -1;
+  }
 
+  //received bytes are framed in the interrupt, the commands are sent by the thread
+  serial.attach(callback(this, &DFRobotDFPlayerMini::onRxInterrupt), SerialBase::RxIrq);
+  _thread.start(callback(this, &DFRobotDFPlayerMini::threadTask));
+}
+
+DFRobotDFPlayerMini::~DFRobotDFPlayerMini()
+{
+  serial.attach(nullptr, SerialBase::RxIrq);
+  _thread.terminate();
 }
 
 bool DFRobotDFPlayerMini::getBusyState(){
@@ -40,13 +54,33 @@ uint16_t DFRobotDFPlayerMini::calculateCheckSum(uint8_t *buffer){
   return -sum;
 }
 
-void DFRobotDFPlayerMini::sendStack(){
-  if (_sending[Stack_ACK]) {  //if the ack mode is on wait until the last transmition
-    while (_isSending) {
-      
-      waitAvailable();
-    }
+void DFRobotDFPlayerMini::sendStack(uint8_t command){
+  sendStack(command, 0);
+}
+
+void DFRobotDFPlayerMini::sendStack(uint8_t command, uint16_t argument){
+  //only queue the command, the thread sends it
+  command_t cmd = {command, argument};
+  if (!_commandQueue.push(cmd)) {
+#ifdef _DEBUG
+    printf("DFPlayer: command queue full, 0x%02X dropped\n", command);
+#endif
+    return;
   }
+  _thread.flags_set(_commandFlag);
+}
+
+void DFRobotDFPlayerMini::sendStack(uint8_t command, uint8_t argumentHigh, uint8_t argumentLow){
+  uint16_t buffer = argumentHigh;
+  buffer <<= 8;
+  sendStack(command, buffer | argumentLow);
+}
+
+//only called from the thread
+void DFRobotDFPlayerMini::writeStack(uint8_t command, uint16_t argument){
+  _sending[Stack_Command] = command;
+  uint16ToArray(argument, _sending+Stack_Parameter);
+  uint16ToArray(calculateCheckSum(_sending), _sending+Stack_CheckSum);
 
 #ifdef _DEBUG
   printf("\n");
@@ -58,29 +92,51 @@ void DFRobotDFPlayerMini::sendStack(){
   printf("\n");
 #endif
   serial.write(_sending, DFPLAYER_SEND_LENGTH);
-  _timeOutTimer  = Kernel::get_ms_count();
-  _isSending = _sending[Stack_ACK];
-  
-  if (!_sending[Stack_ACK]) { //if the ack mode is off wait 10 ms after one transmition.
-    
-  }
 }
 
-void DFRobotDFPlayerMini::sendStack(uint8_t command){
-  sendStack(command, 0);
+int DFRobotDFPlayerMini::queryStack(uint8_t command, uint16_t argument){
+  sendStack(command, argument);
+  return _queryValues[command & 0x0F];
 }
 
-void DFRobotDFPlayerMini::sendStack(uint8_t command, uint16_t argument){
-  _sending[Stack_Command] = command;
-  uint16ToArray(argument, _sending+Stack_Parameter);
-  uint16ToArray(calculateCheckSum(_sending), _sending+Stack_CheckSum);
-  sendStack();
-}
+void DFRobotDFPlayerMini::threadTask(){
+  while (true) {
+    ThisThread::flags_wait_any(_commandFlag);
 
-void DFRobotDFPlayerMini::sendStack(uint8_t command, uint8_t argumentHigh, uint8_t argumentLow){
-  uint16_t buffer = argumentHigh;
-  buffer <<= 8;
-  sendStack(command, buffer | argumentLow);
+    command_t cmd;
+    while (_commandQueue.pop(cmd)) {
+      //a late answer of the last command must not count for this one
+      ThisThread::flags_clear(_replyFlag | _onlineFlag);
+
+      const bool isWaiting = isQuery(cmd.command) || _sending[Stack_ACK];
+      if (isWaiting) {
+        _pendingQuery = isQuery(cmd.command) ? cmd.command : 0x41;
+      }
+      writeStack(cmd.command, cmd.argument);
+
+      if (cmd.command == 0x0C) {
+        //after a reset the module needs a while until it reports that it is online
+        _isOnline = false;
+        if (ThisThread::flags_wait_any_for(_onlineFlag, std::chrono::milliseconds(DFPLAYER_RESET_TIMEOUT_MS)) & osFlagsError) {
+#ifdef _DEBUG
+          printf("DFPlayer: Keine Antwort nach Reset!\n");
+#endif
+          _isTimeOut = true;
+        }
+      }
+      else if (isWaiting) {
+        if (ThisThread::flags_wait_any_for(_replyFlag, std::chrono::milliseconds(_timeOutDuration)) & osFlagsError) {
+#ifdef _DEBUG
+          printf("DFPlayer: Timeout 0x%02X\n", cmd.command);
+#endif
+          _isTimeOut = true;
+        }
+      }
+      _pendingQuery = 0;
+
+      ThisThread::sleep_for(std::chrono::milliseconds(DFPLAYER_COMMAND_GAP_MS));
+    }
+  }
 }
 
 void DFRobotDFPlayerMini::enableACK(){
@@ -100,7 +156,7 @@ bool DFRobotDFPlayerMini::waitAvailable(unsigned long duration){
     if (Kernel::get_ms_count() - timer > duration) {
       return handleError(TimeOut);
     }
-    
+    ThisThread::sleep_for(1ms);
   }
   return true;
 }
@@ -114,39 +170,14 @@ bool DFRobotDFPlayerMini::begin(bool isACK, bool doReset)
         disableACK();
     }
 
-    // Optionaler Reset
+    // Optionaler Reset, die Online-Meldung kommt später als Event (isOnline())
     if (doReset) {
-        reset();
-
-        // Warten auf echte Antwort vom DFPlayer
-        if (!waitAvailable(2000)) {
-#ifdef _DEBUG
-            printf("DFPlayer: Keine Antwort nach Reset!\n");
-#endif
-            return false;   // DFPlayer antwortet nicht
+        if (_commandQueue.full()) {
+            return false;
         }
+        reset();
     }
-
-    // Rückmeldung genau EINMAL auslesen
-    uint8_t type = readType();
-
-#ifdef _DEBUG
-    printf("DFPlayer begin(): Antwort-Typ = 0x%02X\n", type);
-#endif
-
-    // Gültige Online-Zustände prüfen
-    if (type == DFPlayerCardOnline ||
-        type == DFPlayerUSBOnline  ||
-        type == DFPlayerCardUSBOnline) {
-        return true;
-    }
-
-    // Falls ACK deaktiviert ist, nicht auf Rückmeldung bestehen
-    if (!isACK) {
-        return true;
-    }
-
-    return false;
+    return true;
 }
 
 uint8_t DFRobotDFPlayerMini::readType(){
@@ -160,7 +191,6 @@ uint16_t DFRobotDFPlayerMini::read(){
 }
 
 bool DFRobotDFPlayerMini::handleMessage(uint8_t type, uint16_t parameter){
-  _receivedIndex = 0;
   _handleType = type;
   _handleParameter = parameter;
   _isAvailable = true;
@@ -169,7 +199,6 @@ bool DFRobotDFPlayerMini::handleMessage(uint8_t type, uint16_t parameter){
 
 bool DFRobotDFPlayerMini::handleError(uint8_t type, uint16_t parameter){
   handleMessage(type, parameter);
-  _isSending = false;
   return false;
 }
 
@@ -178,50 +207,60 @@ uint8_t DFRobotDFPlayerMini::readCommand(){
   return _handleCommand;
 }
 
+//called from the RX interrupt with a valid stack
 void DFRobotDFPlayerMini::parseStack(){
-  uint8_t handleCommand = *(_received + Stack_Command);
-  if (handleCommand == 0x41) { //handle the 0x41 ack feedback as a spcecial case, in case the pollusion of _handleCommand, _handleParameter, and _handleType.
-    _isSending = false;
+  const uint8_t command = *(_received + Stack_Command);
+  const uint16_t parameter = arrayToUint16(_received + Stack_Parameter);
+
+  //the thread waits for the ack or the reply of its query
+  if (_pendingQuery && (command == _pendingQuery || command == 0x41 || command == 0x40)) {
+    _thread.flags_set(_replyFlag);
+  }
+  if (command == 0x41) { //handle the 0x41 ack feedback as a spcecial case, it is not an event
     return;
   }
-  
-  _handleCommand = handleCommand;
-  _handleParameter =  arrayToUint16(_received + Stack_Parameter);
+  if (isQuery(command)) {
+    _queryValues[command & 0x0F] = parameter;
+  }
+  if (command == 0x3F) {
+    _isOnline = true;
+    _thread.flags_set(_onlineFlag);
+  }
 
-  switch (_handleCommand) {
+  switch (command) {
     case 0x3C:
     case 0x3D:
-      handleMessage(DFPlayerPlayFinished, _handleParameter);
+      pushEvent(DFPlayerPlayFinished, parameter);
       break;
     case 0x3F:
-      if (_handleParameter & 0x01) {
-        handleMessage(DFPlayerUSBOnline, _handleParameter);
+      if (parameter & 0x01) {
+        pushEvent(DFPlayerUSBOnline, parameter);
       }
-      else if (_handleParameter & 0x02) {
-        handleMessage(DFPlayerCardOnline, _handleParameter);
+      else if (parameter & 0x02) {
+        pushEvent(DFPlayerCardOnline, parameter);
       }
-      else if (_handleParameter & 0x03) {
-        handleMessage(DFPlayerCardUSBOnline, _handleParameter);
+      else if (parameter & 0x03) {
+        pushEvent(DFPlayerCardUSBOnline, parameter);
       }
       break;
     case 0x3A:
-      if (_handleParameter & 0x01) {
-        handleMessage(DFPlayerUSBInserted, _handleParameter);
+      if (parameter & 0x01) {
+        pushEvent(DFPlayerUSBInserted, parameter);
       }
-      else if (_handleParameter & 0x02) {
-        handleMessage(DFPlayerCardInserted, _handleParameter);
+      else if (parameter & 0x02) {
+        pushEvent(DFPlayerCardInserted, parameter);
       }
       break;
     case 0x3B:
-      if (_handleParameter & 0x01) {
-        handleMessage(DFPlayerUSBRemoved, _handleParameter);
+      if (parameter & 0x01) {
+        pushEvent(DFPlayerUSBRemoved, parameter);
       }
-      else if (_handleParameter & 0x02) {
-        handleMessage(DFPlayerCardRemoved, _handleParameter);
+      else if (parameter & 0x02) {
+        pushEvent(DFPlayerCardRemoved, parameter);
       }
       break;
     case 0x40:
-      handleMessage(DFPlayerError, _handleParameter);
+      pushEvent(DFPlayerError, parameter);
       break;
     case 0x3E:
     case 0x42:
@@ -237,10 +276,10 @@ void DFRobotDFPlayerMini::parseStack(){
     case 0x4D:
     case 0x4E:
     case 0x4F:
-      handleMessage(DFPlayerFeedBack, _handleParameter);
+      pushEvent(DFPlayerFeedBack, parameter);
       break;
     default:
-      handleError(WrongStack);
+      pushEvent(WrongStack);
       break;
   }
 }
@@ -256,78 +295,74 @@ bool DFRobotDFPlayerMini::validateStack(){
   return calculateCheckSum(_received) == arrayToUint16(_received+Stack_CheckSum);
 }
 
-bool DFRobotDFPlayerMini::available(){
-  while (serial.readable()) {
-    
-    if (_receivedIndex == 0) {
-        uint8_t b;
-
-        int result = serial.read(&b, 1);
-        if (result == 1) {
-        _received[_receivedIndex] = b;
-    }
+void DFRobotDFPlayerMini::pushEvent(uint8_t type, uint16_t parameter){
+  //a full queue drops the newest event, the caller did not read the older ones yet
+  event_t event = {type, _received[Stack_Command], parameter};
+  _eventQueue.push(event);
+}
 
-#ifdef _DEBUG
-      printf("received:");
-      printf("0x%02X ",_received[_receivedIndex]);
-      printf(" ");
-#endif
-      if (_received[Stack_Header] == 0x7E) {
-        _receivedIndex ++;
+void DFRobotDFPlayerMini::onRxInterrupt(){
+  uint8_t b;
+  while (serial.readable() && serial.read(&b, 1) == 1) {
+    parseByte(b);
+  }
+}
+
+//called from the RX interrupt for every received byte
+void DFRobotDFPlayerMini::parseByte(uint8_t b){
+  _received[_receivedIndex] = b;
+  switch (_receivedIndex) {
+    case Stack_Header:
+      if (b != 0x7E) {
+        return;
       }
-    }
-    else{
-        uint8_t b;
-        int result = serial.read(&b, 1);
-        if (result == 1) {
-            _received[_receivedIndex] = b;   // ✅ RICHTIG
-        } else {
-            return false;
-        }
-#ifdef _DEBUG
-      printf("0x%02X ",_received[_receivedIndex]);
-      printf(" ");
-#endif
-      switch (_receivedIndex) {
-        case Stack_Version:
-          if (_received[_receivedIndex] != 0xFF) {
-            return handleError(WrongStack);
-          }
-          break;
-        case Stack_Length:
-          if (_received[_receivedIndex] != 0x06) {
-            return handleError(WrongStack);
-          }
-          break;
-        case Stack_End:
-#ifdef _DEBUG
-          printf("\n");
-#endif
-          if (_received[_receivedIndex] != 0xEF) {
-            return handleError(WrongStack);
-          }
-          else{
-            if (validateStack()) {
-              _receivedIndex = 0;
-              parseStack();
-              return _isAvailable;
-            }
-            else{
-              return handleError(WrongStack);
-            }
-          }
-          break;
-        default:
-          break;
+      break;
+    case Stack_Version:
+      if (b != 0xFF) {
+        _receivedIndex = 0;
+        pushEvent(WrongStack);
+        return;
       }
-      _receivedIndex++;
-    }
+      break;
+    case Stack_Length:
+      if (b != 0x06) {
+        _receivedIndex = 0;
+        pushEvent(WrongStack);
+        return;
+      }
+      break;
+    case Stack_End:
+      _receivedIndex = 0;
+      if (b != 0xEF || !validateStack()) {
+        pushEvent(WrongStack);
+      }
+      else{
+        parseStack();
+      }
+      return;
+    default:
+      break;
   }
-  
-  
-  return _isAvailable;
+  _receivedIndex++;
 }
 
+bool DFRobotDFPlayerMini::available(){
+  if (_isTimeOut) {
+    _isTimeOut = false;
+    handleError(TimeOut);
+    return true;
+  }
+
+  event_t event;
+  if (!_eventQueue.pop(event)) {
+    return _isAvailable;
+  }
+  _handleCommand = event.command;
+#ifdef _DEBUG
+  printf("received: type %d, command 0x%02X, parameter %d\n", event.type, event.command, event.parameter);
+#endif
+  return handleMessage(event.type, event.parameter);
+}
 
 void DFRobotDFPlayerMini::next(){
   sendStack(0x01);
@@ -446,128 +481,49 @@ void DFRobotDFPlayerMini::disableDAC(){
 }
 
 int DFRobotDFPlayerMini::readState(){
-  sendStack(0x42);
-  if (waitAvailable()) {
-    if (readType() == DFPlayerFeedBack) {
-      return read();
-    }
-    else{
-      return -1;
-    }
-  }
-  else{
-    return -1;
-  }
+  return queryStack(0x42);
 }
 
 int DFRobotDFPlayerMini::readVolume(){
-  sendStack(0x43);
-  if (waitAvailable()) {
-    return read();
-  }
-  else{
-    return -1;
-  }
+  return queryStack(0x43);
 }
 
 int DFRobotDFPlayerMini::readEQ(){
-  sendStack(0x44);
-  if (waitAvailable()) {
-    if (readType() == DFPlayerFeedBack) {
-      return read();
-    }
-    else{
-      return -1;
-    }
-  }
-  else{
-    return -1;
-  }
+  return queryStack(0x44);
 }
 
 int DFRobotDFPlayerMini::readFileCounts(uint8_t device){
   switch (device) {
     case DFPLAYER_DEVICE_U_DISK:
-      sendStack(0x47);
-      break;
+      return queryStack(0x47);
     case DFPLAYER_DEVICE_SD:
-      sendStack(0x48);
-      break;
+      return queryStack(0x48);
     case DFPLAYER_DEVICE_FLASH:
-      sendStack(0x49);
-      break;
+      return queryStack(0x49);
     default:
-      break;
-  }
-  
-  if (waitAvailable()) {
-    if (readType() == DFPlayerFeedBack) {
-      return read();
-    }
-    else{
       return -1;
-    }
-  }
-  else{
-    return -1;
   }
 }
 
 int DFRobotDFPlayerMini::readCurrentFileNumber(uint8_t device){
   switch (device) {
     case DFPLAYER_DEVICE_U_DISK:
-      sendStack(0x4B);
-      break;
+      return queryStack(0x4B);
     case DFPLAYER_DEVICE_SD:
-      sendStack(0x4C);
-      break;
+      return queryStack(0x4C);
     case DFPLAYER_DEVICE_FLASH:
-      sendStack(0x4D);
-      break;
+      return queryStack(0x4D);
     default:
-      break;
-  }
-  if (waitAvailable()) {
-    if (readType() == DFPlayerFeedBack) {
-      return read();
-    }
-    else{
       return -1;
-    }
-  }
-  else{
-    return -1;
   }
 }
 
 int DFRobotDFPlayerMini::readFileCountsInFolder(int folderNumber){
-  sendStack(0x4E, folderNumber);
-  if (waitAvailable()) {
-    if (readType() == DFPlayerFeedBack) {
-      return read();
-    }
-    else{
-      return -1;
-    }
-  }
-  else{
-    return -1;
-  }
+  return queryStack(0x4E, folderNumber);
 }
 
 int DFRobotDFPlayerMini::readFolderCounts(){
-  sendStack(0x4F);
-  if (waitAvailable()) {
-    if (readType() == DFPlayerFeedBack) {
-      return read();
-    }
-    else{
-      return -1;
-    }
-  }
-  else{
-    return -1;
-  }
+  return queryStack(0x4F);
 }
 
 int DFRobotDFPlayerMini::readFileCounts(){
@@ -6,9 +6,15 @@
 #include "lib/DebounceIn/DebounceIn.h"
 #include "lib\SerialStream\SerialStream.h"
 #include "ThreadFlag.h"
+#include "StepPulseEngine.h"
+#include "SPSCRingBuffer.h"
+#include "CarJack.h"
 #include <cstdint>
 
 
+// The player does not block the caller: commands are queued and sent by a low priority thread that keeps
+// the gap the module needs between two commands (and waits for the ack or the reply of a query), received
+// bytes are framed in the RX interrupt and the messages are queued as events for available()/readType()/read().
 class DFRobotDFPlayerMini{
 private:
 
@@ -28,6 +34,11 @@ private:
     #define DFPLAYER_RECEIVED_LENGTH 10
     #define DFPLAYER_SEND_LENGTH 10
 
+    #define DFPLAYER_COMMAND_QUEUE_SIZE 8
+    #define DFPLAYER_EVENT_QUEUE_SIZE 8
+    #define DFPLAYER_COMMAND_GAP_MS 100     //the module drops commands that follow each other too fast
+    #define DFPLAYER_RESET_TIMEOUT_MS 2000  //time the module needs to be online again after a reset
+
     //#define _DEBUG
 
     #define TimeOut 0
@@ -60,11 +71,10 @@ private:
     #define Stack_CheckSum 7
     #define Stack_End 9
 
-    BufferedSerial serial;
+    UnbufferedSerial serial;
 
     DigitalIn BusyPin;
 
-    unsigned long _timeOutTimer;
     unsigned long _timeOutDuration = 500;
 
     uint8_t _received[DFPLAYER_RECEIVED_LENGTH];
@@ -72,10 +82,41 @@ private:
 
     uint8_t _receivedIndex=0;
 
-    void sendStack();
+    //command from the caller to the sending thread
+    struct command_t {
+      uint8_t command;
+      uint16_t argument;
+    };
+    //message from the RX interrupt to the caller
+    struct event_t {
+      uint8_t type;
+      uint8_t command;
+      uint16_t parameter;
+    };
+
+    SPSCRingBuffer<command_t> _commandQueue;
+    SPSCRingBuffer<event_t> _eventQueue;
+
+    Thread _thread;
+    ThreadFlag _commandFlag;  //a command was queued
+    ThreadFlag _replyFlag;    //the ack or the reply of the pending query was received
+    ThreadFlag _onlineFlag;   //the module reported that it is online
+
+    volatile uint8_t _pendingQuery = 0;   //query that the sending thread waits for, 0 if none
+    volatile bool _isTimeOut = false;     //the sending thread did not get an answer in time
+    volatile bool _isOnline = false;
+    volatile int _queryValues[0x10];      //last reply of the queries 0x40 - 0x4F, -1 if there was none
+
     void sendStack(uint8_t command);
     void sendStack(uint8_t command, uint16_t argument);
     void sendStack(uint8_t command, uint8_t argumentHigh, uint8_t argumentLow);
+    void writeStack(uint8_t command, uint16_t argument);
+    int queryStack(uint8_t command, uint16_t argument = 0);
+
+    void threadTask();
+    void onRxInterrupt();
+    void parseByte(uint8_t b);
+    void pushEvent(uint8_t type, uint16_t parameter = 0);
 
     void enableACK();
     void disableACK();
@@ -88,6 +129,7 @@ private:
 
     void parseStack();
     bool validateStack();
+    bool isQuery(uint8_t command) const { return command >= 0x40 && command <= 0x4F; }
 
     uint8_t device = DFPLAYER_DEVICE_SD;
 
@@ -97,6 +139,7 @@ private:
 public:
 
     explicit DFRobotDFPlayerMini(PinName RX, PinName TX, PinName BUSY);
+    virtual ~DFRobotDFPlayerMini();
 
     bool getBusyState();
     bool getBaneModeState();
@@ -116,17 +159,23 @@ public:
     uint8_t _handleCommand;
     uint16_t _handleParameter;
     bool _isAvailable = false;
-    bool _isSending = false;
 
     bool handleMessage(uint8_t type, uint16_t parameter = 0);
     bool handleError(uint8_t type, uint16_t parameter = 0);
 
     uint8_t readCommand();
 
+    //returns immediately, the reset and the commands that follow are sent as soon as the module is
+    //online again, false if the command queue is full
     bool begin(bool isACK = false, bool doReset = true);
 
+    //true after the module reported that it is online
+    bool isOnline() const { return _isOnline; }
+
+    //blocks the caller (sleeping) until an event is available, do not use it in the control loop
     bool waitAvailable(unsigned long duration = 0);
 
+    //true if an event is available, never blocks
     bool available();
 
     uint8_t readType();
@@ -191,6 +240,8 @@ public:
 
     void disableDAC();
 
+    //the queries never block: they queue the query and return the last reply (-1 if there was none yet),
+    //the reply also arrives as DFPlayerFeedBack event with readCommand() equal to the query
     int readState();
 
     int readVolume();
@@ -222,6 +273,9 @@ public:
      * Initializes the stepper motor with specified step and direction pins.
      * Optionally, the steps per revolution can be set, defaulting to 200 * 16 steps.
      *
+     * The step pulses are generated by the StepPulseEngine from a one-shot timer interrupt, the
+     * engine owns the acceleration profile (maxVelocity is reached within rampUpTime).
+     *
      * @param step_pin Pin to control the stepping pulses.
      * @param dir_pin Pin to control the direction of rotation.
      * @param step_per_rev Number of steps per revolution (default is 3200).
@@ -233,15 +287,13 @@ public:
      */
     virtual ~Stepper();
 
-    bool rampUp(uint8_t mainExecutionTime);   //steadily increases motorspeed to lift the jack, returns true if max speed has been reached
-                                                    //needs set execution time of mainloop
+    bool rampUp();      //drives upwards, the engine ramps the speed up, returns true if max speed has been reached
 
-    bool rampDown(uint8_t mainExecutionTime);       //steadily increases motorspeed to lower the jack, returns true if max (negative) speed has been reached
-                                                    //needs set execution time of mainloop
+    bool rampDown();    //drives downwards, the engine ramps the speed up, returns true if max (negative) speed has been reached
                                                     
-    bool up();      //lifts the jack with constant speed, returns 1 if top pos has been reached
+    bool up();      //drives to the top pos, decelerates in time, returns 1 if top pos has been reached
 
-    bool down();    //lowers the jack with constant speed, returns 1 if lowest pos has been reached
+    bool down();    //drives to the lowest pos (if initialized), decelerates in time, returns 1 if lowest pos has been reached
 
     /**
      * @brief Sets the internal rotation of the motor.
@@ -250,12 +302,13 @@ public:
      *
      * @param rotations The rotation count to set (default is 0.0f).
      */
-    void setInternalRotation(float rotations = 0.0f) { m_steps = static_cast<int>(rotations * m_steps_per_rev + 0.5f); };
+    void setInternalRotation(float rotations = 0.0f);
 
     /**
      * @brief Sets the motor's velocity.
      *
-     * Adjusts the speed of the motor's movement.
+     * Adjusts the speed of the motor's movement, the engine accelerates and decelerates with
+     * the ramp, 0 stops the motor with the ramp.
      *
      * @param velocity The new velocity to set.
      */
@@ -268,7 +321,7 @@ public:
      *
      * @return Current velocity.
      */
-    float getVelocity() const { return m_velocity; };
+    float getVelocity() const { return m_Engine.getVelocity(); };
 
     /**
      * @brief Gets the current rotation count.
@@ -277,13 +330,11 @@ public:
      *
      * @return Current rotation count.
      */
-    float getRotation() const { return static_cast<float>(m_steps) / m_steps_per_rev; };
+    float getRotation() const { return static_cast<float>(m_Engine.getSteps()) / m_steps_per_rev; };
 
 
 private:
-    static constexpr int PULSE_MUS = 10;
-    static constexpr int STEPS_MIN = std::numeric_limits<int>::min();
-    static constexpr int STEPS_MAX = std::numeric_limits<int>::max();
+    static constexpr int PULSE_MUS = 5;         //High time of the step pulse and setup time of the direction in us
 
 
     const uint16_t maxVelocity = 12;             //Maximal Motorvelocity (rotations per second), max allowed: 16, max recomenden: 10
@@ -296,26 +347,25 @@ private:
     DigitalOut m_Step;
     DigitalOut m_Dir;
 
-    Thread m_Thread;
-    Ticker m_Ticker;
-    ThreadFlag m_ThreadFlag;
     Timeout m_Timeout;
+    Timeout m_PulseTimeout;     //Ends the step pulse and delays it after a change of the direction
+    Timer m_Timer;
+    int64_t m_time_next_mus;    //Time of the next timer event, the events are scheduled relative to each other
 
     float m_steps_per_rev;
-    float m_time_step_const;
 
-    int m_steps_setpoint;
-    int m_steps;
-    float m_velocity;
+    StepPulseEngine m_Engine;
 
-    int m_period_mus;  ///< Period of the step signal in microseconds.
+    //last command sent to the engine, commands are only sent if they change
+    bool m_is_velocity_command;
+    int m_steps_setpoint;
+    float m_velocity_setpoint;
 
-    void step();
-    void enableDigitalOutput();
-    void disableDigitalOutput();
-    void threadTask();
-    void sendThreadFlag();
-    float calcVelocity();
+    void onTimer();
+    void onPulseStart();
+    void onPulseEnd();
+    void startTimer();
+    bool sendCommand(StepPulseEngine::command_result_t result);    //starts the timer if needed, returns false if the command was discarded
 
     
     /**
@@ -328,15 +378,6 @@ private:
      */
     void setRotation(float rotations, float velocity = 1.0f);
 
-    /**
-     * @brief Sets the motor's rotation to a specified position.
-     *
-     * Moves the motor to the specified rotation count at the current velocity.
-     *
-     * @param rotations Target rotation position.
-     */
-    void setRotation(float rotations);
-
     /**
      * @brief Sets the motor's relative rotation at a given velocity.
      *
@@ -347,15 +388,6 @@ private:
      */
     void setRotationRelative(float rotations, float velocity = 1.0f);
 
-    /**
-     * @brief Sets the motor's relative rotation.
-     *
-     * Moves the motor by a specified relative rotation amount at the current velocity.
-     *
-     * @param rotations Relative rotation amount.
-     */
-    void setRotationRelative(float rotations);
-
 
     /**
      * @brief Sets the motor's steps to a specific value at a given velocity.
@@ -367,15 +399,6 @@ private:
      */
     void setSteps(int steps, float velocity);
 
-        /**
-     * @brief Sets the internal velocity of the motor.
-     *
-     * This function sets the internal velocity without moving the motor.
-     *
-     * @param velocity The velocity to set (default is 0.0f).
-     */
-    void setInternalVelocity(float velocity = 0.0f) { m_velocity = velocity; };
-
         /**
      * @brief Gets the current step setpoint.
      *
@@ -392,7 +415,7 @@ private:
      *
      * @return Current step position.
      */
-    int getSteps() const { return m_steps; };
+    int getSteps() const { return m_Engine.getSteps(); };
 
 
 };
@@ -16,11 +16,14 @@
 //Instantiates Inputs
 DebounceIn UserButton(PC_13);
 
-DigitalIn LimitSwitch(PC_8);
-DigitalIn UpSwitch(PC_10);
-DigitalIn DownSwitch(PC_11);
+//Every edge of the limit switch wakes the main thread, the state machine debounces it
+InterruptIn LimitSwitch(PC_8, PullDown);
 
-DigitalIn HandleSensor(PB_12);
+//The switches and the handle sensor wake the main thread once their level is stable
+DebounceIn UpSwitch(PC_10, PullDown);
+DebounceIn DownSwitch(PC_11, PullDown);
+
+DebounceIn HandleSensor(PB_12);
 
 //Instances Outputs
 DigitalOut EnableStepper(PC_6);
@@ -31,6 +34,10 @@ bool resetAll = false;          //Edge to reset the variables
 
 bool motorInitialized = false;      //if true, motor is initialized
 
+osThreadId_t mainThreadId;          //Thread that runs the state machine
+unsigned int inputFlag = 0;         //Flag that signals the main thread an input change
+volatile uint8_t debouncedInputs = 0;   //Stable levels of the switches and the handle sensor, written by the debounce callbacks
+
 //Function is called when the UserButton is pressed
 void executeMainFunction(){  
     //Switches executeMainTask when the UserButton is pressed
@@ -40,39 +47,71 @@ void executeMainFunction(){
         resetAll = true;
 }
 
-int main(){
-    //Function is called when the UserButton is pressed
-    UserButton.fall(&executeMainFunction);
-
-    LimitSwitch.mode(PullDown);
-    UpSwitch.mode(PullDown);
-    DownSwitch.mode(PullDown);
-
-    bool toggleModeDetected = false;    //detects if the mode (manual or automatic) has been changed
-    bool modeState = false;             //manual=1 or automatic=0
-
-    uint16_t limitSwitchReadCounter = 0;                 //Counts for how many loops in a row the Limitswitch has been enganged
-    const uint16_t limitSwitchReadCycles = 3; //3        //Cycles until the Limitswitch is being read as enaged
+//Function is called on every edge of the limit switch, the main thread reads the level
+void inputChanged(){
+    osThreadFlagsSet(mainThreadId, inputFlag);
+}
 
-    uint16_t bothSwitchesEngagedCounter = 0;                 //Counts for how many loops in a row both the up and down switch are being pressed
-    const uint16_t bothSwitchesEngagedDelay = 3000; //3000   //Delay until the Limitswitch is being read as enaged
+//Function is called when a switch or the handle sensor has been stable for the debounce time
+void setDebouncedInput(uint8_t input, bool isActive){
+    if(isActive) debouncedInputs |= input;
+    else         debouncedInputs &= ~input;
+    osThreadFlagsSet(mainThreadId, inputFlag);
+}
 
-    uint16_t solenoidReleaseCounter = 0;                    //Counts the loops until the solenoid gets release
-    const uint16_t solenoidReleaseDelay = 3000; //1500      //Delay between releasing the down switch and releasing the solenoid in ms
+uint8_t readInputs(){
+    uint8_t inputs = debouncedInputs;
+    if(!LimitSwitch.read()) inputs |= CarJack::INPUT_LIMIT_SWITCH;  //the limit switch is low if engaged
+    return inputs;
+}
 
-    uint16_t solenoidHoldCounter = 0;                       //Counts the loops until the the carjack can be driven down
-    const uint16_t driveDownDelay = 400; //400              //Delay between pulling the solenoid back and driving the carjack down in ms
+//Actions of the state machine on the hardware of the carjack
+class CarJackHardware : public CarJackIO
+{
+public:
+    CarJackHardware(Stepper& stepper, DFRobotDFPlayerMini* player) : m_Stepper(stepper), m_Player(player) {}
+
+    void enableStepper(bool enable) override { EnableStepper.write(enable); }
+    void setSolenoid(bool pullBack) override { Solenoid.write(pullBack); }
+    void stop() override { m_Stepper.setVelocity(0); }
+    bool rampUp() override { return m_Stepper.rampUp(); }
+    bool rampDown() override { return m_Stepper.rampDown(); }
+    bool up() override { return m_Stepper.up(); }
+    bool down() override { return m_Stepper.down(); }
+
+    void setInitialized(bool isInitialized) override {
+        //Sets the stepcounter to 0 when the LimitSwitch is engaged
+        if(isInitialized) m_Stepper.setInternalRotation(0);
+        motorInitialized = isInitialized;
+    }
 
-    const uint8_t mainTaskPeriod = 20; //20  //Executiontime of main whileloop
-    Timer MainTaskTimer;                      //Creates MainTaskTimer Object;
+    void play(Sound sound) override {
+        if(!m_Player) return;
+        switch(sound){
+            case SOUND_NOT_INITIALIZED: m_Player->play(DFRobotDFPlayerMini::notInitialized); break;
+            case SOUND_IN_UPPER_POS:    m_Player->play(DFRobotDFPlayerMini::inUpperPos); break;
+            case SOUND_IN_LOWER_POS:    m_Player->play(DFRobotDFPlayerMini::inLowerPos); break;
+            case SOUND_MANUAL_MODE:     m_Player->play(DFRobotDFPlayerMini::manualMode); break;
+            case SOUND_AUTOMATIC_MODE:  m_Player->play(DFRobotDFPlayerMini::automaticMode); break;
+        }
+    }
 
-    uint8_t lastTrackPlayed = 0;    //stores which track has been played to not play it repeadedly
+    void toggleVoiceMode() override {
+        if(m_Player) m_Player->setBaneModeState();
+    }
 
+private:
+    Stepper& m_Stepper;
+    DFRobotDFPlayerMini* m_Player;
+};
 
-    bool edgedetectionVoiceModes = false;   //stores the state of the Voicemode for edgedetection
+uint32_t getTimeMs(){
+    return static_cast<uint32_t>(Kernel::get_ms_count());
+}
 
-    //Starts the Timer
-    MainTaskTimer.start();
+int main(){
+    //Function is called when the UserButton is pressed
+    UserButton.fall(&executeMainFunction);
 
     #ifdef _playerEnabled
         //Creates objects, as only one object of each class is needed, they are called the same as their classes
@@ -88,6 +127,9 @@ int main(){
             Player.volume(25);
             printf("DFPlayer started.\n");
         }
+        DFRobotDFPlayerMini* PlayerPtr = &Player;
+    #else
+        DFRobotDFPlayerMini* PlayerPtr = nullptr;
     #endif
 
     
@@ -95,201 +137,57 @@ int main(){
     Stepper Stepper(STEP, DIR, stepsPerRev);
     Stepper.setVelocity(0);
 
+    CarJackHardware Hardware(Stepper, PlayerPtr);
+    CarJack CarJack(Hardware);
+
+    //Every input change wakes the main thread
+    ThreadFlag InputFlag;
+    inputFlag = InputFlag;
+    mainThreadId = ThisThread::get_id();
+    LimitSwitch.rise(&inputChanged);
+    LimitSwitch.fall(&inputChanged);
+
+    //Contact bounce of the switches is filtered by DebounceIn, the levels at the start are taken as they are
+    if(UpSwitch.read())     debouncedInputs |= CarJack::INPUT_UP_SWITCH;
+    if(DownSwitch.read())   debouncedInputs |= CarJack::INPUT_DOWN_SWITCH;
+    if(HandleSensor.read()) debouncedInputs |= CarJack::INPUT_HANDLE_SENSOR;
+    UpSwitch.rise([]() { setDebouncedInput(CarJack::INPUT_UP_SWITCH, true); });
+    UpSwitch.fall([]() { setDebouncedInput(CarJack::INPUT_UP_SWITCH, false); });
+    DownSwitch.rise([]() { setDebouncedInput(CarJack::INPUT_DOWN_SWITCH, true); });
+    DownSwitch.fall([]() { setDebouncedInput(CarJack::INPUT_DOWN_SWITCH, false); });
+    HandleSensor.rise([]() { setDebouncedInput(CarJack::INPUT_HANDLE_SENSOR, true); });
+    HandleSensor.fall([]() { setDebouncedInput(CarJack::INPUT_HANDLE_SENSOR, false); });
+
+    CarJack.begin(readInputs(), getTimeMs());
+
+    #ifdef _debug
+        const char* lastStateName = "";
+    #endif
 
     while(true){
-        MainTaskTimer.reset();  //resets the maintasktimer
-
-        
-        #ifdef _playerEnabled
-            /*
-            if(Player.getBusyState()){
-                printf("Player Busy\n");
-            }
-            else{
-                printf("Player ready\n");
-            }
-            */
-            printf("readType: %d, read: %d\n",Player.readType(), Player.read());
-        #endif
-        
-
-        //voicemode toggle
-        if(UpSwitch.read() and DownSwitch.read()){
-            bothSwitchesEngagedCounter++;
-            if(bothSwitchesEngagedCounter >= bothSwitchesEngagedDelay / mainTaskPeriod){
-                if(!edgedetectionVoiceModes){
-                edgedetectionVoiceModes = true;
-                #ifdef _playerEnabled
-                    Player.setBaneModeState();
-                #endif
-                }
-            }
+        //sleeps until an input changes or the next timer of the state machine expires
+        const int32_t timeToNextTimerMs = CarJack.getTimeToNextTimerMs();
+        if(timeToNextTimerMs < 0){
+            ThisThread::flags_wait_any(inputFlag);
         }
         else{
-           bothSwitchesEngagedCounter = 0;
-           edgedetectionVoiceModes = false; 
+            ThisThread::flags_wait_any_for(inputFlag, std::chrono::milliseconds(timeToNextTimerMs));
         }
 
-        //detects Modechange
-        if(HandleSensor.read() != modeState){
-            modeState = !modeState;
-            toggleModeDetected = true;
-        }
-        else{
-            toggleModeDetected = false;
-        }
+        CarJack.update(readInputs(), getTimeMs());
 
-        //Main switch, Manual or Automatic Mode
-        switch(HandleSensor.read()){
-            case true: 
-                #ifdef _debug
-                    printf("Manual\n");
-                #endif
-                //Manual mode
-                Stepper.setVelocity(0);
-                EnableStepper.write(false);  //disbales the stepper
-                Solenoid.write(false);      //Solenoid in resting position
-
-                motorInitialized = false;   //Resets the motorInitialized flag
-
-                //When the mode has changed to "manual" play that mp3
-                #ifdef _playerEnabled
-                    if(toggleModeDetected) Player.play(DFRobotDFPlayerMini::manualMode);
-                    if(Stepper.down()) Player.play(DFRobotDFPlayerMini::inLowerPos);
-                #endif
-                
-                break;
-
-            case false:
-                #ifdef _debug
-                    printf("Automatic\n");
-                #endif
-
-                EnableStepper.write(true);                 //enables the stepper
-
-                //When the mode has changed to "automatic" play that mp3
-                #ifdef _playerEnabled
-                    if(toggleModeDetected) Player.play(DFRobotDFPlayerMini::automaticMode);
-                #endif
-
-                if(!LimitSwitch.read()){
-                    limitSwitchReadCounter++;   //increases the counter if the switch is enaged
-                    if(limitSwitchReadCounter >= limitSwitchReadCycles){    //after a set cycletimes where the switch hase been engaged, read as high
-                        #ifdef _debug
-                            printf("Limitswitch triggered\n");
-                        #endif
-                        //Sets the stepcounter to 0 when the LimitSwitch is !high
-                        Stepper.setInternalRotation(0);
-                        motorInitialized = true;
-                    }
-                }
-                else{
-                    limitSwitchReadCounter = 0; //Resets the counter if the switch isn't enaged
-                }
-                if(DownSwitch.read() && !UpSwitch.read()){
-                    #ifdef _debug
-                        printf("Down Switch, pull Solenoid back\n");
-                    #endif
-                    //Pulls the Solenoid back
-                    Solenoid.write(true);
-                    if(solenoidHoldCounter >= driveDownDelay / mainTaskPeriod){ //Delay to pull the solenoid back
-                        //ramp up the motor
-                        #ifdef _debug
-                            printf("Motorramp downwards\n");
-                        #endif
-                        if(Stepper.rampDown(mainTaskPeriod)){
-                            //if speed is reached, drive downwards with full speed
-                            //if endpos is reached, stop
-                            #ifdef _debug
-                                printf("Downwards full speed\n");
-                            #endif
-                            if(Stepper.down()){
-                                #ifdef _debug
-                                    printf("In lower pos\n");
-                                #endif
-                                #ifdef _playerEnabled
-                                if(lastTrackPlayed != DFRobotDFPlayerMini::inLowerPos){
-                                    lastTrackPlayed = DFRobotDFPlayerMini::inLowerPos;
-                                    Player.play(DFRobotDFPlayerMini::inLowerPos);
-                                }
-                                #endif
-                                
-                            }
-                        }
-                    }
-                    else solenoidHoldCounter++;
-                }
-                else if(UpSwitch.read() && !DownSwitch.read()){
-                    #ifdef _debug
-                        printf("Up Switch\n");
-                    #endif
-                    if(!motorInitialized){
-                        //motor not initialized
-                        #ifdef _debug
-                            printf("Motor not initialized\n");
-                        #endif
-                        #ifdef _playerEnabled
-                        if(lastTrackPlayed != DFRobotDFPlayerMini::notInitialized){
-                            lastTrackPlayed = DFRobotDFPlayerMini::notInitialized;
-                            Player.play(DFRobotDFPlayerMini::notInitialized);
-                        }
-
-                        #endif
-                    }
-                    else if(Stepper.rampUp(mainTaskPeriod)){
-                        Solenoid.write(false);
-                        
-                        //if speed is reached, drive upwards with full speed
-                        //if endpos is reached, stop
-                        #ifdef _debug
-                                printf("Upwards full speed\n");
-                        #endif
-                        if(Stepper.up()){
-                            #ifdef _debug
-                                printf("In upper pos\n");
-                            #endif
-                            #ifdef _playerEnabled
-                            if(lastTrackPlayed !=DFRobotDFPlayerMini::inUpperPos){
-                                lastTrackPlayed =  DFRobotDFPlayerMini::inUpperPos;
-                                Player.play(DFRobotDFPlayerMini::inUpperPos);
-                            }
-                                
-                            #endif
-                        }
-                    }
-                }
-                else{
-                    Stepper.setVelocity(0);
-                    //delay to deactivate the solenoid after stopping to drive upwards
-                    if(solenoidReleaseCounter >= solenoidReleaseDelay / mainTaskPeriod){
-                        Solenoid.write(false);
-                        #ifdef _debug
-                            printf("release Solenoid\n");
-                        #endif
-                    }
-                    else{
-                        solenoidReleaseCounter++;
-                    }
-                    //wird nach drücken des UserButton einmal ausgefuehrt
-                        if(resetAll){
-                        }
-                }
-                #ifdef _debug
-                    printf("Motor Velocity :%f\n", Stepper.getVelocity());
-                    printf("rotations :%f\n\n", Stepper.getRotation());
-                #endif
-            break;
-        }
-        if(!Solenoid.read()){
-            solenoidHoldCounter = 0;
-        }
-        if(!Solenoid.read() || DownSwitch.read()){
-            solenoidReleaseCounter = 0;
-        }
-        //read timer and make the main thread sleep for the remaining time span (non blocking)
-        int mainTaskElapsedTime = std::chrono::duration_cast<std::chrono::milliseconds>(MainTaskTimer.elapsed_time()).count();
-        //printf("\nMainTaskElapsedTime: %d\n", mainTaskElapsedTime);
-        thread_sleep_for(mainTaskPeriod - mainTaskElapsedTime);
-        
+        #ifdef _debug
+            //prints the state only when it changed
+            if(CarJack.getStateName() != lastStateName){
+                lastStateName = CarJack.getStateName();
+                printf("%s, rotations: %f\n", lastStateName, Stepper.getRotation());
+            }
+        #endif
+
+        #ifdef _playerEnabled
+            if (Player.available()) {
+                printf("readType: %d, read: %d\n",Player.readType(), Player.read());
+            }
+        #endif
     }
-}
\ No newline at end of file
+}
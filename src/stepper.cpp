@@ -6,178 +6,151 @@ Stepper::Stepper(PinName step_pin,
                  PinName dir_pin,
                  uint16_t step_per_rev) : m_Step(step_pin)
                                         , m_Dir(dir_pin)
-                                        , m_Thread(osPriorityHigh2)
+                                        , m_Engine(static_cast<float>(step_per_rev),
+                                                   static_cast<float>(maxVelocity),
+                                                   static_cast<float>(maxVelocity) / (rampUpTime * 1.0e-3f))
 {
     m_steps_per_rev = static_cast<float>(step_per_rev);
-    m_time_step_const = 1.0e6f / m_steps_per_rev;
 
-    m_steps_setpoint = 0;
-    m_steps = 0;
-    m_velocity = 1.0f;
+    m_time_next_mus = 0;
 
-    m_period_mus = 0;
+    m_is_velocity_command = true;
+    m_steps_setpoint = 0;
+    m_velocity_setpoint = 0.0f;
 
-    // start thread
-    m_Thread.start(callback(this, &Stepper::threadTask));
+    // the timer events are scheduled relative to this timer
+    m_Timer.start();
 }
 
 Stepper::~Stepper()
 {
-    m_Ticker.detach();
     m_Timeout.detach();
-    m_Thread.terminate();
+    m_PulseTimeout.detach();
 }
 
 bool Stepper::up()
 {
-    if(getRotation() >= rotationToTopPos){
-        //top pos reached, stop motor
-        setVelocity(0);
-        return true;
-    }
-    //top pos not yet reached, sets speed
-    setVelocity(maxVelocity);
-    return false;
+    //drives to the top pos, the engine decelerates so that it stops there
+    setRotation(rotationToTopPos, maxVelocity);
+    return getRotation() >= rotationToTopPos;
 }
 
 bool Stepper::down()
 {
-    if(getRotation() <= softwareStopPos && motorInitialized){
-        //lowest pos reached, stop motor
-        setVelocity(0);
-        return true;
+    if(motorInitialized){
+        //drives to the lowest pos, the engine decelerates so that it stops there
+        setRotation(softwareStopPos, maxVelocity);
+        return getRotation() <= softwareStopPos;
     }
-    //lowest pos not yet reached, sets speed
+    //lowest pos unknown, sets speed
     setVelocity(-maxVelocity);
     return false;
 }
 
-bool Stepper::rampUp(uint8_t mainExecutionTime)
+bool Stepper::rampUp()
 {
-    if(getVelocity() < maxVelocity){
-        //calculates and sets the speedincrease while ramping up the motor to drive upwards
-        setVelocity(getVelocity() + maxVelocity / (rampUpTime / mainExecutionTime));
-        return false;
-    }
-    return true;
+    //the engine ramps the speed up to drive upwards
+    setVelocity(maxVelocity);
+    return getVelocity() >= m_Engine.getVelocityMax();
 }
 
-bool Stepper::rampDown(uint8_t mainExecutionTime)
+bool Stepper::rampDown()
 {
-    if(getVelocity() > -maxVelocity){
-        //calculates and sets the speedincrease while ramping up the motor to drive downwards
-        setVelocity(getVelocity() - maxVelocity / (rampUpTime / mainExecutionTime));
-        return false;
-    }
-    return true;
+    //the engine ramps the speed up to drive downwards
+    setVelocity(-maxVelocity);
+    return getVelocity() <= -m_Engine.getVelocityMax();
 }
 
-
-void Stepper::setRotation(float rotations, float velocity)
+void Stepper::setInternalRotation(float rotations)
 {
-    setSteps(static_cast<int>(rotations * m_steps_per_rev + 0.5f), velocity);
+    sendCommand(m_Engine.setPosition(static_cast<int>(rotations * m_steps_per_rev + 0.5f)));
 }
 
-void Stepper::setRotation(float rotations)
+void Stepper::setRotation(float rotations, float velocity)
 {
-    setRotation(rotations, m_velocity);
+    setSteps(static_cast<int>(rotations * m_steps_per_rev + 0.5f), velocity);
 }
 
 void Stepper::setRotationRelative(float rotations, float velocity)
 {
-    setSteps(static_cast<int>(rotations * m_steps_per_rev + 0.5f) + m_steps, velocity);
-}
-
-void Stepper::setRotationRelative(float rotations)
-{
-    setSteps(static_cast<int>(rotations * m_steps_per_rev + 0.5f) + m_steps, m_velocity);
+    setSteps(static_cast<int>(rotations * m_steps_per_rev + 0.5f) + getSteps(), velocity);
 }
 
 void Stepper::setVelocity(float velocity)
 {
-    if (velocity == 0.0f) {
-        m_velocity = 0.0f;
-        m_period_mus = 0;
-        m_Ticker.detach();
+    // only send new commands, this is called every cycle of the main loop
+    if (m_is_velocity_command && m_velocity_setpoint == velocity)
         return;
-    } else if (velocity > 0.0f)
-        setSteps(STEPS_MAX, velocity);
-    else
-        setSteps(STEPS_MIN, velocity);
-}
 
-void Stepper::setSteps(int steps, float velocity)
-{
-    // return if setpoint is equal to steps or velocity is zero
-    m_steps_setpoint = steps;
-    if (m_steps_setpoint == m_steps || velocity == 0.0f) {
-        m_velocity = 0.0f;
-        m_period_mus = 0;
-        m_Ticker.detach();
+    // the last command is only stored if the engine took it, otherwise it is sent again in the next cycle
+    if (!sendCommand(m_Engine.setVelocity(velocity)))
         return;
-    }
-    
-    // write direction
-    if (m_steps_setpoint > m_steps)
-        m_Dir.write(1);
-    else
-        m_Dir.write(0);
-
-    // calculate period for ticker in microseconds
-    const int period_mus = static_cast<int>(m_time_step_const / fabs(velocity) + 0.5f);
-    
-    // make sure we only attach the ticker if the period has changed
-    if (m_period_mus != period_mus) {
-
-        // update quantizised velocity
-        m_velocity = copysignf(m_time_step_const / static_cast<float>(period_mus), velocity);
-
-        // update period
-        m_period_mus = period_mus;
-    
-        // attach sendThreadFlag() to ticker so that sendThreadFlag() is called periodically, which signals the thread to execute
-        m_Ticker.attach(callback(this, &Stepper::sendThreadFlag), std::chrono::microseconds{m_period_mus});
-    }
+    m_is_velocity_command = true;
+    m_velocity_setpoint = velocity;
 }
 
-void Stepper::step()
+void Stepper::setSteps(int steps, float velocity)
 {
-    // send one step via timeout
-    enableDigitalOutput();
-    m_Timeout.attach(callback(this, &Stepper::disableDigitalOutput), std::chrono::microseconds{PULSE_MUS});
+    // only send new commands, this is called every cycle of the main loop
+    if (!m_is_velocity_command && m_steps_setpoint == steps && m_velocity_setpoint == velocity)
+        return;
 
-    // increment steps
-    if (m_Dir.read() == 0)
-        m_steps--;
-    else
-        m_steps++;
+    // the last command is only stored if the engine took it, otherwise it is sent again in the next cycle
+    if (!sendCommand(m_Engine.setTarget(steps, velocity)))
+        return;
+    m_is_velocity_command = false;
+    m_steps_setpoint = steps;
+    m_velocity_setpoint = velocity;
 }
 
-void Stepper::enableDigitalOutput()
+bool Stepper::sendCommand(StepPulseEngine::command_result_t result)
 {
-    m_Step = 1; // set the digital output to high
+    if (result == StepPulseEngine::COMMAND_DISCARDED) {
+        printf("Stepper: command buffer of the engine full, command discarded\n");
+        return false;
+    }
+    if (result == StepPulseEngine::COMMAND_START_TIMER)
+        startTimer();
+    return true;
 }
 
-void Stepper::disableDigitalOutput()
+void Stepper::startTimer()
 {
-    m_Step = 0; // set the digital output to low
+    // the engine is not running, so the timer interrupt can not access m_time_next_mus
+    m_time_next_mus = m_Timer.elapsed_time().count() + 1;
+    m_Timeout.attach(callback(this, &Stepper::onTimer), std::chrono::microseconds{1});
 }
 
-void Stepper::threadTask()
+void Stepper::onTimer()
 {
-    while (true) {
-        ThisThread::flags_wait_any(m_ThreadFlag);
+    uint32_t delay_mus;
+    if (m_Engine.onTimer(delay_mus)) {
+        // the direction only changes when the motor stands still, the driver needs a setup time before the step,
+        // the pulse is started and ended by its own timeout, so the interrupt does not wait
+        const int dir = m_Engine.getDirection() ? 1 : 0;
+        if (m_Dir.read() != dir) {
+            m_Dir.write(dir);
+            m_PulseTimeout.attach(callback(this, &Stepper::onPulseStart), std::chrono::microseconds{PULSE_MUS});
+        } else {
+            onPulseStart();
+        }
+    }
 
-        if (m_steps_setpoint == m_steps) {
-            m_period_mus = 0;
-            m_Ticker.detach();
-        } else
-            step();
+    if (delay_mus > 0) {
+        // the next event is scheduled relative to this one, so the latency of the interrupt does not add up
+        m_time_next_mus += delay_mus;
+        const int64_t time_to_next_mus = m_time_next_mus - m_Timer.elapsed_time().count();
+        m_Timeout.attach(callback(this, &Stepper::onTimer), std::chrono::microseconds{(time_to_next_mus > 1) ? time_to_next_mus : 1});
     }
 }
 
-void Stepper::sendThreadFlag()
+void Stepper::onPulseStart()
+{
+    m_Step = 1;
+    m_PulseTimeout.attach(callback(this, &Stepper::onPulseEnd), std::chrono::microseconds{PULSE_MUS});
+}
+
+void Stepper::onPulseEnd()
 {
-    // set the thread flag to trigger the thread task
-    m_Thread.flags_set(m_ThreadFlag);
+    m_Step = 0;
 }